@@ -30,6 +30,7 @@
 #include <exception>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include "keyvi/dictionary/completion/multiword_completion.h"
@@ -215,6 +216,21 @@ keyvi_bytes keyvi_match_get_msgpacked_value_compressed(const struct keyvi_match*
   return keyvi_bytes{data_size, static_cast<const uint8_t*>(data_ptr)};
 }
 
+keyvi_bytes keyvi_match_get_msgpacked_value_view(const struct keyvi_match* match) {
+  const keyvi_bytes empty_keyvi_bytes{0, nullptr};
+
+  if (!match->obj_) {
+    return empty_keyvi_bytes;
+  }
+
+  std::string_view msgpacked_value;
+  if (!match->obj_->GetMsgPackedValueAsStringView(&msgpacked_value) || msgpacked_value.empty()) {
+    return empty_keyvi_bytes;
+  }
+
+  return keyvi_bytes{msgpacked_value.size(), reinterpret_cast<const uint8_t*>(msgpacked_value.data())};
+}
+
 char* keyvi_match_get_matched_string(const keyvi_match* match) {
   return std_2_c_string(match->obj_ ? match->obj_->GetMatchedString() : "");
 }
@@ -44,6 +44,7 @@
 #include "keyvi/dictionary/dictionary_types.h"
 #include "keyvi/dictionary/fsa/internal/constants.h"
 #include "keyvi/util/configuration.h"
+#include "keyvi/util/os_utils.h"
 
 /** Extracts the parameters. */
 keyvi::util::parameters_t extract_parameters(const boost::program_options::variables_map& vm) {
@@ -72,6 +73,8 @@ int main(int argc, char** argv) {
   description.add_options()("output-file,o", boost::program_options::value<std::string>(), "output file");
   description.add_options()("memory-limit,m", boost::program_options::value<std::string>(),
                             "amount of main memory to use");
+  description.add_options()("nice,n", boost::program_options::value<int>(),
+                            "lower the cpu and io priority by the given nice value (Linux only)");
   description.add_options()("parameter,p",
                             boost::program_options::value<std::vector<std::string>>()
                                 ->default_value(std::vector<std::string>(), "EMPTY")
@@ -113,6 +116,10 @@ int main(int argc, char** argv) {
       }
     }
 
+    if (vm.count("nice") != 0U) {
+      keyvi::util::OsUtils::LowerThreadPriority(vm["nice"].as<int>());
+    }
+
     keyvi::util::parameters_t params = extract_parameters(vm);
     if (vm.count("memory-limit") != 0U) {
       params[MEMORY_LIMIT_KEY] = vm["memory-limit"].as<std::string>();
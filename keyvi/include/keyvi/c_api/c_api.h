@@ -100,6 +100,11 @@ keyvi_bytes keyvi_match_get_msgpacked_value(const struct keyvi_match*);
 keyvi_bytes keyvi_match_get_msgpacked_value_compressed(const struct keyvi_match*,
                                                        keyvi::compression::CompressionAlgorithm);
 
+// Zero-copy variant of keyvi_match_get_msgpacked_value: the bytes point into the dictionary and are valid as long as
+// the match is alive, they must not be passed to keyvi_bytes_destroy. Returns empty bytes if the value is not
+// available without conversion, e.g. if it is compressed, use keyvi_match_get_msgpacked_value in this case.
+keyvi_bytes keyvi_match_get_msgpacked_value_view(const struct keyvi_match*);
+
 char* keyvi_match_get_matched_string(const struct keyvi_match*);
 
 //////////////////////
@@ -25,9 +25,10 @@
 #ifndef KEYVI_DICTIONARY_DICTIONARY_H_
 #define KEYVI_DICTIONARY_DICTIONARY_H_
 
+#include <array>
 #include <memory>
-#include <queue>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -36,11 +37,16 @@
 #include "keyvi/dictionary/fsa/traverser_types.h"
 #include "keyvi/dictionary/match.h"
 #include "keyvi/dictionary/match_iterator.h"
+#include "keyvi/dictionary/match_view.h"
+#include "keyvi/dictionary/matching/fuzzy_automaton_matching.h"
 #include "keyvi/dictionary/matching/fuzzy_matching.h"
 #include "keyvi/dictionary/matching/fuzzy_multiword_completion_matching.h"
+#include "keyvi/dictionary/matching/fuzzy_top_n_matching.h"
 #include "keyvi/dictionary/matching/multiword_completion_matching.h"
 #include "keyvi/dictionary/matching/near_matching.h"
 #include "keyvi/dictionary/matching/prefix_completion_matching.h"
+#include "keyvi/dictionary/query_context.h"
+#include "keyvi/dictionary/text_annotator.h"
 #include "keyvi/dictionary/util/bounded_priority_queue.h"
 
 // #define ENABLE_TRACING
@@ -84,6 +90,47 @@ class Dictionary final {
 
   match_t operator[](const std::string& key) const { return GetSubscript(fsa_->GetStartState(), key); }
 
+  /**
+   * Check whether several keys are in the dictionary.
+   *
+   * Keys are walked interleaved, so memory access of one key overlaps with the others,
+   * which is faster than calling Contains in a loop.
+   *
+   * @param keys The keys
+   * @return for every key True if it is in the dictionary, False otherwise.
+   */
+  std::vector<bool> ContainsMany(const std::vector<std::string>& keys) const {
+    const std::vector<uint64_t> final_states = WalkMany(fsa_->GetStartState(), keys);
+    std::vector<bool> result;
+    result.reserve(keys.size());
+
+    for (const uint64_t state : final_states) {
+      result.push_back(state != 0);
+    }
+
+    return result;
+  }
+
+  /**
+   * Exact match for several keys, see ContainsMany.
+   *
+   * @param keys The keys
+   * @return for every key a match, empty if the key is not in the dictionary.
+   */
+  std::vector<match_t> GetMany(const std::vector<std::string>& keys) const {
+    const std::vector<uint64_t> final_states = WalkMany(fsa_->GetStartState(), keys);
+    std::vector<match_t> matches(keys.size());
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (final_states[i]) {
+        matches[i] =
+            std::make_shared<Match>(0, keys[i].size(), keys[i], 0, fsa_, fsa_->GetStateValue(final_states[i]));
+      }
+    }
+
+    return matches;
+  }
+
   /**
    * Exact Match function.
    *
@@ -99,6 +146,34 @@ class Dictionary final {
    */
   MatchIterator::MatchIteratorPair GetAllItems() const { return GetAllItems(fsa_->GetStartState()); }
 
+  /**
+   * Call the visitor for every item of the dictionary, in the same order as GetAllItems.
+   *
+   * Other than GetAllItems this does not create a Match per item, the visitor gets a MatchView which is only valid
+   * during the call. The visitor can return false to stop early.
+   *
+   * @param visitor callable taking a MatchView&
+   */
+  template <class VisitorT>
+  void ForEachMatch(VisitorT&& visitor) const {
+    std::vector<unsigned char> traversal_stack;
+    traversal_stack.reserve(1024);
+
+    for (fsa::StateTraverser<> traverser(fsa_, fsa_->GetStartState()); traverser; traverser++) {
+      traversal_stack.resize(traverser.GetDepth() - 1);
+      traversal_stack.push_back(traverser.GetStateLabel());
+
+      if (traverser.IsFinalState()) {
+        MatchView view(0, traverser.GetDepth(),
+                       std::string_view(reinterpret_cast<const char*>(traversal_stack.data()), traversal_stack.size()),
+                       0, fsa_, traverser.GetStateValue());
+        if (!CallVisitor(visitor, view)) {
+          return;
+        }
+      }
+    }
+  }
+
   /**
    * A simple leftmostlongest lookup function.
    *
@@ -139,46 +214,44 @@ class Dictionary final {
   }
 
   /**
-   * A simple leftmostlongest lookup function.
+   * Lookup all tokens of a text, returns the longest match for every token start, see TextAnnotator.
    *
    * @param text the input
    * @return a match iterator.
    */
   MatchIterator::MatchIteratorPair LookupText(const std::string& text) {
-    const size_t text_length = text.size();
-    std::queue<MatchIterator> iterators;
-
-    TRACE("LookupText, 1st lookup for: %s", text.c_str());
-
-    iterators.push(Lookup(text).begin());
-    size_t position = 1;
-
-    while (position < text_length) {
-      if (text[position] != ' ') {
-        ++position;
-        continue;
-      }
-
-      ++position;
-      TRACE("LookupText, starting lookup for: %s", text.c_str() + position);
-      iterators.push(Lookup(text, position).begin());
-    }
+    TRACE("LookupText: %s", text.c_str());
+    TextAnnotator annotator(annotation_mode_t::LONGEST);
+    auto matches = std::make_shared<std::vector<match_t>>();
 
-    MatchIterator current_it = iterators.front();
-    iterators.pop();
+    annotator.Annotate(fsa_, text, [&matches](const MatchView& m) { matches->push_back(m.ToMatch()); });
 
-    auto func = [iterators = std::move(iterators), current_it]() mutable {
-      while (iterators.size() && !*current_it) {
-        current_it = iterators.front();
-        iterators.pop();
+    size_t i = 0;
+    auto func = [matches, i]() mutable {
+      if (i < matches->size()) {
+        return std::move((*matches)[i++]);
       }
-
-      return *current_it++;
+      return match_t();
     };
 
     return MatchIterator::MakeIteratorPair(func);
   }
 
+  /**
+   * Annotate a text in a single pass using the given annotator, the visitor gets called for every match.
+   *
+   * The match passed to the visitor points into the text and is only valid during the call, the visitor can return
+   * false to stop early.
+   *
+   * @param annotator the annotator, which defines the matches to report and the token boundaries
+   * @param text the input
+   * @param visitor callable taking a MatchView&
+   */
+  template <class VisitorT>
+  void LookupText(TextAnnotator* annotator, const std::string_view text, VisitorT&& visitor) const {
+    annotator->Annotate(fsa_, text, std::forward<VisitorT>(visitor));
+  }
+
   /**
    * Match a key near: Match as much as possible exact given the minimum prefix length and then return everything below.
    *
@@ -199,6 +272,45 @@ class Dictionary final {
     return GetFuzzy(fsa_->GetStartState(), query, max_edit_distance, minimum_exact_prefix);
   }
 
+  /**
+   * Fuzzy matching returning only the top n matches, ordered by edit distance and weight.
+   *
+   * The search is best first and stops as soon as the top n matches are found, unlike draining GetFuzzy and sorting
+   * the result, the costs depend on the number of requested matches rather than on the number of candidates.
+   *
+   * @param query the query
+   * @param max_edit_distance the maximum allowed edit distance
+   * @param minimum_exact_prefix the minimum exact prefix to match before matching approximate
+   * @param top_n the number of matches to return
+   */
+  MatchIterator::MatchIteratorPair GetFuzzy(const std::string& query, const int32_t max_edit_distance,
+                                            const size_t minimum_exact_prefix, const size_t top_n) const {
+    auto data = std::make_shared<matching::FuzzyTopNMatching>(matching::FuzzyTopNMatching::FromSingleFsa(
+        fsa_, query, max_edit_distance, minimum_exact_prefix, top_n));
+
+    auto func = [data]() { return data->NextMatch(); };
+    return MatchIterator::MakeIteratorPair(func, std::move(data->FirstMatch()));
+  }
+
+  /**
+   * Fuzzy matching using a Levenshtein automaton, returns the same matches as GetFuzzy.
+   *
+   * The query gets compiled into an automaton, which makes every step of the traversal a table lookup. Compared to
+   * GetFuzzy this is faster the more states get visited, e.g. for large dictionaries or a short exact prefix.
+   *
+   * @param query the query
+   * @param max_edit_distance the maximum allowed edit distance
+   * @param minimum_exact_prefix the minimum exact prefix to match before matching approximate
+   */
+  MatchIterator::MatchIteratorPair GetFuzzyWithAutomaton(const std::string& query, const int32_t max_edit_distance,
+                                                         const size_t minimum_exact_prefix = 2) const {
+    auto data = std::make_shared<matching::FuzzyAutomatonMatching<>>(
+        matching::FuzzyAutomatonMatching<>::FromSingleFsa(fsa_, query, max_edit_distance, minimum_exact_prefix));
+
+    auto func = [data]() { return data->NextMatch(); };
+    return MatchIterator::MakeIteratorPair(func, std::move(data->FirstMatch()));
+  }
+
   MatchIterator::MatchIteratorPair GetPrefixCompletion(const std::string& query) const {
     return GetPrefixCompletion(fsa_->GetStartState(), query);
   }
@@ -207,6 +319,59 @@ class Dictionary final {
     return GetPrefixCompletion(fsa_->GetStartState(), query, top_n);
   }
 
+  /**
+   * Near matching using the given context, the visitor gets called for every match.
+   *
+   * Other than the iterator based version this reuses the memory of the context and does not allocate in steady
+   * state. The match passed to the visitor is owned by the context and only valid during the call. The visitor can
+   * return false to stop early.
+   *
+   * @param context the query context, must not be used concurrently
+   * @param key the key
+   * @param minimum_prefix_length the minimum prefix length to match exact
+   * @param greedy if true matches everything below minimum prefix
+   * @param visitor callable taking a Match&
+   */
+  template <class VisitorT>
+  void GetNear(QueryContext* context, const std::string& key, const size_t minimum_prefix_length, const bool greedy,
+               VisitorT&& visitor) const {
+    context->near_matching_.Reset(fsa_, fsa_->GetStartState(), key, minimum_prefix_length, greedy);
+    context->VisitMatches(&context->near_matching_, std::forward<VisitorT>(visitor));
+  }
+
+  /**
+   * Fuzzy matching using the given context, the visitor gets called for every match.
+   *
+   * See GetNear(QueryContext*, ...) for the lifetime of the match.
+   *
+   * @param context the query context, must not be used concurrently
+   * @param query the query
+   * @param max_edit_distance the maximum allowed edit distance
+   * @param minimum_exact_prefix the minimum exact prefix to match before matching approximate
+   * @param visitor callable taking a Match&
+   */
+  template <class VisitorT>
+  void GetFuzzy(QueryContext* context, const std::string& query, const int32_t max_edit_distance,
+                const size_t minimum_exact_prefix, VisitorT&& visitor) const {
+    context->fuzzy_matching_.Reset(fsa_, fsa_->GetStartState(), query, max_edit_distance, minimum_exact_prefix);
+    context->VisitMatches(&context->fuzzy_matching_, std::forward<VisitorT>(visitor));
+  }
+
+  /**
+   * Prefix completion using the given context, the visitor gets called for every match.
+   *
+   * See GetNear(QueryContext*, ...) for the lifetime of the match.
+   *
+   * @param context the query context, must not be used concurrently
+   * @param query the query
+   * @param visitor callable taking a Match&
+   */
+  template <class VisitorT>
+  void GetPrefixCompletion(QueryContext* context, const std::string& query, VisitorT&& visitor) const {
+    context->prefix_completion_matching_.Reset(fsa_, fsa_->GetStartState(), query);
+    context->VisitMatches(&context->prefix_completion_matching_, std::forward<VisitorT>(visitor));
+  }
+
   MatchIterator::MatchIteratorPair GetMultiwordCompletion(const std::string& query,
                                                           const unsigned char multiword_separator = 0x1b) const {
     return GetMultiwordCompletion(fsa_->GetStartState(), query, multiword_separator);
@@ -235,21 +400,19 @@ class Dictionary final {
   match_t GetSubscript(const uint64_t start_state, const std::string& key) const {
     uint64_t state = start_state;
 
-    if (!state) {
+    if (!state || !fsa_->MayContain(state, key)) {
       return match_t();
     }
 
     const size_t text_length = key.size();
+    size_t i = 0;
+    state = fsa_->TryJumpTransitions(state, key, &i);
 
-    for (size_t i = 0; i < text_length; ++i) {
+    for (; state && i < text_length; ++i) {
       state = fsa_->TryWalkTransition(state, key[i]);
-
-      if (!state) {
-        break;
-      }
     }
 
-    if (!fsa_->IsFinalState(state)) {
+    if (!state || !fsa_->IsFinalState(state)) {
       return match_t();
     }
 
@@ -259,14 +422,21 @@ class Dictionary final {
   bool Contains(const uint64_t start_state, const std::string& key) const {
     uint64_t state = start_state;
 
-    if (!state) {
+    if (!state || !fsa_->MayContain(state, key)) {
       return false;
     }
 
     const size_t key_length = key.size();
 
     TRACE("Contains for %s", key.c_str());
-    for (size_t i = 0; i < key_length; ++i) {
+    size_t i = 0;
+    state = fsa_->TryJumpTransitions(state, key, &i);
+
+    if (!state) {
+      return false;
+    }
+
+    for (; i < key_length; ++i) {
       state = fsa_->TryWalkTransition(state, key[i]);
 
       if (!state) {
@@ -284,24 +454,88 @@ class Dictionary final {
     return false;
   }
 
+  /**
+   * Walk all keys through the automaton, interleaving MULTI_KEY_LOOKUP_LANES keys at a time. After every step the
+   * next transition of a key gets prefetched, so it is hopefully in cache when the key gets its turn again.
+   *
+   * @return for every key the final state it ends in or 0 if the key does not exist.
+   */
+  std::vector<uint64_t> WalkMany(const uint64_t start_state, const std::vector<std::string>& keys) const {
+    std::vector<uint64_t> states(keys.size(), 0);
+
+    if (!start_state) {
+      return states;
+    }
+
+    // key index and position in the key for every lane
+    std::array<size_t, MULTI_KEY_LOOKUP_LANES> lane_keys;
+    std::array<size_t, MULTI_KEY_LOOKUP_LANES> lane_positions;
+    size_t next_key = 0;
+    size_t active_lanes = 0;
+
+    while (next_key < keys.size() || active_lanes > 0) {
+      // fill free lanes
+      while (active_lanes < MULTI_KEY_LOOKUP_LANES && next_key < keys.size()) {
+        size_t position = 0;
+        const uint64_t state = fsa_->MayContain(start_state, keys[next_key])
+                                   ? fsa_->TryJumpTransitions(start_state, keys[next_key], &position)
+                                   : 0;
+
+        if (!state || position == keys[next_key].size()) {
+          states[next_key] = (state && fsa_->IsFinalState(state)) ? state : 0;
+        } else {
+          states[next_key] = state;
+          fsa_->PrefetchTransition(state, keys[next_key][position]);
+          lane_keys[active_lanes] = next_key;
+          lane_positions[active_lanes] = position;
+          ++active_lanes;
+        }
+        ++next_key;
+      }
+
+      // make one step for every lane
+      size_t lane = 0;
+      while (lane < active_lanes) {
+        const size_t key_index = lane_keys[lane];
+        const std::string& key = keys[key_index];
+        const uint64_t state = fsa_->TryWalkTransition(states[key_index], key[lane_positions[lane]]);
+        const size_t position = ++lane_positions[lane];
+
+        if (state && position < key.size()) {
+          states[key_index] = state;
+          fsa_->PrefetchTransition(state, key[position]);
+          ++lane;
+          continue;
+        }
+
+        // key is done, either it ended or we fell out of the automaton
+        states[key_index] = (state && fsa_->IsFinalState(state)) ? state : 0;
+
+        --active_lanes;
+        lane_keys[lane] = lane_keys[active_lanes];
+        lane_positions[lane] = lane_positions[active_lanes];
+      }
+    }
+
+    return states;
+  }
+
   MatchIterator::MatchIteratorPair Get(const uint64_t start_state, const std::string& key) const {
     uint64_t state = start_state;
 
-    if (!state) {
+    if (!state || !fsa_->MayContain(state, key)) {
       return MatchIterator::EmptyIteratorPair();
     }
 
     const size_t text_length = key.size();
+    size_t i = 0;
+    state = fsa_->TryJumpTransitions(state, key, &i);
 
-    for (size_t i = 0; i < text_length; ++i) {
+    for (; state && i < text_length; ++i) {
       state = fsa_->TryWalkTransition(state, key[i]);
-
-      if (!state) {
-        break;
-      }
     }
 
-    if (!fsa_->IsFinalState(state)) {
+    if (!state || !fsa_->IsFinalState(state)) {
       return MatchIterator::EmptyIteratorPair();
     }
 
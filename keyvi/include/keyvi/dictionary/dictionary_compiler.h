@@ -26,8 +26,10 @@
 #define KEYVI_DICTIONARY_DICTIONARY_COMPILER_H_
 
 #include <algorithm>
+#include <array>
 #include <functional>
 #include <memory>
+#include <numeric>
 #include <queue>
 #include <string>
 #include <utility>
@@ -48,6 +50,7 @@
 #include "keyvi/util/configuration.h"
 #include "keyvi/util/os_utils.h"
 #include "keyvi/util/serialization_utils.h"
+#include "keyvi/util/thread_pool.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -95,6 +98,8 @@ class DictionaryCompiler final {
     parallel_sort_threshold_ =
         keyvi::util::mapGet(params_, PARALLEL_SORT_THRESHOLD_KEY, DEFAULT_PARALLEL_SORT_THRESHOLD);
 
+    parallel_compile_ = keyvi::util::mapGet(params_, PARALLEL_COMPILE_KEY, DEFAULT_PARALLEL_COMPILE);
+
     value_store_ = new ValueStoreT(params_);
   }
 
@@ -104,7 +109,7 @@ class DictionaryCompiler final {
       // ourselves
       delete value_store_;
     }
-    if (chunk_ > 0) {
+    if (chunk_ > 0 || partitions_ > 0) {
       boost::filesystem::remove_all(temporary_directory_);
     }
   }
@@ -118,6 +123,9 @@ class DictionaryCompiler final {
     }
 
     size_of_keys_ += input_key.size();
+    if (!input_key.empty()) {
+      ++leading_byte_counts_[static_cast<unsigned char>(input_key[0])];
+    }
 
     memory_estimate_ += EstimateMemory(input_key);
     // no move, we have no ownership
@@ -136,7 +144,10 @@ class DictionaryCompiler final {
 
     value_store_->CloseFeeding();
 
-    if (chunk_ == 0) {
+    const std::vector<size_t> partitions = GetPartitions();
+    if (partitions.size() > 1) {
+      CompilePartitioned(partitions, progress_callback, user_data);
+    } else if (chunk_ == 0) {
       CompileSingleChunk(progress_callback, user_data);
     } else {
       CompileByMergingChunks(progress_callback, user_data);
@@ -207,8 +218,20 @@ class DictionaryCompiler final {
   size_t chunk_ = 0;
   size_t size_of_keys_ = 0;
   size_t parallel_sort_threshold_;
+  size_t parallel_compile_;
+  size_t partitions_ = 0;
+  std::array<size_t, 256> leading_byte_counts_ = {};
   boost::filesystem::path temporary_directory_;
 
+  /**
+   * Parameters of the generator of the final dictionary, the key filter gets sized for the given number of keys.
+   */
+  keyvi::util::parameters_t GetGeneratorParams(const size_t number_of_keys) const {
+    keyvi::util::parameters_t params(params_);
+    params[KEY_FILTER_KEYS_KEY] = std::to_string(number_of_keys);
+    return params;
+  }
+
   inline void Sort() {
     if (key_values_.size() > parallel_sort_threshold_ && parallel_sort_threshold_ != 0) {
       boost::sort::block_indirect_sort(key_values_.begin(), key_values_.end());
@@ -232,9 +255,10 @@ class DictionaryCompiler final {
 
     Sort();
 
-    // disable minimization for faster compile
+    // disable minimization for faster compile, chunks get merged again, only the final dictionary needs a key filter
     keyvi::util::parameters_t params(params_);
     params[MINIMIZATION_KEY] = "off";
+    params[KEY_FILTER_KEY] = "false";
     fsa::Generator<keyvi::dictionary::fsa::internal::SparseArrayPersistence<uint16_t>, fsa::internal::NullValueStore,
                    uint32_t, int32_t>
         generator(params);
@@ -263,7 +287,7 @@ class DictionaryCompiler final {
 
     generator_ =
         GeneratorAdapter::template CreateGenerator<keyvi::dictionary::fsa::internal::SparseArrayPersistence<uint16_t>>(
-            size_of_keys_, params_, value_store_);
+            size_of_keys_, GetGeneratorParams(key_values_.size()), value_store_);
 
     if (key_values_.size() > 0) {
       size_t number_of_items = key_values_.size();
@@ -325,46 +349,120 @@ class DictionaryCompiler final {
 
     generator_ =
         GeneratorAdapter::template CreateGenerator<keyvi::dictionary::fsa::internal::SparseArrayPersistence<uint16_t>>(
-            size_of_keys_, params_, value_store_);
+            size_of_keys_, GetGeneratorParams(number_of_items), value_store_);
+
+    MergeChunks(
+        &segments_pqueue,
+        [this](std::string&& key, const fsa::ValueHandle& handle) { generator_->Add(std::move(key), handle); },
+        [&]() {
+          ++added_key_values;
+          if (progress_callback && (added_key_values % callback_trigger == 0)) {
+            progress_callback(added_key_values, number_of_items, user_data);
+          }
+        });
 
-    std::string top_key;
-    while (!segments_pqueue.empty()) {
-      auto segment_it = segments_pqueue.top();
-      segments_pqueue.pop();
+    // free up disk space as early as possible
+    boost::filesystem::remove_all(temporary_directory_);
+    chunk_ = 0;
+    generator_->CloseFeeding();
+  }
 
-      top_key = segment_it.entryIterator().GetKey();
+  /**
+   * Split the keys by leading byte into ranges with about the same number of keys.
+   *
+   * @return the first leading byte of every partition, less than 2 partitions if the compile is not partitioned
+   */
+  std::vector<size_t> GetPartitions() const {
+    std::vector<size_t> partitions;
+    if (parallel_compile_ < 2) {
+      return partitions;
+    }
 
-      // check for same keys and merge only the most recent one
-      while (!segments_pqueue.empty() && segments_pqueue.top().entryIterator().operator==(top_key)) {
-        auto to_inc = segments_pqueue.top();
+    const size_t number_of_keys =
+        std::accumulate(leading_byte_counts_.begin(), leading_byte_counts_.end(), static_cast<size_t>(0));
+    size_t keys_in_partitions = 0;
 
-        segments_pqueue.pop();
-        if (++to_inc) {
-          TRACE("push iterator");
-          segments_pqueue.push(to_inc);
-        }
+    for (size_t c = 0; c < leading_byte_counts_.size(); ++c) {
+      if (leading_byte_counts_[c] == 0) {
+        continue;
+      }
 
-        ++added_key_values;
-        if (progress_callback && (added_key_values % callback_trigger == 0)) {
-          progress_callback(added_key_values, number_of_items, user_data);
-        }
+      // start a new partition once the previous ones got their share
+      if (keys_in_partitions * parallel_compile_ >= number_of_keys * partitions.size()) {
+        partitions.push_back(c);
       }
-      fsa::ValueHandle handle;
-      handle.no_minimization_ = false;
+      keys_in_partitions += leading_byte_counts_[c];
+    }
 
-      // get the weight value, for now simple: does not require access to the
-      // value store itself
-      handle.weight_ = value_store_->GetMergeWeight(segment_it.entryIterator().GetValueId());
-      handle.value_idx_ = segment_it.entryIterator().GetValueId();
+    return partitions;
+  }
 
-      TRACE("Add key: %s", top_key.c_str());
-      generator_->Add(std::move(top_key), handle);
+  /**
+   * Compile the partitions in parallel, each into a minimized automaton, and add them to a common start state.
+   *
+   * @param partitions the first leading byte of every partition
+   */
+  inline void CompilePartitioned(const std::vector<size_t>& partitions, callback_t progress_callback = nullptr,
+                                 void* user_data = nullptr) {
+    std::vector<fsa::automata_t> chunks;
 
-      if (++segment_it) {
-        segments_pqueue.push(segment_it);
+    if (chunk_ == 0) {
+      Sort();
+      boost::filesystem::create_directory(temporary_directory_);
+    } else {
+      // create the last chunk
+      if (key_values_.size() > 0) {
+        CreateChunk();
+      }
+
+      for (size_t i = 0; i < chunk_; ++i) {
+        boost::filesystem::path filename(temporary_directory_);
+        filename /= "fsa_";
+        filename += std::to_string(i);
+        chunks.emplace_back(new fsa::Automata(filename.string()));
       }
-      ++added_key_values;
-      if (progress_callback && (added_key_values % callback_trigger == 0)) {
+    }
+    partitions_ = partitions.size();
+
+    // every partition gets its share of the memory
+    keyvi::util::parameters_t params(params_);
+    params[MEMORY_LIMIT_KEY] = std::to_string(std::max(memory_limit_ / partitions.size(), size_t(1024 * 1024)));
+
+    // the keys get hashed for the key filter while compiling the partitions
+    std::vector<std::vector<uint64_t>> key_hashes(partitions.size());
+
+    keyvi::util::ThreadPool::Shared().ParallelFor(partitions.size(), [&](const size_t i) {
+      const size_t end = i + 1 < partitions.size() ? partitions[i + 1] : leading_byte_counts_.size();
+
+      if (size_of_keys_ > UINT32_MAX) {
+        key_hashes[i] = CompilePartition<uint64_t>(i, partitions[i], end, chunks, params);
+      } else {
+        key_hashes[i] = CompilePartition<uint32_t>(i, partitions[i], end, chunks, params);
+      }
+    });
+
+    key_values_.clear();
+    chunks.clear();
+
+    std::vector<fsa::automata_t> partition_fsas;
+    size_t number_of_items = 0;
+    for (size_t i = 0; i < partitions.size(); ++i) {
+      partition_fsas.emplace_back(new fsa::Automata(GetPartitionFilename(i).string()));
+      number_of_items += partition_fsas.back()->GetNumberOfKeys();
+    }
+
+    generator_ =
+        GeneratorAdapter::template CreateGenerator<keyvi::dictionary::fsa::internal::SparseArrayPersistence<uint16_t>>(
+            size_of_keys_, GetGeneratorParams(number_of_items), value_store_);
+
+    size_t added_key_values = 0;
+    for (size_t i = 0; i < partition_fsas.size(); ++i) {
+      fsa::automata_t& partition_fsa = partition_fsas[i];
+      generator_->AddPartition(partition_fsa, std::move(key_hashes[i]));
+      added_key_values += partition_fsa->GetNumberOfKeys();
+      partition_fsa.reset();
+
+      if (progress_callback) {
         progress_callback(added_key_values, number_of_items, user_data);
       }
     }
@@ -372,9 +470,147 @@ class DictionaryCompiler final {
     // free up disk space as early as possible
     boost::filesystem::remove_all(temporary_directory_);
     chunk_ = 0;
+    partitions_ = 0;
     generator_->CloseFeeding();
   }
 
+  /**
+   * Compile the keys with a leading byte in [begin, end) into a minimized automaton, values are kept as value ids.
+   *
+   * @return the hashes of the keys for the key filter, empty if no key filter gets built
+   */
+  template <class OffsetTypeT>
+  std::vector<uint64_t> CompilePartition(const size_t partition, const size_t begin, const size_t end,
+                                         const std::vector<fsa::automata_t>& chunks,
+                                         const keyvi::util::parameters_t& params) const {
+    fsa::Generator<keyvi::dictionary::fsa::internal::SparseArrayPersistence<uint16_t>, fsa::internal::NullValueStore,
+                   OffsetTypeT, int32_t>
+        generator(params);
+
+    if (chunks.empty()) {
+      const auto first = std::partition_point(key_values_.begin(), key_values_.end(), [begin](const key_value_t& kv) {
+        return kv.key.empty() || static_cast<unsigned char>(kv.key[0]) < begin;
+      });
+      const auto last = std::partition_point(first, key_values_.end(), [end](const key_value_t& kv) {
+        return static_cast<unsigned char>(kv.key[0]) < end;
+      });
+
+      for (auto it = first; it != last; ++it) {
+        generator.Add(it->key, it->value);
+      }
+    } else {
+      std::string key;
+      for (size_t c = begin; c < end; ++c) {
+        std::priority_queue<fsa::SegmentIterator> segments_pqueue;
+        bool leading_byte_is_key = false;
+        uint64_t leading_byte_value_idx = 0;
+
+        for (size_t i = 0; i < chunks.size(); ++i) {
+          if (chunks[i]->Empty()) {
+            continue;
+          }
+
+          const uint64_t state =
+              chunks[i]->TryWalkTransition(chunks[i]->GetStartState(), static_cast<unsigned char>(c));
+          if (state == 0) {
+            continue;
+          }
+
+          // the key consisting of just the leading byte, the most recent chunk wins
+          if (chunks[i]->IsFinalState(state)) {
+            leading_byte_is_key = true;
+            leading_byte_value_idx = chunks[i]->GetStateValue(state);
+          }
+
+          fsa::SegmentIterator segment_it(fsa::EntryIterator(chunks[i], state), i);
+          if (segment_it) {
+            segments_pqueue.push(segment_it);
+          }
+        }
+
+        key.assign(1, static_cast<char>(c));
+        if (leading_byte_is_key) {
+          generator.Add(key, CreateMergeValueHandle(leading_byte_value_idx));
+        }
+
+        // the iterators return the keys without the leading byte
+        MergeChunks(
+            &segments_pqueue,
+            [&key, &generator](std::string&& suffix, const fsa::ValueHandle& handle) {
+              key.resize(1);
+              key += suffix;
+              generator.Add(key, handle);
+            },
+            []() {});
+      }
+    }
+
+    std::vector<uint64_t> key_hashes = generator.ReleaseKeyHashes();
+    generator.CloseFeeding();
+    generator.WriteToFile(GetPartitionFilename(partition).string());
+    return key_hashes;
+  }
+
+  boost::filesystem::path GetPartitionFilename(const size_t partition) const {
+    boost::filesystem::path filename(temporary_directory_);
+    filename /= "partition_";
+    filename += std::to_string(partition);
+    return filename;
+  }
+
+  /**
+   * Merge the keys of several chunks in order, for equal keys the value of the most recent chunk wins.
+   *
+   * @param segments_pqueue iterators of the chunks
+   * @param add_key called with every key to keep and its value handle
+   * @param count_key called for every key taken from a chunk, including the ones that got replaced
+   */
+  template <typename AddKeyT, typename CountKeyT>
+  void MergeChunks(std::priority_queue<fsa::SegmentIterator>* segments_pqueue, AddKeyT add_key,
+                   CountKeyT count_key) const {
+    std::string top_key;
+    while (!segments_pqueue->empty()) {
+      auto segment_it = segments_pqueue->top();
+      segments_pqueue->pop();
+
+      top_key = segment_it.entryIterator().GetKey();
+
+      // check for same keys and merge only the most recent one
+      while (!segments_pqueue->empty() && segments_pqueue->top().entryIterator().operator==(top_key)) {
+        auto to_inc = segments_pqueue->top();
+
+        segments_pqueue->pop();
+        if (++to_inc) {
+          TRACE("push iterator");
+          segments_pqueue->push(to_inc);
+        }
+        count_key();
+      }
+
+      TRACE("Add key: %s", top_key.c_str());
+      add_key(std::move(top_key), CreateMergeValueHandle(segment_it.entryIterator().GetValueId()));
+
+      if (++segment_it) {
+        segments_pqueue->push(segment_it);
+      }
+      count_key();
+    }
+  }
+
+  /**
+   * Create a handle for a value that is already in the value store, e.g. a value of a chunk.
+   */
+  fsa::ValueHandle CreateMergeValueHandle(const uint64_t value_idx) const {
+    fsa::ValueHandle handle;
+    handle.no_minimization_ = false;
+
+    // get the weight value, for now simple: does not require access to the
+    // value store itself
+    handle.weight_ = value_store_->GetMergeWeight(value_idx);
+    handle.value_idx_ = value_idx;
+    return handle;
+  }
+
   /**
    * Register a value before inserting the key(for optimization purposes).
    *
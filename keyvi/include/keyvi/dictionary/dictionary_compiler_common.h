@@ -20,6 +20,7 @@
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "keyvi/dictionary/fsa/generator.h"
@@ -37,6 +38,8 @@ struct key_value_pair {
 
   key_value_pair(const KeyT& k, const ValueT& v) : key(k), value(v) {}
 
+  key_value_pair(KeyT&& k, const ValueT& v) : key(std::move(k)), value(v) {}
+
   bool operator<(const key_value_pair kv) const { return key < kv.key; }
 
   bool operator==(const key_value_pair other) const {
@@ -112,6 +112,17 @@ class DictionaryIndexCompiler final {
     key_values_.push_back(key_value_t(input_key, RegisterValue(value)));
   }
 
+  void Add(std::string&& input_key, typename ValueStoreT::value_t value = ValueStoreT::no_value) {
+    if (generator_) {
+      throw compiler_exception("You're not supposed to add more data once compilation is done!");
+    }
+
+    size_of_keys_ += input_key.size();
+
+    memory_estimate_ += EstimateMemory(input_key);
+    key_values_.push_back(key_value_t(std::move(input_key), RegisterValue(value)));
+  }
+
   void Delete(const std::string& input_key) {
     fsa::ValueHandle handle(0,      // offset of value
                             0,      // weight
@@ -136,7 +147,7 @@ class DictionaryIndexCompiler final {
 
     generator_ =
         GeneratorAdapter::template CreateGenerator<keyvi::dictionary::fsa::internal::SparseArrayPersistence<uint16_t>>(
-            size_of_keys_, params_, value_store_);
+            size_of_keys_, GetGeneratorParams(key_values_.size()), value_store_);
 
     // special mode for stable (incremental) inserts, in this case we have
     // to respect the order and take
@@ -219,6 +230,15 @@ class DictionaryIndexCompiler final {
   size_t size_of_keys_ = 0;
   size_t parallel_sort_threshold_;
 
+  /**
+   * Parameters of the generator of the final dictionary, the key filter gets sized for the given number of keys.
+   */
+  keyvi::util::parameters_t GetGeneratorParams(const size_t number_of_keys) const {
+    keyvi::util::parameters_t params(params_);
+    params[KEY_FILTER_KEYS_KEY] = std::to_string(number_of_keys);
+    return params;
+  }
+
   inline void Sort() {
     if (key_values_.size() > parallel_sort_threshold_ && parallel_sort_threshold_ != 0) {
       // see gh#215 parallel_stable_sort segfaults
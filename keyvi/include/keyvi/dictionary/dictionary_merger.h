@@ -27,6 +27,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <memory>
@@ -46,6 +47,8 @@
 #include "keyvi/dictionary/fsa/internal/value_store_factory.h"
 #include "keyvi/dictionary/fsa/segment_iterator.h"
 #include "keyvi/util/configuration.h"
+#include "keyvi/util/os_utils.h"
+#include "keyvi/util/rate_limiter.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -86,8 +89,23 @@ class DictionaryMerger final {
     params_[TEMPORARY_PATH_KEY] = keyvi::util::mapGetTemporaryPath(params);
 
     append_merge_ = MERGE_APPEND == keyvi::util::mapGet<std::string>(params_, MERGE_MODE, "");
+
+    const size_t rate_limit = keyvi::util::mapGetMemory(params_, MERGE_RATE_LIMIT_KEY, 0);
+    if (rate_limit > 0) {
+      rate_limiter_ = std::make_shared<keyvi::util::RateLimiter>(rate_limit);
+    }
   }
 
+  /**
+   * Throttle the merge with a rate limiter, e.g. one shared between all merges of an index.
+   *
+   * The merge pays for the bytes of the input files it has processed and for the bytes it writes. The final
+   * compilation after the last key is not throttled, it works in memory and on temporary files.
+   *
+   * @param rate_limiter the rate limiter
+   */
+  void SetRateLimiter(const std::shared_ptr<keyvi::util::RateLimiter>& rate_limiter) { rate_limiter_ = rate_limiter; }
+
   void Add(const std::string& filename) {
     if (std::count(inputFiles_.begin(), inputFiles_.end(), filename)) {
       throw std::invalid_argument("File is added already: " + filename);
@@ -139,7 +157,7 @@ class DictionaryMerger final {
 
   void Merge(const std::string& filename) {
     Merge();
-    generator_->WriteToFile(filename);
+    WriteToFile(filename);
   }
 
   void Merge() {
@@ -156,14 +174,25 @@ class DictionaryMerger final {
       throw merger_exception("not merged yet");
     }
 
-    generator_->Write(stream);
+    if (!rate_limiter_) {
+      generator_->Write(stream);
+      return;
+    }
+
+    keyvi::util::RateLimitedStreamBuffer rate_limited_buffer(stream.rdbuf(), rate_limiter_.get());
+    std::ostream rate_limited_stream(&rate_limited_buffer);
+    generator_->Write(rate_limited_stream);
+    stream.setstate(rate_limited_stream.rdstate());
   }
 
   void WriteToFile(const std::string& filename) {
     if (!generator_) {
       throw merger_exception("not merged yet");
     }
-    generator_->WriteToFile(filename);
+
+    std::ofstream out_stream = keyvi::util::OsUtils::OpenOutFileStream(filename);
+    Write(out_stream);
+    out_stream.close();
   }
 
   const MergeStats& GetStats() const { return stats_; }
@@ -178,6 +207,42 @@ class DictionaryMerger final {
   parameters_t params_;
   std::string manifest_ = std::string();
   MergeStats stats_;
+  std::shared_ptr<keyvi::util::RateLimiter> rate_limiter_;
+  double bytes_per_key_ = 0;
+  size_t keys_unpaid_ = 0;
+
+  /**
+   * Estimate the bytes to read per key, used to pay the rate limiter while iterating, writes are paid when written.
+   */
+  void InitThrottle() {
+    if (!rate_limiter_) {
+      return;
+    }
+
+    size_t bytes = 0;
+    size_t keys = 0;
+    for (size_t i = 0; i < inputFiles_.size(); ++i) {
+      bytes += boost::filesystem::file_size(inputFiles_[i]);
+      keys += dicts_to_merge_[i]->GetNumberOfKeys();
+    }
+
+    bytes_per_key_ = keys > 0 ? static_cast<double>(bytes) / static_cast<double>(keys) : 0;
+    keys_unpaid_ = 0;
+  }
+
+  /**
+   * Pay for processed keys, in batches to keep the overhead low.
+   */
+  void Throttle(const bool final = false) {
+    if (!rate_limiter_) {
+      return;
+    }
+
+    if (++keys_unpaid_ >= 1024 || final) {
+      rate_limiter_->Acquire(static_cast<size_t>(bytes_per_key_ * keys_unpaid_));
+      keys_unpaid_ = 0;
+    }
+  }
 
   size_t GetTotalSparseArraySize() const {
     size_t sparse_array_size_sum = 0;
@@ -187,6 +252,21 @@ class DictionaryMerger final {
     return sparse_array_size_sum;
   }
 
+  /**
+   * Parameters of the generator, the key filter gets sized for all keys of the inputs, deleted and updated ones
+   * included.
+   */
+  parameters_t GetGeneratorParams() const {
+    size_t number_of_keys = 0;
+    for (const auto& fsa : dicts_to_merge_) {
+      number_of_keys += fsa->GetNumberOfKeys();
+    }
+
+    parameters_t params(params_);
+    params[KEY_FILTER_KEYS_KEY] = std::to_string(number_of_keys);
+    return params;
+  }
+
   bool KeyDeleted(size_t segment_index, const std::string& key) {
     if (!deleted_keys_[segment_index].empty() && key == deleted_keys_[segment_index].back()) {
       deleted_keys_[segment_index].pop_back();
@@ -208,13 +288,15 @@ class DictionaryMerger final {
 
     generator_ =
         GeneratorAdapter::template CreateGenerator<keyvi::dictionary::fsa::internal::SparseArrayPersistence<uint16_t>>(
-            GetTotalSparseArraySize(), params_, value_store);
+            GetTotalSparseArraySize(), GetGeneratorParams(), value_store);
 
     std::string top_key;
+    InitThrottle();
 
     while (!segments_pqueue_.empty()) {
       auto segment_it = segments_pqueue_.top();
       segments_pqueue_.pop();
+      Throttle();
 
       top_key = segment_it.entryIterator().GetKey();
 
@@ -249,6 +331,7 @@ class DictionaryMerger final {
         segments_pqueue_.push(segment_it);
       }
     }
+    Throttle(true);
     dicts_to_merge_.clear();
     TRACE("finished iterating, do final compile.");
     generator_->CloseFeeding();
@@ -258,13 +341,15 @@ class DictionaryMerger final {
     ValueStoreAppendMergeT* value_store = new ValueStoreAppendMergeT(inputFiles_);
     generator_ =
         GeneratorAdapter::template CreateGenerator<keyvi::dictionary::fsa::internal::SparseArrayPersistence<uint16_t>>(
-            GetTotalSparseArraySize(), params_, value_store);
+            GetTotalSparseArraySize(), GetGeneratorParams(), value_store);
 
     std::string top_key;
+    InitThrottle();
 
     while (!segments_pqueue_.empty()) {
       auto segment_it = segments_pqueue_.top();
       segments_pqueue_.pop();
+      Throttle();
 
       top_key = segment_it.entryIterator().GetKey();
 
@@ -298,6 +383,7 @@ class DictionaryMerger final {
         segments_pqueue_.push(segment_it);
       }
     }
+    Throttle(true);
     dicts_to_merge_.clear();
     TRACE("finished iterating, do final compile.");
     generator_->CloseFeeding();
@@ -317,9 +403,25 @@ class DictionaryMerger final {
     if (deleted_keys_stream.good()) {
       TRACE("found deleted keys file");
 
-      {
+      char magic[KEYVI_FILE_MAGIC_LEN];
+      deleted_keys_stream.read(magic, KEYVI_FILE_MAGIC_LEN);
+
+      if (deleted_keys_stream.gcount() == KEYVI_FILE_MAGIC_LEN &&
+          std::strncmp(magic, KEYVI_FILE_MAGIC, KEYVI_FILE_MAGIC_LEN) == 0) {
+        // key-only dictionary
+        fsa::automata_t deleted_keys_fsa = std::make_shared<fsa::Automata>(deleted_keys_file.string());
+        if (deleted_keys_fsa->GetNumberOfKeys() > 0) {
+          fsa::EntryIterator end_it;
+          for (fsa::EntryIterator it(deleted_keys_fsa); it != end_it; ++it) {
+            deleted_keys.push_back(it.GetKey());
+          }
+        }
+      } else {
+        // old format: msgpack
         // reads the buffer as 1 big chunk, could be improved
         // msgpack v2.x provides a better interface (visitor)
+        deleted_keys_stream.clear();
+        deleted_keys_stream.seekg(0);
         std::stringstream buffer;
         buffer << deleted_keys_stream.rdbuf();
 
@@ -30,6 +30,7 @@
 #include <fstream>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <boost/lexical_cast.hpp>
 
@@ -57,6 +58,8 @@ static const char NUMBER_OF_KEYS_PROPERTY[] = "number_of_keys";
 static const char VALUE_STORE_TYPE_PROPERTY[] = "value_store_type";
 static const char NUMBER_OF_STATES_PROPERTY[] = "number_of_states";
 static const char SIZE_PROPERTY[] = "size";
+static const char ROOT_JUMP_TABLE_PROPERTY[] = "root_jump_table";
+static const char KEY_FILTER_PROPERTY[] = "key_filter";
 
 class DictionaryProperties {
  public:
@@ -68,7 +71,8 @@ class DictionaryProperties {
                        const fsa::internal::value_store_t value_store_type, uint64_t sparse_array_version,
                        const size_t sparse_array_size, const size_t persistence_offset, const size_t transitions_offset,
                        const fsa::internal::ValueStoreProperties& value_store_properties, const std::string& manifest,
-                       const std::string& specialized_dictionary_properties) {
+                       const std::string& specialized_dictionary_properties, const size_t root_jump_table_offset = 0,
+                       const size_t key_filter_offset = 0, const size_t key_filter_size = 0) {
     file_name_ = file_name;
     version_ = version;
     start_state_ = start_state;
@@ -82,6 +86,11 @@ class DictionaryProperties {
     value_store_properties_ = value_store_properties;
     manifest_ = manifest;
     specialized_dictionary_properties_ = specialized_dictionary_properties;
+    root_jump_table_ = root_jump_table_offset != 0;
+    root_jump_table_offset_ = root_jump_table_offset;
+    key_filter_ = key_filter_offset != 0;
+    key_filter_offset_ = key_filter_offset;
+    key_filter_size_ = key_filter_size;
   }
 
   /**
@@ -90,7 +99,8 @@ class DictionaryProperties {
   DictionaryProperties(const uint64_t version, const uint64_t start_state, const uint64_t number_of_keys,
                        const uint64_t number_of_states, const fsa::internal::value_store_t value_store_type,
                        uint64_t sparse_array_version, const size_t sparse_array_size, const std::string& manifest,
-                       const std::string& specialized_dictionary_properties) {
+                       const std::string& specialized_dictionary_properties, const bool root_jump_table = false,
+                       const bool key_filter = false) {
     version_ = version;
     start_state_ = start_state;
     number_of_keys_ = number_of_keys;
@@ -100,6 +110,8 @@ class DictionaryProperties {
     sparse_array_size_ = sparse_array_size;
     manifest_ = manifest;
     specialized_dictionary_properties_ = specialized_dictionary_properties;
+    root_jump_table_ = root_jump_table;
+    key_filter_ = key_filter;
   }
 
   static DictionaryProperties FromFile(const std::string& file_name, const size_t offset = 0) {
@@ -139,10 +151,43 @@ class DictionaryProperties {
   size_t GetTransitionsSize() const { return sparse_array_size_ * 2; }
 
   size_t GetEndOffset() const {
+    if (key_filter_offset_) {
+      return key_filter_offset_ + key_filter_size_;
+    }
+
+    return GetRootJumpTableEndOffset();
+  }
+
+  /**
+   * End of the value store section, equal to the end of the transitions if the value store has no persisted data.
+   */
+  size_t GetValueStoreEndOffset() const {
     return value_store_properties_.GetOffset() ? value_store_properties_.GetOffset() + value_store_properties_.GetSize()
                                                : GetTransitionsOffset() + GetTransitionsSize();
   }
 
+  size_t GetRootJumpTableEndOffset() const {
+    if (root_jump_table_offset_) {
+      return root_jump_table_offset_ + GetRootJumpTableSize();
+    }
+
+    return GetValueStoreEndOffset();
+  }
+
+  /**
+   * Offset of the root jump table, 0 if the dictionary has none.
+   */
+  size_t GetRootJumpTableOffset() const { return root_jump_table_offset_; }
+
+  size_t GetRootJumpTableSize() const { return ROOT_JUMP_TABLE_SIZE * sizeof(uint64_t); }
+
+  /**
+   * Offset of the key filter, 0 if the dictionary has none.
+   */
+  size_t GetKeyFilterOffset() const { return key_filter_offset_; }
+
+  size_t GetKeyFilterSize() const { return key_filter_size_; }
+
   const fsa::internal::ValueStoreProperties& GetValueStoreProperties() const { return value_store_properties_; }
 
   const std::string& GetManifest() const { return manifest_; }
@@ -169,6 +214,14 @@ class DictionaryProperties {
     writer.Uint64(static_cast<uint64_t>(value_store_type_));
     writer.Key(NUMBER_OF_STATES_PROPERTY);
     writer.Uint64(number_of_states_);
+    if (root_jump_table_) {
+      writer.Key(ROOT_JUMP_TABLE_PROPERTY);
+      writer.Uint64(ROOT_JUMP_TABLE_DEPTH);
+    }
+    if (key_filter_) {
+      writer.Key(KEY_FILTER_PROPERTY);
+      writer.Uint64(KEY_FILTER_VERSION);
+    }
     writer.EndObject();
 
     writer.Key("Persistence");
@@ -217,6 +270,16 @@ class DictionaryProperties {
         writer.Key(SPECIALIZED_DICTIONARY_PROPERTY);
         writer.String(specialized_dictionary_properties_);
       }
+      // root jump table, stored after the value store
+      if (root_jump_table_) {
+        writer.Key(ROOT_JUMP_TABLE_PROPERTY);
+        writer.String(std::to_string(ROOT_JUMP_TABLE_DEPTH));
+      }
+      // key filter, stored after the value store and the root jump table
+      if (key_filter_) {
+        writer.Key(KEY_FILTER_PROPERTY);
+        writer.String(std::to_string(KEY_FILTER_VERSION));
+      }
       writer.EndObject();
     }
 
@@ -243,6 +306,58 @@ class DictionaryProperties {
     stream.write(string_buffer.GetString(), string_buffer.GetLength());
   }
 
+  /**
+   * Write the root jump table section, to be called after the value store has been written.
+   *
+   * @param stream the stream to write into
+   * @param root_jump_table table with ROOT_JUMP_TABLE_SIZE states
+   */
+  static void WriteRootJumpTable(std::ostream& stream, const std::vector<uint64_t>& root_jump_table) {
+    rapidjson::StringBuffer string_buffer;
+
+    {
+      rapidjson::Writer<rapidjson::StringBuffer> writer(string_buffer);
+
+      writer.StartObject();
+      writer.Key(SIZE_PROPERTY);
+      writer.String(std::to_string(root_jump_table.size() * sizeof(uint64_t)));
+      writer.EndObject();
+    }
+
+    uint32_t size = htobe32(string_buffer.GetLength());
+    stream.write(reinterpret_cast<const char*>(&size), sizeof(uint32_t));
+    stream.write(string_buffer.GetString(), string_buffer.GetLength());
+
+    for (const uint64_t state : root_jump_table) {
+      const uint64_t state_le = htole64(state);
+      stream.write(reinterpret_cast<const char*>(&state_le), sizeof(uint64_t));
+    }
+  }
+
+  /**
+   * Write the key filter section, to be called after the value store and the root jump table have been written.
+   *
+   * @param stream the stream to write into
+   * @param key_filter the filter, see fsa::internal::KeyFilter
+   */
+  static void WriteKeyFilter(std::ostream& stream, const std::vector<unsigned char>& key_filter) {
+    rapidjson::StringBuffer string_buffer;
+
+    {
+      rapidjson::Writer<rapidjson::StringBuffer> writer(string_buffer);
+
+      writer.StartObject();
+      writer.Key(SIZE_PROPERTY);
+      writer.String(std::to_string(key_filter.size()));
+      writer.EndObject();
+    }
+
+    uint32_t size = htobe32(string_buffer.GetLength());
+    stream.write(reinterpret_cast<const char*>(&size), sizeof(uint32_t));
+    stream.write(string_buffer.GetString(), string_buffer.GetLength());
+    stream.write(reinterpret_cast<const char*>(key_filter.data()), key_filter.size());
+  }
+
  private:
   std::string file_name_;
   uint64_t version_ = 0;
@@ -257,6 +372,11 @@ class DictionaryProperties {
   fsa::internal::ValueStoreProperties value_store_properties_;
   std::string manifest_;
   std::string specialized_dictionary_properties_;
+  bool root_jump_table_ = false;
+  size_t root_jump_table_offset_ = 0;
+  bool key_filter_ = false;
+  size_t key_filter_offset_ = 0;
+  size_t key_filter_size_ = 0;
 
   static DictionaryProperties ReadJsonFormat(const std::string& file_name, std::ifstream& file_stream) {
     rapidjson::Document automata_properties;
@@ -298,6 +418,14 @@ class DictionaryProperties {
       }
     }
 
+    // tables with a different depth are not supported, ignore them
+    const bool root_jump_table = keyvi::util::SerializationUtils::GetOptionalUInt64FromValueOrString(
+                                     automata_properties, ROOT_JUMP_TABLE_PROPERTY, 0) == ROOT_JUMP_TABLE_DEPTH;
+
+    // same for filters of a different version
+    const bool key_filter = keyvi::util::SerializationUtils::GetOptionalUInt64FromValueOrString(
+                                automata_properties, KEY_FILTER_PROPERTY, 0) == KEY_FILTER_VERSION;
+
     rapidjson::Document sparse_array_properties;
     keyvi::util::SerializationUtils::ReadLengthPrefixedJsonRecord(file_stream, &sparse_array_properties);
 
@@ -331,9 +459,49 @@ class DictionaryProperties {
       value_store_properties = fsa::internal::ValueStoreProperties::FromJson(file_stream);
     }
 
+    size_t root_jump_table_offset = 0;
+    size_t section_offset = value_store_properties.GetOffset()
+                                ? value_store_properties.GetOffset() + value_store_properties.GetSize()
+                                : transitions_offset + bucket_size * sparse_array_size;
+
+    if (root_jump_table) {
+      file_stream.seekg(section_offset);
+
+      rapidjson::Document root_jump_table_properties;
+      keyvi::util::SerializationUtils::ReadLengthPrefixedJsonRecord(file_stream, &root_jump_table_properties);
+      root_jump_table_offset = file_stream.tellg();
+
+      // check for file truncation
+      file_stream.seekg(root_jump_table_offset + ROOT_JUMP_TABLE_SIZE * sizeof(uint64_t) - 1);
+      if (file_stream.peek() == EOF) {
+        throw std::invalid_argument("file is corrupt(truncated)");
+      }
+      section_offset = root_jump_table_offset + ROOT_JUMP_TABLE_SIZE * sizeof(uint64_t);
+    }
+
+    size_t key_filter_offset = 0;
+    size_t key_filter_size = 0;
+
+    if (key_filter) {
+      file_stream.seekg(section_offset);
+
+      rapidjson::Document key_filter_properties;
+      keyvi::util::SerializationUtils::ReadLengthPrefixedJsonRecord(file_stream, &key_filter_properties);
+      key_filter_offset = file_stream.tellg();
+      key_filter_size =
+          keyvi::util::SerializationUtils::GetOptionalSizeFromValueOrString(key_filter_properties, SIZE_PROPERTY, 0);
+
+      // check for file truncation
+      file_stream.seekg(key_filter_offset + key_filter_size - 1);
+      if (key_filter_size == 0 || file_stream.peek() == EOF) {
+        throw std::invalid_argument("file is corrupt(truncated)");
+      }
+    }
+
     return DictionaryProperties(file_name, version, start_state, number_of_keys, number_of_states, value_store_type,
                                 sparse_array_version, sparse_array_size, persistence_offset, transitions_offset,
-                                value_store_properties, manifest, specialized_dictionary_properties);
+                                value_store_properties, manifest, specialized_dictionary_properties,
+                                root_jump_table_offset, key_filter_offset, key_filter_size);
   }
 };
 
@@ -0,0 +1,455 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * dictionary_relayout.h
+ *
+ * Rewrite the sparse array of a dictionary for better cache and page locality.
+ */
+
+#ifndef KEYVI_DICTIONARY_DICTIONARY_RELAYOUT_H_
+#define KEYVI_DICTIONARY_DICTIONARY_RELAYOUT_H_
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "keyvi/dictionary/dictionary_properties.h"
+#include "keyvi/dictionary/fsa/automata.h"
+#include "keyvi/dictionary/fsa/internal/constants.h"
+#include "keyvi/dictionary/fsa/internal/sparse_array_builder.h"
+#include "keyvi/dictionary/fsa/internal/sparse_array_persistence.h"
+#include "keyvi/dictionary/fsa/internal/unpacked_state.h"
+#include "keyvi/dictionary/fsa/internal/value_store_types.h"
+#include "keyvi/dictionary/fsa/traversal/traversal_base.h"
+#include "keyvi/util/configuration.h"
+#include "keyvi/util/os_utils.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace dictionary {
+
+/**
+ * Exception class for dictionary relayout
+ */
+struct relayout_exception : public std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+/**
+ * Rewrites the sparse array of a dictionary, so that states which are traversed together end up close to each other.
+ *
+ * The sparse array builder places states by packing opportunity in the order they are created, which scatters the
+ * hot paths of a big dictionary over many pages. The relayout writes all states again: cold states first, hot states
+ * last, so the hot part gets packed densely around the start state. Hotness is taken from an access profile (queries
+ * with counts), without a profile states are ordered by depth (BFS).
+ *
+ * The output uses the same file format, keys, values and the value store are unchanged.
+ *
+ * The state graph (states, their parents and scores) and the access profile are kept in memory and must fit into half
+ * of the memory limit, the other half buffers the new sparse array. Bigger dictionaries are rejected before any work is done.
+ */
+class DictionaryRelayout final {
+  using PersistenceT = fsa::internal::SparseArrayPersistence<uint16_t>;
+  using BuilderT = fsa::internal::SparseArrayBuilder<PersistenceT, uint64_t>;
+
+ public:
+  explicit DictionaryRelayout(const std::string& file_name,
+                              const keyvi::util::parameters_t& params = keyvi::util::parameters_t())
+      : file_name_(file_name),
+        params_(params),
+        properties_(DictionaryProperties::FromFile(file_name)),
+        fsa_(std::make_shared<fsa::Automata>(file_name)) {
+    params_[TEMPORARY_PATH_KEY] = keyvi::util::mapGetTemporaryPath(params);
+  }
+
+  DictionaryRelayout& operator=(DictionaryRelayout const&) = delete;
+  DictionaryRelayout(const DictionaryRelayout& that) = delete;
+
+  /**
+   * Record an access, all states on the path of query get the count added to their hotness.
+   *
+   * @param query the key or prefix that has been looked up
+   * @param count how often it has been looked up
+   */
+  void AddAccess(const std::string& query, const uint64_t count = 1) {
+    uint64_t state = fsa_->GetStartState();
+    size_t depth = 0;
+
+    while (state != 0) {
+      hotness_[state] += count;
+
+      if (depth == query.size()) {
+        break;
+      }
+      state = fsa_->TryWalkTransition(state, query[depth++]);
+    }
+  }
+
+  /**
+   * Read an access profile, either an access trace (one query per line) or a weighted query sample
+   * (query, tab, count).
+   *
+   * @param file_name the profile
+   */
+  void AddAccessProfile(const std::string& file_name) {
+    std::ifstream in_stream(file_name);
+
+    if (!in_stream.good()) {
+      throw relayout_exception("failed to open access profile " + file_name);
+    }
+
+    std::string line;
+    while (std::getline(in_stream, line)) {
+      const size_t tab = line.rfind('\t');
+      uint64_t count = 1;
+
+      // only take it as count if the whole field is a number, otherwise the line is the query
+      if (tab != std::string::npos && tab + 1 < line.size()) {
+        const char* field_end = line.data() + line.size();
+        const auto result = std::from_chars(line.data() + tab + 1, field_end, count);
+        if (result.ec == std::errc() && result.ptr == field_end) {
+          line.resize(tab);
+        } else {
+          count = 1;
+        }
+      }
+
+      AddAccess(line, count);
+    }
+  }
+
+  /**
+   * Rewrite the sparse array.
+   */
+  void Relayout() {
+    if (persistence_) {
+      throw relayout_exception("relayout already done");
+    }
+
+    const size_t memory_limit = keyvi::util::mapGetMemory(params_, MEMORY_LIMIT_KEY, DEFAULT_MEMORY_LIMIT_GENERATOR);
+    const size_t state_graph_memory = GetStateGraphMemory();
+    if (state_graph_memory > memory_limit / 2) {
+      throw relayout_exception("relayout of " + file_name_ + " requires a memory limit of at least " +
+                               std::to_string(2 * state_graph_memory) + " bytes");
+    }
+
+    persistence_.reset(new PersistenceT(memory_limit / 2, params_[TEMPORARY_PATH_KEY]));
+
+    // no minimization needed, all states are unique already
+    builder_.reset(new BuilderT(memory_limit / 10, persistence_.get(), HasInnerWeights(), false));
+
+    if (fsa_->GetStartState() == 0) {
+      persistence_->Flush();
+      return;
+    }
+
+    CollectStates();
+
+    // Kahn's algorithm in reverse: a state can be written once all its children are written, as the transitions
+    // point to them. Of all states ready to be written take the coldest, so hot states end up together near the
+    // start state, which is written last. Ties are broken by the old offset to keep the original locality.
+    using entry_t = std::tuple<uint64_t, uint64_t, size_t>;
+    std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> ready;
+
+    for (size_t i = 0; i < states_.size(); ++i) {
+      if (pending_children_[i] == 0) {
+        ready.emplace(scores_[i], states_[i], i);
+      }
+    }
+
+    new_offsets_.assign(states_.size(), 0);
+    fsa::internal::UnpackedState<PersistenceT> unpacked_state(persistence_.get());
+    fsa::traversal::TraversalState<> traversal_state;
+    fsa::traversal::TraversalPayload<> payload;
+
+    while (!ready.empty()) {
+      const size_t i = std::get<2>(ready.top());
+      ready.pop();
+
+      unpacked_state.Clear();
+      fsa_->GetOutGoingTransitions(states_[i], &traversal_state, &payload);
+
+      for (const auto& transition : traversal_state.traversal_state_payload.transitions) {
+        unpacked_state.Add(transition.label, new_offsets_[GetIndex(transition.state)]);
+      }
+
+      if (fsa_->IsFinalState(states_[i])) {
+        unpacked_state.AddFinalState(fsa_->GetStateValue(states_[i]));
+      }
+
+      if (HasInnerWeights()) {
+        unpacked_state.UpdateWeightIfHigher(fsa_->GetInnerWeight(states_[i]));
+      }
+
+      unpacked_state.IncrementNoMinimizationCounter();
+      new_offsets_[i] = builder_->PersistState(&unpacked_state);
+
+      for (size_t e = parents_begin_[i]; e < parents_begin_[i + 1]; ++e) {
+        const size_t parent = parents_[e];
+        if (--pending_children_[parent] == 0) {
+          ready.emplace(scores_[parent], states_[parent], parent);
+        }
+      }
+    }
+
+    start_state_ = new_offsets_[0];
+
+    if (properties_.GetRootJumpTableOffset()) {
+      BuildRootJumpTable();
+    }
+
+    persistence_->Flush();
+
+    // free memory, states and their new offsets are kept for GetNewOffset
+    scores_ = std::vector<uint64_t>();
+    pending_children_ = std::vector<uint16_t>();
+    parents_ = std::vector<size_t>();
+    parents_begin_ = std::vector<size_t>();
+  }
+
+  /**
+   * Write the relayouted dictionary into the given stream.
+   *
+   * @param stream The stream to write into.
+   */
+  void Write(std::ostream& stream) {
+    if (!persistence_) {
+      throw relayout_exception("relayout not done yet");
+    }
+
+    stream << KEYVI_FILE_MAGIC;
+
+    DictionaryProperties p(properties_.GetVersion(), start_state_, properties_.GetNumberOfKeys(),
+                           builder_->GetNumberOfStates(), properties_.GetValueStoreType(), persistence_->GetVersion(),
+                           persistence_->GetSize(), properties_.GetManifest(),
+                           properties_.GetSpecializedDictionaryProperties(), root_jump_table_states_.size() > 0,
+                           properties_.GetKeyFilterOffset() != 0);
+    p.WriteAsJsonV2(stream);
+
+    persistence_->Write(stream);
+
+    // the value store is not touched, copy it as is
+    const size_t value_store_begin = properties_.GetTransitionsOffset() + properties_.GetTransitionsSize();
+    const size_t value_store_end = properties_.GetValueStoreEndOffset();
+
+    if (value_store_end > value_store_begin) {
+      std::ifstream in_stream(file_name_, std::ios::binary);
+      in_stream.seekg(value_store_begin);
+
+      std::vector<char> buffer(1024 * 1024);
+      size_t remaining = value_store_end - value_store_begin;
+      while (remaining > 0) {
+        const size_t chunk = std::min(remaining, buffer.size());
+        if (!in_stream.read(buffer.data(), chunk)) {
+          throw relayout_exception("failed to read value store from " + file_name_);
+        }
+        stream.write(buffer.data(), chunk);
+        remaining -= chunk;
+      }
+    }
+
+    if (root_jump_table_states_.size() > 0) {
+      DictionaryProperties::WriteRootJumpTable(stream, root_jump_table_states_);
+    }
+
+    // the key filter only depends on the keys, copy it as is
+    if (properties_.GetKeyFilterOffset()) {
+      std::ifstream in_stream(file_name_, std::ios::binary);
+      in_stream.seekg(properties_.GetKeyFilterOffset());
+
+      std::vector<unsigned char> key_filter(properties_.GetKeyFilterSize());
+      if (!in_stream.read(reinterpret_cast<char*>(key_filter.data()), key_filter.size())) {
+        throw relayout_exception("failed to read key filter from " + file_name_);
+      }
+      DictionaryProperties::WriteKeyFilter(stream, key_filter);
+    }
+  }
+
+  void WriteToFile(const std::string& file_name) {
+    std::ofstream out_stream = keyvi::util::OsUtils::OpenOutFileStream(file_name);
+
+    Write(out_stream);
+    out_stream.close();
+  }
+
+  /**
+   * Get the new offset of a state of the input dictionary, 0 if unknown. Only valid after Relayout.
+   */
+  uint64_t GetNewOffset(const uint64_t state) const {
+    const auto it = std::lower_bound(states_by_offset_.begin(), states_by_offset_.end(), state,
+                                     [this](const size_t i, const uint64_t offset) { return states_[i] < offset; });
+    return it != states_by_offset_.end() && states_[*it] == state ? new_offsets_[*it] : 0;
+  }
+
+ private:
+  std::string file_name_;
+  keyvi::util::parameters_t params_;
+  DictionaryProperties properties_;
+  fsa::automata_t fsa_;
+  std::unordered_map<uint64_t, uint64_t> hotness_;
+
+  // states in BFS order, index 0 is the start state
+  std::vector<uint64_t> states_;
+  // indexes into states_, ordered by offset
+  std::vector<size_t> states_by_offset_;
+  std::vector<uint64_t> scores_;
+  // number of transitions of every state, at most 256 plus the final state
+  std::vector<uint16_t> pending_children_;
+  // the parents of every state in CSR form
+  std::vector<size_t> parents_;
+  std::vector<size_t> parents_begin_;
+
+  std::vector<uint64_t> new_offsets_;
+  std::unique_ptr<PersistenceT> persistence_;
+  std::unique_ptr<BuilderT> builder_;
+  uint64_t start_state_ = 0;
+  std::vector<uint64_t> root_jump_table_states_;
+
+  bool HasInnerWeights() const {
+    return properties_.GetValueStoreType() == fsa::internal::value_store_t::INT_WITH_WEIGHTS;
+  }
+
+  /**
+   * Upper bound of the memory needed for the state graph, every transition takes a slot in the sparse array.
+   *
+   * The hotness map is counted as it is, it is freed once turned into scores.
+   */
+  size_t GetStateGraphMemory() const {
+    // states_, states_by_offset_, scores_, new_offsets_, pending_children_, parents_begin_, depths or fill positions
+    // and the queue
+    const size_t bytes_per_state = 8 + 8 + 8 + 8 + 2 + 8 + 8 + 24;
+    const size_t number_of_transitions = properties_.GetSparseArraySize();
+
+    // a hash map node holds the next pointer besides key and value
+    const size_t hotness_memory = hotness_.size() * (sizeof(decltype(hotness_)::value_type) + sizeof(void*)) +
+                                  hotness_.bucket_count() * sizeof(void*);
+
+    // parents_ and the visited bit vector
+    return properties_.GetNumberOfStates() * bytes_per_state + number_of_transitions * sizeof(size_t) +
+           number_of_transitions / 8 + hotness_memory;
+  }
+
+  size_t GetIndex(const uint64_t state) const {
+    return *std::lower_bound(states_by_offset_.begin(), states_by_offset_.end(), state,
+                             [this](const size_t i, const uint64_t offset) { return states_[i] < offset; });
+  }
+
+  void CollectStates() {
+    std::vector<uint32_t> depths;
+    std::vector<bool> visited(properties_.GetSparseArraySize() + 1);
+    fsa::traversal::TraversalState<> traversal_state;
+    fsa::traversal::TraversalPayload<> payload;
+
+    states_.reserve(properties_.GetNumberOfStates());
+    states_.push_back(fsa_->GetStartState());
+    depths.push_back(0);
+    visited[fsa_->GetStartState()] = true;
+
+    // BFS, states_ is the queue
+    for (size_t i = 0; i < states_.size(); ++i) {
+      fsa_->GetOutGoingTransitions(states_[i], &traversal_state, &payload);
+      pending_children_.push_back(static_cast<uint16_t>(traversal_state.traversal_state_payload.transitions.size()));
+
+      for (const auto& transition : traversal_state.traversal_state_payload.transitions) {
+        if (!visited[transition.state]) {
+          visited[transition.state] = true;
+          states_.push_back(transition.state);
+          depths.push_back(depths[i] + 1);
+        }
+      }
+    }
+
+    states_by_offset_.resize(states_.size());
+    for (size_t i = 0; i < states_.size(); ++i) {
+      states_by_offset_[i] = i;
+    }
+    std::sort(states_by_offset_.begin(), states_by_offset_.end(),
+              [this](const size_t a, const size_t b) { return states_[a] < states_[b]; });
+
+    TRACE("collected %d states", states_.size());
+
+    // the higher the score, the later the state gets written
+    const uint32_t max_depth = depths.back();
+    scores_.resize(states_.size());
+    for (size_t i = 0; i < states_.size(); ++i) {
+      if (hotness_.empty()) {
+        scores_[i] = max_depth - depths[i];
+      } else {
+        const auto it = hotness_.find(states_[i]);
+        scores_[i] = it != hotness_.end() ? it->second : 0;
+      }
+    }
+    depths = std::vector<uint32_t>();
+    hotness_ = decltype(hotness_)();
+
+    // count the parents of every state, then fill them in a second pass
+    parents_begin_.assign(states_.size() + 1, 0);
+    for (size_t i = 0; i < states_.size(); ++i) {
+      fsa_->GetOutGoingTransitions(states_[i], &traversal_state, &payload);
+      for (const auto& transition : traversal_state.traversal_state_payload.transitions) {
+        ++parents_begin_[GetIndex(transition.state) + 1];
+      }
+    }
+    for (size_t i = 0; i < states_.size(); ++i) {
+      parents_begin_[i + 1] += parents_begin_[i];
+    }
+
+    parents_.resize(parents_begin_.back());
+    std::vector<size_t> fill(parents_begin_.begin(), parents_begin_.end() - 1);
+    for (size_t i = 0; i < states_.size(); ++i) {
+      fsa_->GetOutGoingTransitions(states_[i], &traversal_state, &payload);
+      for (const auto& transition : traversal_state.traversal_state_payload.transitions) {
+        parents_[fill[GetIndex(transition.state)]++] = i;
+      }
+    }
+  }
+
+  void BuildRootJumpTable() {
+    root_jump_table_states_.assign(ROOT_JUMP_TABLE_SIZE, 0);
+
+    for (size_t first = 0; first < 256; ++first) {
+      const uint64_t state = fsa_->TryWalkTransition(fsa_->GetStartState(), static_cast<unsigned char>(first));
+      if (state == 0) {
+        continue;
+      }
+
+      for (size_t second = 0; second < 256; ++second) {
+        const uint64_t next_state = fsa_->TryWalkTransition(state, static_cast<unsigned char>(second));
+        if (next_state != 0) {
+          root_jump_table_states_[(first << 8) | second] = GetNewOffset(next_state);
+        }
+      }
+    }
+  }
+};
+
+} /* namespace dictionary */
+} /* namespace keyvi */
+
+#endif  // KEYVI_DICTIONARY_DICTIONARY_RELAYOUT_H_
@@ -25,8 +25,10 @@
 #ifndef KEYVI_DICTIONARY_FSA_AUTOMATA_H_
 #define KEYVI_DICTIONARY_FSA_AUTOMATA_H_
 
+#include <cstring>
 #include <memory>
 #include <string>
+#include <string_view>
 
 #include <boost/filesystem.hpp>
 #include <boost/interprocess/file_mapping.hpp>
@@ -35,8 +37,11 @@
 #include "keyvi/dictionary/dictionary_merger_fwd.h"
 #include "keyvi/dictionary/dictionary_properties.h"
 #include "keyvi/dictionary/fsa/internal/constants.h"
+#include "keyvi/dictionary/fsa/internal/huge_page_region.h"
 #include "keyvi/dictionary/fsa/internal/intrinsics.h"
+#include "keyvi/dictionary/fsa/internal/key_filter.h"
 #include "keyvi/dictionary/fsa/internal/memory_map_flags.h"
+#include "keyvi/dictionary/fsa/internal/outgoing_transitions.h"
 #include "keyvi/dictionary/fsa/internal/value_store_factory.h"
 #include "keyvi/dictionary/fsa/traversal/traversal_base.h"
 #include "keyvi/dictionary/fsa/traversal/weighted_traversal.h"
@@ -53,27 +58,6 @@ class SecondaryKeyDictionary;
 
 namespace fsa {
 
-/**
- * Lookup table to find outgoing transitions quickly(in parallel) by xor'ing the
- * real buffer with this table.
- * (also used for the intrinsic(SSE 4.2) based implementation)
- */
-static unsigned char OUTGOING_TRANSITIONS_MASK[256] = {
-    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12,
-    0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25,
-    0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38,
-    0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b,
-    0x4c, 0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e,
-    0x5f, 0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71,
-    0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f, 0x80, 0x81, 0x82, 0x83, 0x84,
-    0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f, 0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
-    0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f, 0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa,
-    0xab, 0xac, 0xad, 0xae, 0xaf, 0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd,
-    0xbe, 0xbf, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf, 0xd0,
-    0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf, 0xe0, 0xe1, 0xe2, 0xe3,
-    0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef, 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6,
-    0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
-
 /// TODO: refactor (split) class Automata, so there is no need for param "loadVS" and friend classes
 class Automata final {
  public:
@@ -90,7 +74,8 @@ class Automata final {
  private:
   explicit Automata(const dictionary_properties_t& dictionary_properties, loading_strategy_types loading_strategy,
                     const bool load_value_store)
-      : dictionary_properties_(dictionary_properties) {
+      : dictionary_properties_(dictionary_properties),
+        outgoing_transitions_kernel_(internal::GetOutgoingTransitionsKernel()) {
     boost::interprocess::file_mapping file_mapping = boost::interprocess::file_mapping(
         dictionary_properties_->GetFileName().c_str(), boost::interprocess::read_only);
 
@@ -114,9 +99,46 @@ class Automata final {
     labels_region_.advise(advise);
     transitions_region_.advise(advise);
 
+    if (internal::MemoryMapFlags::FSAUseHugePages(loading_strategy)) {
+      internal::MemoryMapFlags::AdviseHugePages(labels_region_);
+      internal::MemoryMapFlags::AdviseHugePages(transitions_region_);
+    }
+
+    if (dictionary_properties_->GetRootJumpTableOffset()) {
+      TRACE("root jump table start offset: %d", dictionary_properties_->GetRootJumpTableOffset());
+      root_jump_table_region_ = boost::interprocess::mapped_region(
+          file_mapping, boost::interprocess::read_only,
+          static_cast<boost::interprocess::offset_t>(dictionary_properties_->GetRootJumpTableOffset()),
+          dictionary_properties_->GetRootJumpTableSize(), nullptr, map_options);
+      root_jump_table_region_.advise(advise);
+      root_jump_table_ = static_cast<const unsigned char*>(root_jump_table_region_.get_address());
+    }
+
+    if (dictionary_properties_->GetKeyFilterOffset()) {
+      TRACE("key filter start offset: %d", dictionary_properties_->GetKeyFilterOffset());
+      key_filter_region_ = boost::interprocess::mapped_region(
+          file_mapping, boost::interprocess::read_only,
+          static_cast<boost::interprocess::offset_t>(dictionary_properties_->GetKeyFilterOffset()),
+          dictionary_properties_->GetKeyFilterSize(), nullptr, map_options);
+      key_filter_region_.advise(advise);
+      key_filter_ = internal::KeyFilter(static_cast<const unsigned char*>(key_filter_region_.get_address()),
+                                        dictionary_properties_->GetKeyFilterSize());
+    }
+
     labels_ = static_cast<unsigned char*>(labels_region_.get_address());
     transitions_compact_ = static_cast<uint16_t*>(transitions_region_.get_address());
 
+    if (internal::MemoryMapFlags::FSACopyToHugePages(loading_strategy)) {
+      labels_copy_ = internal::HugePageRegion(labels_, labels_region_.get_size());
+      transitions_copy_ = internal::HugePageRegion(transitions_compact_, transitions_region_.get_size());
+      labels_ = static_cast<unsigned char*>(labels_copy_.get_address());
+      transitions_compact_ = static_cast<uint16_t*>(transitions_copy_.get_address());
+
+      // the file mappings are not needed anymore
+      labels_region_ = boost::interprocess::mapped_region();
+      transitions_region_ = boost::interprocess::mapped_region();
+    }
+
     if (load_value_store) {
       value_store_reader_.reset(
           internal::ValueStoreFactory::MakeReader(dictionary_properties_->GetValueStoreType(), &file_mapping,
@@ -141,6 +163,8 @@ class Automata final {
 
   uint64_t GetNumberOfKeys() const { return dictionary_properties_->GetNumberOfKeys(); }
 
+  uint64_t GetNumberOfStates() const { return dictionary_properties_->GetNumberOfStates(); }
+
   bool Empty() const { return 0 == GetNumberOfKeys(); }
 
   size_t SparseArraySize() const { return dictionary_properties_->GetSparseArraySize(); }
@@ -154,6 +178,54 @@ class Automata final {
     return 0;
   }
 
+  /**
+   * Jump over the first bytes of a key using the root jump table, if state is the start state and the dictionary
+   * has been compiled with a root jump table. Saves the dependent memory accesses of the first transitions.
+   *
+   * @param state the state to start from
+   * @param key the key to walk
+   * @param depth position in key, gets forwarded by the number of bytes jumped over
+   * @return the state after the jump, 0 if the key has no such prefix, state if no jump was possible
+   */
+  uint64_t TryJumpTransitions(uint64_t state, const std::string& key, size_t* depth) const {
+    if (root_jump_table_ == nullptr || *depth != 0 || key.size() < ROOT_JUMP_TABLE_DEPTH || state != GetStartState()) {
+      return state;
+    }
+
+    const size_t index = (static_cast<size_t>(static_cast<unsigned char>(key[0])) << 8) |
+                         static_cast<unsigned char>(key[1]);
+    uint64_t next_state;
+    std::memcpy(&next_state, root_jump_table_ + index * sizeof(uint64_t), sizeof(uint64_t));
+    *depth = ROOT_JUMP_TABLE_DEPTH;
+
+    return le64toh(next_state);
+  }
+
+  /**
+   * Check the key filter, if state is the start state and the dictionary has been compiled with a key filter.
+   *
+   * @param state the state the key is looked up from
+   * @param key the key
+   * @return false if the key is definitely not in the dictionary, true if it might be
+   */
+  bool MayContain(uint64_t state, const std::string& key) const {
+    if (!key_filter_ || state != GetStartState()) {
+      return true;
+    }
+
+    return key_filter_.MayContain(key);
+  }
+
+  /**
+   * Hint the CPU to load the labels and transitions touched by walking c from the given state.
+   *
+   * Useful to overlap memory access when walking several keys at once.
+   */
+  void PrefetchTransition(uint64_t starting_state, unsigned char c) const {
+    KEYVI_PREFETCH(labels_ + starting_state + c);
+    KEYVI_PREFETCH(transitions_compact_ + starting_state + c);
+  }
+
   /**
    * Get the outgoing states of state quickly in 1 step.
    *
@@ -172,75 +244,18 @@ class Automata final {
     // reset the state
     traversal_state->Clear();
 
-#if defined(KEYVI_SSE42)
-    // Optimized version using SSE4.2, see http://www.strchr.com/strcmp_and_strlen_using_sse_4.2
-
-    __m128i* labels_as_m128 = reinterpret_cast<__m128i*>(labels_ + starting_state);
-    __m128i* mask_as_m128 = reinterpret_cast<__m128i*>(OUTGOING_TRANSITIONS_MASK);
-    unsigned char symbol = 0;
-
-    // check 16 bytes at a time
-    for (int offset = 0; offset < 16; ++offset) {
-      __m128i mask =
-          _mm_cmpestrm(_mm_loadu_si128(labels_as_m128), 16, _mm_loadu_si128(mask_as_m128), 16,
-                       _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_EACH | _SIDD_MASKED_POSITIVE_POLARITY | _SIDD_BIT_MASK);
-
-      uint64_t mask_int = _mm_extract_epi64(mask, 0);
-      TRACE("Bitmask %d", mask_int);
-
-      if (mask_int != 0) {
-        for (auto i = 0; i < 16; ++i) {
-          if ((mask_int & 1) == 1) {
-            TRACE("push symbol+%d", symbol + i);
-            traversal_state->Add(ResolvePointer(starting_state, symbol + i), symbol + i, payload);
-          }
-          mask_int = mask_int >> 1;
-        }
-      }
-
-      ++labels_as_m128;
-      ++mask_as_m128;
-      symbol += 16;
-    }
-#else
-    uint64_t* labels_as_ll = reinterpret_cast<uint64_t*>(labels_ + starting_state);
-    uint64_t* mask_as_ll = reinterpret_cast<uint64_t*>(OUTGOING_TRANSITIONS_MASK);
-    unsigned char symbol = 0;
-
-    // check 8 bytes at a time
-    for (int offset = 0; offset < 32; ++offset) {
-      uint64_t xor_labels_with_mask = *labels_as_ll ^ *mask_as_ll;
+    uint64_t transitions_bitmap[4];
+    outgoing_transitions_kernel_(labels_ + starting_state, transitions_bitmap);
 
-      if (((xor_labels_with_mask & 0x00000000000000ffULL) == 0)) {
+    for (size_t word = 0; word < 4; ++word) {
+      uint64_t bits = transitions_bitmap[word];
+      while (bits) {
+        const unsigned char symbol = static_cast<unsigned char>((word << 6) + internal::CountTrailingZeros(bits));
+        TRACE("push symbol+%d", symbol);
         traversal_state->Add(ResolvePointer(starting_state, symbol), symbol, payload);
+        bits &= bits - 1;
       }
-      if ((xor_labels_with_mask & 0x000000000000ff00ULL) == 0) {
-        traversal_state->Add(ResolvePointer(starting_state, symbol + 1), symbol + 1, payload);
-      }
-      if ((xor_labels_with_mask & 0x0000000000ff0000ULL) == 0) {
-        traversal_state->Add(ResolvePointer(starting_state, symbol + 2), symbol + 2, payload);
-      }
-      if ((xor_labels_with_mask & 0x00000000ff000000ULL) == 0) {
-        traversal_state->Add(ResolvePointer(starting_state, symbol + 3), symbol + 3, payload);
-      }
-      if ((xor_labels_with_mask & 0x000000ff00000000ULL) == 0) {
-        traversal_state->Add(ResolvePointer(starting_state, symbol + 4), symbol + 4, payload);
-      }
-      if ((xor_labels_with_mask & 0x0000ff0000000000ULL) == 0) {
-        traversal_state->Add(ResolvePointer(starting_state, symbol + 5), symbol + 5, payload);
-      }
-      if ((xor_labels_with_mask & 0x00ff000000000000ULL) == 0) {
-        traversal_state->Add(ResolvePointer(starting_state, symbol + 6), symbol + 6, payload);
-      }
-      if ((xor_labels_with_mask & 0xff00000000000000ULL) == 0) {
-        traversal_state->Add(ResolvePointer(starting_state, symbol + 7), symbol + 7, payload);
-      }
-
-      ++labels_as_ll;
-      ++mask_as_ll;
-      symbol += 8;
     }
-#endif
 
     // post, e.g. sort transitions
     TRACE("postprocess transitions");
@@ -258,102 +273,21 @@ class Automata final {
     // reset the state
     traversal_state->Clear();
 
-#if defined(KEYVI_SSE42)
-    // Optimized version using SSE4.2, see http://www.strchr.com/strcmp_and_strlen_using_sse_4.2
-
-    __m128i* labels_as_m128 = reinterpret_cast<__m128i*>(labels_ + starting_state);
-    __m128i* mask_as_m128 = reinterpret_cast<__m128i*>(OUTGOING_TRANSITIONS_MASK);
-    unsigned char symbol = 0;
-
-    // check 16 bytes at a time
-    for (int offset = 0; offset < 16; ++offset) {
-      __m128i mask =
-          _mm_cmpestrm(_mm_loadu_si128(labels_as_m128), 16, _mm_loadu_si128(mask_as_m128), 16,
-                       _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_EACH | _SIDD_MASKED_POSITIVE_POLARITY | _SIDD_BIT_MASK);
-
-      uint64_t mask_int = _mm_extract_epi64(mask, 0);
-      TRACE("Bitmask %d", mask_int);
-
-      if (mask_int != 0) {
-        for (auto i = 0; i < 16; ++i) {
-          if ((mask_int & 1) == 1) {
-            TRACE("push symbol+%d", symbol + i);
-            uint64_t child_state = ResolvePointer(starting_state, symbol + i);
-            uint32_t weight = GetInnerWeight(child_state);
-            weight = weight != 0 ? weight : parent_weight;
-            traversal_state->Add(child_state, weight, symbol + i, payload);
-          }
-          mask_int = mask_int >> 1;
-        }
-      }
-
-      ++labels_as_m128;
-      ++mask_as_m128;
-      symbol += 16;
-    }
-#else
-    uint64_t* labels_as_ll = reinterpret_cast<uint64_t*>(labels_ + starting_state);
-    uint64_t* mask_as_ll = reinterpret_cast<uint64_t*>(OUTGOING_TRANSITIONS_MASK);
-    unsigned char symbol = 0;
+    uint64_t transitions_bitmap[4];
+    outgoing_transitions_kernel_(labels_ + starting_state, transitions_bitmap);
 
-    // check 8 bytes at a time
-    for (int offset = 0; offset < 32; ++offset) {
-      uint64_t xor_labels_with_mask = *labels_as_ll ^ *mask_as_ll;
-
-      if (((xor_labels_with_mask & 0x00000000000000ffULL) == 0)) {
+    for (size_t word = 0; word < 4; ++word) {
+      uint64_t bits = transitions_bitmap[word];
+      while (bits) {
+        const unsigned char symbol = static_cast<unsigned char>((word << 6) + internal::CountTrailingZeros(bits));
+        TRACE("push symbol+%d", symbol);
         uint64_t child_state = ResolvePointer(starting_state, symbol);
         uint32_t weight = GetInnerWeight(child_state);
         weight = weight != 0 ? weight : parent_weight;
         traversal_state->Add(child_state, weight, symbol, payload);
+        bits &= bits - 1;
       }
-      if ((xor_labels_with_mask & 0x000000000000ff00ULL) == 0) {
-        uint64_t child_state = ResolvePointer(starting_state, symbol + 1);
-        uint32_t weight = GetInnerWeight(child_state);
-        weight = weight != 0 ? weight : parent_weight;
-        traversal_state->Add(child_state, weight, symbol + 1, payload);
-      }
-      if ((xor_labels_with_mask & 0x0000000000ff0000ULL) == 0) {
-        uint64_t child_state = ResolvePointer(starting_state, symbol + 2);
-        uint32_t weight = GetInnerWeight(child_state);
-        weight = weight != 0 ? weight : parent_weight;
-        traversal_state->Add(child_state, weight, symbol + 2, payload);
-      }
-      if ((xor_labels_with_mask & 0x00000000ff000000ULL) == 0) {
-        uint64_t child_state = ResolvePointer(starting_state, symbol + 3);
-        uint32_t weight = GetInnerWeight(child_state);
-        weight = weight != 0 ? weight : parent_weight;
-        traversal_state->Add(child_state, weight, symbol + 3, payload);
-      }
-      if ((xor_labels_with_mask & 0x000000ff00000000ULL) == 0) {
-        uint64_t child_state = ResolvePointer(starting_state, symbol + 4);
-        uint32_t weight = GetInnerWeight(child_state);
-        weight = weight != 0 ? weight : parent_weight;
-        traversal_state->Add(child_state, weight, symbol + 4, payload);
-      }
-      if ((xor_labels_with_mask & 0x0000ff0000000000ULL) == 0) {
-        uint64_t child_state = ResolvePointer(starting_state, symbol + 5);
-        uint32_t weight = GetInnerWeight(child_state);
-        weight = weight != 0 ? weight : parent_weight;
-        traversal_state->Add(child_state, weight, symbol + 5, payload);
-      }
-      if ((xor_labels_with_mask & 0x00ff000000000000ULL) == 0) {
-        uint64_t child_state = ResolvePointer(starting_state, symbol + 6);
-        uint32_t weight = GetInnerWeight(child_state);
-        weight = weight != 0 ? weight : parent_weight;
-        traversal_state->Add(child_state, weight, symbol + 6, payload);
-      }
-      if ((xor_labels_with_mask & 0xff00000000000000ULL) == 0) {
-        uint64_t child_state = ResolvePointer(starting_state, symbol + 7);
-        uint32_t weight = GetInnerWeight(child_state);
-        weight = weight != 0 ? weight : parent_weight;
-        traversal_state->Add(child_state, weight, symbol + 7, payload);
-      }
-
-      ++labels_as_ll;
-      ++mask_as_ll;
-      symbol += 8;
     }
-#endif
 
     // post, e.g. sort transitions
     TRACE("postprocess transitions");
@@ -408,6 +342,36 @@ class Automata final {
     return value_store_reader_->GetMsgPackedValueAsString(state_value, compression_algorithm);
   }
 
+  /**
+   * Get the raw value without copying, see IValueStoreReader::GetRawValueAsStringView.
+   *
+   * @return true if supported by the value store, false otherwise
+   */
+  bool GetRawValueAsStringView(uint64_t state_value, std::string_view* raw_value) const {
+    assert(value_store_reader_);
+    return value_store_reader_->GetRawValueAsStringView(state_value, raw_value);
+  }
+
+  /**
+   * Get the msgpack value without copying, see IValueStoreReader::GetMsgPackedValueAsStringView.
+   *
+   * @return true if supported by the value store, false otherwise
+   */
+  bool GetMsgPackedValueAsStringView(uint64_t state_value, std::string_view* msgpacked_value) const {
+    assert(value_store_reader_);
+    return value_store_reader_->GetMsgPackedValueAsStringView(state_value, msgpacked_value);
+  }
+
+  /**
+   * Get the value as string without copying, see IValueStoreReader::GetValueAsStringView.
+   *
+   * @return true if supported by the value store, false otherwise
+   */
+  bool GetValueAsStringView(uint64_t state_value, std::string_view* value) const {
+    assert(value_store_reader_);
+    return value_store_reader_->GetValueAsStringView(state_value, value);
+  }
+
   [[nodiscard]] std::string GetStatistics() const { return dictionary_properties_->GetStatistics(); }
 
   [[nodiscard]] const std::string& GetManifest() const { return dictionary_properties_->GetManifest(); }
@@ -419,8 +383,15 @@ class Automata final {
   std::unique_ptr<internal::IValueStoreReader> value_store_reader_;
   boost::interprocess::mapped_region labels_region_;
   boost::interprocess::mapped_region transitions_region_;
+  boost::interprocess::mapped_region root_jump_table_region_;
+  boost::interprocess::mapped_region key_filter_region_;
+  internal::HugePageRegion labels_copy_;
+  internal::HugePageRegion transitions_copy_;
+  const unsigned char* root_jump_table_ = nullptr;
+  internal::KeyFilter key_filter_;
   unsigned char* labels_;
   uint16_t* transitions_compact_;
+  internal::outgoing_transitions_kernel_t outgoing_transitions_kernel_;
 
   template <keyvi::dictionary::fsa::internal::value_store_t>
   friend class keyvi::dictionary::DictionaryMerger;
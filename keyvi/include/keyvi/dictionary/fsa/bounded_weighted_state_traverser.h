@@ -80,7 +80,7 @@ class BoundedWeightedStateTraverser final {
     other.at_end_ = false;
   }
 
-  automata_t GetFsa() const { return fsa_; }
+  const automata_t& GetFsa() const { return fsa_; }
 
   bool IsFinalState() { return fsa_->IsFinalState(current_state_); }
 
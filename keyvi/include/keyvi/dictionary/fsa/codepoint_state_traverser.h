@@ -70,6 +70,21 @@ class CodePointStateTraverser final {
     other.codepoint_ = 0;
   }
 
+  /**
+   * Restart the traversal, reusing the memory allocated so far.
+   *
+   * @param f the fsa
+   * @param state the state to start from, 0 results in an exhausted traverser
+   */
+  void Reset(automata_t f, uint64_t state) {
+    wrapped_state_traverser_.Reset(f, state, false);
+    transitions_stack_.clear();
+    utf8_length_stack_.clear();
+    codepoint_ = 0;
+    current_depth_ = 0;
+    this->operator++(0);
+  }
+
   void operator++(int) {
     int remaining_bytes = 0;
     do {
@@ -108,7 +123,7 @@ class CodePointStateTraverser final {
     ExtractCodePointFromStack();
   }
 
-  automata_t GetFsa() const { return wrapped_state_traverser_.GetFsa(); }
+  const automata_t& GetFsa() const { return wrapped_state_traverser_.GetFsa(); }
 
   bool IsFinalState() { return wrapped_state_traverser_.IsFinalState(); }
 
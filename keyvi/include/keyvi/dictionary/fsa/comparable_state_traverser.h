@@ -97,6 +97,23 @@ class ComparableStateTraverser final {
   ComparableStateTraverser &operator=(ComparableStateTraverser const &) = delete;
   ComparableStateTraverser(const ComparableStateTraverser &that) = delete;
 
+  /**
+   * Restart the traversal with a new payload, reusing the memory allocated so far.
+   *
+   * @param f the fsa
+   * @param start_state the state to start from, 0 results in an exhausted traverser
+   * @param payload the traversal payload
+   * @param advance whether to move to the first state
+   */
+  void Reset(const automata_t f, const uint64_t start_state, traversal::TraversalPayload<transition_t> &&payload,
+             const bool advance = true) {
+    state_traverser_.Reset(f, start_state, std::move(payload), false);
+    label_stack_.clear();
+    if (advance) {
+      this->operator++(0);
+    }
+  }
+
   /**
    * Comparison of the state traverser for the purpose of ordering them
    */
@@ -143,7 +160,7 @@ class ComparableStateTraverser final {
     }
   }
 
-  automata_t GetFsa() const { return state_traverser_.GetFsa(); }
+  const automata_t& GetFsa() const { return state_traverser_.GetFsa(); }
 
   bool IsFinalState() const { return state_traverser_.IsFinalState(); }
 
@@ -28,12 +28,17 @@
 #include <algorithm>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "keyvi/dictionary/dictionary_properties.h"
+#include "keyvi/dictionary/fsa/automata.h"
+#include "keyvi/dictionary/fsa/entry_iterator.h"
+#include "keyvi/dictionary/fsa/internal/key_filter.h"
 #include "keyvi/dictionary/fsa/internal/null_value_store.h"
 #include "keyvi/dictionary/fsa/internal/sparse_array_builder.h"
 #include "keyvi/dictionary/fsa/internal/unpacked_state.h"
 #include "keyvi/dictionary/fsa/internal/unpacked_state_stack.h"
+#include "keyvi/dictionary/fsa/traversal/traversal_base.h"
 #include "keyvi/util/configuration.h"
 #include "keyvi/util/os_utils.h"
 #include "keyvi/util/serialization_utils.h"
@@ -134,6 +139,19 @@ class Generator final {
                      ValueStoreT* value_store = NULL)
       : params_(params) {
     memory_limit_ = keyvi::util::mapGetMemory(params_, MEMORY_LIMIT_KEY, DEFAULT_MEMORY_LIMIT_GENERATOR);
+    key_filter_ = keyvi::util::mapGetBool(params_, KEY_FILTER_KEY, false);
+
+    // with the number of keys known, the key filter is allocated up front and taken from the memory limit
+    const size_t key_filter_keys = keyvi::util::mapGet<size_t>(params_, KEY_FILTER_KEYS_KEY, 0);
+    if (key_filter_ && key_filter_keys > 0) {
+      const size_t key_filter_size = internal::KeyFilter::GetSize(key_filter_keys);
+      if (key_filter_size >= memory_limit_) {
+        throw std::invalid_argument("memory limit too low, the key filter for " + std::to_string(key_filter_keys) +
+                                    " keys requires " + std::to_string(key_filter_size) + " bytes");
+      }
+      memory_limit_ -= key_filter_size;
+      key_filter_data_.assign(key_filter_size, 0);
+    }
 
     // use 50% or limit minus 200MB for the memory limit of the hashtable
     const size_t memory_limit_minimization =
@@ -141,6 +159,7 @@ class Generator final {
 
     params_[TEMPORARY_PATH_KEY] = keyvi::util::mapGetTemporaryPath(params);
     minimize_ = keyvi::util::mapGetBool(params_, MINIMIZATION_KEY, true);
+    root_jump_table_ = keyvi::util::mapGetBool(params_, ROOT_JUMP_TABLE_KEY, false);
 
     persistence_ = new PersistenceT(memory_limit_ - memory_limit_minimization, params_[TEMPORARY_PATH_KEY]);
 
@@ -202,6 +221,10 @@ class Generator final {
     // count number of entries
     ++number_of_keys_added_;
 
+    if (key_filter_) {
+      AddKeyHash(internal::KeyFilter::Hash(input_key.data(), input_key.size()));
+    }
+
     // if inner weights are used update them
     uint32_t weight = value_store_->GetWeightValue(value);
     if (weight > 0) {
@@ -241,6 +264,10 @@ class Generator final {
     // count number of entries
     ++number_of_keys_added_;
 
+    if (key_filter_) {
+      AddKeyHash(internal::KeyFilter::Hash(input_key.data(), input_key.size()));
+    }
+
     // if inner weights are used update them
     if (handle.weight_ > 0) {
       stack_->UpdateWeights(0, input_key.size() + 1, handle.weight_);
@@ -250,6 +277,147 @@ class Generator final {
     state_ = generator_state::FEEDING;
   }
 
+  /**
+   * Add all keys of an automaton that was built for a partition of the input, e.g. by another generator in parallel.
+   *
+   * The states of the partition are copied below the start state, each one only once. Equal states of different
+   * partitions are minimized again. Partitions must not share a leading byte, must be added in the order of their
+   * leading bytes and can not be mixed with Add. Values must be value ids of the value store of this generator.
+   *
+   * The states already copied are remembered in a table of fixed size, a sixteenth of the memory limit. A state that
+   * got evicted is copied again and minimized by the builder.
+   *
+   * @param partition the automaton of the partition
+   * @param key_hashes the hashes of the keys of the partition for the key filter, e.g. from ReleaseKeyHashes of the
+   * generator of the partition, if missing the keys get hashed by iterating the partition
+   */
+  void AddPartition(const automata_t& partition, std::vector<uint64_t>&& key_hashes = std::vector<uint64_t>()) {
+    if (state_ != generator_state::FEEDING) {
+      throw generator_exception("not in feeding state");
+    }
+
+    if (!last_key_.empty()) {
+      throw generator_exception("partitions can not be mixed with keys");
+    }
+
+    if (partition->Empty()) {
+      return;
+    }
+
+    traversal::TraversalPayload<> payload;
+    std::vector<PartitionFrame> frames(1);
+    frames[0].state = partition->GetStartState();
+    partition->GetOutGoingTransitions(frames[0].state, &frames[0].transitions, &payload);
+
+    internal::UnpackedState<PersistenceT>* root = stack_->Get(0);
+    if (root->size() > 0 && frames[0].transitions.GetNextState() != 0 &&
+        (*root)[root->size() - 1].label >= frames[0].transitions.GetNextTransition()) {
+      throw generator_exception("partitions must be added in order of their leading bytes");
+    }
+
+    // weights are only stored up to the cut off depth, a state reachable in both ranges needs 2 copies
+    const size_t weight_cut_off = static_cast<size_t>(stack_->GetWeightCutOff());
+
+    // a power of 2 slots, not more than the number of states of the partition
+    const size_t max_copied_states =
+        std::min(memory_limit_ / (16 * sizeof(CopiedState)), partition->GetNumberOfStates());
+    size_t copied_states_bits = 10;
+    while ((size_t(2) << copied_states_bits) <= max_copied_states) {
+      ++copied_states_bits;
+    }
+    std::vector<CopiedState> copied_states(size_t(1) << copied_states_bits);
+
+    // depth first, a state gets persisted once all its successors are
+    while (frames.size() > 1 || frames[0].transitions.GetNextState() != 0) {
+      const size_t depth = frames.size() - 1;
+      const uint64_t next_state = frames[depth].transitions.GetNextState();
+
+      if (next_state != 0) {
+        const bool weighted = depth + 1 < weight_cut_off;
+        const CopiedState& copied_state = copied_states[CopiedStateSlot(next_state, copied_states_bits)];
+
+        if (copied_state.state == next_state && copied_state.offsets[weighted] != 0) {
+          stack_->Insert(depth, frames[depth].transitions.GetNextTransition(), copied_state.offsets[weighted]);
+          frames[depth].weight = std::max(frames[depth].weight, copied_state.weight);
+          frames[depth].transitions++;
+          continue;
+        }
+
+        frames.emplace_back();
+        PartitionFrame& frame = frames.back();
+        frame.state = next_state;
+        partition->GetOutGoingTransitions(next_state, &frame.transitions, &payload);
+
+        if (partition->IsFinalState(next_state)) {
+          const uint64_t value_idx = partition->GetStateValue(next_state);
+          stack_->InsertFinalState(depth + 1, value_idx, false);
+          frame.weight = value_store_->GetMergeWeight(value_idx);
+        }
+        continue;
+      }
+
+      // all outgoing transitions are copied, persist the state
+      internal::UnpackedState<PersistenceT>* unpacked_state = stack_->Get(depth);
+      const uint32_t weight = frames[depth].weight;
+      stack_->UpdateWeights(depth, depth + 1, weight);
+
+      const OffsetTypeT transition_pointer = builder_->PersistState(unpacked_state);
+      const int no_minimization_counter = unpacked_state->GetNoMinimizationCounter();
+
+      CopiedState& copied_state = copied_states[CopiedStateSlot(frames[depth].state, copied_states_bits)];
+      if (copied_state.state != frames[depth].state) {
+        copied_state = CopiedState();
+        copied_state.state = frames[depth].state;
+      }
+      copied_state.offsets[depth < weight_cut_off] = transition_pointer;
+      copied_state.weight = weight;
+
+      stack_->Erase(depth);
+      frames.pop_back();
+
+      PartitionFrame& parent = frames.back();
+      stack_->Insert(depth - 1, parent.transitions.GetNextTransition(), 0);
+      stack_->PushTransitionPointer(depth - 1, transition_pointer, no_minimization_counter);
+      parent.weight = std::max(parent.weight, weight);
+      parent.transitions++;
+    }
+
+    if (frames[0].weight > 0) {
+      stack_->UpdateWeights(0, 1, frames[0].weight);
+    }
+
+    number_of_keys_added_ += partition->GetNumberOfKeys();
+
+    if (!key_filter_) {
+      return;
+    }
+
+    if (key_hashes.size() == partition->GetNumberOfKeys()) {
+      for (const uint64_t hash : key_hashes) {
+        AddKeyHash(hash);
+      }
+      std::vector<uint64_t>().swap(key_hashes);
+      return;
+    }
+
+    for (EntryIterator it(partition), end_it; it != end_it; ++it) {
+      const std::string key = it.GetKey();
+      AddKeyHash(internal::KeyFilter::Hash(key.data(), key.size()));
+    }
+  }
+
+  /**
+   * Hand over the hashes of the keys added so far, e.g. to build the key filter of a dictionary the keys get added
+   * to with AddPartition. The key filter of this generator only covers keys added afterwards.
+   *
+   * @return the hashes of the keys, empty if no key filter gets built or it gets filled while adding keys
+   */
+  std::vector<uint64_t> ReleaseKeyHashes() {
+    std::vector<uint64_t> key_hashes;
+    key_hashes.swap(key_hashes_);
+    return key_hashes;
+  }
+
   void CloseFeeding() {
     if (state_ != generator_state::FEEDING) {
       throw generator_exception("not in feeding state");
@@ -266,6 +434,14 @@ class Generator final {
 
       start_state_ = builder_->PersistState(unpacked_state);
 
+      if (root_jump_table_) {
+        BuildRootJumpTable();
+      }
+
+      if (key_filter_ && key_filter_data_.empty()) {
+        key_filter_data_ = internal::KeyFilter::Build(key_hashes_);
+      }
+
       TRACE("wrote start state at %d", start_state_);
       TRACE("Check first transition: %d/%d %s", (*unpacked_state)[0].label,
             persistence_->ReadTransitionLabel(start_state_ + (*unpacked_state)[0].label),
@@ -275,6 +451,7 @@ class Generator final {
     } else {
       // empty dictionaries have start_state_ = 1 for backwards compatibility
       start_state_ = 1;
+      std::vector<unsigned char>().swap(key_filter_data_);
     }
 
     // free structures that are not needed anymore
@@ -283,6 +460,7 @@ class Generator final {
     number_of_states_ = builder_->GetNumberOfStates();
     delete builder_;
     builder_ = 0;
+    std::vector<uint64_t>().swap(key_hashes_);
 
     persistence_->Flush();
 
@@ -305,7 +483,8 @@ class Generator final {
 
     keyvi::dictionary::DictionaryProperties p(file_version, start_state_, number_of_keys_added_, number_of_states_,
                                               value_store_->GetValueStoreType(), persistence_->GetVersion(),
-                                              persistence_->GetSize(), manifest_, specialized_dictionary_properties_);
+                                              persistence_->GetSize(), manifest_, specialized_dictionary_properties_,
+                                              root_jump_table_states_.size() > 0, key_filter_data_.size() > 0);
     p.WriteAsJsonV2(stream);
 
     // write data from persistence
@@ -313,6 +492,14 @@ class Generator final {
 
     // write date from value store
     value_store_->Write(stream);
+
+    if (root_jump_table_states_.size() > 0) {
+      keyvi::dictionary::DictionaryProperties::WriteRootJumpTable(stream, root_jump_table_states_);
+    }
+
+    if (key_filter_data_.size() > 0) {
+      keyvi::dictionary::DictionaryProperties::WriteKeyFilter(stream, key_filter_data_);
+    }
   }
 
   void WriteToFile(const std::string& filename) {
@@ -336,6 +523,19 @@ class Generator final {
   }
 
  private:
+  struct PartitionFrame final {
+    uint64_t state = 0;
+    traversal::TraversalState<> transitions;
+    uint32_t weight = 0;
+  };
+
+  struct CopiedState final {
+    uint64_t state = 0;
+    // offset without and with weight
+    OffsetTypeT offsets[2] = {0, 0};
+    uint32_t weight = 0;
+  };
+
   size_t memory_limit_;
   keyvi::util::parameters_t params_;
   PersistenceT* persistence_;
@@ -348,10 +548,64 @@ class Generator final {
   generator_state state_ = generator_state::FEEDING;
   OffsetTypeT start_state_ = 0;
   uint64_t number_of_states_ = 0;
+  bool root_jump_table_ = false;
+  std::vector<uint64_t> root_jump_table_states_;
+  bool key_filter_ = false;
+  // hashes of the keys if the number of keys is not known up front, the filter gets built from them at the end
+  std::vector<uint64_t> key_hashes_;
+  std::vector<unsigned char> key_filter_data_;
   std::string manifest_;
   std::string specialized_dictionary_properties_;
   bool minimize_ = true;
 
+  /**
+   * The slot of a state in the table of copied states, the product with the golden ratio spreads the offsets.
+   */
+  static inline size_t CopiedStateSlot(const uint64_t state, const size_t bits) {
+    return static_cast<size_t>((state * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - bits));
+  }
+
+  /**
+   * Walk a transition using the persistence, only valid while the persistence is not flushed.
+   */
+  inline uint64_t TryWalkPersistedTransition(uint64_t state, unsigned char c) const {
+    if (persistence_->ReadTransitionLabel(state + c) != c) {
+      return 0;
+    }
+
+    return persistence_->ResolveTransitionValue(state + c, persistence_->ReadTransitionValue(state + c));
+  }
+
+  /**
+   * Add a key to the key filter, directly if the filter is allocated already, otherwise keep its hash.
+   */
+  inline void AddKeyHash(const uint64_t hash) {
+    if (key_filter_data_.size() > 0) {
+      internal::KeyFilter::Add(&key_filter_data_, hash);
+    } else {
+      key_hashes_.push_back(hash);
+    }
+  }
+
+  /**
+   * Collect the states reachable from the start state with ROOT_JUMP_TABLE_DEPTH bytes.
+   */
+  void BuildRootJumpTable() {
+    root_jump_table_states_.assign(ROOT_JUMP_TABLE_SIZE, 0);
+
+    for (size_t first = 0; first < 256; ++first) {
+      const uint64_t state = TryWalkPersistedTransition(start_state_, static_cast<unsigned char>(first));
+      if (state == 0) {
+        continue;
+      }
+
+      for (size_t second = 0; second < 256; ++second) {
+        root_jump_table_states_[(first << 8) | second] =
+            TryWalkPersistedTransition(state, static_cast<unsigned char>(second));
+      }
+    }
+  }
+
   inline void FeedStack(const size_t start, const std::string& key) {
     for (size_t i = start; i < key.size(); ++i) {
       const uint32_t ukey = static_cast<uint32_t>(static_cast<unsigned char>(key[i]));
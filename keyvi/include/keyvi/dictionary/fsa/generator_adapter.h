@@ -30,6 +30,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "keyvi/dictionary/fsa/generator.h"
 #include "keyvi/util/configuration.h"
@@ -52,6 +53,7 @@ class GeneratorAdapterInterface {
 
   virtual void Add(const std::string& input_key, ValueT value) {}
   virtual void Add(const std::string& input_key, const fsa::ValueHandle& value) {}
+  virtual void AddPartition(const automata_t& partition, std::vector<uint64_t>&& key_hashes) {}
 
   virtual size_t GetFsaSize() const { return 0; }
   virtual void CloseFeeding() {}
@@ -76,6 +78,10 @@ class GeneratorAdapter final : public GeneratorAdapterInterface<typename ValueSt
 
   void Add(const std::string& input_key, const fsa::ValueHandle& value) { generator_.Add(std::move(input_key), value); }
 
+  void AddPartition(const automata_t& partition, std::vector<uint64_t>&& key_hashes) {
+    generator_.AddPartition(partition, std::move(key_hashes));
+  }
+
   size_t GetFsaSize() const { return generator_.GetFsaSize(); }
 
   void CloseFeeding() { generator_.CloseFeeding(); }
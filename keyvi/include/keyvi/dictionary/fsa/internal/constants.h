@@ -57,6 +57,21 @@ static const size_t COMPACT_SIZE_INNER_WEIGHT_MAX_VALUE = 0xffff;
 // the sparse array where the new state fits in
 static const size_t SPARSE_ARRAY_SEARCH_OFFSET = 151;
 
+// number of key bytes covered by the optional root jump table, a dense table of all states reachable from the start
+// state with this many bytes
+static const size_t ROOT_JUMP_TABLE_DEPTH = 2;
+static const size_t ROOT_JUMP_TABLE_SIZE = 65536;
+
+// layout of the optional key filter, a blocked bloom filter over all keys: every key sets KEY_FILTER_HASH_FUNCTIONS
+// bits within a single block of KEY_FILTER_BLOCK_SIZE bytes, blocks are sized for KEY_FILTER_BITS_PER_KEY
+static const size_t KEY_FILTER_VERSION = 1;
+static const size_t KEY_FILTER_BLOCK_SIZE = 64;
+static const size_t KEY_FILTER_BITS_PER_KEY = 10;
+static const size_t KEY_FILTER_HASH_FUNCTIONS = 7;
+
+// number of keys walked interleaved by multi key lookups
+static const size_t MULTI_KEY_LOOKUP_LANES = 16;
+
 // 1 GB default memory limit for the dictionary compiler
 static const size_t DEFAULT_MEMORY_LIMIT_COMPILER = 1 * 1024 * 1024 * 1024;
 
@@ -68,6 +83,9 @@ static const size_t DEFAULT_MEMORY_LIMIT_VALUE_STORE = 500 * 1024 * 1024;
 
 static const size_t DEFAULT_PARALLEL_SORT_THRESHOLD = 10000;
 
+// number of partitions, split by leading byte, the dictionary compiler builds in parallel, 0 or 1 for single threaded
+static const size_t DEFAULT_PARALLEL_COMPILE = 0;
+
 // default for vector values
 static const size_t DEFAULT_VECTOR_SIZE = 10;
 
@@ -79,9 +97,15 @@ static const char COMPRESSION_THRESHOLD_KEY[] = "compression_threshold";
 static const char MINIMIZATION_KEY[] = "minimization";
 static const char SINGLE_PRECISION_FLOAT_KEY[] = "floating_point_precision";
 static const char PARALLEL_SORT_THRESHOLD_KEY[] = "parallel_sort_threshold";
+static const char PARALLEL_COMPILE_KEY[] = "parallel_compile";
 static const char VECTOR_SIZE_KEY[] = "vector_size";
 static const char MERGE_MODE[] = "merge_mode";
 static const char MERGE_APPEND[] = "append";
+static const char MERGE_RATE_LIMIT_KEY[] = "merge_rate_limit";
+static const char ROOT_JUMP_TABLE_KEY[] = "root_jump_table";
+static const char KEY_FILTER_KEY[] = "key_filter";
+// number of keys known up front, the key filter gets filled while adding keys instead of hashing them all first
+static const char KEY_FILTER_KEYS_KEY[] = "key_filter_keys";
 
 // constants for specialized dictionaries
 static const char SECONDARY_KEY_DICT_KEYS_PROPERTY[] = "secondary_keys";
@@ -0,0 +1,136 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * huge_page_region.h
+ *
+ * Anonymous memory region backed by huge pages, used to hold a copy of the key part.
+ */
+
+#ifndef KEYVI_DICTIONARY_FSA_INTERNAL_HUGE_PAGE_REGION_H_
+#define KEYVI_DICTIONARY_FSA_INTERNAL_HUGE_PAGE_REGION_H_
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace dictionary {
+namespace fsa {
+namespace internal {
+
+/**
+ * A private, anonymous copy of a memory area, backed by huge pages if possible.
+ *
+ * Tries explicit huge pages (MAP_HUGETLB) first, which requires reserved huge pages (vm.nr_hugepages), and falls
+ * back to a populated anonymous mapping with transparent huge pages requested. Either way, accessing the copy never
+ * causes a major page fault.
+ */
+class HugePageRegion final {
+ public:
+  static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  HugePageRegion() {}
+
+  HugePageRegion(const void* source, const size_t size) {
+    // round up to the huge page size, required by munmap for MAP_HUGETLB
+    mapped_size_ = ((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+
+    if (mapped_size_ == 0) {
+      return;
+    }
+
+#if defined(_WIN32)
+    fallback_.reset(new char[mapped_size_]);
+    address_ = fallback_.get();
+#else  // not _WIN32
+#if defined(MAP_HUGETLB)
+    address_ = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (address_ != MAP_FAILED) {
+      hugetlb_ = true;
+    } else {
+      TRACE("MAP_HUGETLB failed, fall back to transparent huge pages");
+#endif
+      address_ = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+      if (address_ == MAP_FAILED) {
+        address_ = nullptr;
+        throw std::bad_alloc();
+      }
+#if defined(MADV_HUGEPAGE)
+      // advise before touching the memory, so pages get allocated huge right away
+      madvise(address_, mapped_size_, MADV_HUGEPAGE);
+#endif
+#if defined(MAP_HUGETLB)
+    }
+#endif
+#endif  // not _WIN32
+
+    std::memcpy(address_, source, size);
+
+#if !defined(_WIN32)
+    mprotect(address_, mapped_size_, PROT_READ);
+#endif
+  }
+
+  ~HugePageRegion() {
+#if !defined(_WIN32)
+    if (address_ != nullptr) {
+      munmap(address_, mapped_size_);
+    }
+#endif
+  }
+
+  HugePageRegion& operator=(HugePageRegion const&) = delete;
+  HugePageRegion(const HugePageRegion& that) = delete;
+
+  HugePageRegion& operator=(HugePageRegion&& other) {
+    std::swap(address_, other.address_);
+    std::swap(mapped_size_, other.mapped_size_);
+    std::swap(hugetlb_, other.hugetlb_);
+    std::swap(fallback_, other.fallback_);
+    return *this;
+  }
+
+  void* get_address() const { return address_; }
+
+  /**
+   * @return true if the region uses explicit huge pages, false if it relies on transparent huge pages
+   */
+  bool IsHugeTLB() const { return hugetlb_; }
+
+ private:
+  void* address_ = nullptr;
+  size_t mapped_size_ = 0;
+  bool hugetlb_ = false;
+  std::unique_ptr<char[]> fallback_;
+};
+
+} /* namespace internal */
+} /* namespace fsa */
+} /* namespace dictionary */
+} /* namespace keyvi */
+
+#endif  // KEYVI_DICTIONARY_FSA_INTERNAL_HUGE_PAGE_REGION_H_
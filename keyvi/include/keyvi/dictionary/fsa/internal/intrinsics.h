@@ -33,4 +33,11 @@
 #include <nmmintrin.h>
 #endif
 
+// prefetch a cache line for reading, no-op if the compiler does not support it
+#if !defined(KEYVI_DISABLE_OPTIMIZATIONS) && (defined(__GNUC__) || defined(__clang__))
+#define KEYVI_PREFETCH(address) __builtin_prefetch(address, 0, 3)
+#else
+#define KEYVI_PREFETCH(address)
+#endif
+
 #endif  // KEYVI_DICTIONARY_FSA_INTERNAL_INTRINSICS_H_
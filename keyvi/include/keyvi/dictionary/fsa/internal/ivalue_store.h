@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <variant>
 
 #include <boost/container/flat_map.hpp>
@@ -140,6 +141,44 @@ class IValueStoreReader {
    */
   virtual std::string GetValueAsString(uint64_t fsa_value) const = 0;
 
+  /**
+   * Get Value in raw format without copying it.
+   *
+   * Only supported by value stores which store the raw format as is. The view points into the value store and is
+   * valid as long as the value store is loaded.
+   *
+   * @param fsa_value
+   * @param raw_value the view to set
+   * @return true if supported, false otherwise
+   */
+  virtual bool GetRawValueAsStringView(uint64_t fsa_value, std::string_view* raw_value) const { return false; }
+
+  /**
+   * Get Value as msgpack without copying it.
+   *
+   * Only supported by value stores which store msgpack and only for uncompressed values. The view points into the
+   * value store and is valid as long as the value store is loaded.
+   *
+   * @param fsa_value
+   * @param msgpacked_value the view to set
+   * @return true if supported, false otherwise
+   */
+  virtual bool GetMsgPackedValueAsStringView(uint64_t fsa_value, std::string_view* msgpacked_value) const {
+    return false;
+  }
+
+  /**
+   * Get Value as string without copying it.
+   *
+   * Only supported by value stores which store the value as string. The view points into the value store and is
+   * valid as long as the value store is loaded.
+   *
+   * @param fsa_value
+   * @param value the view to set
+   * @return true if supported, false otherwise
+   */
+  virtual bool GetValueAsStringView(uint64_t fsa_value, std::string_view* value) const { return false; }
+
   /**
    * Get Weight
    *
@@ -29,6 +29,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "keyvi/dictionary/fsa/internal/intrinsics.h"
@@ -401,6 +402,28 @@ class JsonValueStoreReader final : public IValueStoreReader {
     return compressor->CompressWithoutHeader(msgpacked_value);
   }
 
+  bool GetRawValueAsStringView(uint64_t fsa_value, std::string_view* raw_value) const override {
+    *raw_value = keyvi::util::decodeVarIntStringView(strings_ + fsa_value);
+    return true;
+  }
+
+  bool GetMsgPackedValueAsStringView(uint64_t fsa_value, std::string_view* msgpacked_value) const override {
+    const std::string_view raw_value = keyvi::util::decodeVarIntStringView(strings_ + fsa_value);
+
+    if (raw_value.empty()) {
+      *msgpacked_value = raw_value;
+      return true;
+    }
+
+    // compressed values can not be returned without decompressing them
+    if (raw_value[0] != compression::CompressionAlgorithm::NO_COMPRESSION) {
+      return false;
+    }
+
+    *msgpacked_value = raw_value.substr(1);
+    return true;
+  }
+
   std::string GetValueAsString(uint64_t fsa_value) const override {
     TRACE("JsonValueStoreReader GetValueAsString");
     std::string packed_string = keyvi::util::decodeVarIntString(strings_ + fsa_value);
@@ -0,0 +1,193 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * key_filter.h
+ *
+ * Blocked bloom filter over the keys of a dictionary, to answer most lookups of missing keys without walking the FSA.
+ */
+
+#ifndef KEYVI_DICTIONARY_FSA_INTERNAL_KEY_FILTER_H_
+#define KEYVI_DICTIONARY_FSA_INTERNAL_KEY_FILTER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "keyvi/dictionary/fsa/internal/constants.h"
+#include "keyvi/dictionary/util/endian.h"
+
+namespace keyvi {
+namespace dictionary {
+namespace fsa {
+namespace internal {
+
+/**
+ * Read only view of a key filter, a key maps to a single block, so a lookup touches 1 cache line.
+ *
+ * The filter has no false negatives: if MayContain returns false, the key is not in the dictionary.
+ */
+class KeyFilter final {
+ public:
+  KeyFilter() {}
+
+  KeyFilter(const unsigned char* filter, const size_t size)
+      : filter_(filter), number_of_blocks_(size / KEY_FILTER_BLOCK_SIZE) {}
+
+  operator bool() const { return number_of_blocks_ > 0; }
+
+  bool MayContain(const std::string& key) const { return MayContain(Hash(key.data(), key.size())); }
+
+  bool MayContain(const uint64_t hash) const {
+    const unsigned char* block = filter_ + GetBlock(hash, number_of_blocks_) * KEY_FILTER_BLOCK_SIZE;
+    uint64_t bits = Mix(hash);
+
+    for (size_t i = 0; i < KEY_FILTER_HASH_FUNCTIONS; ++i, bits >>= 9) {
+      const size_t bit = bits & 511;
+      if ((block[bit >> 3] & (1 << (bit & 7))) == 0) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Size in bytes of the filter for the given number of keys.
+   */
+  static size_t GetSize(const size_t number_of_keys) {
+    const size_t number_of_blocks =
+        std::max(size_t(1), (number_of_keys * KEY_FILTER_BITS_PER_KEY + KEY_FILTER_BLOCK_SIZE * 8 - 1) /
+                                (KEY_FILTER_BLOCK_SIZE * 8));
+    return number_of_blocks * KEY_FILTER_BLOCK_SIZE;
+  }
+
+  /**
+   * Add a key to a filter under construction, a filter sized for fewer keys gets more false positives.
+   *
+   * @param filter the filter, zero initialized, of a size returned by GetSize
+   * @param hash the hash of the key, see Hash
+   */
+  static void Add(std::vector<unsigned char>* filter, const uint64_t hash) {
+    const size_t number_of_blocks = filter->size() / KEY_FILTER_BLOCK_SIZE;
+    unsigned char* block = filter->data() + GetBlock(hash, number_of_blocks) * KEY_FILTER_BLOCK_SIZE;
+    uint64_t bits = Mix(hash);
+
+    for (size_t i = 0; i < KEY_FILTER_HASH_FUNCTIONS; ++i, bits >>= 9) {
+      const size_t bit = bits & 511;
+      block[bit >> 3] |= (1 << (bit & 7));
+    }
+  }
+
+  /**
+   * Build the filter from the hashes of all keys.
+   *
+   * @param hashes the hashes, see Hash
+   * @return the filter, to be persisted as is
+   */
+  static std::vector<unsigned char> Build(const std::vector<uint64_t>& hashes) {
+    std::vector<unsigned char> filter(GetSize(hashes.size()), 0);
+
+    for (const uint64_t hash : hashes) {
+      Add(&filter, hash);
+    }
+
+    return filter;
+  }
+
+  /**
+   * Hash of a key, MurmurHash64A with a fixed seed, the result does not depend on the platform.
+   */
+  static uint64_t Hash(const char* key, const size_t length) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    uint64_t h = 0x6b657976ULL ^ (length * m);
+
+    const size_t chunks = length / 8;
+    for (size_t i = 0; i < chunks; ++i) {
+      uint64_t k;
+      std::memcpy(&k, key + i * 8, sizeof(uint64_t));
+      k = le64toh(k);
+
+      k *= m;
+      k ^= k >> r;
+      k *= m;
+      h ^= k;
+      h *= m;
+    }
+
+    const unsigned char* tail = reinterpret_cast<const unsigned char*>(key + chunks * 8);
+    switch (length & 7) {
+      case 7:
+        h ^= static_cast<uint64_t>(tail[6]) << 48;
+        [[fallthrough]];
+      case 6:
+        h ^= static_cast<uint64_t>(tail[5]) << 40;
+        [[fallthrough]];
+      case 5:
+        h ^= static_cast<uint64_t>(tail[4]) << 32;
+        [[fallthrough]];
+      case 4:
+        h ^= static_cast<uint64_t>(tail[3]) << 24;
+        [[fallthrough]];
+      case 3:
+        h ^= static_cast<uint64_t>(tail[2]) << 16;
+        [[fallthrough]];
+      case 2:
+        h ^= static_cast<uint64_t>(tail[1]) << 8;
+        [[fallthrough]];
+      case 1:
+        h ^= static_cast<uint64_t>(tail[0]);
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+  }
+
+ private:
+  const unsigned char* filter_ = nullptr;
+  size_t number_of_blocks_ = 0;
+
+  static size_t GetBlock(const uint64_t hash, const size_t number_of_blocks) {
+    // map the upper 32 bits onto [0, number_of_blocks) without a division
+    return static_cast<size_t>(((hash >> 32) * number_of_blocks) >> 32);
+  }
+
+  /**
+   * Derive the bit positions from the hash, independent of the bits used to select the block.
+   */
+  static uint64_t Mix(uint64_t hash) {
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+  }
+};
+
+} /* namespace internal */
+} /* namespace fsa */
+} /* namespace dictionary */
+} /* namespace keyvi */
+
+#endif  // KEYVI_DICTIONARY_FSA_INTERNAL_KEY_FILTER_H_
@@ -29,6 +29,8 @@
 #include <sys/mman.h>
 #endif
 
+#include <cstdint>
+
 #include <boost/interprocess/file_mapping.hpp>
 #include <boost/interprocess/mapped_region.hpp>
 
@@ -76,6 +78,7 @@ class MemoryMapFlags final {
       case loading_strategy_types::populate:
       case loading_strategy_types::populate_key_part:
       case loading_strategy_types::populate_key_part_no_readahead_value_part:
+      case loading_strategy_types::copy_key_part_huge_pages:
         flags |= MAP_POPULATE;
         break;
       default:
@@ -143,6 +146,9 @@ class MemoryMapFlags final {
         break;
       case loading_strategy_types::populate_lazy:
         return boost::interprocess::mapped_region::advice_types::advice_willneed;
+      case loading_strategy_types::copy_key_part_huge_pages:
+        // the mapping is only read once for copying it
+        return boost::interprocess::mapped_region::advice_types::advice_sequential;
       default:
         break;
     }
@@ -151,6 +157,47 @@ class MemoryMapFlags final {
 #endif
   }
 
+  /**
+   * Whether the FSA part should be backed by transparent huge pages, not covered by the boost advice types.
+   *
+   * @param strategy load strategy
+   * @return true if AdviseHugePages should be called on the FSA regions
+   */
+  static bool FSAUseHugePages(const loading_strategy_types strategy) {
+    return strategy == loading_strategy_types::huge_pages_key_part;
+  }
+
+  /**
+   * Whether the FSA part should be copied into anonymous huge pages, see HugePageRegion.
+   *
+   * @param strategy load strategy
+   * @return true if the FSA part should be copied
+   */
+  static bool FSACopyToHugePages(const loading_strategy_types strategy) {
+    return strategy == loading_strategy_types::copy_key_part_huge_pages;
+  }
+
+  /**
+   * Ask the OS to back the given region with transparent huge pages (madvise(MADV_HUGEPAGE)). For file mappings this
+   * requires a kernel with support for read-only file THP, otherwise the advice is silently ignored.
+   *
+   * @param region the mapped region
+   */
+  static void AdviseHugePages(const boost::interprocess::mapped_region& region) {
+#if defined(MADV_HUGEPAGE)
+    if (region.get_address() == nullptr) {
+      return;
+    }
+
+    // madvise requires a page aligned address
+    const std::size_t page_size = boost::interprocess::mapped_region::get_page_size();
+    const uintptr_t address = reinterpret_cast<uintptr_t>(region.get_address());
+    const uintptr_t aligned_address = address & ~(static_cast<uintptr_t>(page_size) - 1);
+
+    madvise(reinterpret_cast<void*>(aligned_address), region.get_size() + (address - aligned_address), MADV_HUGEPAGE);
+#endif
+  }
+
   /**
    * Translates the loading strategy into the according options for madvise. To be used for loading the Values part.
    *
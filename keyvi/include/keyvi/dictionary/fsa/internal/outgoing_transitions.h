@@ -0,0 +1,213 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * outgoing_transitions.h
+ *
+ * Kernels to find all outgoing transitions of a state, selected at runtime
+ * according to the instruction set of the host.
+ */
+
+#ifndef KEYVI_DICTIONARY_FSA_INTERNAL_OUTGOING_TRANSITIONS_H_
+#define KEYVI_DICTIONARY_FSA_INTERNAL_OUTGOING_TRANSITIONS_H_
+
+#include <cstdint>
+#include <cstring>
+
+#include "keyvi/dictionary/fsa/internal/intrinsics.h"
+
+#if !defined(KEYVI_DISABLE_OPTIMIZATIONS) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define KEYVI_RUNTIME_DISPATCH
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace dictionary {
+namespace fsa {
+
+/**
+ * Lookup table to find outgoing transitions quickly(in parallel) by comparing the
+ * real buffer with this table, used by all kernels below.
+ */
+static const unsigned char OUTGOING_TRANSITIONS_MASK[256] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12,
+    0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25,
+    0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38,
+    0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b,
+    0x4c, 0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e,
+    0x5f, 0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71,
+    0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f, 0x80, 0x81, 0x82, 0x83, 0x84,
+    0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f, 0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+    0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f, 0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa,
+    0xab, 0xac, 0xad, 0xae, 0xaf, 0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd,
+    0xbe, 0xbf, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf, 0xd0,
+    0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf, 0xe0, 0xe1, 0xe2, 0xe3,
+    0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef, 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6,
+    0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+
+namespace internal {
+
+/**
+ * Kernel that sets bit i of bitmap[i / 64] if the state starting at labels has an outgoing transition with label i.
+ */
+typedef void (*outgoing_transitions_kernel_t)(const unsigned char* labels, uint64_t* bitmap);
+
+inline void GetOutgoingTransitionsScalar(const unsigned char* labels, uint64_t* bitmap) {
+  // check 8 bytes at a time
+  for (size_t word = 0; word < 4; ++word) {
+    uint64_t bits = 0;
+
+    for (size_t offset = 0; offset < 64; offset += 8) {
+      uint64_t labels_as_ll;
+      uint64_t mask_as_ll;
+      std::memcpy(&labels_as_ll, labels + (word << 6) + offset, sizeof(uint64_t));
+      std::memcpy(&mask_as_ll, OUTGOING_TRANSITIONS_MASK + (word << 6) + offset, sizeof(uint64_t));
+      const uint64_t xor_labels_with_mask = labels_as_ll ^ mask_as_ll;
+
+      // skip if no byte is 0, i.e. no label matches
+      if (((xor_labels_with_mask - 0x0101010101010101ULL) & ~xor_labels_with_mask & 0x8080808080808080ULL) == 0) {
+        continue;
+      }
+
+      for (size_t i = 0; i < 8; ++i) {
+        if (((xor_labels_with_mask >> (i << 3)) & 0xff) == 0) {
+          bits |= 1ULL << (offset + i);
+        }
+      }
+    }
+
+    bitmap[word] = bits;
+  }
+}
+
+#if defined(KEYVI_SSE42)
+// Optimized version using SSE4.2, see http://www.strchr.com/strcmp_and_strlen_using_sse_4.2
+inline void GetOutgoingTransitionsSSE42(const unsigned char* labels, uint64_t* bitmap) {
+  const __m128i* labels_as_m128 = reinterpret_cast<const __m128i*>(labels);
+  const __m128i* mask_as_m128 = reinterpret_cast<const __m128i*>(OUTGOING_TRANSITIONS_MASK);
+
+  // check 16 bytes at a time
+  for (size_t word = 0; word < 4; ++word) {
+    uint64_t bits = 0;
+    for (size_t offset = 0; offset < 64; offset += 16) {
+      __m128i mask =
+          _mm_cmpestrm(_mm_loadu_si128(labels_as_m128), 16, _mm_loadu_si128(mask_as_m128), 16,
+                       _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_EACH | _SIDD_MASKED_POSITIVE_POLARITY | _SIDD_BIT_MASK);
+
+      bits |= (static_cast<uint64_t>(_mm_extract_epi64(mask, 0)) & 0xffff) << offset;
+      ++labels_as_m128;
+      ++mask_as_m128;
+    }
+    bitmap[word] = bits;
+  }
+}
+#endif
+
+#if defined(KEYVI_RUNTIME_DISPATCH)
+// check 32 bytes at a time
+__attribute__((target("avx2"))) inline void GetOutgoingTransitionsAVX2(const unsigned char* labels,
+                                                                       uint64_t* bitmap) {
+  for (size_t word = 0; word < 4; ++word) {
+    const unsigned char* l = labels + (word << 6);
+    const unsigned char* m = OUTGOING_TRANSITIONS_MASK + (word << 6);
+
+    const uint32_t low = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(l)),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m)))));
+    const uint32_t high = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(l + 32)),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m + 32)))));
+    bitmap[word] = (static_cast<uint64_t>(high) << 32) | low;
+  }
+}
+
+// check 64 bytes at a time
+__attribute__((target("avx512bw"))) inline void GetOutgoingTransitionsAVX512(const unsigned char* labels,
+                                                                             uint64_t* bitmap) {
+  for (size_t word = 0; word < 4; ++word) {
+    bitmap[word] = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(labels + (word << 6)),
+                                          _mm512_loadu_si512(OUTGOING_TRANSITIONS_MASK + (word << 6)));
+  }
+}
+#endif
+
+/**
+ * Select the fastest kernel the host supports.
+ */
+inline outgoing_transitions_kernel_t SelectOutgoingTransitionsKernel() {
+#if defined(KEYVI_RUNTIME_DISPATCH)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw")) {
+    TRACE("select AVX-512BW kernel");
+    return &GetOutgoingTransitionsAVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    TRACE("select AVX2 kernel");
+    return &GetOutgoingTransitionsAVX2;
+  }
+#endif
+#if defined(KEYVI_SSE42)
+  TRACE("select SSE4.2 kernel");
+  return &GetOutgoingTransitionsSSE42;
+#else
+  TRACE("select scalar kernel");
+  return &GetOutgoingTransitionsScalar;
+#endif
+}
+
+/**
+ * Kernel for this host, detected once.
+ */
+inline outgoing_transitions_kernel_t GetOutgoingTransitionsKernel() {
+  static const outgoing_transitions_kernel_t kernel = SelectOutgoingTransitionsKernel();
+  return kernel;
+}
+
+/**
+ * Position of the lowest set bit, bits must not be 0.
+ */
+inline unsigned int CountTrailingZeros(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(bits);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;  // NOLINT
+  _BitScanForward64(&index, bits);
+  return index;
+#else
+  unsigned int index = 0;
+  while ((bits & 1) == 0) {
+    bits >>= 1;
+    ++index;
+  }
+  return index;
+#endif
+}
+
+} /* namespace internal */
+} /* namespace fsa */
+} /* namespace dictionary */
+} /* namespace keyvi */
+
+#endif  // KEYVI_DICTIONARY_FSA_INTERNAL_OUTGOING_TRANSITIONS_H_
@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <boost/functional/hash.hpp>
@@ -285,6 +286,11 @@ class StringValueStoreReader final : public IValueStoreReader {
 
   std::string GetValueAsString(uint64_t fsa_value) const override { return std::string(strings_ + fsa_value); }
 
+  bool GetValueAsStringView(uint64_t fsa_value, std::string_view* value) const override {
+    *value = std::string_view(strings_ + fsa_value);
+    return true;
+  }
+
   std::string GetRawValueAsString(uint64_t fsa_value) const override {
     // TODO(hendrik): replace with std::format once we have C++20
     return compression::compression_strategy_by_code(compression::CompressionAlgorithm::NO_COMPRESSION)
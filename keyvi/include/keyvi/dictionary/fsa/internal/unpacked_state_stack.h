@@ -100,6 +100,11 @@ class UnpackedStateStack final {
 
   void Erase(size_t pos) { Get(pos)->Clear(); }
 
+  /**
+   * States from this depth on do not get weights.
+   */
+  int GetWeightCutOff() const { return weight_cut_off_; }
+
  private:
   std::vector<UnpackedState<PersistenceT>*> unpacked_state_pool_;
   PersistenceT* persistence_;
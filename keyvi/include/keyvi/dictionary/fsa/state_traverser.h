@@ -96,7 +96,46 @@ class StateTraverser final {
     other.current_label_ = 0;
   }
 
-  automata_t GetFsa() const { return fsa_; }
+  /**
+   * Restart the traversal, reusing the memory allocated so far.
+   *
+   * @param f the fsa
+   * @param start_state the state to start from, 0 results in an exhausted traverser
+   * @param advance whether to move to the first state
+   */
+  void Reset(automata_t f, const uint64_t start_state, const bool advance = true) {
+    Reset(f, start_state, traversal::TraversalPayload<TransitionT>(), advance);
+  }
+
+  /**
+   * Restart the traversal with a new payload, reusing the memory allocated so far.
+   *
+   * @param f the fsa
+   * @param start_state the state to start from, 0 results in an exhausted traverser
+   * @param payload the traversal payload
+   * @param advance whether to move to the first state
+   */
+  void Reset(automata_t f, const uint64_t start_state, traversal::TraversalPayload<TransitionT> &&payload,
+             const bool advance = true) {
+    fsa_ = f;
+    current_state_ = start_state;
+    current_weight_ = 0;
+    current_label_ = 0;
+    stack_.traversal_stack_payload = std::move(payload);
+
+    if (start_state == 0) {
+      return;
+    }
+
+    f->GetOutGoingTransitions(start_state, &stack_.GetStates(), &stack_.traversal_stack_payload,
+                              f->GetInnerWeight(start_state));
+
+    if (advance) {
+      this->operator++(0);
+    }
+  }
+
+  const automata_t& GetFsa() const { return fsa_; }
 
   bool IsFinalState() const { return fsa_->IsFinalState(current_state_); }
 
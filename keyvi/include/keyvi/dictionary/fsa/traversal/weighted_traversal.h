@@ -68,9 +68,21 @@ inline void TraversalState<WeightedTransition>::Add(uint64_t s, uint32_t weight,
 
 template <>
 inline void TraversalState<WeightedTransition>::PostProcess(TraversalPayload<WeightedTransition>* payload) {
-  if (traversal_state_payload.transitions.size() > 0) {
-    std::stable_sort(traversal_state_payload.transitions.begin(), traversal_state_payload.transitions.end(),
-                     WeightedTransitionCompare);
+  auto& transitions = traversal_state_payload.transitions;
+
+  // std::stable_sort allocates a temporary buffer, for the typical small number of transitions insertion sort is
+  // cheaper and does not allocate
+  if (transitions.size() <= 32) {
+    for (size_t i = 1; i < transitions.size(); ++i) {
+      const WeightedTransition transition = transitions[i];
+      size_t j = i;
+      for (; j > 0 && WeightedTransitionCompare(transition, transitions[j - 1]); --j) {
+        transitions[j] = transitions[j - 1];
+      }
+      transitions[j] = transition;
+    }
+  } else {
+    std::stable_sort(transitions.begin(), transitions.end(), WeightedTransitionCompare);
   }
 }
 
@@ -183,7 +183,7 @@ class ZipStateTraverser final {
 
   bool AtEnd() const { return traverser_queue_.empty(); }
 
-  automata_t GetFsa() const { return fsa_; }
+  const automata_t& GetFsa() const { return fsa_; }
 
   bool IsFinalState() const { return final_; }
 
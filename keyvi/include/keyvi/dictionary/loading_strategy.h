@@ -29,7 +29,9 @@ enum class loading_strategy_types {
   populate_lazy,                 // load data lazy but ask the OS to read ahead if possible (does not block)
   lazy_no_readahead,             // disable any read-ahead (for cases when index > x * main memory)
   lazy_no_readahead_value_part,  // disable read-ahead only for the value part
-  populate_key_part_no_readahead_value_part  // populate the key part, but disable read ahead value part
+  populate_key_part_no_readahead_value_part,  // populate the key part, but disable read ahead value part
+  huge_pages_key_part,        // ask the OS to back the key part with transparent huge pages, load value part lazy
+  copy_key_part_huge_pages    // copy the key part into anonymous huge pages (MAP_HUGETLB), never faults after loading
 };
 
 using LoadingStrategy = loading_strategy_types;
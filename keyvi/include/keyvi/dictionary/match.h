@@ -27,8 +27,10 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include <boost/container/flat_map.hpp>
 
@@ -52,6 +54,9 @@ template <class MatcherT, class DeletedT>
 keyvi::dictionary::match_t NextFilteredMatch(const MatcherT&, const DeletedT&);
 template <class MatcherT, class DeletedT>
 keyvi::dictionary::match_t FirstFilteredMatch(const MatcherT&, const DeletedT&);
+template <class DeletedT>
+std::vector<keyvi::dictionary::match_t> MergeFilteredMatches(std::vector<std::vector<keyvi::dictionary::match_t>>*,
+                                                             const DeletedT&);
 }  // namespace internal
 }  // namespace index
 namespace dictionary {
@@ -105,6 +110,28 @@ struct Match {
     return *this;
   }
 
+  /**
+   * Reinitialize the match in place, the memory of the matched string is reused.
+   *
+   * @param a start position
+   * @param b end position
+   * @param matched_item the matched string
+   * @param score the score
+   * @param fsa the fsa the match belongs to
+   * @param state the state value
+   */
+  void Reset(size_t a, size_t b, const std::string_view matched_item, double score, const fsa::automata_t& fsa,
+             uint64_t state) {
+    start_ = a;
+    end_ = b;
+    matched_item_.assign(matched_item.data(), matched_item.size());
+    raw_value_.clear();
+    score_ = score;
+    fsa_ = fsa;
+    state_ = state;
+    attributes_.reset();
+  }
+
   size_t GetEnd() const { return end_; }
 
   void SetEnd(size_t end = 0) { end_ = end; }
@@ -229,6 +256,65 @@ struct Match {
     return fsa_->GetMsgPackedValueAsString(state_, compression_algorithm);
   }
 
+  /**
+   * Get the raw value without copying it.
+   *
+   * The view is valid as long as the match and the dictionary it belongs to are alive.
+   *
+   * @param raw_value the view to set
+   * @return true if a view is available, false if the value must be retrieved with GetRawValueAsString
+   */
+  bool GetRawValueAsStringView(std::string_view* raw_value) const {
+    if (!fsa_) {
+      *raw_value = raw_value_;
+      return true;
+    }
+
+    return fsa_->GetRawValueAsStringView(state_, raw_value);
+  }
+
+  /**
+   * Get the msgpack value without copying it, only possible for uncompressed values.
+   *
+   * The view is valid as long as the match and the dictionary it belongs to are alive.
+   *
+   * @param msgpacked_value the view to set
+   * @return true if a view is available, false if the value must be retrieved with GetMsgPackedValueAsString
+   */
+  bool GetMsgPackedValueAsStringView(std::string_view* msgpacked_value) const {
+    if (!fsa_) {
+      if (raw_value_.empty()) {
+        *msgpacked_value = std::string_view();
+        return true;
+      }
+
+      if (raw_value_[0] != compression::CompressionAlgorithm::NO_COMPRESSION) {
+        return false;
+      }
+
+      *msgpacked_value = std::string_view(raw_value_).substr(1);
+      return true;
+    }
+
+    return fsa_->GetMsgPackedValueAsStringView(state_, msgpacked_value);
+  }
+
+  /**
+   * Get the value as string without copying it, only possible for string values.
+   *
+   * The view is valid as long as the match and the dictionary it belongs to are alive.
+   *
+   * @param value the view to set
+   * @return true if a view is available, false if the value must be retrieved with GetValueAsString
+   */
+  bool GetValueAsStringView(std::string_view* value) const {
+    if (!fsa_) {
+      return false;
+    }
+
+    return fsa_->GetValueAsStringView(state_, value);
+  }
+
   /**
    * being able to set the value, e.g. when keyvi is used over network boundaries
    *
@@ -251,8 +337,13 @@ struct Match {
   friend match_t index::internal::NextFilteredMatch(const MatcherT&, const DeletedT&);
   template <class MatcherT, class DeletedT>
   friend match_t index::internal::FirstFilteredMatch(const MatcherT&, const DeletedT&);
+  template <class DeletedT>
+  friend std::vector<match_t> index::internal::MergeFilteredMatches(
+      std::vector<std::vector<keyvi::dictionary::match_t>>*, const DeletedT&);
 
   fsa::automata_t& GetFsa() { return fsa_; }
+
+  friend class MatchView;
 };
 
 } /* namespace dictionary */
@@ -0,0 +1,171 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * match_view.h
+ *
+ * Lightweight, non-owning match handed to visitors.
+ */
+
+#ifndef KEYVI_DICTIONARY_MATCH_VIEW_H_
+#define KEYVI_DICTIONARY_MATCH_VIEW_H_
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "keyvi/compression/compression_strategy.h"
+#include "keyvi/dictionary/fsa/automata.h"
+#include "keyvi/dictionary/match.h"
+
+namespace keyvi {
+namespace dictionary {
+
+/**
+ * A match that only points to the data of the matcher that created it, used by the ForEachMatch visitor API.
+ *
+ * A view is only valid during the visitor call, the matched string points into the traversal buffers of the matcher.
+ * Values are read lazily from the fsa, use ToMatch to create an owning copy. A view of a match without fsa, e.g. a
+ * pending write of an index, reads the value from that match instead.
+ */
+class MatchView final {
+ public:
+  MatchView(size_t start, size_t end, std::string_view matched_item, double score, const fsa::automata_t& fsa,
+            uint64_t state_value)
+      : start_(start), end_(end), matched_item_(matched_item), score_(score), fsa_(&fsa), state_value_(state_value) {}
+
+  explicit MatchView(const Match& match)
+      : start_(match.start_),
+        end_(match.end_),
+        matched_item_(match.matched_item_),
+        score_(match.score_),
+        fsa_(&match.fsa_),
+        state_value_(match.state_),
+        match_(&match) {}
+
+  size_t GetStart() const { return start_; }
+
+  size_t GetEnd() const { return end_; }
+
+  std::string_view GetMatchedString() const { return matched_item_; }
+
+  double GetScore() const { return score_; }
+
+  const fsa::automata_t& GetFsa() const { return *fsa_; }
+
+  uint64_t GetStateValue() const { return state_value_; }
+
+  uint32_t GetWeight() const {
+    if (!*fsa_) {
+      return 0;
+    }
+
+    return (*fsa_)->GetWeight(state_value_);
+  }
+
+  std::string GetValueAsString() const {
+    if (!*fsa_) {
+      return match_ ? match_->GetValueAsString() : "";
+    }
+
+    return (*fsa_)->GetValueAsString(state_value_);
+  }
+
+  std::string GetRawValueAsString() const {
+    if (!*fsa_) {
+      return match_ ? match_->GetRawValueAsString() : "";
+    }
+
+    return (*fsa_)->GetRawValueAsString(state_value_);
+  }
+
+  std::string GetMsgPackedValueAsString(const compression::CompressionAlgorithm compression_algorithm =
+                                            compression::CompressionAlgorithm::NO_COMPRESSION) const {
+    if (!*fsa_) {
+      return match_ ? match_->GetMsgPackedValueAsString(compression_algorithm) : "";
+    }
+
+    return (*fsa_)->GetMsgPackedValueAsString(state_value_, compression_algorithm);
+  }
+
+  /**
+   * Get the msgpack value without copying it, see Match::GetMsgPackedValueAsStringView.
+   */
+  bool GetMsgPackedValueAsStringView(std::string_view* msgpacked_value) const {
+    if (!*fsa_) {
+      return match_ ? match_->GetMsgPackedValueAsStringView(msgpacked_value) : false;
+    }
+
+    return (*fsa_)->GetMsgPackedValueAsStringView(state_value_, msgpacked_value);
+  }
+
+  /**
+   * Get the value as string without copying it, see Match::GetValueAsStringView.
+   */
+  bool GetValueAsStringView(std::string_view* value) const {
+    if (!*fsa_) {
+      return false;
+    }
+
+    return (*fsa_)->GetValueAsStringView(state_value_, value);
+  }
+
+  /**
+   * Materialize the view into a match, which can be used after the visitor call.
+   */
+  match_t ToMatch() const {
+    if (match_ && !*fsa_) {
+      match_t match = std::make_shared<Match>(start_, end_, std::string(matched_item_), score_);
+      match->SetRawValue(match_->GetRawValueAsString());
+      return match;
+    }
+
+    return std::make_shared<Match>(start_, end_, std::string(matched_item_), score_, *fsa_, state_value_);
+  }
+
+ private:
+  size_t start_;
+  size_t end_;
+  std::string_view matched_item_;
+  double score_;
+  const fsa::automata_t* fsa_;
+  uint64_t state_value_;
+  const Match* match_ = nullptr;
+};
+
+/**
+ * Call a visitor with a match.
+ *
+ * Visitors either return void or a bool, returning false means the caller should stop.
+ *
+ * @return false if the visitor requested to stop
+ */
+template <class VisitorT, class MatchT>
+inline bool CallVisitor(VisitorT&& visitor, MatchT& match) {
+  if constexpr (std::is_void_v<std::invoke_result_t<VisitorT, MatchT&>>) {
+    visitor(match);
+    return true;
+  } else {
+    return visitor(match);
+  }
+}
+
+} /* namespace dictionary */
+} /* namespace keyvi */
+
+#endif  // KEYVI_DICTIONARY_MATCH_VIEW_H_
@@ -0,0 +1,277 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * fuzzy_automaton_matching.h
+ *
+ * Fuzzy matching by intersecting the fsa with a Levenshtein automaton.
+ */
+
+#ifndef KEYVI_DICTIONARY_MATCHING_FUZZY_AUTOMATON_MATCHING_H_
+#define KEYVI_DICTIONARY_MATCHING_FUZZY_AUTOMATON_MATCHING_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utf8.h"
+
+#include "keyvi/dictionary/fsa/automata.h"
+#include "keyvi/dictionary/fsa/codepoint_state_traverser.h"
+#include "keyvi/dictionary/fsa/traverser_types.h"
+#include "keyvi/dictionary/fsa/zip_state_traverser.h"
+#include "keyvi/dictionary/match.h"
+#include "keyvi/dictionary/match_view.h"
+#include "keyvi/dictionary/matching/fuzzy_matching.h"
+#include "keyvi/stringdistance/levenshtein_automaton.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace dictionary {
+namespace matching {
+
+/**
+ * Fuzzy matcher returning the same matches as FuzzyMatching, in the same order.
+ *
+ * Instead of calculating a row of the distance matrix for every traversed character, the query is compiled into a
+ * stringdistance::LevenshteinAutomaton which is walked in parallel to the fsa. Every step is a table lookup once the
+ * transition has been taken before, subtrees are pruned as soon as the automaton reaches its dead state.
+ */
+template <class codepointInnerTraverserType = fsa::WeightedStateTraverser>
+class FuzzyAutomatonMatching final {
+ public:
+  using automaton_state_t = stringdistance::LevenshteinAutomaton::state_t;
+
+  /**
+   * Create a fuzzy matcher from a single Fsa
+   *
+   * @param fsa the fsa
+   * @param query the query
+   * @param max_edit_distance the maximum allowed edit distance
+   * @param minimum_exact_prefix the minimum exact prefix to match before matching approximate
+   */
+  static FuzzyAutomatonMatching FromSingleFsa(const fsa::automata_t& fsa, const std::string& query,
+                                              const int32_t max_edit_distance, const size_t minimum_exact_prefix = 2) {
+    return FromSingleFsa(fsa, fsa->GetStartState(), query, max_edit_distance, minimum_exact_prefix);
+  }
+
+  /**
+   * Create a fuzzy matcher from a single Fsa
+   *
+   * @param fsa the fsa
+   * @param start_state the state to start from
+   * @param query the query
+   * @param max_edit_distance the maximum allowed edit distance
+   * @param minimum_exact_prefix the minimum exact prefix to match before matching approximate
+   */
+  static FuzzyAutomatonMatching FromSingleFsa(const fsa::automata_t& fsa, const uint64_t start_state,
+                                              const std::string& query, const int32_t max_edit_distance,
+                                              const size_t minimum_exact_prefix = 2) {
+    std::vector<uint32_t> codepoints;
+    utf8::unchecked::utf8to32(query.begin(), query.end(), back_inserter(codepoints));
+
+    uint64_t state = codepoints.size() < minimum_exact_prefix ? 0 : start_state;
+    size_t utf8_depth = 0;
+    for (size_t depth = 0; state != 0 && depth < minimum_exact_prefix; ++depth) {
+      const size_t code_point_length = util::Utf8Utils::GetCharLength(query[utf8_depth]);
+      for (size_t i = 0; state != 0 && i < code_point_length; ++i, ++utf8_depth) {
+        state = fsa->TryWalkTransition(state, query[utf8_depth]);
+      }
+    }
+
+    if (state == 0) {
+      return FuzzyAutomatonMatching();
+    }
+
+    auto traverser = std::make_unique<fsa::CodePointStateTraverser<codepointInnerTraverserType>>(fsa, state);
+    return FuzzyAutomatonMatching(std::move(traverser), std::move(codepoints), max_edit_distance, minimum_exact_prefix,
+                                  {{fsa, state}});
+  }
+
+  /**
+   * Create a fuzzy matcher from multiple Fsas
+   *
+   * @param fsas a vector of fsas
+   * @param query the query
+   * @param max_edit_distance the maximum allowed edit distance
+   * @param minimum_exact_prefix the minimum exact prefix to match before matching approximate
+   */
+  template <class innerTraverserType = fsa::WeightedStateTraverser>
+  static FuzzyAutomatonMatching<fsa::ZipStateTraverser<innerTraverserType>> FromMulipleFsas(
+      const std::vector<fsa::automata_t>& fsas, const std::string& query, const int32_t max_edit_distance,
+      const size_t minimum_exact_prefix = 2) {
+    std::vector<uint32_t> codepoints;
+    utf8::unchecked::utf8to32(query.begin(), query.end(), back_inserter(codepoints));
+
+    if (codepoints.size() < minimum_exact_prefix) {
+      return FuzzyAutomatonMatching<fsa::ZipStateTraverser<innerTraverserType>>();
+    }
+
+    std::vector<std::pair<fsa::automata_t, uint64_t>> fsa_start_state_pairs =
+        FuzzyMatching<>::FilterWithExactPrefix(fsas, query, minimum_exact_prefix);
+
+    if (fsa_start_state_pairs.size() == 0) {
+      return FuzzyAutomatonMatching<fsa::ZipStateTraverser<innerTraverserType>>();
+    }
+
+    fsa::ZipStateTraverser<innerTraverserType> zip_state_traverser(fsa_start_state_pairs, false);
+    auto traverser = std::make_unique<fsa::CodePointStateTraverser<fsa::ZipStateTraverser<innerTraverserType>>>(
+        std::move(zip_state_traverser));
+
+    return FuzzyAutomatonMatching<fsa::ZipStateTraverser<innerTraverserType>>(
+        std::move(traverser), std::move(codepoints), max_edit_distance, minimum_exact_prefix, fsa_start_state_pairs);
+  }
+
+  match_t& FirstMatch() { return first_match_; }
+
+  match_t NextMatch() {
+    if (!SeekMatch()) {
+      return match_t();
+    }
+
+    UpdateCandidate();
+    TRACE("found match %s %lu", candidate_.c_str(), traverser_ptr_->GetStateValue());
+    match_t m = std::make_shared<Match>(0, candidate_codepoints_.size(), candidate_, GetScore(),
+                                        traverser_ptr_->GetFsa(), traverser_ptr_->GetStateValue());
+    (*traverser_ptr_)++;
+    return m;
+  }
+
+  /**
+   * Call the visitor for every remaining match, without creating Match objects.
+   *
+   * The visitor gets a MatchView which is only valid during the call, it can return false to stop early.
+   *
+   * @param visitor callable taking a MatchView&
+   */
+  template <class VisitorT>
+  void ForEachMatch(VisitorT&& visitor) {
+    if (first_match_) {
+      MatchView view(*first_match_);
+      const bool proceed = CallVisitor(visitor, view);
+      first_match_.reset();
+      if (!proceed) {
+        return;
+      }
+    }
+
+    while (SeekMatch()) {
+      UpdateCandidate();
+      MatchView view(0, candidate_codepoints_.size(), candidate_, GetScore(), traverser_ptr_->GetFsa(),
+                     traverser_ptr_->GetStateValue());
+      const bool proceed = CallVisitor(visitor, view);
+      (*traverser_ptr_)++;
+      if (!proceed) {
+        return;
+      }
+    }
+  }
+
+ private:
+  std::unique_ptr<fsa::CodePointStateTraverser<codepointInnerTraverserType>> traverser_ptr_;
+  std::unique_ptr<stringdistance::LevenshteinAutomaton> automaton_ptr_;
+  size_t exact_prefix_ = 0;
+  match_t first_match_;
+
+  // automaton states and codepoints of the current path, index 0 is the state after the exact prefix
+  std::vector<automaton_state_t> automaton_states_;
+  std::vector<uint32_t> candidate_codepoints_;
+  std::string candidate_;
+
+  template <class T>
+  friend class FuzzyAutomatonMatching;
+
+  FuzzyAutomatonMatching() {}
+
+  FuzzyAutomatonMatching(std::unique_ptr<fsa::CodePointStateTraverser<codepointInnerTraverserType>>&& traverser,
+                         std::vector<uint32_t>&& codepoints, const int32_t max_edit_distance, const size_t exact_prefix,
+                         const std::vector<std::pair<fsa::automata_t, uint64_t>>& fsa_start_state_pairs)
+      : traverser_ptr_(std::move(traverser)),
+        automaton_ptr_(std::make_unique<stringdistance::LevenshteinAutomaton>(codepoints, max_edit_distance)),
+        exact_prefix_(exact_prefix) {
+    automaton_state_t state = automaton_ptr_->GetStartState();
+    for (size_t i = 0; i < exact_prefix_; ++i) {
+      state = automaton_ptr_->Step(state, codepoints[i]);
+    }
+    automaton_states_.push_back(state);
+
+    codepoints.resize(exact_prefix_);
+    candidate_codepoints_ = std::move(codepoints);
+
+    // check for a match given the exact prefix
+    if (automaton_ptr_->IsFinal(state)) {
+      for (const auto& fsa_state : fsa_start_state_pairs) {
+        if (fsa_state.first->IsFinalState(fsa_state.second)) {
+          UpdateCandidate();
+          first_match_ = std::make_shared<Match>(0, exact_prefix_, candidate_, automaton_ptr_->GetScore(state),
+                                                 fsa_state.first, fsa_state.first->GetStateValue(fsa_state.second));
+          break;
+        }
+      }
+    }
+
+    if (state == stringdistance::LevenshteinAutomaton::DEAD_STATE) {
+      traverser_ptr_.reset();
+    }
+  }
+
+  /**
+   * Move the traverser to the next match.
+   *
+   * @return true if the traverser points to a match, false if it is exhausted
+   */
+  bool SeekMatch() {
+    for (; traverser_ptr_ && *traverser_ptr_; (*traverser_ptr_)++) {
+      const size_t depth = traverser_ptr_->GetDepth();
+      const automaton_state_t state =
+          automaton_ptr_->Step(automaton_states_[depth - 1], traverser_ptr_->GetStateLabel());
+
+      TRACE("automaton step %lu depth: %lu -> %u", traverser_ptr_->GetStateLabel(), depth, state);
+      automaton_states_.resize(depth);
+      automaton_states_.push_back(state);
+      candidate_codepoints_.resize(exact_prefix_ + depth - 1);
+      candidate_codepoints_.push_back(traverser_ptr_->GetStateLabel());
+
+      // don't consider subtrees which can not be matched anyways
+      if (state == stringdistance::LevenshteinAutomaton::DEAD_STATE) {
+        traverser_ptr_->Prune();
+        continue;
+      }
+
+      if (traverser_ptr_->IsFinalState() && automaton_ptr_->IsFinal(state)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  int32_t GetScore() const { return automaton_ptr_->GetScore(automaton_states_.back()); }
+
+  void UpdateCandidate() {
+    candidate_.clear();
+    utf8::unchecked::utf32to8(candidate_codepoints_.begin(), candidate_codepoints_.end(), back_inserter(candidate_));
+  }
+};
+
+} /* namespace matching */
+} /* namespace dictionary */
+} /* namespace keyvi */
+#endif  // KEYVI_DICTIONARY_MATCHING_FUZZY_AUTOMATON_MATCHING_H_
@@ -38,6 +38,7 @@
 #include "keyvi/dictionary/fsa/traverser_types.h"
 #include "keyvi/dictionary/fsa/zip_state_traverser.h"
 #include "keyvi/dictionary/match.h"
+#include "keyvi/dictionary/match_view.h"
 #include "keyvi/dictionary/util/utf8_utils.h"
 #include "keyvi/stringdistance/levenshtein.h"
 
@@ -56,6 +57,8 @@ keyvi::dictionary::match_t NextFilteredMatch(const MatcherT&, const DeletedT&);
 }  // namespace internal
 }  // namespace index
 namespace dictionary {
+class QueryContext;
+
 namespace matching {
 
 template <class codepointInnerTraverserType = fsa::WeightedStateTraverser>
@@ -136,6 +139,22 @@ class FuzzyMatching final {
       uint64_t state = fsa->GetStartState();
       size_t depth = 0;
       size_t utf8_depth = 0;
+
+      // a code point has at least 1 byte, so the jump never crosses the exact prefix
+      if (minimum_exact_prefix >= ROOT_JUMP_TABLE_DEPTH) {
+        size_t jumped_bytes = 0;
+        state = fsa->TryJumpTransitions(state, query, &jumped_bytes);
+
+        // count the code points jumped over and finish the last one if the jump ended within it
+        while (utf8_depth < jumped_bytes) {
+          utf8_depth += util::Utf8Utils::GetCharLength(query[utf8_depth]);
+          ++depth;
+        }
+        for (size_t i = jumped_bytes; state != 0 && i < utf8_depth; ++i) {
+          state = fsa->TryWalkTransition(state, query[i]);
+        }
+      }
+
       while (state != 0 && depth < minimum_exact_prefix) {
         const size_t code_point_length = util::Utf8Utils::GetCharLength(query[utf8_depth]);
         for (size_t i = 0; i < code_point_length; ++i, ++utf8_depth) {
@@ -157,29 +176,148 @@ class FuzzyMatching final {
   match_t& FirstMatch() { return first_match_; }
 
   match_t NextMatch() {
-    for (; traverser_ptr_ && *traverser_ptr_; (*traverser_ptr_)++) {
-      TRACE("metric->put %lu  depth: %lu", traverser_ptr_->GetStateLabel(), candidate_length() - 1);
-      const int32_t intermediate_score = metric_ptr_->Put(traverser_ptr_->GetStateLabel(), candidate_length() - 1);
-      // don't consider subtrees which can not be matched anyways
-      if (metric_ptr_->GetInputSequence().size() > candidate_length() && intermediate_score > max_edit_distance_) {
-        traverser_ptr_->Prune();
-        continue;
+    if (!SeekMatch()) {
+      return match_t();
+    }
+
+    TRACE("found match %s %lu", metric_ptr_->GetCandidate().c_str(), traverser_ptr_->GetStateValue());
+    match_t m = std::make_shared<Match>(0, candidate_length(), metric_ptr_->GetCandidate(), metric_ptr_->GetScore(),
+                                        traverser_ptr_->GetFsa(), traverser_ptr_->GetStateValue());
+    (*traverser_ptr_)++;
+    return m;
+  }
+
+  /**
+   * Reinitialize the matcher for a new query, reusing the memory allocated for previous queries.
+   *
+   * Other than the factory methods this does not create a first match, all matches are returned by
+   * NextMatch(Match*).
+   *
+   * @param fsa the fsa
+   * @param start_state the state to start from
+   * @param query the query
+   * @param max_edit_distance the maximum allowed edit distance
+   * @param minimum_exact_prefix the minimum exact prefix to match before matching approximate
+   */
+  void Reset(const fsa::automata_t& fsa, const uint64_t start_state, const std::string& query,
+             const int32_t max_edit_distance, const size_t minimum_exact_prefix = 2) {
+    max_edit_distance_ = max_edit_distance;
+    exact_prefix_ = minimum_exact_prefix;
+    first_match_state_ = 0;
+
+    codepoints_.clear();
+    utf8::unchecked::utf8to32(query.begin(), query.end(), back_inserter(codepoints_));
+
+    uint64_t state = codepoints_.size() < minimum_exact_prefix ? 0 : start_state;
+    size_t utf8_depth = 0;
+    for (size_t depth = 0; state != 0 && depth < minimum_exact_prefix; ++depth) {
+      const size_t code_point_length = util::Utf8Utils::GetCharLength(query[utf8_depth]);
+      for (size_t i = 0; state != 0 && i < code_point_length; ++i, ++utf8_depth) {
+        state = fsa->TryWalkTransition(state, query[utf8_depth]);
       }
+    }
 
-      if (metric_ptr_->GetInputSequence().size() + max_edit_distance_ < candidate_length()) {
-        traverser_ptr_->Prune();
-        continue;
+    if (state == 0) {
+      if (traverser_ptr_) {
+        traverser_ptr_->Reset(fsa, 0);
       }
+      return;
+    }
 
-      if (traverser_ptr_->IsFinalState() && metric_ptr_->GetScore() <= max_edit_distance_) {
-        TRACE("found match %s %lu", metric_ptr_->GetCandidate().c_str(), traverser_ptr_->GetStateValue());
-        match_t m = std::make_shared<Match>(0, candidate_length(), metric_ptr_->GetCandidate(), metric_ptr_->GetScore(),
-                                            traverser_ptr_->GetFsa(), traverser_ptr_->GetStateValue());
-        (*traverser_ptr_)++;
-        return m;
+    // initialize the distance metric with the exact prefix
+    if (metric_ptr_) {
+      metric_ptr_->Reset(codepoints_, max_edit_distance);
+    } else {
+      metric_ptr_.reset(new stringdistance::Levenshtein(codepoints_, 20, max_edit_distance));
+    }
+
+    for (size_t i = 0; i < exact_prefix_; ++i) {
+      metric_ptr_->Put(codepoints_[i], i);
+    }
+
+    if (fsa->IsFinalState(state) && metric_ptr_->GetScore() <= max_edit_distance) {
+      first_match_state_ = state;
+      metric_ptr_->GetCandidate(&candidate_);
+    }
+
+    if (traverser_ptr_) {
+      traverser_ptr_->Reset(fsa, state);
+    } else {
+      traverser_ptr_.reset(new fsa::CodePointStateTraverser<codepointInnerTraverserType>(fsa, state));
+    }
+  }
+
+  /**
+   * Get the next match without allocating, see Reset.
+   *
+   * @param match the match to fill in
+   * @return true if a match has been found, false if the matcher is exhausted
+   */
+  bool NextMatch(Match* match) {
+    if (first_match_state_) {
+      match->Reset(0, exact_prefix_, candidate_, metric_ptr_->GetScore(), traverser_ptr_->GetFsa(),
+                   traverser_ptr_->GetFsa()->GetStateValue(first_match_state_));
+      first_match_state_ = 0;
+      return true;
+    }
+
+    if (!SeekMatch()) {
+      return false;
+    }
+
+    metric_ptr_->GetCandidate(&candidate_);
+    match->Reset(0, candidate_length(), candidate_, metric_ptr_->GetScore(), traverser_ptr_->GetFsa(),
+                 traverser_ptr_->GetStateValue());
+    (*traverser_ptr_)++;
+    return true;
+  }
+
+  /**
+   * Call the visitor for every remaining match, without creating Match objects.
+   *
+   * The visitor gets a MatchView which is only valid during the call, it can return false to stop early.
+   *
+   * @param visitor callable taking a MatchView&
+   */
+  template <class VisitorT>
+  void ForEachMatch(VisitorT&& visitor) {
+    ForEachMatch(std::forward<VisitorT>(visitor), [](const MatchView&) { return false; });
+  }
+
+  /**
+   * Call the visitor for every remaining match that is not filtered.
+   *
+   * @param visitor callable taking a MatchView&
+   * @param is_filtered callable taking a MatchView&, returns true if the match should be skipped
+   */
+  template <class VisitorT, class FilterT>
+  void ForEachMatch(VisitorT&& visitor, FilterT&& is_filtered) {
+    if (first_match_) {
+      MatchView view(*first_match_);
+      const bool proceed = is_filtered(view) || CallVisitor(visitor, view);
+      first_match_.reset();
+      if (!proceed) {
+        return;
+      }
+    } else if (first_match_state_) {
+      MatchView view(0, exact_prefix_, candidate_, metric_ptr_->GetScore(), traverser_ptr_->GetFsa(),
+                     traverser_ptr_->GetFsa()->GetStateValue(first_match_state_));
+      first_match_state_ = 0;
+      if (!is_filtered(view) && !CallVisitor(visitor, view)) {
+        return;
+      }
+    }
+
+    while (SeekMatch()) {
+      metric_ptr_->GetCandidate(&candidate_);
+      MatchView view(0, candidate_length(), candidate_, metric_ptr_->GetScore(), traverser_ptr_->GetFsa(),
+                     traverser_ptr_->GetStateValue());
+      const bool proceed = is_filtered(view) || CallVisitor(visitor, view);
+      (*traverser_ptr_)++;
+      if (!proceed) {
+        return;
       }
     }
-    return match_t();
   }
 
  private:
@@ -199,13 +337,47 @@ class FuzzyMatching final {
 
   FuzzyMatching() : max_edit_distance_(0), exact_prefix_(0) {}
 
+  /**
+   * Move the traverser to the next match.
+   *
+   * @return true if the traverser points to a match, false if it is exhausted
+   */
+  bool SeekMatch() {
+    for (; traverser_ptr_ && *traverser_ptr_; (*traverser_ptr_)++) {
+      TRACE("metric->put %lu  depth: %lu", traverser_ptr_->GetStateLabel(), candidate_length() - 1);
+      const int32_t intermediate_score = metric_ptr_->Put(traverser_ptr_->GetStateLabel(), candidate_length() - 1);
+      // don't consider subtrees which can not be matched anyways
+      if (metric_ptr_->GetInputSequence().size() > candidate_length() && intermediate_score > max_edit_distance_) {
+        traverser_ptr_->Prune();
+        continue;
+      }
+
+      if (metric_ptr_->GetInputSequence().size() + max_edit_distance_ < candidate_length()) {
+        traverser_ptr_->Prune();
+        continue;
+      }
+
+      if (traverser_ptr_->IsFinalState() && metric_ptr_->GetScore() <= max_edit_distance_) {
+        return true;
+      }
+    }
+    return false;
+  }
+
  private:
   std::unique_ptr<stringdistance::Levenshtein> metric_ptr_;
   std::unique_ptr<fsa::CodePointStateTraverser<codepointInnerTraverserType>> traverser_ptr_;
-  const int32_t max_edit_distance_;
-  const size_t exact_prefix_;
+  int32_t max_edit_distance_;
+  size_t exact_prefix_;
   match_t first_match_;
 
+  // buffers for reuse, see Reset
+  std::vector<uint32_t> codepoints_;
+  std::string candidate_;
+  uint64_t first_match_state_ = 0;
+
+  friend class dictionary::QueryContext;
+
   template <class PayloadT, class SegmentT>
   friend class index::internal::BaseIndexReader;
 
@@ -0,0 +1,316 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * fuzzy_top_n_matching.h
+ *
+ * Best-first fuzzy matching returning the n best matches by edit distance and weight.
+ */
+
+#ifndef KEYVI_DICTIONARY_MATCHING_FUZZY_TOP_N_MATCHING_H_
+#define KEYVI_DICTIONARY_MATCHING_FUZZY_TOP_N_MATCHING_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utf8.h"
+
+#include "keyvi/dictionary/fsa/automata.h"
+#include "keyvi/dictionary/fsa/traversal/weighted_traversal.h"
+#include "keyvi/dictionary/match.h"
+#include "keyvi/dictionary/matching/fuzzy_matching.h"
+#include "keyvi/dictionary/util/utf8_utils.h"
+#include "keyvi/stringdistance/levenshtein_automaton.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace dictionary {
+namespace matching {
+
+/**
+ * Fuzzy matcher returning the top n matches ordered by edit distance first and weight second.
+ *
+ * Instead of a depth first traversal, states are expanded best first: a state is prioritized by a lower bound of the
+ * edit distance of all keys below it, taken from a stringdistance::LevenshteinAutomaton, and by its inner weight, which
+ * is an upper bound of the weights below it. A match is returned once it is at the top of the queue, at that point no
+ * state left in the queue can lead to a better match. The search stops after n matches, the rest of the dictionary is
+ * never visited.
+ *
+ * Without inner weights, matches with the same distance are returned in no particular order.
+ */
+class FuzzyTopNMatching final {
+ public:
+  /**
+   * Create a fuzzy matcher from a single Fsa
+   *
+   * @param fsa the fsa
+   * @param query the query
+   * @param max_edit_distance the maximum allowed edit distance
+   * @param minimum_exact_prefix the minimum exact prefix to match before matching approximate
+   * @param top_n the number of matches to return
+   */
+  static FuzzyTopNMatching FromSingleFsa(const fsa::automata_t& fsa, const std::string& query,
+                                         const int32_t max_edit_distance, const size_t minimum_exact_prefix,
+                                         const size_t top_n) {
+    return FromMulipleFsas({fsa}, query, max_edit_distance, minimum_exact_prefix, top_n);
+  }
+
+  /**
+   * Create a fuzzy matcher from multiple Fsas
+   *
+   * If a key exists in several fsas, only the match of the last fsa is returned.
+   *
+   * @param fsas a vector of fsas, ordered oldest to newest
+   * @param query the query
+   * @param max_edit_distance the maximum allowed edit distance
+   * @param minimum_exact_prefix the minimum exact prefix to match before matching approximate
+   * @param top_n the number of matches to return
+   */
+  static FuzzyTopNMatching FromMulipleFsas(const std::vector<fsa::automata_t>& fsas, const std::string& query,
+                                           const int32_t max_edit_distance, const size_t minimum_exact_prefix,
+                                           const size_t top_n) {
+    std::vector<uint32_t> codepoints;
+    utf8::unchecked::utf8to32(query.begin(), query.end(), back_inserter(codepoints));
+
+    if (top_n == 0 || codepoints.size() < minimum_exact_prefix) {
+      return FuzzyTopNMatching();
+    }
+
+    std::vector<std::pair<fsa::automata_t, uint64_t>> fsa_start_state_pairs =
+        FuzzyMatching<>::FilterWithExactPrefix(fsas, query, minimum_exact_prefix);
+
+    if (fsa_start_state_pairs.size() == 0) {
+      return FuzzyTopNMatching();
+    }
+
+    return FuzzyTopNMatching(std::move(fsa_start_state_pairs), codepoints, max_edit_distance, minimum_exact_prefix,
+                             top_n);
+  }
+
+  /**
+   * All matches are returned by NextMatch, the first match is always empty.
+   */
+  match_t& FirstMatch() { return first_match_; }
+
+  match_t NextMatch() {
+    while (matches_ < top_n_ && !queue_.empty()) {
+      const Entry entry = queue_.top();
+      queue_.pop();
+
+      if (entry.is_match) {
+        UpdateCandidate(entry.path);
+        if (IsShadowed(entry.fsa_index)) {
+          continue;
+        }
+
+        ++matches_;
+        const fsa::automata_t& fsa = fsa_start_state_pairs_[entry.fsa_index].first;
+        TRACE("found match %s score %d weight %u", candidate_.c_str(), entry.distance, entry.weight);
+        return std::make_shared<Match>(0, utf8::unchecked::distance(candidate_.begin(), candidate_.end()), candidate_,
+                                       entry.distance, fsa, fsa->GetStateValue(entry.state));
+      }
+
+      Expand(entry);
+    }
+
+    return match_t();
+  }
+
+  /**
+   * Undo counting the last match, e.g. because the caller filtered it.
+   */
+  void ResetLastMatch() { --matches_; }
+
+ private:
+  using automaton_state_t = stringdistance::LevenshteinAutomaton::state_t;
+
+  static constexpr uint32_t NO_PATH = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * A state to expand or a match to return.
+   */
+  struct Entry {
+    // lower bound of the distance for states, the distance for matches
+    int32_t distance;
+    // upper bound of the weight for states, the weight for matches
+    uint32_t weight;
+    // insertion order, to prefer matches and the states found first on ties
+    uint64_t sequence;
+    uint64_t state;
+    uint32_t path;
+    uint32_t fsa_index;
+    automaton_state_t automaton_state;
+    // the codepoint read so far and the number of bytes missing, if the state is within a multi byte codepoint
+    uint32_t partial_codepoint;
+    uint8_t missing_bytes;
+    bool is_match;
+
+    // std::priority_queue returns the greatest element
+    bool operator<(const Entry& other) const {
+      if (distance != other.distance) {
+        return distance > other.distance;
+      }
+      if (weight != other.weight) {
+        return weight < other.weight;
+      }
+      if (is_match != other.is_match) {
+        return other.is_match;
+      }
+      return sequence > other.sequence;
+    }
+  };
+
+  /**
+   * Node of the tree of traversed paths, used to build the candidate string of a match.
+   */
+  struct PathNode {
+    uint32_t parent;
+    unsigned char label;
+  };
+
+  std::vector<std::pair<fsa::automata_t, uint64_t>> fsa_start_state_pairs_;
+  std::unique_ptr<stringdistance::LevenshteinAutomaton> automaton_ptr_;
+  size_t top_n_ = 0;
+  size_t matches_ = 0;
+  uint64_t sequence_ = 0;
+  match_t first_match_;
+
+  std::priority_queue<Entry> queue_;
+  std::vector<PathNode> path_nodes_;
+  std::string exact_prefix_;
+  std::string candidate_;
+
+  fsa::traversal::TraversalState<fsa::traversal::WeightedTransition> transitions_;
+  fsa::traversal::TraversalPayload<fsa::traversal::WeightedTransition> payload_{};
+
+  FuzzyTopNMatching() {}
+
+  FuzzyTopNMatching(std::vector<std::pair<fsa::automata_t, uint64_t>>&& fsa_start_state_pairs,
+                    const std::vector<uint32_t>& codepoints, const int32_t max_edit_distance,
+                    const size_t minimum_exact_prefix, const size_t top_n)
+      : fsa_start_state_pairs_(std::move(fsa_start_state_pairs)),
+        automaton_ptr_(std::make_unique<stringdistance::LevenshteinAutomaton>(codepoints, max_edit_distance)),
+        top_n_(top_n) {
+    automaton_state_t automaton_state = automaton_ptr_->GetStartState();
+    for (size_t i = 0; i < minimum_exact_prefix; ++i) {
+      automaton_state = automaton_ptr_->Step(automaton_state, codepoints[i]);
+    }
+
+    if (automaton_state == stringdistance::LevenshteinAutomaton::DEAD_STATE) {
+      return;
+    }
+
+    utf8::unchecked::utf32to8(codepoints.begin(), codepoints.begin() + minimum_exact_prefix,
+                              back_inserter(exact_prefix_));
+
+    for (uint32_t fsa_index = 0; fsa_index < fsa_start_state_pairs_.size(); ++fsa_index) {
+      const uint64_t state = fsa_start_state_pairs_[fsa_index].second;
+
+      // without a stored inner weight there is no upper bound
+      uint32_t weight = fsa_start_state_pairs_[fsa_index].first->GetInnerWeight(state);
+      weight = weight != 0 ? weight : std::numeric_limits<uint32_t>::max();
+
+      queue_.push(Entry{automaton_ptr_->GetMinimumDistance(automaton_state), weight, sequence_++, state, NO_PATH,
+                        fsa_index, automaton_state, 0, 0, false});
+    }
+  }
+
+  void Expand(const Entry& entry) {
+    const fsa::automata_t& fsa = fsa_start_state_pairs_[entry.fsa_index].first;
+
+    if (entry.missing_bytes == 0 && fsa->IsFinalState(entry.state) && automaton_ptr_->IsFinal(entry.automaton_state)) {
+      Entry match = entry;
+      match.distance = automaton_ptr_->GetScore(entry.automaton_state);
+      match.weight = fsa->GetWeight(fsa->GetStateValue(entry.state));
+      match.sequence = sequence_++;
+      match.is_match = true;
+      queue_.push(match);
+    }
+
+    fsa->GetOutGoingTransitions(entry.state, &transitions_, &payload_, entry.weight);
+
+    for (const auto& transition : transitions_.traversal_state_payload.transitions) {
+      Entry child = entry;
+      child.state = transition.state;
+      child.weight = transition.weight;
+      child.sequence = sequence_++;
+
+      if (entry.missing_bytes == 0) {
+        const size_t length = util::Utf8Utils::GetCharLength(transition.label);
+        child.missing_bytes = static_cast<uint8_t>(length - 1);
+        child.partial_codepoint = length == 1 ? transition.label : transition.label & (0x7f >> length);
+      } else {
+        child.missing_bytes = entry.missing_bytes - 1;
+        child.partial_codepoint = (entry.partial_codepoint << 6) | (transition.label & 0x3f);
+      }
+
+      // step the automaton once the codepoint is complete
+      if (child.missing_bytes == 0) {
+        child.automaton_state = automaton_ptr_->Step(entry.automaton_state, child.partial_codepoint);
+        if (child.automaton_state == stringdistance::LevenshteinAutomaton::DEAD_STATE) {
+          continue;
+        }
+        child.distance = automaton_ptr_->GetMinimumDistance(child.automaton_state);
+      }
+
+      child.path = static_cast<uint32_t>(path_nodes_.size());
+      path_nodes_.push_back(PathNode{entry.path, transition.label});
+      queue_.push(child);
+    }
+  }
+
+  void UpdateCandidate(uint32_t path) {
+    candidate_.clear();
+    for (; path != NO_PATH; path = path_nodes_[path].parent) {
+      candidate_.push_back(path_nodes_[path].label);
+    }
+    candidate_.append(exact_prefix_.rbegin(), exact_prefix_.rend());
+    std::reverse(candidate_.begin(), candidate_.end());
+  }
+
+  /**
+   * @return true if the candidate exists in a newer fsa, which takes precedence
+   */
+  bool IsShadowed(const uint32_t fsa_index) const {
+    for (size_t i = fsa_index + 1; i < fsa_start_state_pairs_.size(); ++i) {
+      const fsa::automata_t& fsa = fsa_start_state_pairs_[i].first;
+      uint64_t state = fsa_start_state_pairs_[i].second;
+
+      for (size_t j = exact_prefix_.size(); state != 0 && j < candidate_.size(); ++j) {
+        state = fsa->TryWalkTransition(state, candidate_[j]);
+      }
+
+      if (state != 0 && fsa->IsFinalState(state)) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+} /* namespace matching */
+} /* namespace dictionary */
+} /* namespace keyvi */
+#endif  // KEYVI_DICTIONARY_MATCHING_FUZZY_TOP_N_MATCHING_H_
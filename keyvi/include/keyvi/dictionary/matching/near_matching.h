@@ -33,6 +33,7 @@
 #include "keyvi/dictionary/fsa/traverser_types.h"
 #include "keyvi/dictionary/fsa/zip_state_traverser.h"
 #include "keyvi/dictionary/match.h"
+#include "keyvi/dictionary/match_view.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -49,6 +50,8 @@ keyvi::dictionary::match_t NextFilteredMatch(const MatcherT&, const DeletedT&);
 }  // namespace internal
 }  // namespace index
 namespace dictionary {
+class QueryContext;
+
 namespace matching {
 
 template <class innerTraverserType = fsa::ComparableStateTraverser<fsa::NearStateTraverser>>
@@ -118,42 +121,184 @@ class NearMatching final {
   match_t& FirstMatch() { return first_match_; }
 
   match_t NextMatch() {
-    TRACE("call next match %lu", matched_depth_);
-    for (; traverser_ptr_ && traverser_ptr_->GetDepth() > matched_depth_;) {
-      if (traverser_ptr_->IsFinalState()) {
-        // optimize? fill vector upfront?
-        std::string match_str =
-            exact_prefix_ + std::string(reinterpret_cast<const char*>(traverser_ptr_->GetStateLabels().data()),
-                                        traverser_ptr_->GetDepth());
-
-        // length should be query.size???
-        match_t m = std::make_shared<Match>(0, traverser_ptr_->GetDepth() + exact_prefix_.size(), match_str,
-                                            exact_prefix_.size() + traverser_ptr_->GetTraversalPayload().exact_depth,
-                                            traverser_ptr_->GetFsa(), traverser_ptr_->GetStateValue());
-
-        if (!greedy_) {
-          // remember the depth
-          TRACE("found a match, remember depth, only allow matches with same depth %ld",
-                traverser_ptr_->GetTraversalPayload().exact_depth);
-          matched_depth_ = traverser_ptr_->GetTraversalPayload().exact_depth;
-        }
-
-        (*traverser_ptr_)++;
-        return m;
+    if (!SeekMatch()) {
+      return match_t();
+    }
+
+    // optimize? fill vector upfront?
+    std::string match_str =
+        exact_prefix_ + std::string(reinterpret_cast<const char*>(traverser_ptr_->GetStateLabels().data()),
+                                    traverser_ptr_->GetDepth());
+
+    // length should be query.size???
+    match_t m = std::make_shared<Match>(0, traverser_ptr_->GetDepth() + exact_prefix_.size(), match_str,
+                                        exact_prefix_.size() + traverser_ptr_->GetTraversalPayload().exact_depth,
+                                        traverser_ptr_->GetFsa(), traverser_ptr_->GetStateValue());
+
+    RememberMatchedDepth();
+    (*traverser_ptr_)++;
+    return m;
+  }
+
+  /**
+   * Reinitialize the matcher for a new query, reusing the memory allocated for previous queries.
+   *
+   * Other than the factory methods this does not create a first match, all matches are returned by
+   * NextMatch(Match*).
+   *
+   * @param fsa the fsa
+   * @param start_state the state to start from
+   * @param query the query
+   * @param minimum_exact_prefix the minimum exact prefix to match before matching approximate
+   * @param greedy if true matches everything below minimum prefix
+   */
+  void Reset(const fsa::automata_t& fsa, const uint64_t start_state, const std::string& query,
+             const size_t minimum_exact_prefix, const bool greedy = false) {
+    uint64_t state = query.size() < minimum_exact_prefix ? 0 : start_state;
+    first_match_state_ = 0;
+    matched_depth_ = 0;
+    greedy_ = greedy;
+
+    for (size_t i = 0; state != 0 && i < minimum_exact_prefix; ++i) {
+      state = fsa->TryWalkTransition(state, query[i]);
+    }
+
+    if (state == 0) {
+      if (traverser_ptr_) {
+        traverser_ptr_->Reset(fsa, 0, fsa::traversal::TraversalPayload<fsa::traversal::NearTransition>());
       }
-      (*traverser_ptr_)++;
+      return;
+    }
+
+    exact_prefix_.assign(query, 0, minimum_exact_prefix);
+    query_length_ = query.size();
+
+    if (!near_key_) {
+      near_key_ = std::make_shared<std::string>();
+    }
+    near_key_->assign(query, minimum_exact_prefix);
+
+    if (traverser_ptr_) {
+      traverser_ptr_->Reset(fsa, state, fsa::traversal::TraversalPayload<fsa::traversal::NearTransition>(near_key_));
+    } else {
+      traverser_ptr_ = std::make_unique<innerTraverserType>(
+          fsa, state, fsa::traversal::TraversalPayload<fsa::traversal::NearTransition>(near_key_), true, 0);
+    }
+
+    if (fsa->IsFinalState(state)) {
+      first_match_state_ = state;
+    }
+  }
+
+  /**
+   * Get the next match without allocating, see Reset.
+   *
+   * @param match the match to fill in
+   * @return true if a match has been found, false if the matcher is exhausted
+   */
+  bool NextMatch(Match* match) {
+    if (first_match_state_) {
+      match_buffer_.assign(exact_prefix_);
+      match_buffer_.append(*near_key_);
+      match->Reset(0, query_length_, match_buffer_, exact_prefix_.size(), traverser_ptr_->GetFsa(),
+                   traverser_ptr_->GetFsa()->GetStateValue(first_match_state_));
+      first_match_state_ = 0;
+      return true;
+    }
+
+    if (!SeekMatch()) {
+      return false;
     }
 
-    return match_t();
+    match_buffer_.assign(exact_prefix_);
+    match_buffer_.append(reinterpret_cast<const char*>(traverser_ptr_->GetStateLabels().data()),
+                         traverser_ptr_->GetDepth());
+    match->Reset(0, traverser_ptr_->GetDepth() + exact_prefix_.size(), match_buffer_,
+                 exact_prefix_.size() + traverser_ptr_->GetTraversalPayload().exact_depth, traverser_ptr_->GetFsa(),
+                 traverser_ptr_->GetStateValue());
+
+    RememberMatchedDepth();
+    (*traverser_ptr_)++;
+    return true;
+  }
+
+  /**
+   * Call the visitor for every remaining match, without creating Match objects.
+   *
+   * The visitor gets a MatchView which is only valid during the call, it can return false to stop early.
+   *
+   * @param visitor callable taking a MatchView&
+   */
+  template <class VisitorT>
+  void ForEachMatch(VisitorT&& visitor) {
+    ForEachMatch(std::forward<VisitorT>(visitor), [](const MatchView&) { return false; });
+  }
+
+  /**
+   * Call the visitor for every remaining match that is not filtered.
+   *
+   * A filtered match does not count as match when restricting the depth of the following matches.
+   *
+   * @param visitor callable taking a MatchView&
+   * @param is_filtered callable taking a MatchView&, returns true if the match should be skipped
+   */
+  template <class VisitorT, class FilterT>
+  void ForEachMatch(VisitorT&& visitor, FilterT&& is_filtered) {
+    if (first_match_) {
+      MatchView view(*first_match_);
+      const bool proceed = is_filtered(view) || CallVisitor(visitor, view);
+      first_match_.reset();
+      if (!proceed) {
+        return;
+      }
+    } else if (first_match_state_) {
+      match_buffer_.assign(exact_prefix_);
+      match_buffer_.append(*near_key_);
+      MatchView view(0, query_length_, match_buffer_, exact_prefix_.size(), traverser_ptr_->GetFsa(),
+                     traverser_ptr_->GetFsa()->GetStateValue(first_match_state_));
+      first_match_state_ = 0;
+      if (!is_filtered(view) && !CallVisitor(visitor, view)) {
+        return;
+      }
+    }
+
+    while (SeekMatch()) {
+      match_buffer_.assign(exact_prefix_);
+      match_buffer_.append(reinterpret_cast<const char*>(traverser_ptr_->GetStateLabels().data()),
+                           traverser_ptr_->GetDepth());
+      MatchView view(0, traverser_ptr_->GetDepth() + exact_prefix_.size(), match_buffer_,
+                     exact_prefix_.size() + traverser_ptr_->GetTraversalPayload().exact_depth, traverser_ptr_->GetFsa(),
+                     traverser_ptr_->GetStateValue());
+
+      bool proceed = true;
+      if (is_filtered(view)) {
+        ResetLastMatch();
+      } else {
+        RememberMatchedDepth();
+        proceed = CallVisitor(visitor, view);
+      }
+      (*traverser_ptr_)++;
+      if (!proceed) {
+        return;
+      }
+    }
   }
 
  private:
   std::unique_ptr<innerTraverserType> traverser_ptr_;
-  const std::string exact_prefix_;
+  std::string exact_prefix_;
   match_t first_match_;
-  const bool greedy_ = false;
+  bool greedy_ = false;
   size_t matched_depth_ = 0;
 
+  // buffers for reuse, see Reset
+  std::shared_ptr<std::string> near_key_;
+  std::string match_buffer_;
+  size_t query_length_ = 0;
+  uint64_t first_match_state_ = 0;
+
+  friend class dictionary::QueryContext;
+
   NearMatching(std::unique_ptr<innerTraverserType>&& traverser, match_t&& first_match,
                std::string&& minimum_exact_prefix, const bool greedy)
       : traverser_ptr_(std::move(traverser)),
@@ -163,6 +308,32 @@ class NearMatching final {
 
   NearMatching() {}
 
+  /**
+   * Move the traverser to the next match.
+   *
+   * @return true if the traverser points to a match, false if it is exhausted
+   */
+  bool SeekMatch() {
+    TRACE("call next match %lu", matched_depth_);
+    for (; traverser_ptr_ && traverser_ptr_->GetDepth() > matched_depth_;) {
+      if (traverser_ptr_->IsFinalState()) {
+        return true;
+      }
+      (*traverser_ptr_)++;
+    }
+
+    return false;
+  }
+
+  void RememberMatchedDepth() {
+    if (!greedy_) {
+      // remember the depth
+      TRACE("found a match, remember depth, only allow matches with same depth %ld",
+            traverser_ptr_->GetTraversalPayload().exact_depth);
+      matched_depth_ = traverser_ptr_->GetTraversalPayload().exact_depth;
+    }
+  }
+
   template <class PayloadT, class SegmentT>
   friend class index::internal::BaseIndexReader;
 
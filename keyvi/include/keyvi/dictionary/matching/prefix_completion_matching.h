@@ -25,6 +25,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -33,6 +34,7 @@
 #include "keyvi/dictionary/fsa/traverser_types.h"
 #include "keyvi/dictionary/fsa/zip_state_traverser.h"
 #include "keyvi/dictionary/match.h"
+#include "keyvi/dictionary/match_view.h"
 #include "keyvi/dictionary/util/utf8_utils.h"
 #include "keyvi/stringdistance/levenshtein.h"
 #include "utf8.h"
@@ -50,6 +52,8 @@ keyvi::dictionary::match_t NextFilteredMatch(const MatcherT&, const DeletedT&);
 }  // namespace internal
 }  // namespace index
 namespace dictionary {
+class QueryContext;
+
 namespace matching {
 
 template <class innerTraverserType = fsa::WeightedStateTraverser>
@@ -83,7 +87,8 @@ class PrefixCompletionMatching final {
 
     const size_t query_length = query.size();
     size_t depth = 0;
-    uint64_t state = start_state;
+    uint64_t state = fsa->TryJumpTransitions(start_state, query, &depth);
+    traversal_stack->insert(traversal_stack->end(), query.begin(), query.begin() + depth);
 
     match_t first_match;
 
@@ -124,9 +129,9 @@ class PrefixCompletionMatching final {
     std::vector<std::pair<fsa::automata_t, uint64_t>> fsa_start_state_pairs;
 
     for (const fsa::automata_t& fsa : fsas) {
-      uint64_t state = fsa->GetStartState();
-
       size_t depth = 0;
+      uint64_t state = fsa->TryJumpTransitions(fsa->GetStartState(), query, &depth);
+
       while (state != 0 && depth != query_length) {
         state = fsa->TryWalkTransition(state, query[depth++]);
       }
@@ -167,24 +172,136 @@ class PrefixCompletionMatching final {
   match_t& FirstMatch() { return first_match_; }
 
   match_t NextMatch() {
-    for (; traverser_ptr_ && *traverser_ptr_; (*traverser_ptr_)++) {
-      traversal_stack_->resize(prefix_length_ + traverser_ptr_->GetDepth() - 1);
-      traversal_stack_->push_back(traverser_ptr_->GetStateLabel());
-      TRACE("Current depth %d (%d)", prefix_length_ + traverser_ptr_->GetDepth() - 1, traversal_stack_->size());
+    if (!SeekMatch()) {
+      return match_t();
+    }
 
-      if (traverser_ptr_->IsFinalState()) {
-        std::string match_str = std::string(traversal_stack_->begin(), traversal_stack_->end());
+    std::string match_str = std::string(traversal_stack_->begin(), traversal_stack_->end());
+
+    TRACE("found final state at depth %d %s", prefix_length_ + traverser_ptr_->GetDepth(), match_str.c_str());
+    match_t m = std::make_shared<Match>(0, prefix_length_ + traverser_ptr_->GetDepth(), match_str, 0,
+                                        traverser_ptr_->GetFsa(), traverser_ptr_->GetStateValue());
+
+    (*traverser_ptr_)++;
+    return m;
+  }
+
+  /**
+   * Reinitialize the matcher for a new query, reusing the memory allocated for previous queries.
+   *
+   * Other than the factory methods this does not create a first match, all matches are returned by
+   * NextMatch(Match*).
+   *
+   * @param fsa the fsa
+   * @param start_state the state to start from
+   * @param query the query
+   */
+  void Reset(const fsa::automata_t& fsa, const uint64_t start_state, const std::string& query) {
+    const size_t query_length = query.size();
+    size_t depth = 0;
+    uint64_t state = start_state;
+    first_match_state_ = 0;
+    prefix_length_ = query_length;
+
+    if (state != 0) {
+      state = fsa->TryJumpTransitions(state, query, &depth);
+    }
+
+    while (state != 0 && depth != query_length) {
+      state = fsa->TryWalkTransition(state, query[depth++]);
+    }
+
+    if (!traversal_stack_) {
+      traversal_stack_ = std::make_unique<std::vector<unsigned char>>();
+      traversal_stack_->reserve(1024);
+    }
+    traversal_stack_->assign(query.begin(), query.end());
+
+    if (traverser_ptr_) {
+      traverser_ptr_->Reset(fsa, state);
+    } else if (state != 0) {
+      traverser_ptr_ = std::make_unique<innerTraverserType>(fsa, state);
+    }
+
+    if (state != 0 && fsa->IsFinalState(state)) {
+      first_match_state_ = state;
+    }
+  }
+
+  /**
+   * Get the next match without allocating, see Reset.
+   *
+   * @param match the match to fill in
+   * @return true if a match has been found, false if the matcher is exhausted
+   */
+  bool NextMatch(Match* match) {
+    if (first_match_state_) {
+      match->Reset(0, prefix_length_,
+                   std::string_view(reinterpret_cast<const char*>(traversal_stack_->data()), prefix_length_), 0,
+                   traverser_ptr_->GetFsa(), traverser_ptr_->GetFsa()->GetStateValue(first_match_state_));
+      first_match_state_ = 0;
+      return true;
+    }
+
+    if (!SeekMatch()) {
+      return false;
+    }
+
+    match->Reset(0, prefix_length_ + traverser_ptr_->GetDepth(),
+                 std::string_view(reinterpret_cast<const char*>(traversal_stack_->data()), traversal_stack_->size()),
+                 0, traverser_ptr_->GetFsa(), traverser_ptr_->GetStateValue());
+    (*traverser_ptr_)++;
+    return true;
+  }
 
-        TRACE("found final state at depth %d %s", prefix_length_ + traverser_ptr_->GetDepth(), match_str.c_str());
-        match_t m = std::make_shared<Match>(0, prefix_length_ + traverser_ptr_->GetDepth(), match_str, 0,
-                                            traverser_ptr_->GetFsa(), traverser_ptr_->GetStateValue());
+  /**
+   * Call the visitor for every remaining match, without creating Match objects.
+   *
+   * The visitor gets a MatchView which is only valid during the call, it can return false to stop early.
+   *
+   * @param visitor callable taking a MatchView&
+   */
+  template <class VisitorT>
+  void ForEachMatch(VisitorT&& visitor) {
+    ForEachMatch(std::forward<VisitorT>(visitor), [](const MatchView&) { return false; });
+  }
 
-        (*traverser_ptr_)++;
-        return m;
+  /**
+   * Call the visitor for every remaining match that is not filtered.
+   *
+   * @param visitor callable taking a MatchView&
+   * @param is_filtered callable taking a MatchView&, returns true if the match should be skipped
+   */
+  template <class VisitorT, class FilterT>
+  void ForEachMatch(VisitorT&& visitor, FilterT&& is_filtered) {
+    if (first_match_) {
+      MatchView view(*first_match_);
+      const bool proceed = is_filtered(view) || CallVisitor(visitor, view);
+      first_match_.reset();
+      if (!proceed) {
+        return;
+      }
+    } else if (first_match_state_) {
+      MatchView view(0, prefix_length_,
+                     std::string_view(reinterpret_cast<const char*>(traversal_stack_->data()), prefix_length_), 0,
+                     traverser_ptr_->GetFsa(), traverser_ptr_->GetFsa()->GetStateValue(first_match_state_));
+      first_match_state_ = 0;
+      if (!is_filtered(view) && !CallVisitor(visitor, view)) {
+        return;
       }
     }
 
-    return match_t();
+    while (SeekMatch()) {
+      MatchView view(
+          0, prefix_length_ + traverser_ptr_->GetDepth(),
+          std::string_view(reinterpret_cast<const char*>(traversal_stack_->data()), traversal_stack_->size()), 0,
+          traverser_ptr_->GetFsa(), traverser_ptr_->GetStateValue());
+      const bool proceed = is_filtered(view) || CallVisitor(visitor, view);
+      (*traverser_ptr_)++;
+      if (!proceed) {
+        return;
+      }
+    }
   }
 
   void SetMinWeight(uint32_t min_weight) { traverser_ptr_->SetMinWeight(min_weight); }
@@ -199,11 +316,33 @@ class PrefixCompletionMatching final {
 
   PrefixCompletionMatching() {}
 
+  /**
+   * Move the traverser to the next match.
+   *
+   * @return true if the traverser points to a match, false if it is exhausted
+   */
+  bool SeekMatch() {
+    for (; traverser_ptr_ && *traverser_ptr_; (*traverser_ptr_)++) {
+      traversal_stack_->resize(prefix_length_ + traverser_ptr_->GetDepth() - 1);
+      traversal_stack_->push_back(traverser_ptr_->GetStateLabel());
+      TRACE("Current depth %d (%d)", prefix_length_ + traverser_ptr_->GetDepth() - 1, traversal_stack_->size());
+
+      if (traverser_ptr_->IsFinalState()) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
  private:
   std::unique_ptr<innerTraverserType> traverser_ptr_;
   match_t first_match_;
   std::unique_ptr<std::vector<unsigned char>> traversal_stack_;
-  const size_t prefix_length_ = 0;
+  size_t prefix_length_ = 0;
+  uint64_t first_match_state_ = 0;
+
+  friend class dictionary::QueryContext;
 
   // reset method for the index in the special case the match is deleted
   template <class MatcherT, class DeletedT>
@@ -0,0 +1,81 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * query_context.h
+ *
+ * Reusable scratch space for queries.
+ */
+
+#ifndef KEYVI_DICTIONARY_QUERY_CONTEXT_H_
+#define KEYVI_DICTIONARY_QUERY_CONTEXT_H_
+
+#include "keyvi/dictionary/match.h"
+#include "keyvi/dictionary/match_view.h"
+#include "keyvi/dictionary/matching/fuzzy_matching.h"
+#include "keyvi/dictionary/matching/near_matching.h"
+#include "keyvi/dictionary/matching/prefix_completion_matching.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace dictionary {
+
+class Dictionary;
+
+/**
+ * Holds the matchers and buffers of a query, so that they can be reused by the next query.
+ *
+ * Once the buffers have grown to the size required by the queries, querying with a context does not allocate memory.
+ * A context must not be shared between threads, use one per thread.
+ */
+class QueryContext final {
+ public:
+  QueryContext() {}
+
+  QueryContext& operator=(QueryContext const&) = delete;
+  QueryContext(const QueryContext& that) = delete;
+
+ private:
+  matching::FuzzyMatching<> fuzzy_matching_;
+  matching::PrefixCompletionMatching<> prefix_completion_matching_;
+  matching::NearMatching<> near_matching_;
+  Match match_;
+
+  friend class Dictionary;
+
+  /**
+   * Call the visitor for every match of the matcher.
+   *
+   * The visitor can return false to stop early, visitors returning void get all matches.
+   */
+  template <class MatcherT, class VisitorT>
+  void VisitMatches(MatcherT* matcher, VisitorT&& visitor) {
+    while (matcher->NextMatch(&match_)) {
+      if (!CallVisitor(visitor, match_)) {
+        TRACE("visitor requested stop");
+        return;
+      }
+    }
+  }
+};
+
+} /* namespace dictionary */
+} /* namespace keyvi */
+
+#endif  // KEYVI_DICTIONARY_QUERY_CONTEXT_H_
@@ -0,0 +1,259 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * text_annotator.h
+ *
+ * Find all dictionary keys in a text in a single pass.
+ */
+
+#ifndef KEYVI_DICTIONARY_TEXT_ANNOTATOR_H_
+#define KEYVI_DICTIONARY_TEXT_ANNOTATOR_H_
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "keyvi/dictionary/fsa/automata.h"
+#include "keyvi/dictionary/fsa/internal/intrinsics.h"
+#include "keyvi/dictionary/match_view.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace dictionary {
+
+enum class annotation_mode_t {
+  ALL,              // every match, including matches within or overlapping other matches
+  LONGEST,          // the longest match for every start position, matches can overlap
+  LEFTMOST_LONGEST  // non-overlapping matches, the leftmost match wins, the longest if several start there
+};
+
+/**
+ * Scans a text once and reports the keys of a dictionary found in it.
+ *
+ * Matches start at the beginning of the text or after a boundary character and end before a boundary character or at
+ * the end of the text. Without boundary characters keys are matched anywhere in the text.
+ *
+ * The annotator keeps a state for every start position that still has outgoing transitions and advances all of them
+ * with every byte, so the text is read only once. Stretches without active states are skipped by searching for the
+ * next boundary. Buffers are reused, an annotator must not be shared between threads.
+ */
+class TextAnnotator final {
+ public:
+  /**
+   * @param mode which matches to report
+   * @param boundaries characters that separate tokens
+   */
+  explicit TextAnnotator(const annotation_mode_t mode = annotation_mode_t::LEFTMOST_LONGEST,
+                         const std::string& boundaries = " ")
+      : mode_(mode), boundaries_(boundaries) {
+    boundary_table_.fill(false);
+    for (const char c : boundaries_) {
+      boundary_table_[static_cast<unsigned char>(c)] = true;
+    }
+    entries_.reserve(16);
+  }
+
+  /**
+   * Annotate the text, the visitor gets called for every match in order of the start position.
+   *
+   * For annotation_mode_t::ALL matches are reported in order of the end position instead. The matched string of the
+   * MatchView points into the text. The visitor can return false to stop early.
+   *
+   * @param fsa the fsa
+   * @param text the text
+   * @param visitor callable taking a MatchView&
+   */
+  template <class VisitorT>
+  void Annotate(const fsa::automata_t& fsa, const std::string_view text, VisitorT&& visitor) {
+    entries_.clear();
+    committed_end_ = 0;
+
+    const uint64_t start_state = fsa->GetStartState();
+    const size_t text_length = text.size();
+    size_t position = 0;
+
+    while (position < text_length) {
+      if (IsTokenStart(text, position) && position >= committed_end_) {
+        entries_.push_back({position, start_state, 0, 0});
+      }
+
+      const bool at_token_end = IsTokenEnd(text, position + 1);
+      size_t kept = 0;
+
+      for (size_t i = 0; i < entries_.size(); ++i) {
+        entry& e = entries_[i];
+
+        if (e.state != 0) {
+          e.state = fsa->TryWalkTransition(e.state, text[position]);
+
+          if (e.state != 0 && at_token_end && fsa->IsFinalState(e.state)) {
+            if (mode_ == annotation_mode_t::ALL) {
+              MatchView view(e.start, position + 1, text.substr(e.start, position + 1 - e.start), 0, fsa,
+                             fsa->GetStateValue(e.state));
+              if (!CallVisitor(visitor, view)) {
+                return;
+              }
+            } else {
+              e.match_end = position + 1;
+              e.match_state_value = fsa->GetStateValue(e.state);
+            }
+          }
+        }
+
+        // keep entries which can still match or wait for earlier entries to be resolved
+        if (e.state != 0 || e.match_end != 0) {
+          entries_[kept++] = e;
+        }
+      }
+      entries_.resize(kept);
+      ++position;
+
+      if (!ResolveFinishedEntries(fsa, text, &visitor)) {
+        return;
+      }
+
+      if (entries_.empty() && !boundaries_.empty() && position < text_length && !IsTokenStart(text, position)) {
+        // nothing active, continue after the next boundary
+        position = FindBoundary(text, position) + 1;
+      }
+    }
+
+    // end of text, no entry can grow anymore, drop the ones without a match
+    size_t kept = 0;
+    for (entry& e : entries_) {
+      if (e.match_end != 0) {
+        e.state = 0;
+        entries_[kept++] = e;
+      }
+    }
+    entries_.resize(kept);
+    ResolveFinishedEntries(fsa, text, &visitor);
+  }
+
+ private:
+  struct entry {
+    size_t start;
+    uint64_t state;
+    size_t match_end;
+    uint64_t match_state_value;
+  };
+
+  annotation_mode_t mode_;
+  std::string boundaries_;
+  std::array<bool, 256> boundary_table_;
+  std::vector<entry> entries_;
+  size_t committed_end_ = 0;
+
+  bool IsBoundary(const char c) const { return boundary_table_[static_cast<unsigned char>(c)]; }
+
+  bool IsTokenStart(const std::string_view text, const size_t position) const {
+    return position == 0 || boundaries_.empty() || IsBoundary(text[position - 1]);
+  }
+
+  bool IsTokenEnd(const std::string_view text, const size_t end) const {
+    return end == text.size() || boundaries_.empty() || IsBoundary(text[end]);
+  }
+
+  /**
+   * Report the matches of entries that can not grow anymore, in order of the start position.
+   *
+   * @return false if the visitor requested to stop
+   */
+  template <class VisitorT>
+  bool ResolveFinishedEntries(const fsa::automata_t& fsa, const std::string_view text, VisitorT* visitor) {
+    if (mode_ == annotation_mode_t::ALL) {
+      return true;
+    }
+
+    size_t resolved = 0;
+    for (; resolved < entries_.size() && entries_[resolved].state == 0; ++resolved) {
+      const entry& e = entries_[resolved];
+
+      if (e.start < committed_end_) {
+        continue;
+      }
+
+      MatchView view(e.start, e.match_end, text.substr(e.start, e.match_end - e.start), 0, fsa, e.match_state_value);
+      if (!CallVisitor(*visitor, view)) {
+        return false;
+      }
+
+      if (mode_ == annotation_mode_t::LEFTMOST_LONGEST) {
+        committed_end_ = e.match_end;
+      }
+    }
+
+    if (resolved > 0) {
+      entries_.erase(entries_.begin(), entries_.begin() + resolved);
+    }
+
+    // drop the entries overlapping the last match
+    if (committed_end_ > 0) {
+      size_t overlapping = 0;
+      while (overlapping < entries_.size() && entries_[overlapping].start < committed_end_) {
+        ++overlapping;
+      }
+      entries_.erase(entries_.begin(), entries_.begin() + overlapping);
+    }
+
+    return true;
+  }
+
+  /**
+   * Find the next boundary character.
+   *
+   * @return the position of the boundary or the length of the text if there is none
+   */
+  size_t FindBoundary(const std::string_view text, size_t position) const {
+#if defined(KEYVI_SSE42)
+    if (boundaries_.size() <= 16) {
+      char needles_buffer[16] = {0};
+      std::memcpy(needles_buffer, boundaries_.data(), boundaries_.size());
+      const __m128i needles = _mm_loadu_si128(reinterpret_cast<const __m128i*>(needles_buffer));
+      const int needles_length = static_cast<int>(boundaries_.size());
+
+      for (; position + 16 <= text.size(); position += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + position));
+        const int index = _mm_cmpestri(needles, needles_length, block, 16,
+                                       _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if (index < 16) {
+          return position + index;
+        }
+      }
+    }
+#endif
+
+    for (; position < text.size(); ++position) {
+      if (IsBoundary(text[position])) {
+        return position;
+      }
+    }
+
+    return text.size();
+  }
+};
+
+} /* namespace dictionary */
+} /* namespace keyvi */
+
+#endif  // KEYVI_DICTIONARY_TEXT_ANNOTATOR_H_
@@ -28,6 +28,7 @@
 #include <cstddef>
 
 static const char INDEX_REFRESH_INTERVAL[] = "refresh_interval";
+static const char INDEX_WATCHER_POLL_INTERVAL[] = "watcher_poll_interval";
 static const char MERGE_POLICY[] = "merge_policy";
 static const char DEFAULT_MERGE_POLICY[] = "tiered";
 static const char KEYVIMERGER_BIN[] = "keyvimerger_bin";
@@ -35,9 +36,18 @@ static const char INDEX_MAX_SEGMENTS[] = "max_segments";
 static const char SEGMENT_COMPILE_KEY_THRESHOLD[] = "segment_compile_key_threshold";
 static const char SEGMENT_EXTERNAL_MERGE_KEY_THRESHOLD[] = "segment_external_merge_key_threshold";
 static const char MAX_CONCURRENT_MERGES[] = "max_concurrent_merges";
+static const char MAX_CONCURRENT_COMPILES[] = "max_concurrent_compiles";
+static const char INDEX_MEMORY_BUDGET[] = "memory_budget";
+static const char MERGE_NICE[] = "merge_nice";
+static const char INDEX_MEMTABLE[] = "memtable";
+static const char PARALLEL_QUERY_MIN_SEGMENTS[] = "parallel_query_min_segments";
 
 // defaults
 static const size_t DEFAULT_REFRESH_INTERVAL = 1000ul;
+
+// with inotify a reader only polls for changes at this interval (in ms), to catch changes that are not reported,
+// e.g. made by another host on a network file system, 0 disables polling
+static const size_t DEFAULT_WATCHER_POLL_INTERVAL = 60000ul;
 static const size_t DEFAULT_COMPILE_KEY_THRESHOLD = 10000ul;
 static const size_t DEFAULT_EXTERNAL_MERGE_KEY_THRESHOLD = 100000ul;
 #if defined(_WIN32)
@@ -46,10 +56,32 @@ static const char DEFAULT_KEYVIMERGER_BIN[] = "keyvimerger.exe";
 static const char DEFAULT_KEYVIMERGER_BIN[] = "keyvimerger";
 #endif
 
-// spinlock wait time if there are too many segments
-static const size_t SPINLOCK_WAIT_FOR_SEGMENT_MERGES_MS = 10;
+// minimum number of segments to traverse segments in parallel for a query, 0 disables parallel queries
+static const size_t DEFAULT_PARALLEL_QUERY_MIN_SEGMENTS = 0;
+
+// number of single writes collected before they are handed over to the worker thread as one batch
+static const size_t WRITE_BUFFER_SIZE = 1000;
+
+// number of write buffers kept for reuse, so buffers are allocated only once
+static const size_t WRITE_BUFFER_RING_SIZE = 4;
 
 // max parallel process for segment merging
 static const size_t MAX_CONCURRENT_MERGES_DEFAULT = 8;
 
+// memory shared by the compilers and merges of an index including their key filters, can be given in bytes or with
+// _kb, _mb, _gb suffix
+static const size_t DEFAULT_INDEX_MEMORY_BUDGET = 64 * 1024 * 1024;
+
+// minimum memory limit of a single compiler or merge
+static const size_t MIN_JOB_MEMORY_LIMIT = 5 * 1024 * 1024;
+
+// estimated memory a compiler or merge needs per key for a good minimization
+static const size_t JOB_MEMORY_PER_KEY = 64;
+
+// whether writes are readable from memory before they got compiled into a segment, costs a copy of every write
+static const bool DEFAULT_INDEX_MEMTABLE = false;
+
+// max segments compiled in the background, 0 compiles on the writer thread
+static const size_t MAX_CONCURRENT_COMPILES_DEFAULT = 2;
+
 #endif  // KEYVI_INDEX_CONSTANTS_H_
@@ -31,9 +31,11 @@
 #include <chrono>              //NOLINT
 #include <condition_variable>  //NOLINT
 #include <ctime>
+#include <future>  //NOLINT
 #include <memory>
 #include <string>
 #include <thread>  //NOLINT
+#include <utility>
 #include <vector>
 
 #include <boost/filesystem.hpp>
@@ -79,6 +81,9 @@ class Index final : public internal::BaseIndexReader<internal::IndexWriterWorker
 
     index_lock_ = boost::interprocess::file_lock(index_lock_file.string().c_str());
     index_lock_.lock();
+
+    // make writes readable before they are flushed
+    SetMemTable(Payload().GetMemTable());
   }
 
   ~Index() {
@@ -99,6 +104,14 @@ class Index final : public internal::BaseIndexReader<internal::IndexWriterWorker
    */
   void Set(const std::string& key, const std::string& value) { Payload().Add(key, value); }
 
+  /**
+   * Set key to given value, taking ownership of key and value
+   *
+   * @param key the key
+   * @param value the value
+   */
+  void Set(std::string&& key, std::string&& value) { Payload().Add(std::move(key), std::move(value)); }
+
   /**
    * Set multiple keys and to multiple values
    *
@@ -110,6 +123,13 @@ class Index final : public internal::BaseIndexReader<internal::IndexWriterWorker
     Payload().Add(key_values);
   }
 
+  /**
+   * Set multiple keys and to multiple values, taking ownership of the key values
+   *
+   * @param key_values a vector of key value pairs, moved as a whole to the writer
+   */
+  void MSet(key_value_vector_t&& key_values) { Payload().Add(std::move(key_values)); }
+
   /**
    * Delete a key
    *
@@ -121,22 +141,27 @@ class Index final : public internal::BaseIndexReader<internal::IndexWriterWorker
    * Flush the index, persists all pending writes and makes the accessible.
    *
    * @param async if true only trigger a flush, if false(default) wait until flush has been executed.
+   * @return a future, ready once the flush has been executed, it rethrows if a compilation failed since the last
+   * flush or force merge
    */
-  void Flush(const bool async = false) {
+  std::shared_future<void> Flush(const bool async = false) {
     TRACE("Flush (manually)");
-    Payload().Flush(async);
+    return Payload().Flush(async);
   }
 
   /**
    * Force merge all segment to the number of segments given (default 1)
    *
    * @param max_segments maximum number of segments the index should have afterwards
+   * @param async if true only trigger the merge, if false(default) wait until the segments have been merged.
+   * @return a future, ready once the index has at most max_segments segments, it rethrows if a compilation failed
+   * since the last flush or force merge
    */
-  void ForceMerge(const size_t max_segments = 1) {
+  std::shared_future<void> ForceMerge(const size_t max_segments = 1, const bool async = false) {
     if (max_segments < 1) {
       throw std::invalid_argument("max_segments must be > 1");
     }
-    Payload().ForceMerge(max_segments);
+    return Payload().ForceMerge(max_segments, async);
   }
 
  private:
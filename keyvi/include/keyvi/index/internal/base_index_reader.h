@@ -26,20 +26,35 @@
 #ifndef KEYVI_INDEX_INTERNAL_BASE_INDEX_READER_H_
 #define KEYVI_INDEX_INTERNAL_BASE_INDEX_READER_H_
 
+#include <algorithm>
+#include <functional>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "utf8.h"
+
 #include "keyvi/dictionary/fsa/automata.h"
 #include "keyvi/dictionary/match.h"
 #include "keyvi/dictionary/match_iterator.h"
+#include "keyvi/dictionary/match_view.h"
 #include "keyvi/dictionary/matching/fuzzy_matching.h"
+#include "keyvi/dictionary/matching/fuzzy_top_n_matching.h"
 #include "keyvi/dictionary/matching/near_matching.h"
+#include "keyvi/dictionary/matching/prefix_completion_matching.h"
+#include "keyvi/dictionary/util/utf8_utils.h"
+#include "keyvi/index/constants.h"
 #include "keyvi/index/internal/index_lookup_util.h"
+#include "keyvi/index/internal/mem_table.h"
 #include "keyvi/index/internal/read_only_segment.h"
+#include "keyvi/stringdistance/levenshtein.h"
+#include "keyvi/util/configuration.h"
+#include "keyvi/util/thread_pool.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -56,8 +71,10 @@ class BaseIndexReader {
  public:
   using const_segments_t = const std::shared_ptr<std::vector<std::shared_ptr<SegmentT>>>;
 
-  template <typename... Args>
-  explicit BaseIndexReader(Args... args) : payload_(args...) {}
+  explicit BaseIndexReader(const std::string& index_directory, const keyvi::util::parameters_t& params)
+      : payload_(index_directory, params),
+        parallel_query_min_segments_(keyvi::util::mapGet<size_t>(params, PARALLEL_QUERY_MIN_SEGMENTS,
+                                                                 DEFAULT_PARALLEL_QUERY_MIN_SEGMENTS)) {}
 
   /**
    * Get a match for the given key
@@ -66,6 +83,10 @@ class BaseIndexReader {
    */
   dictionary::match_t operator[](const std::string& key) {
     dictionary::match_t match;
+    if (LookupMemTable(key, &match)) {
+      return match;
+    }
+
     const_segments_t segments = payload_.Segments();
 
     for (auto it = segments->crbegin(); it != segments->crend(); ++it) {
@@ -87,6 +108,11 @@ class BaseIndexReader {
    * @param key the key
    */
   bool Contains(const std::string& key) {
+    bool deleted = false;
+    if (mem_table_ && mem_table_->Get(key, &deleted)) {
+      return !deleted;
+    }
+
     const_segments_t segments = payload_.Segments();
     for (auto it = segments->crbegin(); it != segments->crend(); it++) {
       if ((*it)->GetDictionary()->Contains(key)) {
@@ -97,6 +123,56 @@ class BaseIndexReader {
     return false;
   }
 
+  /**
+   * Get matches for several keys at once, keys are walked interleaved, see Dictionary::GetMany.
+   *
+   * @param keys the keys
+   * @return for every key a match, empty if the key does not exist or got deleted
+   */
+  std::vector<dictionary::match_t> GetMany(const std::vector<std::string>& keys) {
+    std::vector<dictionary::match_t> matches(keys.size());
+    std::vector<bool> in_mem_table;
+    if (mem_table_ && !mem_table_->Empty()) {
+      in_mem_table.resize(keys.size());
+      for (size_t i = 0; i < keys.size(); ++i) {
+        in_mem_table[i] = LookupMemTable(keys[i], &matches[i]);
+      }
+    }
+
+    LookupMany(
+        keys, in_mem_table,
+        [](const dictionary::dictionary_t& d, const std::vector<std::string>& k) { return d->GetMany(k); },
+        [&matches](const size_t key_index, dictionary::match_t&& match) { matches[key_index] = std::move(match); });
+
+    return matches;
+  }
+
+  /**
+   * Check for several keys at once if an entry exists, see Dictionary::ContainsMany.
+   *
+   * @param keys the keys
+   * @return for every key true if an entry exists
+   */
+  std::vector<bool> ContainsMany(const std::vector<std::string>& keys) {
+    std::vector<bool> result(keys.size(), false);
+    std::vector<bool> in_mem_table;
+    if (mem_table_ && !mem_table_->Empty()) {
+      in_mem_table.resize(keys.size());
+      for (size_t i = 0; i < keys.size(); ++i) {
+        bool deleted = false;
+        in_mem_table[i] = mem_table_->Get(keys[i], &deleted);
+        result[i] = in_mem_table[i] && !deleted;
+      }
+    }
+
+    LookupMany(
+        keys, in_mem_table,
+        [](const dictionary::dictionary_t& d, const std::vector<std::string>& k) { return d->ContainsMany(k); },
+        [&result](const size_t key_index, bool) { result[key_index] = true; });
+
+    return result;
+  }
+
   /**
    * Match a key near:  Match as much as possible exact given the minimum prefix length and then return everything
    * below.
@@ -110,6 +186,389 @@ class BaseIndexReader {
    */
   dictionary::MatchIterator::MatchIteratorPair GetNear(const std::string& query, const size_t minimum_exact_prefix = 2,
                                                        const bool greedy = false) {
+    mem_table_matches_t mem_table_matches = MatchNearInMemTable(query, minimum_exact_prefix);
+    if (mem_table_matches.empty()) {
+      return GetNearInSegments(query, minimum_exact_prefix, greedy);
+    }
+
+    return CombineNearMatches(GetNearInSegments(query, minimum_exact_prefix, greedy), std::move(mem_table_matches),
+                              greedy);
+  }
+
+  /**
+   * Match approximate given the query and edit distance
+   *
+   * @param query a query to match against
+   * @param max_edit_distance the max edit distance allowed for a single match
+   * @param minimum_exact_prefix prefix length to be matched exact
+   */
+  dictionary::MatchIterator::MatchIteratorPair GetFuzzy(const std::string& query, const int32_t max_edit_distance,
+                                                        const size_t minimum_exact_prefix = 2) {
+    mem_table_matches_t mem_table_matches = MatchFuzzyInMemTable(query, max_edit_distance, minimum_exact_prefix);
+    if (mem_table_matches.empty()) {
+      return GetFuzzyInSegments(query, max_edit_distance, minimum_exact_prefix);
+    }
+
+    return CombineFuzzyMatches(GetFuzzyInSegments(query, max_edit_distance, minimum_exact_prefix),
+                               std::move(mem_table_matches));
+  }
+
+  /**
+   * Fuzzy matching returning only the top n matches, ordered by edit distance and weight, deleted keys are skipped.
+   *
+   * @param query the query
+   * @param max_edit_distance the maximum allowed edit distance
+   * @param minimum_exact_prefix the minimum exact prefix to match before matching approximate
+   * @param top_n the number of matches to return
+   */
+  dictionary::MatchIterator::MatchIteratorPair GetFuzzy(const std::string& query, const int32_t max_edit_distance,
+                                                        const size_t minimum_exact_prefix, const size_t top_n) {
+    mem_table_matches_t mem_table_matches = MatchFuzzyInMemTable(query, max_edit_distance, minimum_exact_prefix);
+    if (mem_table_matches.empty()) {
+      return GetFuzzyInSegments(query, max_edit_distance, minimum_exact_prefix, top_n);
+    }
+
+    // every entry of the mem table might shadow a match from the segments, so ask for more
+    std::vector<dictionary::match_t> matches = CombineMatches(
+        GetFuzzyInSegments(query, max_edit_distance, minimum_exact_prefix, top_n + mem_table_matches.size()),
+        mem_table_matches);
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const dictionary::match_t& lhs, const dictionary::match_t& rhs) {
+                       if (lhs->GetScore() != rhs->GetScore()) {
+                         return lhs->GetScore() < rhs->GetScore();
+                       }
+                       return lhs->GetWeight() > rhs->GetWeight();
+                     });
+    if (matches.size() > top_n) {
+      matches.resize(top_n);
+    }
+
+    return MakeIteratorPair(std::move(matches));
+  }
+
+  /**
+   * Call the visitor for every item of the index in lexicographic order, deleted keys are skipped.
+   *
+   * If a key exists in several segments, the newest segment wins. The visitor gets a MatchView which is only valid
+   * during the call, it can return false to stop early.
+   *
+   * @param visitor callable taking a MatchView&
+   */
+  template <class VisitorT>
+  void ForEachMatch(VisitorT&& visitor) {
+    MemTable::snapshot_t snapshot;
+    if (mem_table_) {
+      snapshot = mem_table_->GetSnapshot();
+    }
+
+    if (!snapshot || snapshot->empty()) {
+      ForEachMatchInSegments(std::forward<VisitorT>(visitor));
+      return;
+    }
+
+    // interleave the entries of the mem table, which shadow the segments
+    const std::vector<MemTable::entry_t>& entries = *snapshot;
+    size_t next_entry = 0;
+    bool stopped = false;
+    auto visit_entry = [&visitor, &entries, &next_entry]() {
+      const MemTable::entry_t& entry = entries[next_entry++];
+      if (entry.second.deleted) {
+        return true;
+      }
+
+      dictionary::match_t match = MemTable::CreateMatch(entry.first, entry.second.value);
+      dictionary::MatchView view(*match);
+      return dictionary::CallVisitor(visitor, view);
+    };
+
+    ForEachMatchInSegments([&visit_entry, &entries, &next_entry, &stopped, &visitor](dictionary::MatchView& view) {
+      const std::string_view key = view.GetMatchedString();
+      while (next_entry < entries.size() && entries[next_entry].first < key) {
+        if (!visit_entry()) {
+          stopped = true;
+          return false;
+        }
+      }
+
+      if (next_entry < entries.size() && entries[next_entry].first == key) {
+        stopped = !visit_entry();
+        return !stopped;
+      }
+
+      stopped = !dictionary::CallVisitor(visitor, view);
+      return !stopped;
+    });
+
+    while (!stopped && next_entry < entries.size()) {
+      stopped = !visit_entry();
+    }
+  }
+
+ protected:
+  PayloadT& Payload() { return payload_; }
+
+  /**
+   * Set the table of writes not yet in a segment, it shadows the segments for all queries.
+   */
+  void SetMemTable(const std::shared_ptr<MemTable>& mem_table) { mem_table_ = mem_table; }
+
+ private:
+  //! matches from the mem table ordered by key, an empty match if the key got deleted
+  using mem_table_matches_t = std::vector<std::pair<std::string, dictionary::match_t>>;
+
+  PayloadT payload_;
+  const size_t parallel_query_min_segments_;
+  std::shared_ptr<MemTable> mem_table_;
+
+  /**
+   * Lookup a key in the mem table.
+   *
+   * @param key the key
+   * @param match set to the match, empty if the key got deleted
+   * @return true if the mem table has an entry for the key
+   */
+  bool LookupMemTable(const std::string& key, dictionary::match_t* match) const {
+    if (!mem_table_) {
+      return false;
+    }
+
+    bool deleted = false;
+    std::string value;
+    if (!mem_table_->Get(key, &deleted, &value)) {
+      return false;
+    }
+
+    *match = deleted ? dictionary::match_t() : MemTable::CreateMatch(key, value);
+    return true;
+  }
+
+  /**
+   * Match near in the mem table, the score is the length of the common prefix like for matches from segments.
+   */
+  mem_table_matches_t MatchNearInMemTable(const std::string& query, const size_t minimum_exact_prefix) const {
+    mem_table_matches_t matches;
+    if (!mem_table_ || mem_table_->Empty() || query.size() < minimum_exact_prefix) {
+      return matches;
+    }
+
+    for (const MemTable::entry_t& entry : mem_table_->GetRange(query.substr(0, minimum_exact_prefix))) {
+      const size_t common_prefix =
+          std::mismatch(query.begin(), query.end(), entry.first.begin(), entry.first.end()).first - query.begin();
+
+      matches.emplace_back(entry.first, entry.second.deleted
+                                            ? dictionary::match_t()
+                                            : MemTable::CreateMatch(entry.first, entry.second.value, common_prefix));
+    }
+
+    return matches;
+  }
+
+  /**
+   * Match fuzzy in the mem table, the score is the edit distance like for matches from segments.
+   */
+  mem_table_matches_t MatchFuzzyInMemTable(const std::string& query, const int32_t max_edit_distance,
+                                           const size_t minimum_exact_prefix) const {
+    mem_table_matches_t matches;
+    if (!mem_table_ || mem_table_->Empty()) {
+      return matches;
+    }
+
+    std::vector<uint32_t> codepoints;
+    utf8::unchecked::utf8to32(query.begin(), query.end(), back_inserter(codepoints));
+    if (codepoints.size() < minimum_exact_prefix) {
+      return matches;
+    }
+
+    size_t exact_prefix_length = 0;
+    for (size_t i = 0; i < minimum_exact_prefix; ++i) {
+      exact_prefix_length += dictionary::util::Utf8Utils::GetCharLength(query[exact_prefix_length]);
+    }
+
+    stringdistance::Levenshtein metric(codepoints, 20, max_edit_distance);
+    std::vector<uint32_t> candidate;
+    for (const MemTable::entry_t& entry : mem_table_->GetRange(query.substr(0, exact_prefix_length))) {
+      candidate.clear();
+      utf8::unchecked::utf8to32(entry.first.begin(), entry.first.end(), back_inserter(candidate));
+      if (candidate.size() > codepoints.size() + max_edit_distance) {
+        continue;
+      }
+
+      for (size_t i = 0; i < candidate.size(); ++i) {
+        metric.Put(candidate[i], i);
+      }
+
+      const int32_t score = candidate.empty() ? static_cast<int32_t>(codepoints.size()) : metric.GetScore();
+      if (score <= max_edit_distance) {
+        matches.emplace_back(entry.first, entry.second.deleted
+                                              ? dictionary::match_t()
+                                              : MemTable::CreateMatch(entry.first, entry.second.value, score));
+      }
+    }
+
+    return matches;
+  }
+
+  /**
+   * Collect the matches from segments which are not shadowed by the mem table and add the ones from the mem table.
+   *
+   * @param segment_matches matches from the segments
+   * @param mem_table_matches matches from the mem table for the same query
+   */
+  static std::vector<dictionary::match_t> CombineMatches(dictionary::MatchIterator::MatchIteratorPair segment_matches,
+                                                         const mem_table_matches_t& mem_table_matches) {
+    std::vector<dictionary::match_t> matches;
+    for (const dictionary::match_t& m : segment_matches) {
+      if (!IsShadowed(mem_table_matches, m->GetMatchedString())) {
+        matches.push_back(m);
+      }
+    }
+
+    for (const auto& m : mem_table_matches) {
+      if (m.second) {
+        matches.push_back(m.second);
+      }
+    }
+
+    return matches;
+  }
+
+  /**
+   * Combine near matches from the segments and the mem table lazily, ordered by the length of the matched prefix.
+   *
+   * @param segment_matches near matches from the segments
+   * @param mem_table_matches near matches from the mem table for the same query
+   * @param greedy if false only return matches with the longest matched prefix of both
+   */
+  static dictionary::MatchIterator::MatchIteratorPair CombineNearMatches(
+      dictionary::MatchIterator::MatchIteratorPair segment_matches, mem_table_matches_t&& mem_table_matches,
+      const bool greedy) {
+    // best matches at the back, equal scores in key order
+    auto pending = std::make_shared<std::vector<dictionary::match_t>>();
+    for (auto it = mem_table_matches.rbegin(); it != mem_table_matches.rend(); ++it) {
+      if (it->second) {
+        pending->push_back(it->second);
+      }
+    }
+    std::stable_sort(pending->begin(), pending->end(),
+                     [](const dictionary::match_t& lhs, const dictionary::match_t& rhs) {
+                       return lhs->GetScore() < rhs->GetScore();
+                     });
+
+    auto shadowed = std::make_shared<mem_table_matches_t>(std::move(mem_table_matches));
+    auto next_segment_match = UnshadowedMatches(segment_matches, shadowed);
+
+    auto segment_match = std::make_shared<dictionary::match_t>(next_segment_match());
+    double min_score = 0;
+    if (!greedy) {
+      min_score = std::max(*segment_match ? (*segment_match)->GetScore() : 0.0,
+                           pending->empty() ? 0.0 : pending->back()->GetScore());
+    }
+
+    auto func = [pending, segment_match, next_segment_match, min_score]() {
+      dictionary::match_t m;
+      if (!pending->empty() && (!*segment_match || pending->back()->GetScore() >= (*segment_match)->GetScore())) {
+        m = std::move(pending->back());
+        pending->pop_back();
+      } else if (*segment_match) {
+        m = std::move(*segment_match);
+        *segment_match = next_segment_match();
+      }
+
+      // both sources are ordered, so all following matches have a lower score
+      if (m && m->GetScore() < min_score) {
+        return dictionary::match_t();
+      }
+      return m;
+    };
+
+    return dictionary::MatchIterator::MakeIteratorPair(func);
+  }
+
+  /**
+   * Combine fuzzy matches from the segments and the mem table lazily, both are ordered by key.
+   *
+   * @param segment_matches fuzzy matches from the segments
+   * @param mem_table_matches fuzzy matches from the mem table for the same query
+   */
+  static dictionary::MatchIterator::MatchIteratorPair CombineFuzzyMatches(
+      dictionary::MatchIterator::MatchIteratorPair segment_matches, mem_table_matches_t&& mem_table_matches) {
+    auto mem_table = std::make_shared<mem_table_matches_t>(std::move(mem_table_matches));
+    auto next_segment_match = UnshadowedMatches(segment_matches, mem_table);
+    auto segment_match = std::make_shared<dictionary::match_t>(next_segment_match());
+    auto next_entry = std::make_shared<size_t>(0);
+
+    auto func = [mem_table, next_entry, segment_match, next_segment_match]() {
+      // deleted keys only shadow matches from the segments
+      while (*next_entry < mem_table->size() && !(*mem_table)[*next_entry].second) {
+        ++(*next_entry);
+      }
+
+      if (*next_entry < mem_table->size() &&
+          (!*segment_match || (*mem_table)[*next_entry].first < (*segment_match)->GetMatchedString())) {
+        return (*mem_table)[(*next_entry)++].second;
+      }
+
+      dictionary::match_t m = std::move(*segment_match);
+      if (m) {
+        *segment_match = next_segment_match();
+      }
+      return m;
+    };
+
+    return dictionary::MatchIterator::MakeIteratorPair(func);
+  }
+
+  /**
+   * Create a function returning the next match from the segments which is not shadowed by the mem table.
+   */
+  static std::function<dictionary::match_t()> UnshadowedMatches(
+      dictionary::MatchIterator::MatchIteratorPair segment_matches,
+      const std::shared_ptr<mem_table_matches_t>& shadowed) {
+    auto segment_it = std::make_shared<dictionary::MatchIterator>(segment_matches.begin());
+    return [shadowed, segment_it]() {
+      for (; *segment_it != dictionary::MatchIterator(); ++(*segment_it)) {
+        const dictionary::match_t& m = **segment_it;
+        if (!IsShadowed(*shadowed, m->GetMatchedString())) {
+          dictionary::match_t result = m;
+          ++(*segment_it);
+          return result;
+        }
+      }
+      return dictionary::match_t();
+    };
+  }
+
+  static bool IsShadowed(const mem_table_matches_t& mem_table_matches, const std::string& key) {
+    return std::binary_search(
+        mem_table_matches.begin(), mem_table_matches.end(), key,
+        [](const auto& lhs, const auto& rhs) { return GetKey(lhs) < GetKey(rhs); });
+  }
+
+  static const std::string& GetKey(const std::string& key) { return key; }
+
+  static const std::string& GetKey(const std::pair<std::string, dictionary::match_t>& entry) { return entry.first; }
+
+  static dictionary::MatchIterator::MatchIteratorPair MakeIteratorPair(std::vector<dictionary::match_t>&& matches) {
+    // reversed, to hand out matches from the back
+    auto pending = std::make_shared<std::vector<dictionary::match_t>>(std::move(matches));
+    std::reverse(pending->begin(), pending->end());
+
+    auto func = [pending]() {
+      if (pending->empty()) {
+        return dictionary::match_t();
+      }
+      dictionary::match_t m = std::move(pending->back());
+      pending->pop_back();
+      return m;
+    };
+    return dictionary::MatchIterator::MakeIteratorPair(func);
+  }
+
+  /**
+   * Match near in the segments only, see GetNear.
+   */
+  dictionary::MatchIterator::MatchIteratorPair GetNearInSegments(const std::string& query,
+                                                                 const size_t minimum_exact_prefix, const bool greedy) {
     TRACE("matching near: %s minimum prefix %ld", query.c_str(), minimum_exact_prefix);
     const_segments_t segments = payload_.Segments();
 
@@ -138,7 +597,7 @@ class BaseIndexReader {
       for (auto it = segments->crbegin(); it != segments->crend(); it++) {
         if ((*it)->GetDictionary()->GetFsa() == std::get<0>(fsa_start_state_payloads[0])) {
           typename SegmentT::deleted_ptr_t deleted_keys = (*it)->DeletedKeys();
-          if ((*it)->DeletedKeysSize() > 0) {
+          if (deleted_keys && !deleted_keys->empty()) {
             auto func = [near_matcher, deleted_keys]() { return NextFilteredMatchSingle(near_matcher, deleted_keys); };
 
             // check if first match is a deleted key and reset in case
@@ -171,14 +630,11 @@ class BaseIndexReader {
   }
 
   /**
-   * Match approximate given the query and edit distance
-   *
-   * @param query a query to match against
-   * @param max_edit_distance the max edit distance allowed for a single match
-   * @param minimum_exact_prefix prefix length to be matched exact
+   * Match fuzzy in the segments only, see GetFuzzy.
    */
-  dictionary::MatchIterator::MatchIteratorPair GetFuzzy(const std::string& query, const int32_t max_edit_distance,
-                                                        const size_t minimum_exact_prefix = 2) {
+  dictionary::MatchIterator::MatchIteratorPair GetFuzzyInSegments(const std::string& query,
+                                                                  const int32_t max_edit_distance,
+                                                                  const size_t minimum_exact_prefix) {
     TRACE("matching fuzzy: %s max edit distance %ld minimum prefix %ld", query.c_str(), max_edit_distance,
           minimum_exact_prefix);
     const_segments_t segments = payload_.Segments();
@@ -208,7 +664,7 @@ class BaseIndexReader {
       for (auto it = segments->crbegin(); it != segments->crend(); it++) {
         if ((*it)->GetDictionary()->GetFsa() == fsa_start_state_pairs[0].first) {
           typename SegmentT::deleted_ptr_t deleted_keys = (*it)->DeletedKeys();
-          if ((*it)->DeletedKeysSize() > 0) {
+          if (deleted_keys && !deleted_keys->empty()) {
             auto func = [fuzzy_matcher, deleted_keys]() {
               return NextFilteredMatchSingle(fuzzy_matcher, deleted_keys);
             };
@@ -229,6 +685,10 @@ class BaseIndexReader {
     // segments and filtered fsa's must have the same order
     auto deleted_keys_map = CreatedDeletedKeysMap(segments, fsa_start_state_pairs);
 
+    if (parallel_query_min_segments_ > 0 && fsa_start_state_pairs.size() >= parallel_query_min_segments_) {
+      return GetFuzzyParallel(fsa_start_state_pairs, query, max_edit_distance, minimum_exact_prefix, deleted_keys_map);
+    }
+
     TRACE("create the fuzzy matcher");
 
     auto fuzzy_matcher = std::make_shared<
@@ -247,11 +707,177 @@ class BaseIndexReader {
     return dictionary::MatchIterator::MakeIteratorPair(func, FirstFilteredMatch(fuzzy_matcher, deleted_keys_map));
   }
 
- protected:
-  PayloadT& Payload() { return payload_; }
+  /**
+   * Match the top n fuzzy in the segments only, see GetFuzzy.
+   */
+  dictionary::MatchIterator::MatchIteratorPair GetFuzzyInSegments(const std::string& query,
+                                                                  const int32_t max_edit_distance,
+                                                                  const size_t minimum_exact_prefix,
+                                                                  const size_t top_n) {
+    const_segments_t segments = payload_.Segments();
 
- private:
-  PayloadT payload_;
+    if (segments->size() == 0) {
+      return dictionary::MatchIterator::EmptyIteratorPair();
+    }
+
+    std::vector<dictionary::fsa::automata_t> fsas;
+    std::vector<std::pair<dictionary::fsa::automata_t, uint64_t>> fsa_start_state_pairs;
+    for (auto it = segments->cbegin(); it != segments->cend(); it++) {
+      const dictionary::fsa::automata_t& fsa = (*it)->GetDictionary()->GetFsa();
+      fsas.push_back(fsa);
+      fsa_start_state_pairs.emplace_back(fsa, fsa->GetStartState());
+    }
+
+    auto deleted_keys_map = CreatedDeletedKeysMap(segments, fsa_start_state_pairs);
+    auto fuzzy_matcher = std::make_shared<dictionary::matching::FuzzyTopNMatching>(
+        dictionary::matching::FuzzyTopNMatching::FromMulipleFsas(fsas, query, max_edit_distance, minimum_exact_prefix,
+                                                                 top_n));
+
+    if (deleted_keys_map.size() == 0) {
+      auto func = [fuzzy_matcher]() { return fuzzy_matcher->NextMatch(); };
+      return dictionary::MatchIterator::MakeIteratorPair(func, std::move(fuzzy_matcher->FirstMatch()));
+    }
+
+    auto func = [fuzzy_matcher, deleted_keys_map]() { return NextFilteredMatch(fuzzy_matcher, deleted_keys_map); };
+    return dictionary::MatchIterator::MakeIteratorPair(func, FirstFilteredMatch(fuzzy_matcher, deleted_keys_map));
+  }
+
+  /**
+   * Visit all items of the segments only, see ForEachMatch.
+   */
+  template <class VisitorT>
+  void ForEachMatchInSegments(VisitorT&& visitor) {
+    const_segments_t segments = payload_.Segments();
+
+    if (segments->size() == 0) {
+      return;
+    }
+
+    std::vector<dictionary::fsa::automata_t> fsas;
+    std::vector<std::pair<dictionary::fsa::automata_t, uint64_t>> fsa_start_state_pairs;
+    for (auto it = segments->cbegin(); it != segments->cend(); it++) {
+      const dictionary::fsa::automata_t& fsa = (*it)->GetDictionary()->GetFsa();
+      fsas.push_back(fsa);
+      fsa_start_state_pairs.emplace_back(fsa, fsa->GetStartState());
+    }
+
+    auto deleted_keys_map = CreatedDeletedKeysMap(segments, fsa_start_state_pairs);
+    auto matcher = dictionary::matching::PrefixCompletionMatching<
+        dictionary::fsa::ZipStateTraverser<dictionary::fsa::StateTraverser<>>>::FromMulipleFsas(fsas, "");
+
+    if (deleted_keys_map.size() == 0) {
+      matcher.ForEachMatch(std::forward<VisitorT>(visitor));
+      return;
+    }
+
+    std::string key;
+    matcher.ForEachMatch(std::forward<VisitorT>(visitor),
+                         [&deleted_keys_map, &key](const dictionary::MatchView& match) {
+                           auto dk = deleted_keys_map.find(match.GetFsa());
+                           if (dk == deleted_keys_map.end()) {
+                             return false;
+                           }
+                           key.assign(match.GetMatchedString());
+                           return dk->second->count(key) > 0;
+                         });
+  }
+
+  /**
+   * Match fuzzy segment by segment on the shared thread pool and merge the sorted matches afterwards.
+   *
+   * Returns the same matches in the same order as the zipped traversal, but all matches are collected upfront.
+   */
+  template <typename DeletedT>
+  dictionary::MatchIterator::MatchIteratorPair GetFuzzyParallel(
+      const std::vector<std::pair<dictionary::fsa::automata_t, uint64_t>>& fsa_start_state_pairs,
+      const std::string& query, const int32_t max_edit_distance, const size_t minimum_exact_prefix,
+      const DeletedT& deleted_keys_map) {
+    std::vector<std::vector<dictionary::match_t>> fsa_matches(fsa_start_state_pairs.size());
+
+    TRACE("match fuzzy on %ld segments in parallel", fsa_start_state_pairs.size());
+    keyvi::util::ThreadPool::Shared().ParallelFor(fsa_start_state_pairs.size(), [&](const size_t i) {
+      // traverse in lexicographic order for merging
+      auto fuzzy_matcher = dictionary::matching::FuzzyMatching<dictionary::fsa::StateTraverser<>>::
+          FromSingleFsaWithMatchedExactPrefix<dictionary::fsa::StateTraverser<>>(
+              fsa_start_state_pairs[i].first, fsa_start_state_pairs[i].second, query, max_edit_distance,
+              minimum_exact_prefix);
+
+      std::vector<dictionary::match_t>& matches = fsa_matches[i];
+      if (fuzzy_matcher.FirstMatch()) {
+        matches.push_back(std::move(fuzzy_matcher.FirstMatch()));
+      }
+      for (dictionary::match_t m = fuzzy_matcher.NextMatch(); m; m = fuzzy_matcher.NextMatch()) {
+        matches.push_back(std::move(m));
+      }
+    });
+
+    // reversed, to hand out matches from the back
+    auto matches =
+        std::make_shared<std::vector<dictionary::match_t>>(MergeFilteredMatches(&fsa_matches, deleted_keys_map));
+    std::reverse(matches->begin(), matches->end());
+
+    auto func = [matches]() {
+      if (matches->empty()) {
+        return dictionary::match_t();
+      }
+      dictionary::match_t m = std::move(matches->back());
+      matches->pop_back();
+      return m;
+    };
+    return dictionary::MatchIterator::MakeIteratorPair(func);
+  }
+
+  /**
+   * Lookup keys segment by segment, newest first. Only keys not found yet are looked up in older segments.
+   *
+   * @param keys the keys
+   * @param resolved for every key true if it must not be looked up, e.g. found in the mem table, empty for none
+   * @param lookup_many batch lookup in a single dictionary, returns a result per key that evaluates to true on hit
+   * @param on_found called with the key index and the result for every key found and not deleted
+   */
+  template <typename LookupManyT, typename OnFoundT>
+  void LookupMany(const std::vector<std::string>& keys, const std::vector<bool>& resolved, LookupManyT lookup_many,
+                  OnFoundT on_found) {
+    const_segments_t segments = payload_.Segments();
+
+    std::vector<size_t> pending_indexes;
+    std::vector<std::string> pending_keys;
+    if (resolved.empty()) {
+      pending_indexes.resize(keys.size());
+      std::iota(pending_indexes.begin(), pending_indexes.end(), 0);
+      pending_keys = keys;
+    } else {
+      for (size_t i = 0; i < keys.size(); ++i) {
+        if (!resolved[i]) {
+          pending_indexes.push_back(i);
+          pending_keys.push_back(keys[i]);
+        }
+      }
+    }
+
+    for (auto it = segments->crbegin(); it != segments->crend() && pending_keys.size() > 0; ++it) {
+      auto results = lookup_many((*it)->GetDictionary(), pending_keys);
+      size_t still_pending = 0;
+
+      for (size_t i = 0; i < pending_keys.size(); ++i) {
+        if (results[i]) {
+          if (!(*it)->IsDeleted(pending_keys[i])) {
+            on_found(pending_indexes[i], std::move(results[i]));
+          }
+          continue;
+        }
+
+        if (still_pending != i) {
+          pending_indexes[still_pending] = pending_indexes[i];
+          pending_keys[still_pending] = std::move(pending_keys[i]);
+        }
+        ++still_pending;
+      }
+
+      pending_indexes.resize(still_pending);
+      pending_keys.resize(still_pending);
+    }
+  }
 
   // friend for unit testing only
   friend class keyvi::index::unit_test::IndexFriend;
@@ -0,0 +1,142 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * compile_job.h
+ *
+ * Compilation of a new segment in the background, while the writer keeps accepting writes.
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_COMPILE_JOB_H_
+#define KEYVI_INDEX_INTERNAL_COMPILE_JOB_H_
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "keyvi/dictionary/dictionary_index_compiler.h"
+#include "keyvi/dictionary/dictionary_types.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+class CompileJob final {
+ public:
+  using compiler_t = std::shared_ptr<dictionary::JsonDictionaryIndexCompiler>;
+
+  explicit CompileJob(const compiler_t& compiler, const boost::filesystem::path& output_filename,
+                      const size_t memory_limit, const uint64_t sequence = 0)
+      : compiler_(compiler),
+        output_filename_(output_filename),
+        memory_limit_(memory_limit),
+        sequence_(sequence),
+        finished_(false) {}
+
+  ~CompileJob() {
+    if (compile_thread_.joinable()) {
+      compile_thread_.join();
+    }
+  }
+
+  CompileJob() = delete;
+  CompileJob& operator=(CompileJob const&) = delete;
+  CompileJob(const CompileJob& that) = delete;
+
+  /**
+   * Compile in a background thread.
+   *
+   * @param compile_finished callback invoked from the compile thread once the compilation is done
+   */
+  void Run(const std::function<void()>& compile_finished = std::function<void()>()) {
+    compile_thread_ = std::thread([this, compile_finished]() {
+      try {
+        TRACE("compiling %s", output_filename_.string().c_str());
+        compiler_->Compile();
+        compiler_->WriteToFile(output_filename_.string());
+      } catch (...) {
+        exception_ = std::current_exception();
+      }
+
+      // free resources early
+      compiler_.reset();
+      finished_ = true;
+
+      if (compile_finished) {
+        compile_finished();
+      }
+    });
+  }
+
+  bool Finished() const { return finished_; }
+
+  /**
+   * Wait for the compilation to finish, rethrows if the compilation failed.
+   */
+  void Finalize() {
+    if (compile_thread_.joinable()) {
+      compile_thread_.join();
+    }
+
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+  /**
+   * Remember a key deleted while the compilation runs, to be applied to the segment once it is available.
+   */
+  void DeleteKey(const std::string& key) { deleted_keys_.push_back(key); }
+
+  const std::vector<std::string>& DeletedKeys() const { return deleted_keys_; }
+
+  const boost::filesystem::path& GetOutputFilename() const { return output_filename_; }
+
+  size_t GetMemoryLimit() const { return memory_limit_; }
+
+  /**
+   * The sequence number of the last write that is part of the compilation.
+   */
+  uint64_t GetSequence() const { return sequence_; }
+
+ private:
+  compiler_t compiler_;
+  boost::filesystem::path output_filename_;
+  size_t memory_limit_;
+  uint64_t sequence_;
+  std::vector<std::string> deleted_keys_;
+  std::thread compile_thread_;
+  std::exception_ptr exception_;
+  std::atomic_bool finished_;
+};
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_COMPILE_JOB_H_
@@ -0,0 +1,356 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * deleted_key_set.h
+ *
+ * Read only view of the deleted keys of a segment.
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_DELETED_KEY_SET_H_
+#define KEYVI_INDEX_INTERNAL_DELETED_KEY_SET_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <msgpack.hpp>
+
+#include "keyvi/dictionary/dictionary.h"
+#include "keyvi/dictionary/fsa/entry_iterator.h"
+#include "keyvi/dictionary/fsa/generator.h"
+#include "keyvi/dictionary/fsa/internal/constants.h"
+#include "keyvi/dictionary/fsa/internal/sparse_array_persistence.h"
+#include "keyvi/dictionary/util/endian.h"
+#include "keyvi/util/configuration.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+/**
+ * Deleted keys of a segment, loaded from the deleted keys files (.dk, .dkm).
+ *
+ * Deleted keys files are key-only keyvi dictionaries, they get memory mapped, so loading does not depend on the
+ * number of deleted keys and a lookup walks the automaton instead of hashing the key. Files in the old msgpack format
+ * are still supported, they get loaded into a hash set.
+ *
+ * Deletes that happened after the last compaction are in a log next to the file (e.g. .dk-log), an append-only
+ * sequence of records: key length as little endian uint32 followed by the key. Keys from logs are kept in hash sets,
+ * one layer per load. Layers are immutable and shared between copies, so applying the tail of a log to a copy does
+ * not copy the keys loaded before. Small layers get merged, which keeps the number of layers logarithmic.
+ *
+ * count, empty and size follow std::unordered_set, which this class replaces. Files can overlap, so only empty is
+ * cheap, size has to visit all keys.
+ */
+class DeletedKeySet final {
+ public:
+  DeletedKeySet() : dictionaries_(), key_layers_() {}
+
+  /**
+   * Add the deleted keys of the given file, a file that does not exist is ignored.
+   *
+   * @param filename the deleted keys file
+   */
+  void Load(const std::string& filename) {
+    TRACE("loading deleted keys file %s", filename.c_str());
+
+    std::ifstream deleted_keys_stream(filename, std::ios::binary);
+    if (!deleted_keys_stream.good()) {
+      return;
+    }
+
+    char magic[KEYVI_FILE_MAGIC_LEN];
+    deleted_keys_stream.read(magic, KEYVI_FILE_MAGIC_LEN);
+
+    if (deleted_keys_stream.gcount() == KEYVI_FILE_MAGIC_LEN &&
+        std::strncmp(magic, KEYVI_FILE_MAGIC, KEYVI_FILE_MAGIC_LEN) == 0) {
+      deleted_keys_stream.close();
+      dictionary::dictionary_t deleted_keys = std::make_shared<dictionary::Dictionary>(filename);
+      if (deleted_keys->GetSize() > 0) {
+        dictionaries_.push_back(deleted_keys);
+      }
+      return;
+    }
+
+    // old format: msgpack, files can be shorter than the magic
+    deleted_keys_stream.clear();
+    std::string buffer;
+    deleted_keys_stream.seekg(0, std::ios::end);
+    buffer.resize(deleted_keys_stream.tellg());
+    deleted_keys_stream.seekg(0, std::ios::beg);
+    deleted_keys_stream.read(&buffer[0], buffer.size());
+    msgpack::unpacked unpacked_object;
+    msgpack::unpack(unpacked_object, buffer.data(), buffer.size());
+
+    std::vector<std::string> legacy_keys;
+    unpacked_object.get().convert(legacy_keys);
+    key_layer_t layer;
+    for (const std::string& key : legacy_keys) {
+      Insert(key, &layer);
+    }
+    AddLayer(std::move(layer));
+  }
+
+  /**
+   * Add the deleted keys of the given log, starting at the given offset. A log that does not exist is ignored.
+   *
+   * Only complete records are read, a record that is written concurrently gets picked up by the next call.
+   *
+   * @param filename the log file
+   * @param offset the offset to start reading from, the return value of the previous call
+   * @return the offset after the last complete record
+   */
+  size_t LoadLog(const std::string& filename, size_t offset) {
+    TRACE("loading deleted keys log %s from %d", filename.c_str(), offset);
+
+    key_layer_t layer;
+    size_t log_size = 0;
+    offset = ReadLog(filename, offset, &log_size, [this, &layer](const std::string& key) { Insert(key, &layer); });
+
+    AddLayer(std::move(layer));
+    return offset;
+  }
+
+  /**
+   * Count the records of a log, e.g. to continue appending to it.
+   *
+   * A partial record at the end is left from a crash while appending, it would hide the records appended after it.
+   *
+   * @param filename the log file
+   * @param number_of_records set to the number of complete records
+   * @return false if the log ends with a partial record
+   */
+  static bool ScanLog(const std::string& filename, size_t* number_of_records) {
+    *number_of_records = 0;
+    size_t log_size = 0;
+    const size_t offset =
+        ReadLog(filename, 0, &log_size, [number_of_records](const std::string&) { ++(*number_of_records); });
+
+    return offset == log_size;
+  }
+
+  size_t count(const std::string& key) const {
+    for (const dictionary::dictionary_t& d : dictionaries_) {
+      if (d->Contains(key)) {
+        return 1;
+      }
+    }
+
+    for (const auto& layer : key_layers_) {
+      if (layer->count(key) > 0) {
+        return 1;
+      }
+    }
+
+    return 0;
+  }
+
+  bool empty() const { return dictionaries_.empty() && key_layers_.empty(); }
+
+  /**
+   * The number of deleted keys, visits all keys as files can overlap, use empty to check for deletes.
+   */
+  size_t size() const {
+    size_t size = 0;
+    for (size_t i = 0; i < dictionaries_.size(); ++i) {
+      ForEach(dictionaries_[i], [this, i, &size](const std::string& key) {
+        if (!ContainedInDictionaries(key, i)) {
+          ++size;
+        }
+      });
+    }
+
+    // layers are disjoint, but might overlap with files loaded after them
+    for (const auto& layer : key_layers_) {
+      for (const std::string& key : *layer) {
+        if (!ContainedInDictionaries(key, dictionaries_.size())) {
+          ++size;
+        }
+      }
+    }
+
+    return size;
+  }
+
+  /**
+   * Call func for every deleted key, keys that are in several files get visited more than once.
+   */
+  template <typename FuncT>
+  void ForEach(FuncT func) const {
+    for (const dictionary::dictionary_t& d : dictionaries_) {
+      ForEach(d, func);
+    }
+
+    for (const auto& layer : key_layers_) {
+      for (const std::string& key : *layer) {
+        func(key);
+      }
+    }
+  }
+
+  /**
+   * Write deleted keys as key-only dictionary.
+   *
+   * Readers memory map the file, so it must not be overwritten in place: write to a temporary file and rename it.
+   *
+   * @param filename the file to write to
+   * @param keys the deleted keys, a container of strings in any order, duplicates are ignored
+   * @param memory_limit the memory limit of the compiler
+   */
+  template <typename KeysT>
+  static void Write(const std::string& filename, const KeysT& keys, const size_t memory_limit) {
+    std::vector<std::string> sorted_keys(keys.begin(), keys.end());
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+
+    // a filter makes checks for keys that are not deleted - the common case - cheap
+    dictionary::fsa::Generator<dictionary::fsa::internal::SparseArrayPersistence<>> generator(
+        keyvi::util::parameters_t{{MEMORY_LIMIT_KEY, std::to_string(memory_limit)},
+                                  {KEY_FILTER_KEY, "true"},
+                                  {KEY_FILTER_KEYS_KEY, std::to_string(sorted_keys.size())}});
+
+    for (const std::string& key : sorted_keys) {
+      generator.Add(key);
+    }
+    generator.CloseFeeding();
+    generator.WriteToFile(filename);
+  }
+
+  /**
+   * Append deleted keys to a log, creates the log if it does not exist.
+   *
+   * Appending is not atomic, the writer must check the log with ScanLog before appending to a log it did not write.
+   *
+   * @param filename the log file
+   * @param keys the deleted keys
+   */
+  static void AppendToLog(const std::string& filename, const std::vector<std::string>& keys) {
+    // write the records as a single block, to keep the window for a partial record small
+    std::string buffer;
+    for (const std::string& key : keys) {
+      const uint32_t length = htole32(static_cast<uint32_t>(key.size()));
+      buffer.append(reinterpret_cast<const char*>(&length), sizeof(uint32_t));
+      buffer.append(key);
+    }
+
+    std::ofstream log_stream(filename, std::ios::binary | std::ios::app);
+    log_stream.write(buffer.data(), buffer.size());
+    log_stream.flush();
+  }
+
+ private:
+  //! compacted deleted keys files, memory mapped
+  std::vector<dictionary::dictionary_t> dictionaries_;
+
+  using key_layer_t = std::unordered_set<std::string>;
+
+  //! keys from logs and from files in the old format, the newest layer last
+  std::vector<std::shared_ptr<const key_layer_t>> key_layers_;
+
+  void Insert(const std::string& key, key_layer_t* layer) {
+    if (layer->count(key) == 0 && count(key) == 0) {
+      layer->insert(key);
+    }
+  }
+
+  void AddLayer(key_layer_t&& layer) {
+    if (layer.empty()) {
+      return;
+    }
+
+    // merge with the previous layer unless it is much bigger, so every key gets copied O(log n) times
+    while (!key_layers_.empty() && key_layers_.back()->size() <= 2 * layer.size()) {
+      layer.insert(key_layers_.back()->begin(), key_layers_.back()->end());
+      key_layers_.pop_back();
+    }
+
+    key_layers_.push_back(std::make_shared<const key_layer_t>(std::move(layer)));
+  }
+
+  bool ContainedInDictionaries(const std::string& key, const size_t number_of_dictionaries) const {
+    for (size_t i = 0; i < number_of_dictionaries; ++i) {
+      if (dictionaries_[i]->Contains(key)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Call func for every complete record of a log, starting at the given offset.
+   *
+   * @param filename the log file
+   * @param offset the offset to start reading from
+   * @param log_size set to the size of the log, 0 if it does not exist
+   * @param func called with the key of every record
+   * @return the offset after the last complete record
+   */
+  template <typename FuncT>
+  static size_t ReadLog(const std::string& filename, size_t offset, size_t* log_size, FuncT func) {
+    std::ifstream log_stream(filename, std::ios::binary);
+    if (!log_stream.good()) {
+      *log_size = 0;
+      return offset;
+    }
+
+    log_stream.seekg(0, std::ios::end);
+    *log_size = log_stream.tellg();
+    log_stream.seekg(offset);
+
+    std::string key;
+    uint32_t length;
+    while (offset + sizeof(uint32_t) <= *log_size &&
+           log_stream.read(reinterpret_cast<char*>(&length), sizeof(uint32_t))) {
+      length = le32toh(length);
+      if (length > *log_size - offset - sizeof(uint32_t)) {
+        break;
+      }
+      key.resize(length);
+      if (!log_stream.read(&key[0], key.size())) {
+        break;
+      }
+      func(key);
+      offset += sizeof(uint32_t) + key.size();
+    }
+
+    return offset;
+  }
+
+  template <typename FuncT>
+  static void ForEach(const dictionary::dictionary_t& deleted_keys, FuncT func) {
+    dictionary::fsa::EntryIterator it(deleted_keys->GetFsa());
+    dictionary::fsa::EntryIterator end_it;
+    for (; it != end_it; ++it) {
+      func(it.GetKey());
+    }
+  }
+};
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_DELETED_KEY_SET_H_
@@ -0,0 +1,136 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * directory_watcher.h
+ *
+ * Notification about files written into a directory, based on inotify.
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_DIRECTORY_WATCHER_H_
+#define KEYVI_INDEX_INTERNAL_DIRECTORY_WATCHER_H_
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>  //NOLINT
+#include <string>
+#include <unordered_set>
+
+#include <boost/filesystem.hpp>
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+/**
+ * Watches a directory for files that got written or renamed into it.
+ *
+ * Only available on Linux, on other platforms IsAvailable returns false and the caller has to poll. Note that inotify
+ * does not report changes made by other hosts on network file systems.
+ */
+class DirectoryWatcher final {
+ public:
+  explicit DirectoryWatcher(const boost::filesystem::path& directory) {
+#if defined(__linux__)
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ == -1) {
+      TRACE("inotify not available");
+      return;
+    }
+
+    // files are either renamed into place (toc, compacted deleted keys) or appended to (deleted keys log)
+    if (inotify_add_watch(fd_, directory.string().c_str(), IN_MOVED_TO | IN_CLOSE_WRITE) == -1) {
+      TRACE("failed to watch %s", directory.string().c_str());
+      close(fd_);
+      fd_ = -1;
+    }
+#endif
+  }
+
+  ~DirectoryWatcher() {
+#if defined(__linux__)
+    if (fd_ != -1) {
+      close(fd_);
+    }
+#endif
+  }
+
+  DirectoryWatcher& operator=(DirectoryWatcher const&) = delete;
+  DirectoryWatcher(const DirectoryWatcher& that) = delete;
+
+  bool IsAvailable() const { return fd_ != -1; }
+
+  /**
+   * Wait for changes.
+   *
+   * @param timeout the maximum time to wait
+   * @param changed_files filled with the names of the changed files
+   * @return true if events got lost, in which case the caller must assume that every file changed
+   */
+  bool Wait(const std::chrono::milliseconds timeout, std::unordered_set<std::string>* changed_files) {
+    changed_files->clear();
+#if defined(__linux__)
+    if (fd_ == -1) {
+      return true;
+    }
+
+    struct pollfd poll_fd = {fd_, POLLIN, 0};
+    if (poll(&poll_fd, 1, static_cast<int>(timeout.count())) <= 0) {
+      return false;
+    }
+
+    bool overflow = false;
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+      const ssize_t length = read(fd_, buffer, sizeof(buffer));
+      if (length <= 0) {
+        break;
+      }
+
+      for (char* p = buffer; p < buffer + length;) {
+        const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+        if (event->mask & IN_Q_OVERFLOW) {
+          overflow = true;
+        } else if (event->len > 0) {
+          changed_files->emplace(event->name);
+        }
+        p += sizeof(struct inotify_event) + event->len;
+      }
+    }
+
+    return overflow;
+#else
+    return true;
+#endif
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_DIRECTORY_WATCHER_H_
@@ -57,6 +57,13 @@ class IndexAutoConfig final {
     size_t max_concurrent_merges = cores / 2;
     return std::min(MAX_CONCURRENT_MERGES_DEFAULT, std::max(size_t(1), max_concurrent_merges));
   }
+
+  static size_t MaxConcurrentCompiles() {
+    unsigned int cores = std::thread::hardware_concurrency();
+
+    // even with a single core, compiling in the background keeps the writer responsive
+    return std::min(MAX_CONCURRENT_COMPILES_DEFAULT, std::max(size_t(1), size_t(cores / 2)));
+  }
 };
 
 } /* namespace internal */
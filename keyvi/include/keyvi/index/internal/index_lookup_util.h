@@ -24,6 +24,8 @@
 
 #include <map>
 #include <memory>
+#include <queue>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -126,8 +128,9 @@ inline std::map<dictionary::fsa::automata_t, typename SegmentT::deleted_ptr_t> C
       }
     }
     TRACE("found corresponding sement");
-    if ((*segments_it)->DeletedKeysSize() > 0) {
-      deleted_keys_map.emplace(std::get<0>(fsa), (*segments_it)->DeletedKeys());
+    typename SegmentT::deleted_ptr_t deleted_keys = (*segments_it)->DeletedKeys();
+    if (deleted_keys && !deleted_keys->empty()) {
+      deleted_keys_map.emplace(std::get<0>(fsa), std::move(deleted_keys));
     }
     ++segments_it;
   }
@@ -135,6 +138,69 @@ inline std::map<dictionary::fsa::automata_t, typename SegmentT::deleted_ptr_t> C
   return deleted_keys_map;
 }
 
+/**
+ * Merges the matches of several FSA's, each sorted by key, into a single list sorted by key.
+ *
+ * Same as for ZipStateTraverser, if a key is found in several FSA's the match of the newest FSA is taken. It is dropped
+ * if the key is marked as deleted for this FSA.
+ *
+ * @param fsa_matches matches per FSA, ordered oldest to newest
+ * @param deleted_keys_map deleted keys per FSA
+ */
+template <class DeletedT>
+inline std::vector<dictionary::match_t> MergeFilteredMatches(std::vector<std::vector<dictionary::match_t>>* fsa_matches,
+                                                             const DeletedT& deleted_keys_map) {
+  // position in the list of matches per FSA
+  using cursor_t = std::pair<size_t, size_t>;
+
+  auto greater = [fsa_matches](const cursor_t& lhs, const cursor_t& rhs) {
+    const std::string& lhs_key = (*fsa_matches)[lhs.first][lhs.second]->GetMatchedString();
+    const std::string& rhs_key = (*fsa_matches)[rhs.first][rhs.second]->GetMatchedString();
+    int compare = lhs_key.compare(rhs_key);
+    if (compare != 0) {
+      return compare > 0;
+    }
+    return lhs.first < rhs.first;
+  };
+
+  std::priority_queue<cursor_t, std::vector<cursor_t>, decltype(greater)> cursors(greater);
+  for (size_t i = 0; i < fsa_matches->size(); ++i) {
+    if ((*fsa_matches)[i].size() > 0) {
+      cursors.emplace(i, 0);
+    }
+  }
+
+  auto advance = [fsa_matches, &cursors](const cursor_t& cursor) {
+    if (cursor.second + 1 < (*fsa_matches)[cursor.first].size()) {
+      cursors.emplace(cursor.first, cursor.second + 1);
+    }
+  };
+
+  std::vector<dictionary::match_t> matches;
+  while (!cursors.empty()) {
+    const cursor_t top = cursors.top();
+    cursors.pop();
+    dictionary::match_t& m = (*fsa_matches)[top.first][top.second];
+
+    // skip the same key in older FSA's
+    while (!cursors.empty() &&
+           (*fsa_matches)[cursors.top().first][cursors.top().second]->GetMatchedString() == m->GetMatchedString()) {
+      const cursor_t shadowed = cursors.top();
+      cursors.pop();
+      advance(shadowed);
+    }
+    advance(top);
+
+    auto dk = deleted_keys_map.find(m->GetFsa());
+    if (dk != deleted_keys_map.end() && dk->second->count(m->GetMatchedString()) > 0) {
+      continue;
+    }
+    matches.push_back(std::move(m));
+  }
+
+  return matches;
+}
+
 } /* namespace internal */
 } /* namespace index */
 } /* namespace keyvi */
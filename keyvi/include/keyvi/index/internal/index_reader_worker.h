@@ -29,12 +29,14 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>  //NOLINT
+#include <cstring>
 #include <ctime>
 #include <memory>
 #include <mutex>  //NOLINT
 #include <string>
 #include <thread>  //NOLINT
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <boost/filesystem.hpp>
@@ -47,6 +49,7 @@
 #include "keyvi/dictionary/dictionary.h"
 #include "keyvi/dictionary/match.h"
 #include "keyvi/index/constants.h"
+#include "keyvi/index/internal/directory_watcher.h"
 #include "keyvi/index/internal/read_only_segment.h"
 #include "keyvi/util/configuration.h"
 
@@ -63,6 +66,8 @@ class IndexReaderWorker final {
       : segments_(),
         refresh_interval_(
             std::chrono::milliseconds(keyvi::util::mapGet<uint64_t>(params, INDEX_REFRESH_INTERVAL, 1000))),
+        watcher_poll_interval_(std::chrono::milliseconds(
+            keyvi::util::mapGet<uint64_t>(params, INDEX_WATCHER_POLL_INTERVAL, DEFAULT_WATCHER_POLL_INTERVAL))),
         stop_update_thread_(true) {
     index_directory_ = index_directory;
 
@@ -100,6 +105,7 @@ class IndexReaderWorker final {
   }
 
   void Reload() {
+    std::unique_lock<std::mutex> lock(reload_mutex_);
     ReloadIndex();
     ReloadDeletedKeys();
   }
@@ -121,15 +127,24 @@ class IndexReaderWorker final {
   read_only_segments_t segments_;
   std::weak_ptr<read_only_segment_vec_t> segments_weak_;
   std::mutex mutex_;
+  //! serializes reloads from the update thread and explicit calls to Reload
+  std::mutex reload_mutex_;
   std::unordered_map<std::string, read_only_segment_t> segments_by_name_;
   std::chrono::milliseconds refresh_interval_;
+  //! interval to poll for changes if inotify is available, 0 for never
+  std::chrono::milliseconds watcher_poll_interval_;
   std::thread update_thread_;
   std::atomic_bool stop_update_thread_;
 
-  void ReloadIndex() {
+  /**
+   * Reload the toc if it changed.
+   *
+   * @param force reload even if the modification time did not change, the resolution is only 1s
+   */
+  void ReloadIndex(const bool force = false) {
     std::time_t t = boost::filesystem::last_write_time(index_toc_file_);
 
-    if (t <= last_modification_time_) {
+    if (!force && t <= last_modification_time_) {
       TRACE("no modifications found");
       return;
     }
@@ -188,14 +203,68 @@ class IndexReaderWorker final {
     }
   }
 
+  /**
+   * Reload the deleted keys of the segment the given file belongs to, if it is a deleted keys file.
+   */
+  void ReloadDeletedKeys(const std::string& filename) {
+    for (const char* suffix : {".dk", ".dkm", ".dk-log", ".dkm-log"}) {
+      const size_t suffix_length = std::strlen(suffix);
+      if (filename.size() > suffix_length &&
+          filename.compare(filename.size() - suffix_length, suffix_length, suffix) == 0) {
+        auto segment = segments_by_name_.find(filename.substr(0, filename.size() - suffix_length));
+        if (segment != segments_by_name_.end()) {
+          TRACE("reload deleted keys of %s", segment->first.c_str());
+          segment->second->ReloadDeletedKeys();
+        }
+        return;
+      }
+    }
+  }
+
   void UpdateWatcher() {
-    while (!stop_update_thread_) {
-      TRACE("UpdateWatcher: Check for new segments");
-      // reload
-      ReloadIndex();
+    DirectoryWatcher watcher(index_directory_);
+
+    if (watcher.IsAvailable()) {
+      // changes before the watch got established are not reported
+      std::unique_lock<std::mutex> lock(reload_mutex_);
+      ReloadIndex(true);
       ReloadDeletedKeys();
-      // sleep for next refresh
-      std::this_thread::sleep_for(refresh_interval_);
+    }
+
+    std::unordered_set<std::string> changed_files;
+    auto next_poll = std::chrono::steady_clock::now() + watcher_poll_interval_;
+    while (!stop_update_thread_) {
+      if (!watcher.IsAvailable()) {
+        TRACE("UpdateWatcher: Check for new segments");
+        // reload
+        Reload();
+        // sleep for next refresh
+        std::this_thread::sleep_for(refresh_interval_);
+        continue;
+      }
+
+      // wake up every refresh interval to check whether to stop, an idle index does not touch the file system
+      const bool overflow = watcher.Wait(refresh_interval_, &changed_files);
+      const auto now = std::chrono::steady_clock::now();
+      std::unique_lock<std::mutex> lock(reload_mutex_);
+
+      // events got lost or it is time to poll for changes that are not reported, e.g. made by another host on a
+      // network file system
+      if (overflow || (watcher_poll_interval_.count() > 0 && now >= next_poll)) {
+        ReloadIndex(overflow || changed_files.count("index.toc") > 0);
+        ReloadDeletedKeys();
+        next_poll = now + watcher_poll_interval_;
+        continue;
+      }
+
+      // load new segments first, they load their deleted keys on their own
+      if (changed_files.count("index.toc")) {
+        ReloadIndex(true);
+      }
+
+      for (const std::string& filename : changed_files) {
+        ReloadDeletedKeys(filename);
+      }
     }
   }
 };
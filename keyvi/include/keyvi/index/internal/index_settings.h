@@ -29,6 +29,7 @@
 #include <unordered_map>
 #include <variant>
 
+#include "keyvi/dictionary/fsa/internal/constants.h"
 #include "keyvi/index/constants.h"
 #include "keyvi/index/internal/index_auto_config.h"
 #include "keyvi/util/configuration.h"
@@ -59,6 +60,19 @@ class IndexSettings final {
     } else {
       settings_[MAX_CONCURRENT_MERGES] = IndexAutoConfig::MaxConcurrentMerges();
     }
+    if (params.count(MAX_CONCURRENT_COMPILES)) {
+      settings_[MAX_CONCURRENT_COMPILES] = keyvi::util::mapGet<size_t>(params, MAX_CONCURRENT_COMPILES);
+    } else {
+      settings_[MAX_CONCURRENT_COMPILES] = IndexAutoConfig::MaxConcurrentCompiles();
+    }
+    settings_[INDEX_MEMORY_BUDGET] =
+        keyvi::util::mapGetMemory(params, INDEX_MEMORY_BUDGET, DEFAULT_INDEX_MEMORY_BUDGET);
+    // bytes per second read and written by all merges together, 0: no limit. The limit is lifted while merges fall
+    // behind, except for merges in an external process: they get an equal share of the rate when they start and keep
+    // it until they finish.
+    settings_[MERGE_RATE_LIMIT_KEY] = keyvi::util::mapGetMemory(params, MERGE_RATE_LIMIT_KEY, 0);
+    settings_[MERGE_NICE] = keyvi::util::mapGet<size_t>(params, MERGE_NICE, 0);
+    settings_[INDEX_MEMTABLE] = size_t(keyvi::util::mapGetBool(params, INDEX_MEMTABLE, DEFAULT_INDEX_MEMTABLE));
     if (params.count(SEGMENT_COMPILE_KEY_THRESHOLD)) {
       settings_[SEGMENT_COMPILE_KEY_THRESHOLD] = keyvi::util::mapGet<size_t>(params, SEGMENT_COMPILE_KEY_THRESHOLD);
     } else {
@@ -87,6 +101,16 @@ class IndexSettings final {
 
   const size_t GetMaxConcurrentMerges() const { return std::get<size_t>(settings_.at(MAX_CONCURRENT_MERGES)); }
 
+  const size_t GetMaxConcurrentCompiles() const { return std::get<size_t>(settings_.at(MAX_CONCURRENT_COMPILES)); }
+
+  const size_t GetMemoryBudget() const { return std::get<size_t>(settings_.at(INDEX_MEMORY_BUDGET)); }
+
+  const size_t GetMergeRateLimit() const { return std::get<size_t>(settings_.at(MERGE_RATE_LIMIT_KEY)); }
+
+  const size_t GetMergeNice() const { return std::get<size_t>(settings_.at(MERGE_NICE)); }
+
+  const bool GetMemTable() const { return std::get<size_t>(settings_.at(INDEX_MEMTABLE)) != 0; }
+
   const size_t GetRefreshInterval() const { return std::get<size_t>(settings_.at(INDEX_REFRESH_INTERVAL)); }
 
   const size_t GetSegmentExternalMergeKeyThreshold() const {
@@ -28,10 +28,12 @@
 
 #include <algorithm>
 #include <atomic>
-#include <condition_variable>  //NOLINT
+#include <cstdint>
 #include <ctime>
+#include <exception>
 #include <fstream>
 #include <functional>
+#include <future>  //NOLINT
 #include <list>
 #include <memory>
 #include <mutex>  //NOLINT
@@ -51,13 +53,17 @@
 #include "keyvi/dictionary/dictionary_index_compiler.h"
 #include "keyvi/dictionary/dictionary_types.h"
 #include "keyvi/index/constants.h"
+#include "keyvi/index/internal/compile_job.h"
 #include "keyvi/index/internal/index_settings.h"
+#include "keyvi/index/internal/mem_table.h"
+#include "keyvi/index/internal/memory_budget.h"
 #include "keyvi/index/internal/merge_job.h"
 #include "keyvi/index/internal/merge_policy_selector.h"
 #include "keyvi/index/internal/segment.h"
 #include "keyvi/index/types.h"
 #include "keyvi/util/active_object.h"
 #include "keyvi/util/configuration.h"
+#include "keyvi/util/rate_limiter.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -69,42 +75,87 @@ namespace internal {
 class IndexWriterWorker final {
   using compiler_t = std::shared_ptr<dictionary::JsonDictionaryIndexCompiler>;
   struct IndexPayload {
-    explicit IndexPayload(const std::string& index_directory, const keyvi::util::parameters_t& params)
+    explicit IndexPayload(const std::string& index_directory, const keyvi::util::parameters_t& params,
+                          const std::function<void()>& compile_finished)
         : external_process_ctx_(),
           compiler_(),
+          compiler_memory_limit_(0),
           write_counter_(0),
           segments_(),
           segments_mutex_(),
-          flush_mutex_(),
+          segment_watermarks_(),
           index_directory_(index_directory),
           index_toc_file_(index_directory_ / "index.toc"),
           index_toc_file_part_(index_directory_ / "index.toc.part"),
           settings_(params),
           max_concurrent_merges_(settings_.GetMaxConcurrentMerges()),
+          max_concurrent_compiles_(settings_.GetMaxConcurrentCompiles()),
           max_segments_(settings_.GetMaxSegments()),
           compile_key_threshold_(settings_.GetSegmentCompileKeyThreshold()),
           index_refresh_interval_(settings_.GetRefreshInterval()),
+          write_buffer_size_(std::max(size_t(1), std::min(WRITE_BUFFER_SIZE, compile_key_threshold_))),
+          write_buffer_(),
+          free_write_buffers_(),
+          write_buffer_mutex_(),
+          write_sequence_(0),
+          applied_sequence_(0),
+          purge_sequence_(0),
+          mem_table_(settings_.GetMemTable() ? std::make_shared<MemTable>() : std::shared_ptr<MemTable>()),
+          memory_budget_(settings_.GetMemoryBudget()),
+          merge_rate_limiter_(std::make_shared<util::RateLimiter>(settings_.GetMergeRateLimit())),
+          compile_jobs_(),
+          number_of_compile_jobs_(0),
+          compile_finished_(compile_finished),
+          background_error_(),
           merge_jobs_(),
           any_delete_(false),
           merge_enabled_(true) {
       segments_ = std::make_shared<segment_vec_t>();
+      write_buffer_.reserve(write_buffer_size_);
     }
 
     boost::asio::io_context external_process_ctx_;
     compiler_t compiler_;
+    size_t compiler_memory_limit_;
     std::atomic_size_t write_counter_;
     segments_t segments_;
     std::weak_ptr<segment_vec_t> segments_weak_;
     std::mutex segments_mutex_;
-    std::mutex flush_mutex_;
+    //! promises waiting for the number of segments to drop to the given value, guarded by the segments mutex
+    std::list<std::pair<size_t, std::shared_ptr<std::promise<void>>>> segment_watermarks_;
     const boost::filesystem::path index_directory_;
     const boost::filesystem::path index_toc_file_;
     const boost::filesystem::path index_toc_file_part_;
     const internal::IndexSettings settings_;
     const size_t max_concurrent_merges_;
+    const size_t max_concurrent_compiles_;
     const size_t max_segments_;
     const size_t compile_key_threshold_;
     const size_t index_refresh_interval_;
+    const size_t write_buffer_size_;
+    key_value_vector_t write_buffer_;
+    std::vector<key_value_vector_t> free_write_buffers_;
+    //! guards the write buffers and keeps the order of writes when handing them over to the worker thread
+    std::mutex write_buffer_mutex_;
+    //! sequence number of the last write, guarded by the write buffer mutex
+    uint64_t write_sequence_;
+    //! sequence number of the last write applied on the worker thread
+    uint64_t applied_sequence_;
+    //! sequence number of the last write published in a segment, purged from the mem table once deletes got persisted
+    uint64_t purge_sequence_;
+    //! writes not yet published in a segment, readable by queries, empty if disabled
+    std::shared_ptr<MemTable> mem_table_;
+    MemoryBudget memory_budget_;
+    //! shared by all internal merges
+    std::shared_ptr<util::RateLimiter> merge_rate_limiter_;
+    //! segments compiling in the background, in the order they get published
+    std::list<CompileJob> compile_jobs_;
+    //! size of the list of compile jobs, readable from other threads
+    std::atomic_size_t number_of_compile_jobs_;
+    //! invoked from the compile thread once a compilation is done
+    const std::function<void()> compile_finished_;
+    //! error of a task nobody waits for, e.g. a failed background compilation, reported by the next flush or merge
+    std::exception_ptr background_error_;
     std::list<MergeJob> merge_jobs_;
     bool any_delete_;
     std::atomic_bool merge_enabled_;
@@ -112,7 +163,15 @@ class IndexWriterWorker final {
 
  public:
   explicit IndexWriterWorker(const std::string& index_directory, const keyvi::util::parameters_t& params)
-      : payload_(index_directory, params),
+      : payload_(index_directory, params,
+                 [this]() {
+                   // publish the segment without waiting for the next scheduled task
+                   compiler_active_object_([](IndexPayload& payload) {
+                     KeepBackgroundError(&payload, [&payload]() {
+                       FinalizeCompiles(&payload, payload.max_concurrent_compiles_);
+                     });
+                   });
+                 }),
         merge_policy_(merge_policy(keyvi::util::mapGet<std::string>(params, MERGE_POLICY, DEFAULT_MERGE_POLICY))),
         compiler_active_object_(&payload_, std::bind(&index::internal::IndexWriterWorker::ScheduledTask, this),
                                 std::chrono::milliseconds(payload_.index_refresh_interval_)) {
@@ -127,9 +186,12 @@ class IndexWriterWorker final {
     TRACE("destruct worker: %s", payload_.index_directory_.c_str());
     payload_.merge_enabled_ = false;
 
+    SubmitWriteBuffer();
+
     // push a function to finish all pending merges
     compiler_active_object_([](IndexPayload& payload) {
-      Compile(&payload);
+      // nobody is left to report an error to, but the pending merges must be finished regardless
+      KeepBackgroundError(&payload, [&payload]() { CompileAndPublish(&payload); });
       for (MergeJob& p : payload.merge_jobs_) {
         p.Finalize();
       }
@@ -147,106 +209,185 @@ class IndexWriterWorker final {
     return segments;
   }
 
-  // todo: rvalue version??
-  void Add(const std::string& key, const std::string& value) {
-    // push function
-    TRACE("add key %s, pt: %p", key.c_str(), &key);
+  const std::shared_ptr<MemTable>& GetMemTable() const { return payload_.mem_table_; }
 
-    // strings are copied
-    compiler_active_object_([key, value](IndexPayload& payload) {
-      CreateCompilerIfNeeded(&payload);
-      TRACE("add_async key %s, pt: %p", key.c_str(), &key);
-      payload.compiler_->Add(key, value);
-    });
+  void Add(const std::string& key, const std::string& value) { Add(std::string(key), std::string(value)); }
+
+  /**
+   * Add a key value pair, taking ownership of the strings.
+   *
+   * Writes are collected in a write buffer, which is handed over to the worker thread as a whole when it is full, on
+   * the next bulk add, delete or flush and at the latest with the next scheduled task.
+   */
+  void Add(std::string&& key, std::string&& value) {
+    TRACE("add key %s", key.c_str());
+    size_t writes = 0;
+    {
+      std::unique_lock<std::mutex> lock(payload_.write_buffer_mutex_);
+      ++payload_.write_sequence_;
+      if (payload_.mem_table_) {
+        payload_.mem_table_->Put(key, value, payload_.write_sequence_);
+      }
+      payload_.write_buffer_.emplace_back(std::move(key), std::move(value));
+
+      if (payload_.write_buffer_.size() < payload_.write_buffer_size_) {
+        return;
+      }
+      writes = SubmitWriteBufferLocked();
+    }
+
+    CompileIfThresholdIsHit(writes);
+  }
 
-    CompileIfThresholdIsHit();
+  /**
+   * Add a batch of key value pairs, the batch is moved to the worker thread as a whole.
+   */
+  void Add(key_value_vector_t&& key_values) {
+    TRACE("bulk add keys: %ul", key_values.size());
+    size_t writes = key_values.size();
+    {
+      std::unique_lock<std::mutex> lock(payload_.write_buffer_mutex_);
+      writes += SubmitWriteBufferLocked();
+      AddToMemTableLocked(key_values);
+      EnqueueKeyValues(std::move(key_values), false);
+    }
+
+    CompileIfThresholdIsHit(writes);
   }
 
   template <typename ContainerType>
   void Add(const std::shared_ptr<ContainerType>& key_values) {
     TRACE("bulk add keys: %ul", key_values->size());
+    size_t writes = key_values->size();
+    {
+      std::unique_lock<std::mutex> lock(payload_.write_buffer_mutex_);
+      writes += SubmitWriteBufferLocked();
+      AddToMemTableLocked(*key_values);
 
-    // the shared pointer is copied (not the key/values)
-    compiler_active_object_([key_values](IndexPayload& payload) {
-      CreateCompilerIfNeeded(&payload);
+      // the shared pointer is copied (not the key/values)
+      compiler_active_object_([key_values, sequence = payload_.write_sequence_](IndexPayload& payload) {
+        CreateCompilerIfNeeded(&payload);
 
-      for (auto key_value : *key_values) {
-        TRACE("add_async key %s, pt: %p", key_value.first.c_str(), &key_value.first);
-        payload.compiler_->Add(key_value.first, key_value.second);
-      }
-    });
-    CompileIfThresholdIsHit();
+        for (const auto& key_value : *key_values) {
+          TRACE("add_async key %s, pt: %p", key_value.first.c_str(), &key_value.first);
+          payload.compiler_->Add(key_value.first, key_value.second);
+        }
+        payload.applied_sequence_ = sequence;
+      });
+    }
+    CompileIfThresholdIsHit(writes);
   }
 
   void Delete(const std::string& key) {
-    compiler_active_object_([key](IndexPayload& payload) {
+    size_t writes = 1;
+    std::unique_lock<std::mutex> lock(payload_.write_buffer_mutex_);
+    writes += SubmitWriteBufferLocked();
+    ++payload_.write_sequence_;
+    if (payload_.mem_table_) {
+      payload_.mem_table_->Delete(key, payload_.write_sequence_);
+    }
+
+    compiler_active_object_([key, sequence = payload_.write_sequence_](IndexPayload& payload) {
       payload.any_delete_ = true;
+      payload.applied_sequence_ = sequence;
       TRACE("delete key %s", key.c_str());
 
       if (payload.compiler_) {
         payload.compiler_->Delete(key);
       }
 
+      for (CompileJob& c : payload.compile_jobs_) {
+        c.DeleteKey(key);
+      }
+
       if (payload.segments_) {
         for (const segment_t& s : *payload.segments_) {
           s->DeleteKey(key);
         }
       }
     });
+    lock.unlock();
 
-    CompileIfThresholdIsHit();
+    CompileIfThresholdIsHit(writes);
   }
 
   /**
    * Flush for external use.
+   *
+   * @param async if false, wait until all pending writes got compiled and published
+   * @return a future, ready once the flush got executed, rethrows if compiling failed, including background
+   * compilations that failed since the last flush or force merge
    */
-  void Flush(const bool async = false) {
+  std::shared_future<void> Flush(const bool async = false) {
     TRACE("flush");
+    SubmitWriteBuffer();
+
+    auto flushed = std::make_shared<std::promise<void>>();
+    std::shared_future<void> future = flushed->get_future().share();
 
     if (async) {
-      compiler_active_object_([](IndexPayload& payload) {
-        PersistDeletes(&payload);
-        Compile(&payload);
+      compiler_active_object_([flushed](IndexPayload& payload) {
+        try {
+          PersistDeletes(&payload);
+          Compile(&payload);
+          // publish what is done, but do not wait for the compilation
+          FinalizeCompiles(&payload, payload.max_concurrent_compiles_);
+          RethrowBackgroundError(&payload);
+          flushed->set_value();
+        } catch (...) {
+          flushed->set_exception(std::current_exception());
+        }
       });
     } else {
-      std::condition_variable c;
-      std::unique_lock<std::mutex> lock(payload_.flush_mutex_);
-      std::atomic_bool flushed{false};
-
-      compiler_active_object_([&c, &flushed](IndexPayload& payload) {
-        std::unique_lock<std::mutex> lock(payload.flush_mutex_);
-        PersistDeletes(&payload);
-        Compile(&payload);
-        flushed = true;
-        c.notify_all();
+      compiler_active_object_([flushed](IndexPayload& payload) {
+        try {
+          CompileAndPublish(&payload);
+          RethrowBackgroundError(&payload);
+          flushed->set_value();
+        } catch (...) {
+          flushed->set_exception(std::current_exception());
+        }
       });
 
-      // condition may be unblocked spuriously, check flushed
-      while (flushed == false) {
-        c.wait(lock);
-      }
+      future.get();
     }
+
+    return future;
   }
 
-  void ForceMerge(const size_t max_segments) {
+  /**
+   * Flush and wait for merges to bring the index down to the given number of segments.
+   *
+   * @param max_segments maximum number of segments the index should have afterwards
+   * @param async if false, wait until the index has at most max_segments segments
+   * @return a future, ready once the index has at most max_segments segments, rethrows if compiling failed
+   */
+  std::shared_future<void> ForceMerge(const size_t max_segments, const bool async = false) {
     TRACE("force merge");
+    SubmitWriteBuffer();
+
+    auto merged = std::make_shared<std::promise<void>>();
+    std::shared_future<void> future = merged->get_future().share();
+
+    compiler_active_object_([this, merged, max_segments](IndexPayload& payload) {
+      try {
+        // everything written so far takes part in the merge
+        CompileAndPublish(&payload);
+        RethrowBackgroundError(&payload);
+      } catch (...) {
+        merged->set_exception(std::current_exception());
+        return;
+      }
 
-    // 1st check the queue and empty it if necessary
-    if (compiler_active_object_.Size() > 0) {
-      Flush();
-    }
-
-    // spin until we reach the desired size
-    while (payload_.segments_->size() > max_segments) {
-      // wait some time for segments being merged
-      // todo improve this dependent on number and size of segments
-      std::this_thread::sleep_for(std::chrono::milliseconds(SPINLOCK_WAIT_FOR_SEGMENT_MERGES_MS));
+      AddSegmentWatermark(&payload, max_segments, merged);
+      KeepBackgroundError(&payload, [this]() { FinalizeAndRunMerges(); });
+    });
 
-      // should we somehow got new data, flush again
-      if (compiler_active_object_.Size() > 0) {
-        Flush();
-      }
+    if (!async) {
+      future.get();
     }
+
+    return future;
   }
 
  private:
@@ -254,16 +395,126 @@ class IndexWriterWorker final {
   merge_policy_t merge_policy_;
   util::ActiveObject<IndexPayload> compiler_active_object_;
 
-  void CompileIfThresholdIsHit() {
-    if (++payload_.write_counter_ > payload_.compile_key_threshold_) {
-      compiler_active_object_([](IndexPayload& payload) { Compile(&payload); });
+  /**
+   * Hand over the buffered writes to the worker thread.
+   */
+  void SubmitWriteBuffer() {
+    std::unique_lock<std::mutex> lock(payload_.write_buffer_mutex_);
+    SubmitWriteBufferLocked();
+  }
+
+  /**
+   * Hand over the buffered writes to the worker thread, the caller must hold the write buffer mutex.
+   *
+   * @return the number of writes handed over
+   */
+  size_t SubmitWriteBufferLocked() {
+    const size_t writes = payload_.write_buffer_.size();
+    if (writes == 0) {
+      return 0;
+    }
+
+    key_value_vector_t key_values;
+    if (payload_.free_write_buffers_.size() > 0) {
+      key_values.swap(payload_.free_write_buffers_.back());
+      payload_.free_write_buffers_.pop_back();
+    } else {
+      key_values.reserve(payload_.write_buffer_size_);
+    }
+
+    key_values.swap(payload_.write_buffer_);
+    EnqueueKeyValues(std::move(key_values), true);
+    return writes;
+  }
+
+  /**
+   * Feed the buffered writes straight into the compiler, must be called from the worker thread.
+   *
+   * If tasks are queued, the writes are queued after them instead, which keeps the order of writes.
+   */
+  void ApplyWriteBuffer() {
+    std::unique_lock<std::mutex> lock(payload_.write_buffer_mutex_);
+    if (payload_.write_buffer_.empty()) {
+      return;
+    }
+
+    if (compiler_active_object_.Size() > 0) {
+      SubmitWriteBufferLocked();
+      return;
+    }
+
+    CreateCompilerIfNeeded(&payload_);
+    for (auto& key_value : payload_.write_buffer_) {
+      TRACE("add key %s", key_value.first.c_str());
+      payload_.compiler_->Add(std::move(key_value.first), std::move(key_value.second));
+    }
+    payload_.write_buffer_.clear();
+    payload_.applied_sequence_ = payload_.write_sequence_;
+  }
+
+  /**
+   * Make a batch of key values readable from the mem table, the caller must hold the write buffer mutex.
+   */
+  template <typename ContainerType>
+  void AddToMemTableLocked(const ContainerType& key_values) {
+    ++payload_.write_sequence_;
+    if (!payload_.mem_table_) {
+      return;
+    }
+
+    payload_.mem_table_->PutMany(key_values, payload_.write_sequence_);
+  }
+
+  /**
+   * Move key values to the worker thread and feed them to the compiler.
+   *
+   * @param key_values the key values
+   * @param recycle whether to return the emptied buffer to the ring of free write buffers
+   */
+  void EnqueueKeyValues(key_value_vector_t&& key_values, const bool recycle) {
+    compiler_active_object_([key_values = std::move(key_values), recycle,
+                             sequence = payload_.write_sequence_](IndexPayload& payload) mutable {
+      CreateCompilerIfNeeded(&payload);
+
+      for (auto& key_value : key_values) {
+        TRACE("add_async key %s", key_value.first.c_str());
+        payload.compiler_->Add(std::move(key_value.first), std::move(key_value.second));
+      }
+      payload.applied_sequence_ = sequence;
+
+      if (recycle) {
+        key_values.clear();
+        std::unique_lock<std::mutex> lock(payload.write_buffer_mutex_);
+        if (payload.free_write_buffers_.size() < WRITE_BUFFER_RING_SIZE) {
+          payload.free_write_buffers_.push_back(std::move(key_values));
+        }
+      }
+    });
+  }
+
+  void CompileIfThresholdIsHit(const size_t writes = 1) {
+    if (writes == 0) {
+      return;
+    }
+
+    if ((payload_.write_counter_ += writes) > payload_.compile_key_threshold_) {
+      compiler_active_object_([](IndexPayload& payload) {
+        KeepBackgroundError(&payload, [&payload]() { Compile(&payload); });
+      });
       payload_.write_counter_ = 0;
 
-      // worst case scenario, to many segments, throttle further writes until we are below the limit
-      while (compiler_active_object_.Size() + payload_.segments_->size() >= payload_.max_segments_) {
-        // wait some time and then flush, which should give time to reduce the number of open file descriptors
-        std::this_thread::sleep_for(std::chrono::milliseconds(SPINLOCK_WAIT_FOR_SEGMENT_MERGES_MS));
+      // worst case scenario, to many segments, block further writes until merges brought us below the limit
+      if (compiler_active_object_.Size() + payload_.number_of_compile_jobs_ + payload_.segments_->size() >=
+          payload_.max_segments_) {
+        TRACE("too many segments, throttle writes");
         Flush();
+        compiler_active_object_(
+            [this](IndexPayload& payload) { KeepBackgroundError(&payload, [this]() { FinalizeAndRunMerges(); }); });
+
+        auto below_limit = std::make_shared<std::promise<void>>();
+        std::future<void> future = below_limit->get_future();
+        AddSegmentWatermark(&payload_, payload_.max_segments_ > 0 ? payload_.max_segments_ - 1 : 0, below_limit);
+        future.wait();
       }
     }
   }
@@ -271,20 +522,30 @@ class IndexWriterWorker final {
   void ScheduledTask() {
     TRACE("Scheduled task");
 
-    if (payload_.merge_jobs_.size()) {
-      FinalizeMerge();
-    }
+    KeepBackgroundError(&payload_, [this]() {
+      // buffered writes get compiled with this task, not only with the next one
+      ApplyWriteBuffer();
 
-    if (payload_.merge_enabled_) {
-      RunMerge();
-    }
+      if (payload_.compile_jobs_.size()) {
+        FinalizeCompiles(&payload_, payload_.max_concurrent_compiles_);
+      }
 
-    if (!payload_.compiler_ && !payload_.any_delete_) {
-      return;
-    }
+      if (payload_.merge_jobs_.size()) {
+        FinalizeMerge();
+      }
 
-    PersistDeletes(&payload_);
-    Compile(&payload_);
+      if (payload_.merge_enabled_) {
+        RunMerge();
+      }
+
+      if (payload_.compiler_ || payload_.any_delete_) {
+        PersistDeletes(&payload_);
+        Compile(&payload_);
+      }
+
+      // only after deletes got persisted, otherwise deleted keys would be readable from the segments again
+      PurgeMemTableIfIdle(&payload_);
+    });
   }
 
   /**
@@ -296,6 +557,8 @@ class IndexWriterWorker final {
     TRACE("Finalize Merge");
     for (MergeJob& p : payload_.merge_jobs_) {
       if (p.TryFinalize()) {
+        payload_.memory_budget_.Release(p.GetMemoryLimit());
+
         if (p.Successful()) {
           // let the merge policy know that id is done
           merge_policy_->MergeFinished(p.GetId());
@@ -334,6 +597,7 @@ class IndexWriterWorker final {
 
           // reset as segments have been changed
           payload_.segments_weak_.reset();
+          NotifySegmentWatermarks(&payload_);
 
           // delete old segment files
           for (const segment_t& s : p.Segments()) {
@@ -358,6 +622,10 @@ class IndexWriterWorker final {
             s->MergeFailed();
           }
 
+          // drop the job, it holds no resources anymore
+          p.SetMerged();
+          any_merge_finalized = true;
+
           // todo throttle strategy?
         }
       }
@@ -371,15 +639,37 @@ class IndexWriterWorker final {
     }
   }
 
+  /**
+   * Finalize merges and start new ones without waiting for the next scheduled task, e.g. when a merge is done.
+   */
+  void FinalizeAndRunMerges() {
+    FinalizeMerge();
+
+    if (payload_.merge_enabled_) {
+      RunMerge();
+    }
+  }
+
   /**
    * Run a merge if mergers are available and segments require merge
    */
   void RunMerge() {
+    // if merges fall behind, writes get throttled, so lift the rate limit until merges caught up
+    payload_.merge_rate_limiter_->SetRate(payload_.segments_->size() > payload_.max_segments_ / 2
+                                              ? 0
+                                              : payload_.settings_.GetMergeRateLimit());
+
     if (payload_.merge_jobs_.size() == payload_.max_concurrent_merges_) {
       // to many merges already running, so throttle
       return;
     }
 
+    // wait for memory, unless nothing else runs, which ensures progress even with a tiny budget
+    if (payload_.merge_jobs_.size() > 0 && !payload_.memory_budget_.CanAcquire()) {
+      TRACE("merge throttled, memory budget exhausted");
+      return;
+    }
+
     size_t merge_policy_id = 0;
     std::vector<segment_t> to_merge;
 
@@ -388,18 +678,36 @@ class IndexWriterWorker final {
     }
 
     TRACE("enough segments found for merging");
-    boost::filesystem::path p(payload_.index_directory_);
-    p /= boost::filesystem::unique_path("%%%%-%%%%-%%%%-%%%%.kv");
+    size_t number_of_keys = 0;
+    for (const segment_t& s : to_merge) {
+      number_of_keys += s->GetDictionaryProperties()->GetNumberOfKeys();
+    }
+
+    // the key filter of the merged segment must fit, too
+    if (payload_.merge_jobs_.size() > 0 && !payload_.memory_budget_.CanAcquire(number_of_keys)) {
+      TRACE("merge throttled, memory budget exhausted");
+      return;
+    }
 
     for (segment_t& s : to_merge) {
       s->ElectedForMerge();
     }
 
-    payload_.merge_jobs_.emplace_back(to_merge, merge_policy_id, p, payload_.settings_);
+    boost::filesystem::path p(payload_.index_directory_);
+    p /= boost::filesystem::unique_path("%%%%-%%%%-%%%%-%%%%.kv");
 
-    // force external merge if low on filedescriptors
-    payload_.merge_jobs_.back().Run(&payload_.external_process_ctx_,
-                                    payload_.segments_->size() + to_merge.size() + 10 > payload_.max_segments_);
+    payload_.merge_jobs_.emplace_back(to_merge, merge_policy_id, p, payload_.settings_,
+                                      payload_.memory_budget_.Acquire(number_of_keys), payload_.merge_rate_limiter_);
+
+    // force external merge if low on filedescriptors, a finished internal merge gets finalized right away instead of
+    // waiting for the next scheduled task
+    payload_.merge_jobs_.back().Run(
+        &payload_.external_process_ctx_, payload_.segments_->size() + to_merge.size() + 10 > payload_.max_segments_,
+        [this]() {
+          compiler_active_object_([this](IndexPayload& payload) {
+            KeepBackgroundError(&payload, [this]() { FinalizeAndRunMerges(); });
+          });
+        });
   }
 
   void LoadIndex() {
@@ -421,7 +729,7 @@ class IndexWriterWorker final {
     for (const auto& e : index_toc["files"].GetArray()) {
       boost::filesystem::path p(payload_.index_directory_);
       p /= e.GetString();
-      payload_.segments_->emplace_back(new Segment(p, false));
+      payload_.segments_->emplace_back(new Segment(p, false, payload_.memory_budget_.MaxJobMemoryLimit()));
     }
   }
 
@@ -437,17 +745,97 @@ class IndexWriterWorker final {
 
     // clear delete flag
     payload->any_delete_ = false;
+
+    // the deletes are readable from the segments now
+    PurgeMemTable(payload, payload->purge_sequence_);
+  }
+
+  /**
+   * Compile all pending writes, wait for the compilations and publish the segments and deletes.
+   */
+  static inline void CompileAndPublish(IndexPayload* payload) {
+    Compile(payload);
+    FinalizeCompiles(payload, 0);
+    PersistDeletes(payload);
+    PurgeMemTableIfIdle(payload);
+  }
+
+  /**
+   * Drop everything from the mem table if no write is pending, e.g. deletes not followed by a compilation.
+   */
+  static inline void PurgeMemTableIfIdle(IndexPayload* payload) {
+    if (!payload->compiler_ && payload->compile_jobs_.empty()) {
+      PurgeMemTable(payload, payload->applied_sequence_);
+    }
+  }
+
+  /**
+   * Drop writes up to the given sequence number from the mem table, deferred while deletes are not persisted.
+   *
+   * @param payload the payload
+   * @param sequence the sequence number of the last write readable from the segments
+   */
+  static inline void PurgeMemTable(IndexPayload* payload, const uint64_t sequence) {
+    if (!payload->mem_table_) {
+      return;
+    }
+
+    payload->purge_sequence_ = std::max(payload->purge_sequence_, sequence);
+    if (!payload->any_delete_) {
+      payload->mem_table_->Purge(payload->purge_sequence_);
+    }
+  }
+
+  /**
+   * Register a promise, fulfilled as soon as the index has at most max_segments segments.
+   */
+  static void AddSegmentWatermark(IndexPayload* payload, const size_t max_segments,
+                                  const std::shared_ptr<std::promise<void>>& promise) {
+    std::unique_lock<std::mutex> lock(payload->segments_mutex_);
+    if (payload->segments_->size() <= max_segments) {
+      promise->set_value();
+      return;
+    }
+
+    payload->segment_watermarks_.emplace_back(max_segments, promise);
+  }
+
+  /**
+   * Fulfill the promises waiting for the number of segments to drop, called after the segments changed.
+   */
+  static void NotifySegmentWatermarks(IndexPayload* payload) {
+    std::unique_lock<std::mutex> lock(payload->segments_mutex_);
+    const size_t number_of_segments = payload->segments_->size();
+
+    payload->segment_watermarks_.remove_if(
+        [number_of_segments](const std::pair<size_t, std::shared_ptr<std::promise<void>>>& watermark) {
+          if (number_of_segments <= watermark.first) {
+            watermark.second->set_value();
+            return true;
+          }
+          return false;
+        });
   }
 
   static inline void CreateCompilerIfNeeded(IndexPayload* payload) {
     if (!payload->compiler_) {
       TRACE("recreate compiler");
-      keyvi::util::parameters_t params = keyvi::util::parameters_t{{"memory_limit_mb", "5"}};
+      payload->compiler_memory_limit_ = payload->memory_budget_.Acquire(payload->compile_key_threshold_);
+
+      // segments get a key filter, so lookups of missing keys can skip them without walking the FSA
+      keyvi::util::parameters_t params = keyvi::util::parameters_t{
+          {MEMORY_LIMIT_KEY, std::to_string(payload->compiler_memory_limit_)}, {KEY_FILTER_KEY, "true"}};
 
       payload->compiler_.reset(new dictionary::JsonDictionaryIndexCompiler(params));
     }
   }
 
+  /**
+   * Compile the current compiler into a new segment.
+   *
+   * The compilation runs in the background, a fresh compiler gets created on the next write. If the maximum of
+   * concurrent compilations is reached, wait for the oldest one to finish first.
+   */
   static inline void Compile(IndexPayload* payload) {
     if (!payload->compiler_) {
       TRACE("no compiler found");
@@ -457,19 +845,138 @@ class IndexWriterWorker final {
     boost::filesystem::path p(payload->index_directory_);
     p /= boost::filesystem::unique_path("%%%%-%%%%-%%%%-%%%%.kv");
 
-    TRACE("compiling");
-    payload->compiler_->Compile();
-    TRACE("write to file [%s] [%s]", p.string().c_str(), p.filename().string().c_str());
+    if (payload->max_concurrent_compiles_ == 0) {
+      std::exception_ptr compile_error;
+      try {
+        TRACE("compiling");
+        payload->compiler_->Compile();
+        TRACE("write to file [%s] [%s]", p.string().c_str(), p.filename().string().c_str());
+
+        payload->compiler_->WriteToFile(p.string());
+      } catch (...) {
+        compile_error = std::current_exception();
+      }
+
+      // free resources
+      payload->compiler_.reset();
+      payload->memory_budget_.Release(payload->compiler_memory_limit_);
 
-    payload->compiler_->WriteToFile(p.string());
+      if (compile_error) {
+        CompileFailed(payload, p, compile_error);
+        return;
+      }
+      AddSegment(payload, p, {}, payload->applied_sequence_);
+      return;
+    }
+
+    FinalizeCompiles(payload, payload->max_concurrent_compiles_ - 1);
 
-    // free resources
+    TRACE("compile in background [%s]", p.string().c_str());
+    payload->compile_jobs_.emplace_back(payload->compiler_, p, payload->compiler_memory_limit_,
+                                        payload->applied_sequence_);
+    ++payload->number_of_compile_jobs_;
+    payload->compile_jobs_.back().Run(payload->compile_finished_);
     payload->compiler_.reset();
+  }
 
-    // add/register new segment
+  /**
+   * Publish the segments of finished compilations in the order the compilations were started.
+   *
+   * A failed compilation gets dropped, its error is reported by the next flush or force merge.
+   *
+   * @param payload the payload
+   * @param max_pending wait for compilations until at most max_pending are left
+   */
+  static inline void FinalizeCompiles(IndexPayload* payload, const size_t max_pending) {
+    while (payload->compile_jobs_.size() > 0 &&
+           (payload->compile_jobs_.size() > max_pending || payload->compile_jobs_.front().Finished())) {
+      CompileJob& c = payload->compile_jobs_.front();
+      std::exception_ptr compile_error;
+      try {
+        c.Finalize();
+      } catch (...) {
+        compile_error = std::current_exception();
+      }
+
+      const boost::filesystem::path output_filename = c.GetOutputFilename();
+      const std::vector<std::string> deleted_keys = c.DeletedKeys();
+      const uint64_t sequence = c.GetSequence();
+
+      // remove the job before publishing, so an error can not leave it behind
+      payload->memory_budget_.Release(c.GetMemoryLimit());
+      payload->compile_jobs_.pop_front();
+      --payload->number_of_compile_jobs_;
+
+      if (compile_error) {
+        CompileFailed(payload, output_filename, compile_error);
+        continue;
+      }
+      AddSegment(payload, output_filename, deleted_keys, sequence);
+    }
+  }
+
+  /**
+   * Clean up after a failed compilation and keep the error to be reported by the next flush or force merge.
+   *
+   * @param payload the payload
+   * @param p the file name of the segment that failed to compile
+   * @param compile_error the error
+   */
+  static inline void CompileFailed(IndexPayload* payload, const boost::filesystem::path& p,
+                                   const std::exception_ptr& compile_error) {
+    TRACE("compile failed [%s]", p.string().c_str());
+
+    // remove what got written so far, ignoring errors, e.g. if the file could not be created in the first place
+    boost::system::error_code ec;
+    boost::filesystem::remove(p, ec);
+
+    payload->background_error_ = compile_error;
+  }
+
+  /**
+   * Run a task nobody waits for, an error is kept to be reported by the next flush or force merge.
+   */
+  template <typename TaskType>
+  static inline void KeepBackgroundError(IndexPayload* payload, TaskType task) {
+    try {
+      task();
+    } catch (...) {
+      TRACE("background task failed");
+      payload->background_error_ = std::current_exception();
+    }
+  }
+
+  /**
+   * Rethrow and reset the error of a task nobody waited for, e.g. a failed background compilation.
+   */
+  static inline void RethrowBackgroundError(IndexPayload* payload) {
+    if (!payload->background_error_) {
+      return;
+    }
+
+    std::exception_ptr background_error;
+    std::swap(background_error, payload->background_error_);
+    std::rethrow_exception(background_error);
+  }
+
+  /**
+   * Add/register a new segment.
+   *
+   * @param payload the payload
+   * @param p the file name of the new segment
+   * @param deleted_keys keys deleted while the segment got compiled
+   * @param sequence the sequence number of the last write in the segment
+   */
+  static inline void AddSegment(IndexPayload* payload, const boost::filesystem::path& p,
+                                const std::vector<std::string>& deleted_keys, const uint64_t sequence) {
     // we have to copy the segments (shallow copy/list of shared pointers to segments)
     // and then swap it
-    segment_t new_segment(new Segment(p, true));
+    segment_t new_segment(new Segment(p, true, payload->memory_budget_.MaxJobMemoryLimit()));
+    for (const std::string& key : deleted_keys) {
+      new_segment->DeleteKey(key);
+    }
+    payload->any_delete_ = payload->any_delete_ || deleted_keys.size() > 0;
+
     segments_t new_segments = std::make_shared<segment_vec_t>(*payload->segments_);
     new_segments->push_back(new_segment);
 
@@ -483,6 +990,10 @@ class IndexWriterWorker final {
 
     // reset as segments have been changed
     payload->segments_weak_.reset();
+
+    // the writes are readable from the segment now, deletes only once persisted
+    PurgeMemTable(payload, sequence);
+    NotifySegmentWatermarks(payload);
   }
 
   static void WriteToc(const IndexPayload* payload) {
@@ -0,0 +1,225 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * mem_table.h
+ *
+ * In-memory table of writes that are not yet visible in a segment.
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_MEM_TABLE_H_
+#define KEYVI_INDEX_INTERNAL_MEM_TABLE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>         // NOLINT
+#include <shared_mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "keyvi/dictionary/match.h"
+#include "keyvi/util/json_value.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+/**
+ * Sorted table of pending writes and deletes, readable concurrently while the writer adds to it.
+ *
+ * Every write carries a sequence number, once the segment holding all writes up to a sequence number is published,
+ * the writer purges them. A newer write of the same key replaces the entry, so a purge never drops it too early.
+ *
+ * Writes are remembered in the order of their sequence numbers, so a purge only visits the purged entries.
+ */
+class MemTable final {
+ public:
+  struct Entry {
+    std::string value;
+    uint64_t sequence = 0;
+    bool deleted = false;
+  };
+
+  using entry_t = std::pair<std::string, Entry>;
+  using snapshot_t = std::shared_ptr<const std::vector<entry_t>>;
+
+  MemTable() : size_(0) {}
+
+  MemTable& operator=(MemTable const&) = delete;
+  MemTable(const MemTable& that) = delete;
+
+  void Put(const std::string& key, const std::string& value, const uint64_t sequence) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    PutLocked(key, value, sequence, false);
+  }
+
+  /**
+   * Add a batch of key values with the same sequence number, taking the lock only once.
+   */
+  template <typename ContainerType>
+  void PutMany(const ContainerType& key_values, const uint64_t sequence) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& key_value : key_values) {
+      PutLocked(key_value.first, key_value.second, sequence, false);
+    }
+  }
+
+  void Delete(const std::string& key, const uint64_t sequence) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    PutLocked(key, std::string(), sequence, true);
+  }
+
+  /**
+   * Remove all entries with a sequence number up to the given one.
+   */
+  void Purge(const uint64_t sequence) {
+    if (size_ == 0) {
+      return;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    while (!writes_.empty() && writes_.front().first <= sequence) {
+      // skip writes that got replaced by a newer write of the same key, the newer write comes later
+      if (writes_.front().second->second.sequence == writes_.front().first) {
+        entries_.erase(writes_.front().second);
+      }
+      writes_.pop_front();
+    }
+    if (size_ != entries_.size()) {
+      snapshot_.reset();
+    }
+    size_ = entries_.size();
+    TRACE("purged mem table up to %ld, entries left: %ld", sequence, entries_.size());
+  }
+
+  bool Empty() const { return size_ == 0; }
+
+  size_t Size() const { return size_; }
+
+  /**
+   * Lookup a key.
+   *
+   * @param key the key
+   * @param deleted set to true if the key got deleted
+   * @param value if given, set to the value of the key
+   * @return true if the table has an entry for the key
+   */
+  bool Get(const std::string& key, bool* deleted, std::string* value = nullptr) const {
+    if (size_ == 0) {
+      return false;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+      return false;
+    }
+
+    *deleted = it->second.deleted;
+    if (value) {
+      *value = it->second.value;
+    }
+    return true;
+  }
+
+  /**
+   * Get a copy of all entries starting with the given prefix, including deletes, ordered by key.
+   */
+  std::vector<entry_t> GetRange(const std::string& prefix = std::string()) const {
+    std::vector<entry_t> entries;
+    if (size_ == 0) {
+      return entries;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (auto it = entries_.lower_bound(prefix); it != entries_.end(); ++it) {
+      if (it->first.compare(0, prefix.size(), prefix) != 0) {
+        break;
+      }
+      entries.emplace_back(*it);
+    }
+    return entries;
+  }
+
+  /**
+   * Get all entries, including deletes, ordered by key.
+   *
+   * The snapshot is shared by all callers until the next write, so full scans do not copy the table over and over.
+   *
+   * @return the entries, empty if the table is empty
+   */
+  snapshot_t GetSnapshot() const {
+    if (size_ == 0) {
+      return snapshot_t();
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::unique_lock<std::mutex> snapshot_lock(snapshot_mutex_);
+    if (!snapshot_) {
+      snapshot_ = std::make_shared<const std::vector<entry_t>>(entries_.begin(), entries_.end());
+    }
+    return snapshot_;
+  }
+
+  /**
+   * Create a match for a key and its json value, the value is encoded the same way as in a segment.
+   */
+  static dictionary::match_t CreateMatch(const std::string& key, const std::string& value, const double score = 0) {
+    dictionary::match_t match = std::make_shared<dictionary::Match>(0, key.size(), key);
+    match->SetScore(score);
+    match->SetRawValue(keyvi::util::EncodeJsonValue(value));
+    return match;
+  }
+
+ private:
+  mutable std::shared_mutex mutex_;
+  std::map<std::string, Entry> entries_;
+  std::deque<std::pair<uint64_t, std::map<std::string, Entry>::iterator>> writes_;
+  std::atomic_size_t size_;
+  //! guards creating the snapshot under the shared lock, writers reset it under the exclusive lock
+  mutable std::mutex snapshot_mutex_;
+  mutable snapshot_t snapshot_;
+
+  void PutLocked(const std::string& key, const std::string& value, const uint64_t sequence, const bool deleted) {
+    auto result = entries_.try_emplace(key);
+    Entry& entry = result.first->second;
+
+    // a key written twice with the same sequence number must only be remembered once
+    if (result.second || entry.sequence != sequence) {
+      writes_.emplace_back(sequence, result.first);
+    }
+    entry.value = value;
+    entry.sequence = sequence;
+    entry.deleted = deleted;
+    size_ = entries_.size();
+    snapshot_.reset();
+  }
+};
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_MEM_TABLE_H_
@@ -0,0 +1,108 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * memory_budget.h
+ *
+ * Memory budget of an index, shared by the compilers and merges.
+ */
+
+#ifndef KEYVI_INDEX_INTERNAL_MEMORY_BUDGET_H_
+#define KEYVI_INDEX_INTERNAL_MEMORY_BUDGET_H_
+
+#include <algorithm>
+#include <cstddef>
+
+#include "keyvi/dictionary/fsa/internal/key_filter.h"
+#include "keyvi/index/constants.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+/**
+ * Hands out memory limits to compilers and merges, sized by the number of keys they process.
+ *
+ * A single job gets at most half of the budget, so a big merge does not starve everything else, but at least
+ * MIN_JOB_MEMORY_LIMIT. Every segment gets a key filter, its size is added to the limit of the job on top, the
+ * generator takes it out again. Not thread-safe, only used from the writer thread.
+ */
+class MemoryBudget final {
+ public:
+  explicit MemoryBudget(const size_t budget) : budget_(budget), used_(0) {}
+
+  size_t GetBudget() const { return budget_; }
+
+  size_t Used() const { return used_; }
+
+  size_t Available() const { return used_ < budget_ ? budget_ - used_ : 0; }
+
+  /**
+   * The highest memory limit a single job can get.
+   */
+  size_t MaxJobMemoryLimit() const { return std::max(MIN_JOB_MEMORY_LIMIT, budget_ / 2); }
+
+  /**
+   * Whether a new job would get at least the minimum memory and its key filter without exceeding the budget.
+   *
+   * @param number_of_keys the number of keys the job processes
+   */
+  bool CanAcquire(const size_t number_of_keys = 0) const {
+    return Available() >= MIN_JOB_MEMORY_LIMIT + KeyFilterMemory(number_of_keys);
+  }
+
+  /**
+   * Acquire memory for a job, the caller must release it once the job is done.
+   *
+   * @param number_of_keys the number of keys the job processes
+   * @return the memory limit for the job including the key filter, might exceed what is available if less than the
+   * minimum is left
+   */
+  size_t Acquire(const size_t number_of_keys) {
+    const size_t key_filter_memory = KeyFilterMemory(number_of_keys);
+    const size_t available = Available() > key_filter_memory ? Available() - key_filter_memory : 0;
+    const size_t memory =
+        std::max(MIN_JOB_MEMORY_LIMIT, std::min({number_of_keys * JOB_MEMORY_PER_KEY, budget_ / 2, available})) +
+        key_filter_memory;
+    used_ += memory;
+    TRACE("acquired %ld bytes for %ld keys, used: %ld", memory, number_of_keys, used_);
+    return memory;
+  }
+
+  void Release(const size_t memory) {
+    used_ -= std::min(memory, used_);
+    TRACE("released %ld bytes, used: %ld", memory, used_);
+  }
+
+ private:
+  const size_t budget_;
+  size_t used_;
+
+  static size_t KeyFilterMemory(const size_t number_of_keys) {
+    return dictionary::fsa::internal::KeyFilter::GetSize(number_of_keys);
+  }
+};
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
+
+#endif  // KEYVI_INDEX_INTERNAL_MEMORY_BUDGET_H_
@@ -18,6 +18,7 @@
 #ifndef KEYVI_INDEX_INTERNAL_MERGE_JOB_H_
 #define KEYVI_INDEX_INTERNAL_MERGE_JOB_H_
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>  //NOLINT
 #include <functional>
@@ -32,8 +33,11 @@
 #include "keyvi/dictionary/dictionary_types.h"
 #include "keyvi/dictionary/fsa/internal/json_value_store.h"
 #include "keyvi/dictionary/fsa/internal/sparse_array_persistence.h"
+#include "keyvi/index/constants.h"
 #include "keyvi/index/internal/index_settings.h"
 #include "keyvi/index/internal/segment.h"
+#include "keyvi/util/os_utils.h"
+#include "keyvi/util/rate_limiter.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -45,8 +49,15 @@ namespace internal {
 class MergeJob final {
   struct MergeJobPayload {
     explicit MergeJobPayload(std::vector<segment_t> segments, const boost::filesystem::path& output_filename,
-                             const IndexSettings& settings)
-        : segments_(segments), output_filename_(output_filename), settings_(settings), process_finished_(false) {}
+                             const IndexSettings& settings, const size_t memory_limit,
+                             const std::shared_ptr<util::RateLimiter>& rate_limiter)
+        : segments_(segments),
+          output_filename_(output_filename),
+          settings_(settings),
+          memory_limit_(memory_limit),
+          rate_limiter_(rate_limiter),
+          internal_merge_finished_(false),
+          process_finished_(false) {}
 
     MergeJobPayload() = delete;
     MergeJobPayload& operator=(MergeJobPayload const&) = delete;
@@ -55,18 +66,22 @@ class MergeJob final {
     std::vector<segment_t> segments_;
     boost::filesystem::path output_filename_;
     const IndexSettings& settings_;
+    const size_t memory_limit_;
+    std::shared_ptr<util::RateLimiter> rate_limiter_;
     std::chrono::time_point<std::chrono::system_clock> start_time_;
     std::chrono::time_point<std::chrono::system_clock> end_time_;
     int exit_code_ = -1;
     bool merge_done = false;
+    std::atomic_bool internal_merge_finished_;
     std::atomic_bool process_finished_;
   };
 
  public:
   // todo: add ability to stop merging for shutdown
   explicit MergeJob(segment_vec_t segments, size_t id, const boost::filesystem::path& output_filename,
-                    const IndexSettings& settings)
-      : payload_(segments, output_filename, settings), id_(id), external_process_() {}
+                    const IndexSettings& settings, const size_t memory_limit = MIN_JOB_MEMORY_LIMIT,
+                    const std::shared_ptr<util::RateLimiter>& rate_limiter = std::shared_ptr<util::RateLimiter>())
+      : payload_(segments, output_filename, settings, memory_limit, rate_limiter), id_(id), external_process_() {}
 
   ~MergeJob() {
     if (payload_.process_finished_ == false) {
@@ -78,7 +93,16 @@ class MergeJob final {
   MergeJob& operator=(MergeJob const&) = delete;
   MergeJob(const MergeJob& that) = delete;
 
-  void Run(boost::asio::io_context* external_process_ctx, bool force_external_merge = false) {
+  /**
+   * Start the merge.
+   *
+   * @param external_process_ctx the context for external merge processes
+   * @param force_external_merge whether to merge in an external process regardless of the size
+   * @param merge_finished callback invoked from the merge thread once an internal merge is done, external merges
+   * have to be polled with TryFinalize
+   */
+  void Run(boost::asio::io_context* external_process_ctx, bool force_external_merge = false,
+           const std::function<void()>& merge_finished = std::function<void()>()) {
     uint64_t job_size = 0;
 
     for (const segment_t& segment : payload_.segments_) {
@@ -86,7 +110,7 @@ class MergeJob final {
     }
 
     if (force_external_merge == false && job_size < payload_.settings_.GetSegmentExternalMergeKeyThreshold()) {
-      DoInternalMerge();
+      DoInternalMerge(merge_finished);
     } else {
       DoExternalProcessMerge(external_process_ctx);
     }
@@ -114,7 +138,7 @@ class MergeJob final {
   const std::vector<segment_t>& Segments() const { return payload_.segments_; }
 
   const segment_t MergedSegment() const {
-    return segment_t(new Segment(payload_.output_filename_, payload_.segments_));
+    return segment_t(new Segment(payload_.output_filename_, payload_.segments_, payload_.memory_limit_));
   }
 
   void SetMerged() { payload_.merge_done = true; }
@@ -123,6 +147,8 @@ class MergeJob final {
 
   size_t GetId() const { return id_; }
 
+  size_t GetMemoryLimit() const { return payload_.memory_limit_; }
+
   // todo: ability to kill job/process
 
  private:
@@ -131,16 +157,21 @@ class MergeJob final {
   std::shared_ptr<boost::process::v2::process> external_process_;
   std::thread internal_merge_;
 
-  void DoInternalMerge() {
+  void DoInternalMerge(const std::function<void()>& merge_finished) {
     payload_.start_time_ = std::chrono::system_clock::now();
 
-    internal_merge_ = std::thread([this]() {
+    internal_merge_ = std::thread([this, merge_finished]() {
+      keyvi::util::OsUtils::LowerThreadPriority(static_cast<int>(payload_.settings_.GetMergeNice()));
+
       try {
         keyvi::util::parameters_t params;
 
-        // todo: make this configurable
-        params[MEMORY_LIMIT_KEY] = "5242880";
+        params[MEMORY_LIMIT_KEY] = std::to_string(payload_.memory_limit_);
+        params[KEY_FILTER_KEY] = "true";
         keyvi::dictionary::JsonDictionaryMerger jsonDictionaryMerger(params);
+        if (payload_.rate_limiter_) {
+          jsonDictionaryMerger.SetRateLimiter(payload_.rate_limiter_);
+        }
         for (const segment_t& s : payload_.segments_) {
           jsonDictionaryMerger.Add(s->GetDictionaryPath().string());
         }
@@ -151,6 +182,11 @@ class MergeJob final {
         TRACE("internal merge failed with: %s", e.what());
         payload_.exit_code_ = 1;
       }
+
+      payload_.internal_merge_finished_ = true;
+      if (merge_finished) {
+        merge_finished();
+      }
     });
   }
 
@@ -159,7 +195,23 @@ class MergeJob final {
 
     std::vector<std::string> args;
     args.push_back("-m");
-    args.push_back("5242880");
+    args.push_back(std::to_string(payload_.memory_limit_));
+    args.push_back("-p");
+    args.push_back(std::string(KEY_FILTER_KEY) + "=true");
+
+    // an external process can not share the rate limiter, it gets an equal share of the current rate and keeps it,
+    // lifting or changing the rate later does not reach it
+    if (payload_.rate_limiter_ && payload_.rate_limiter_->GetRate() > 0) {
+      const size_t share = std::max(size_t(1), payload_.rate_limiter_->GetRate() /
+                                                   std::max(size_t(1), payload_.settings_.GetMaxConcurrentMerges()));
+      args.push_back("-p");
+      args.push_back(std::string(MERGE_RATE_LIMIT_KEY) + "=" + std::to_string(share));
+    }
+
+    if (payload_.settings_.GetMergeNice() > 0) {
+      args.push_back("-n");
+      args.push_back(std::to_string(payload_.settings_.GetMergeNice()));
+    }
 
     for (auto s : payload_.segments_) {
       args.push_back("-i");
@@ -182,7 +234,8 @@ class MergeJob final {
         external_process_.reset();
         return true;
       }
-    } else if (internal_merge_.joinable()) {
+    } else if (internal_merge_.joinable() && payload_.internal_merge_finished_) {
+      // only join a finished merge, the caller must not block
       internal_merge_.join();
       // exit code set by merge thread
       payload_.process_finished_ = true;
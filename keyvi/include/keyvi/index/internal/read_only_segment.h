@@ -25,20 +25,20 @@
 #ifndef KEYVI_INDEX_INTERNAL_READ_ONLY_SEGMENT_H_
 #define KEYVI_INDEX_INTERNAL_READ_ONLY_SEGMENT_H_
 
+#include <sys/stat.h>
+
 #include <cstdio>
 #include <ctime>
 #include <memory>
 #include <mutex>  //NOLINT
 #include <set>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
 #include <boost/filesystem.hpp>
 
-#include <msgpack.hpp>
-
 #include "keyvi/dictionary/dictionary.h"
+#include "keyvi/index/internal/deleted_key_set.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -49,7 +49,7 @@ namespace internal {
 
 class ReadOnlySegment {
  public:
-  using deleted_t = std::unordered_set<std::string>;
+  using deleted_t = DeletedKeySet;
   using deleted_ptr_t = std::shared_ptr<deleted_t>;
 
   explicit ReadOnlySegment(const boost::filesystem::path& path)
@@ -58,14 +58,16 @@ class ReadOnlySegment {
             dictionary::DictionaryProperties::FromFile(path.string()))),
         deleted_keys_path_(path),
         deleted_keys_during_merge_path_(path),
+        deleted_keys_log_path_(path),
+        deleted_keys_during_merge_log_path_(path),
         dictionary_filename_(path.filename().string()),
         dictionary_(),
         has_deleted_keys_(false),
-        deleted_keys_(),
-        last_modification_time_deleted_keys_(0),
-        last_modification_time_deleted_keys_during_merge_(0) {
+        deleted_keys_() {
     deleted_keys_path_ += ".dk";
     deleted_keys_during_merge_path_ += ".dkm";
+    deleted_keys_log_path_ += ".dk-log";
+    deleted_keys_during_merge_log_path_ += ".dkm-log";
 
     LoadDictionary();
     LoadDeletedKeys();
@@ -79,6 +81,9 @@ class ReadOnlySegment {
 
   bool HasDeletedKeys() { return has_deleted_keys_; }
 
+  /**
+   * The number of deleted keys, expensive as it visits all of them.
+   */
   size_t DeletedKeysSize() const {
     if (has_deleted_keys_) {
       return deleted_keys_->size();
@@ -116,6 +121,12 @@ class ReadOnlySegment {
 
   const boost::filesystem::path& GetDeletedKeysDuringMergePath() const { return deleted_keys_during_merge_path_; }
 
+  const boost::filesystem::path& GetDeletedKeysLogPath() const { return deleted_keys_log_path_; }
+
+  const boost::filesystem::path& GetDeletedKeysDuringMergeLogPath() const {
+    return deleted_keys_during_merge_log_path_;
+  }
+
   const std::string& GetDictionaryFilename() const { return dictionary_filename_; }
 
  protected:
@@ -125,14 +136,16 @@ class ReadOnlySegment {
             dictionary::DictionaryProperties::FromFile(path.string()))),
         deleted_keys_path_(path),
         deleted_keys_during_merge_path_(path),
+        deleted_keys_log_path_(path),
+        deleted_keys_during_merge_log_path_(path),
         dictionary_filename_(path.filename().string()),
         dictionary_(),
         has_deleted_keys_(false),
-        deleted_keys_(),
-        last_modification_time_deleted_keys_(0),
-        last_modification_time_deleted_keys_during_merge_(0) {
+        deleted_keys_() {
     deleted_keys_path_ += ".dk";
     deleted_keys_during_merge_path_ += ".dkm";
+    deleted_keys_log_path_ += ".dk-log";
+    deleted_keys_during_merge_log_path_ += ".dkm-log";
 
     if (load_dictionary) {
       LoadDictionary();
@@ -149,14 +162,16 @@ class ReadOnlySegment {
         dictionary_properties_(dictionary_properties),
         deleted_keys_path_(dictionary_path_),
         deleted_keys_during_merge_path_(dictionary_path_),
+        deleted_keys_log_path_(dictionary_path_),
+        deleted_keys_during_merge_log_path_(dictionary_path_),
         dictionary_filename_(dictionary_path_.filename().string()),
         dictionary_(),
         has_deleted_keys_(false),
-        deleted_keys_(),
-        last_modification_time_deleted_keys_(0),
-        last_modification_time_deleted_keys_during_merge_(0) {
+        deleted_keys_() {
     deleted_keys_path_ += ".dk";
     deleted_keys_during_merge_path_ += ".dkm";
+    deleted_keys_log_path_ += ".dk-log";
+    deleted_keys_during_merge_log_path_ += ".dkm-log";
 
     if (load_dictionary) {
       LoadDictionary();
@@ -172,47 +187,78 @@ class ReadOnlySegment {
     dictionary_.reset(new dictionary::Dictionary(dictionary_path_.string()));
   }
 
+  /**
+   * Load the deleted keys if any of the deleted keys files changed.
+   *
+   * If only the logs grew, the new records get added as a new layer to a copy of the current deleted keys, which
+   * shares the compacted files and the keys loaded before. Otherwise, e.g. after a compaction, everything gets
+   * reloaded.
+   */
   void LoadDeletedKeys() {
     TRACE("load deleted keys");
 
-    boost::system::error_code ec;
-    std::time_t last_write_dk = boost::filesystem::last_write_time(deleted_keys_path_, ec);
-    // effectively ignore if file does not exist
-    if (ec) {
-      last_write_dk = last_modification_time_deleted_keys_;
+    const FileState dk = GetFileState(deleted_keys_path_);
+    const FileState dkm = GetFileState(deleted_keys_during_merge_path_);
+    const FileState dk_log = GetFileState(deleted_keys_log_path_);
+    const FileState dkm_log = GetFileState(deleted_keys_during_merge_log_path_);
+
+    // effectively ignore if no file exists
+    if (!dk.Exists() && !dkm.Exists() && !dk_log.Exists() && !dkm_log.Exists()) {
+      return;
     }
 
-    std::time_t last_write_dkm = boost::filesystem::last_write_time(deleted_keys_during_merge_path_, ec);
-    // effectively ignore if file does not exist
-    if (ec) {
-      last_write_dkm = last_modification_time_deleted_keys_during_merge_;
+    bool full_reload = !deleted_keys_ || dk != deleted_keys_state_ ||
+                       dkm != deleted_keys_during_merge_state_ || dk_log.inode != deleted_keys_log_state_.inode ||
+                       dkm_log.inode != deleted_keys_during_merge_log_state_.inode ||
+                       dk_log.size < deleted_keys_log_offset_ || dkm_log.size < deleted_keys_during_merge_log_offset_;
+
+    if (!full_reload && dk_log.size == deleted_keys_log_offset_ &&
+        dkm_log.size == deleted_keys_during_merge_log_offset_) {
+      return;
     }
 
-    // if any list has changed, reload it
-    if (last_write_dk > last_modification_time_deleted_keys_ ||
-        last_write_dkm > last_modification_time_deleted_keys_during_merge_) {
-      TRACE("found deleted keys");
+    deleted_ptr_t deleted_keys;
+    size_t dk_log_offset = 0;
+    size_t dkm_log_offset = 0;
 
-      deleted_ptr_t deleted_keys = std::make_shared<deleted_t>();
-      deleted_t deleted_keys_dk = LoadAndUnserializeDeletedKeys(deleted_keys_path_.string());
-      TRACE("Loaded deleted keys: %d", deleted_keys_dk.size());
+    if (!full_reload) {
+      TRACE("apply deleted keys log");
+      deleted_keys = std::make_shared<deleted_t>(*deleted_keys_);
+      dk_log_offset = deleted_keys->LoadLog(deleted_keys_log_path_.string(), deleted_keys_log_offset_);
+      dkm_log_offset =
+          deleted_keys->LoadLog(deleted_keys_during_merge_log_path_.string(), deleted_keys_during_merge_log_offset_);
 
-      deleted_keys->swap(deleted_keys_dk);
-      // deleted_keys->insert(deleted_keys_dk.begin(), deleted_keys_dk.end());
-      deleted_t deleted_keys_dkm = LoadAndUnserializeDeletedKeys(deleted_keys_during_merge_path_.string());
-      TRACE("Loaded deleted keys m: %d", deleted_keys_dkm.size());
+      // a log replaced while reading, the offsets were meaningless
+      full_reload = GetFileState(deleted_keys_log_path_).inode != dk_log.inode ||
+                    GetFileState(deleted_keys_during_merge_log_path_).inode != dkm_log.inode;
+    }
 
-      deleted_keys->insert(deleted_keys_dkm.begin(), deleted_keys_dkm.end());
+    if (full_reload) {
+      TRACE("reload deleted keys");
+      // read the logs before the compacted files, a compaction in between writes the log into the compacted file
+      deleted_keys = std::make_shared<deleted_t>();
+      dk_log_offset = deleted_keys->LoadLog(deleted_keys_log_path_.string(), 0);
+      dkm_log_offset = deleted_keys->LoadLog(deleted_keys_during_merge_log_path_.string(), 0);
+      deleted_keys->Load(deleted_keys_path_.string());
+      deleted_keys->Load(deleted_keys_during_merge_path_.string());
+    }
 
-      // safe swap
-      {
-        std::unique_lock<std::mutex> lock(mutex_);
-        deleted_keys_.swap(deleted_keys);
-      }
-      TRACE("Number of deleted keys: %d", deleted_keys_->size());
+    // remember the state before reading, a change during reading triggers a reload next time
+    deleted_keys_state_ = dk;
+    deleted_keys_during_merge_state_ = dkm;
+    deleted_keys_log_state_ = dk_log;
+    deleted_keys_during_merge_log_state_ = dkm_log;
+    deleted_keys_log_offset_ = dk_log_offset;
+    deleted_keys_during_merge_log_offset_ = dkm_log_offset;
 
-      has_deleted_keys_ = true;
+    // safe swap
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      deleted_keys_.swap(deleted_keys);
     }
+    TRACE("deleted keys loaded, empty: %d", deleted_keys_->empty());
+
+    has_deleted_keys_ = true;
   }
 
   const deleted_t& DeletedKeysDirect() const { return *deleted_keys_; }
@@ -230,6 +276,12 @@ class ReadOnlySegment {
   //! deleted keys while segment gets merged with other segments
   boost::filesystem::path deleted_keys_during_merge_path_;
 
+  //! deletes since the last compaction of the list of deleted keys
+  boost::filesystem::path deleted_keys_log_path_;
+
+  //! deletes since the last compaction of the list of deleted keys during merge
+  boost::filesystem::path deleted_keys_during_merge_log_path_;
+
   //! just the filename part of the dictionary
   std::string dictionary_filename_;
 
@@ -248,28 +300,39 @@ class ReadOnlySegment {
   //! a mutex to secure access to the deleted keys shared pointer
   std::mutex mutex_;
 
-  //! last modification time for the deleted keys file
-  std::time_t last_modification_time_deleted_keys_;
-
-  //! last modification time for the deleted keys file during a merge operation
-  std::time_t last_modification_time_deleted_keys_during_merge_;
-
-  inline static deleted_t LoadAndUnserializeDeletedKeys(const std::string& filename) {
-    TRACE("loading deleted keys file %s", filename.c_str());
-
-    deleted_t deleted_keys;
-    std::ifstream deleted_keys_stream(filename, std::ios::binary);
-    if (deleted_keys_stream.good()) {
-      std::string buffer;
-      deleted_keys_stream.seekg(0, std::ios::end);
-      buffer.resize(deleted_keys_stream.tellg());
-      deleted_keys_stream.seekg(0, std::ios::beg);
-      deleted_keys_stream.read(&buffer[0], buffer.size());
-      msgpack::unpacked unpacked_object;
-      msgpack::unpack(unpacked_object, buffer.data(), buffer.size());
-      unpacked_object.get().convert(deleted_keys);
+  struct FileState {
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    std::time_t modification_time = 0;
+
+    bool Exists() const { return inode != 0; }
+
+    bool operator!=(const FileState& other) const {
+      return inode != other.inode || size != other.size || modification_time != other.modification_time;
     }
-    return deleted_keys;
+  };
+
+  //! state of the deleted keys files when they were loaded
+  FileState deleted_keys_state_;
+  FileState deleted_keys_during_merge_state_;
+  FileState deleted_keys_log_state_;
+  FileState deleted_keys_during_merge_log_state_;
+
+  //! read position in the logs
+  size_t deleted_keys_log_offset_ = 0;
+  size_t deleted_keys_during_merge_log_offset_ = 0;
+
+  static FileState GetFileState(const boost::filesystem::path& path) {
+    FileState state;
+    struct stat file_stat;
+
+    // effectively ignore if file does not exist
+    if (stat(path.string().c_str(), &file_stat) == 0) {
+      state.inode = file_stat.st_ino;
+      state.size = file_stat.st_size;
+      state.modification_time = file_stat.st_mtime;
+    }
+    return state;
   }
 };
 
@@ -18,6 +18,7 @@
 #ifndef KEYVI_INDEX_INTERNAL_SEGMENT_H_
 #define KEYVI_INDEX_INTERNAL_SEGMENT_H_
 
+#include <algorithm>
 #include <cstdio>
 #include <memory>
 #include <mutex>  //NOLINT
@@ -28,9 +29,9 @@
 
 #include <boost/filesystem.hpp>
 
-#include <msgpack.hpp>
-
 #include "keyvi/dictionary/dictionary.h"
+#include "keyvi/index/constants.h"
+#include "keyvi/index/internal/deleted_key_set.h"
 #include "keyvi/index/internal/read_only_segment.h"
 
 // #define ENABLE_TRACING
@@ -42,12 +43,23 @@ namespace internal {
 namespace unit_test {
 class SegmentFriend;
 }
+
+//! minimum number of keys in the log of deleted keys before it gets compacted
+static const size_t DELETED_KEYS_LOG_MIN_COMPACTION = 1000;
+
 class Segment final : public ReadOnlySegment {
  public:
   using deleted_t = ReadOnlySegment::deleted_t;
   using deleted_ptr_t = ReadOnlySegment::deleted_ptr_t;
-
-  explicit Segment(const boost::filesystem::path& path, bool no_deletes = false)
+  using deleted_for_write_t = std::unordered_set<std::string>;
+
+  /**
+   * @param path the segment file
+   * @param no_deletes whether the segment is new, without any deleted keys
+   * @param deleted_keys_memory_limit upper memory limit for compacting the deleted keys
+   */
+  explicit Segment(const boost::filesystem::path& path, bool no_deletes = false,
+                   const size_t deleted_keys_memory_limit = MIN_JOB_MEMORY_LIMIT)
       : ReadOnlySegment(path, false, !no_deletes),
         deleted_keys_for_write_(),
         deleted_keys_during_merge_for_write_(),
@@ -55,11 +67,13 @@ class Segment final : public ReadOnlySegment {
         deletes_loaded(no_deletes),
         in_merge_(false),
         new_delete_(false),
-        deleted_keys_swap_filename_(path) {
+        deleted_keys_swap_filename_(path),
+        deleted_keys_memory_limit_(deleted_keys_memory_limit) {
     deleted_keys_swap_filename_ += ".dk-swap";
   }
 
-  explicit Segment(const boost::filesystem::path& path, const std::vector<std::shared_ptr<Segment>>& parent_segments)
+  explicit Segment(const boost::filesystem::path& path, const std::vector<std::shared_ptr<Segment>>& parent_segments,
+                   const size_t deleted_keys_memory_limit = MIN_JOB_MEMORY_LIMIT)
       : ReadOnlySegment(path, false, false),
         deleted_keys_for_write_(),
         deleted_keys_during_merge_for_write_(),
@@ -68,7 +82,8 @@ class Segment final : public ReadOnlySegment {
         deletes_loaded(true),
         in_merge_(false),
         new_delete_(false),
-        deleted_keys_swap_filename_(path) {
+        deleted_keys_swap_filename_(path),
+        deleted_keys_memory_limit_(deleted_keys_memory_limit) {
     deleted_keys_swap_filename_ += ".dk-swap";
 
     // move deletions that happened during merge into the list of deleted keys
@@ -79,8 +94,7 @@ class Segment final : public ReadOnlySegment {
 
     // persist the current list of deleted keys
     if (deleted_keys_for_write_.size()) {
-      new_delete_ = true;
-      Persist();
+      CompactDeletedKeys(GetDeletedKeysPath(), GetDeletedKeysLogPath(), deleted_keys_for_write_);
     }
   }
 
@@ -115,7 +129,13 @@ class Segment final : public ReadOnlySegment {
   }
 
   void ElectedForMerge() {
-    Persist();
+    // the merger only reads the compacted list of deleted keys
+    LazyLoadDeletedKeys();
+    if (new_delete_ || boost::filesystem::exists(GetDeletedKeysLogPath())) {
+      CompactDeletedKeys(GetDeletedKeysPath(), GetDeletedKeysLogPath(), deleted_keys_for_write_);
+      // the deletes are persisted now, make them readable as persisting them later is a no-op
+      ReloadDeletedKeys();
+    }
     in_merge_ = true;
   }
 
@@ -125,11 +145,11 @@ class Segment final : public ReadOnlySegment {
       deleted_keys_for_write_.insert(deleted_keys_during_merge_for_write_.begin(),
                                      deleted_keys_during_merge_for_write_.end());
 
-      new_delete_ = true;
-      Persist();
+      CompactDeletedKeys(GetDeletedKeysPath(), GetDeletedKeysLogPath(), deleted_keys_for_write_);
       deleted_keys_during_merge_for_write_.clear();
-      // remove dkm file
+      // remove dkm files
       std::remove(GetDeletedKeysDuringMergePath().string().c_str());
+      std::remove(GetDeletedKeysDuringMergeLogPath().string().c_str());
     }
   }
 
@@ -144,7 +164,9 @@ class Segment final : public ReadOnlySegment {
     // delete files, not all files might exist, therefore ignore the output
     std::remove(GetDictionaryPath().string().c_str());
     std::remove(GetDeletedKeysDuringMergePath().string().c_str());
+    std::remove(GetDeletedKeysDuringMergeLogPath().string().c_str());
     std::remove(GetDeletedKeysPath().string().c_str());
+    std::remove(GetDeletedKeysLogPath().string().c_str());
   }
 
   void DeleteKey(const std::string& key) {
@@ -155,43 +177,58 @@ class Segment final : public ReadOnlySegment {
     // load deleted keys as well
     LazyLoadDeletedKeys();
 
+    bool inserted;
     if (in_merge_) {
       TRACE("delete key (in merge) %s", key.c_str());
-      deleted_keys_during_merge_for_write_.insert(key);
+      inserted = deleted_keys_during_merge_for_write_.insert(key).second;
     } else {
       TRACE("delete key (no merge) %s", key.c_str());
-      deleted_keys_for_write_.insert(key);
+      inserted = deleted_keys_for_write_.insert(key).second;
+    }
+
+    if (inserted) {
+      deleted_keys_log_.push_back(key);
+      new_delete_ = true;
     }
-    new_delete_ = true;
   }
 
-  // persist deleted keys
+  /**
+   * Persist deleted keys by appending the new deletes to the log. Once the log holds about as many keys as the
+   * compacted file, both get compacted into a new file, so the cost of writing stays proportional to the deletes.
+   */
   bool Persist() {
     if (!new_delete_) {
       return false;
     }
     TRACE("persist deleted keys");
-    boost::filesystem::path deleted_keys_file = GetDictionaryPath();
 
     // its ensured that before merge persist is called, so we have to persist only one or the other file
     if (in_merge_) {
-      SaveDeletedKeys(GetDeletedKeysDuringMergePath().string(), deleted_keys_during_merge_for_write_);
+      PersistDeletedKeys(GetDeletedKeysDuringMergePath(), GetDeletedKeysDuringMergeLogPath(),
+                         deleted_keys_during_merge_for_write_);
     } else {
-      SaveDeletedKeys(GetDeletedKeysPath().string(), deleted_keys_for_write_);
+      PersistDeletedKeys(GetDeletedKeysPath(), GetDeletedKeysLogPath(), deleted_keys_for_write_);
     }
 
     return true;
   }
 
  private:
-  deleted_t deleted_keys_for_write_;
-  deleted_t deleted_keys_during_merge_for_write_;
+  deleted_for_write_t deleted_keys_for_write_;
+  deleted_for_write_t deleted_keys_during_merge_for_write_;
   std::mutex lazy_load_mutex_;
   bool dictionary_loaded;
   bool deletes_loaded;
   bool in_merge_;
   bool new_delete_;
   boost::filesystem::path deleted_keys_swap_filename_;
+  const size_t deleted_keys_memory_limit_;
+
+  //! deletes not persisted yet
+  std::vector<std::string> deleted_keys_log_;
+
+  //! number of keys in the log since the last compaction
+  size_t deleted_keys_in_log_ = 0;
 
   // friend for unit testing only
   friend class unit_test::SegmentFriend;
@@ -205,7 +242,8 @@ class Segment final : public ReadOnlySegment {
         deletes_loaded(no_deletes),
         in_merge_(false),
         new_delete_(false),
-        deleted_keys_swap_filename_(dictionary_properties->GetFileName()) {
+        deleted_keys_swap_filename_(dictionary_properties->GetFileName()),
+        deleted_keys_memory_limit_(MIN_JOB_MEMORY_LIMIT) {
     deleted_keys_swap_filename_ += ".dk-swap";
   }
 
@@ -229,24 +267,84 @@ class Segment final : public ReadOnlySegment {
 
         // get a copy of the deleted keys for writing
         if (ReadOnlySegment::HasDeletedKeys()) {
-          if (in_merge_) {
-            deleted_keys_during_merge_for_write_.insert(DeletedKeysDirect().begin(), DeletedKeysDirect().end());
-          } else {
-            deleted_keys_for_write_.insert(DeletedKeysDirect().begin(), DeletedKeysDirect().end());
-          }
+          deleted_for_write_t* deleted_keys =
+              in_merge_ ? &deleted_keys_during_merge_for_write_ : &deleted_keys_for_write_;
+          DeletedKeysDirect().ForEach([deleted_keys](const std::string& key) { deleted_keys->insert(key); });
         }
+        InitDeletedKeysLogs();
         deletes_loaded = true;
       }
     }
   }
 
-  void SaveDeletedKeys(const std::string& filename, const deleted_t& deleted_keys) {
-    // write to swap file, than rename it
-    {
-      std::ofstream out_stream(deleted_keys_swap_filename_.string(), std::ios::binary);
-      msgpack::pack(out_stream, deleted_keys);
+  /**
+   * Prepare appending to the logs of deleted keys, called once the deleted keys got loaded.
+   *
+   * Counts the keys already in the log, so after a restart compaction does not wait for another
+   * DELETED_KEYS_LOG_MIN_COMPACTION deletes. A log ending with a partial record, left from a crash while appending,
+   * gets compacted: records appended after a partial record are unreadable.
+   */
+  void InitDeletedKeysLogs() {
+    const deleted_for_write_t& deleted_keys = in_merge_ ? deleted_keys_during_merge_for_write_ : deleted_keys_for_write_;
+    bool compacted = false;
+
+    auto init_log = [this, &deleted_keys, &compacted](const boost::filesystem::path& filename,
+                                                      const boost::filesystem::path& log_filename) {
+      size_t number_of_records = 0;
+      if (DeletedKeySet::ScanLog(log_filename.string(), &number_of_records)) {
+        return number_of_records;
+      }
+
+      TRACE("partial record in deleted keys log %s", log_filename.string().c_str());
+      if (deleted_keys.empty()) {
+        std::remove(log_filename.string().c_str());
+      } else {
+        CompactDeletedKeys(filename, log_filename, deleted_keys);
+      }
+      compacted = true;
+      return size_t(0);
+    };
+
+    const size_t keys_in_merge_log = init_log(GetDeletedKeysDuringMergePath(), GetDeletedKeysDuringMergeLogPath());
+    const size_t keys_in_log = init_log(GetDeletedKeysPath(), GetDeletedKeysLogPath());
+    deleted_keys_in_log_ = in_merge_ ? keys_in_merge_log : keys_in_log;
+
+    if (compacted) {
+      LoadDeletedKeys();
     }
-    std::rename(deleted_keys_swap_filename_.string().c_str(), filename.c_str());
+  }
+
+  void PersistDeletedKeys(const boost::filesystem::path& filename, const boost::filesystem::path& log_filename,
+                          const deleted_for_write_t& deleted_keys) {
+    const size_t keys_in_log = deleted_keys_in_log_ + deleted_keys_log_.size();
+
+    if (keys_in_log >= DELETED_KEYS_LOG_MIN_COMPACTION && keys_in_log * 2 > deleted_keys.size()) {
+      CompactDeletedKeys(filename, log_filename, deleted_keys);
+      return;
+    }
+
+    DeletedKeySet::AppendToLog(log_filename.string(), deleted_keys_log_);
+    deleted_keys_in_log_ = keys_in_log;
+    deleted_keys_log_.clear();
+    new_delete_ = false;
+  }
+
+  void CompactDeletedKeys(const boost::filesystem::path& filename, const boost::filesystem::path& log_filename,
+                          const deleted_for_write_t& deleted_keys) {
+    TRACE("compact deleted keys");
+    // write to swap file, than rename it, readers keep the old file mapped
+    // size the compiler like any other job, but within the limit given by the index, plus the key filter
+    const size_t memory_limit =
+        std::min(deleted_keys_memory_limit_, std::max(MIN_JOB_MEMORY_LIMIT, deleted_keys.size() * JOB_MEMORY_PER_KEY)) +
+        dictionary::fsa::internal::KeyFilter::GetSize(deleted_keys.size());
+    DeletedKeySet::Write(deleted_keys_swap_filename_.string(), deleted_keys, memory_limit);
+    std::rename(deleted_keys_swap_filename_.string().c_str(), filename.string().c_str());
+
+    // the log must be removed after the rename, readers read the log first
+    std::remove(log_filename.string().c_str());
+    deleted_keys_in_log_ = 0;
+    deleted_keys_log_.clear();
+    new_delete_ = false;
   }
 };  // namespace internal
 
@@ -0,0 +1,296 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * bit_parallel_levenshtein.h
+ *
+ * Bit-parallel Damerau-Levenshtein distance (Myers 1999, transpositions by Hyyrö 2003).
+ */
+
+#ifndef KEYVI_STRINGDISTANCE_BIT_PARALLEL_LEVENSHTEIN_H_
+#define KEYVI_STRINGDISTANCE_BIT_PARALLEL_LEVENSHTEIN_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utf8.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace stringdistance {
+
+/**
+ * Drop-in replacement for NeedlemanWunsch with unit costs, e.g. costfunctions::Damerau_Levenshtein.
+ *
+ * Instead of filling the distance matrix cell by cell, a row is encoded as bit vectors of the vertical differences
+ * between neighboring cells, one bit per input codepoint, and calculated with a handful of word operations per 64
+ * codepoints of the input. Rows are kept, so Put can go back to an earlier position like NeedlemanWunsch.
+ *
+ * The cost function only selects the variant: a completion cost of 0 makes inserting characters after the end of the
+ * input free, all other costs are 1. Scores up to max_distance are the same as the ones of NeedlemanWunsch, greater
+ * scores are exact distances where NeedlemanWunsch cuts off.
+ */
+template <class CostFunctionT>
+class BitParallelLevenshtein final {
+ public:
+  BitParallelLevenshtein(const std::vector<uint32_t>& input_sequence, size_t rows, int32_t max_distance)
+      : completion_(CostFunctionT().GetCompletionCost() == 0) {
+    compare_sequence_.reserve(rows);
+    Reset(input_sequence, max_distance);
+  }
+
+  BitParallelLevenshtein() = delete;
+  BitParallelLevenshtein& operator=(BitParallelLevenshtein const&) = delete;
+  BitParallelLevenshtein(const BitParallelLevenshtein& that) = delete;
+  BitParallelLevenshtein(BitParallelLevenshtein&& other) = default;
+
+  /**
+   * Reinitialize for a new input sequence, the memory allocated so far is reused.
+   *
+   * @param input_sequence the new input sequence
+   * @param max_distance the maximum distance
+   */
+  void Reset(const std::vector<uint32_t>& input_sequence, int32_t max_distance) {
+    max_distance_ = std::max(max_distance, 0);
+    input_sequence_.assign(input_sequence.begin(), input_sequence.end());
+    words_ = (input_sequence_.size() + 63) / 64;
+    last_put_row_ = 0;
+
+    // match masks: for every distinct codepoint of the input the positions it occurs at, class 0 for all others
+    ascii_classes_.assign(128, 0);
+    non_ascii_classes_.clear();
+    masks_.assign(words_, 0);
+    uint32_t number_of_classes = 1;
+
+    for (size_t i = 0; i < input_sequence_.size(); ++i) {
+      const uint32_t codepoint = input_sequence_[i];
+      uint32_t character_class = GetClass(codepoint);
+      if (character_class == 0) {
+        character_class = number_of_classes++;
+        if (codepoint < ascii_classes_.size()) {
+          ascii_classes_[codepoint] = character_class;
+        } else {
+          non_ascii_classes_.emplace_back(codepoint, character_class);
+        }
+        masks_.resize(masks_.size() + words_, 0);
+      }
+      masks_[character_class * words_ + i / 64] |= uint64_t(1) << (i % 64);
+    }
+
+    // first row: the distance to the input prefixes grows by 1 per codepoint
+    EnsureCapacity(1);
+    std::fill(vp_.begin(), vp_.begin() + words_, ~uint64_t(0));
+    std::fill(vn_.begin(), vn_.begin() + words_, 0);
+    std::fill(d0_.begin(), d0_.begin() + words_, 0);
+    classes_[0] = 0;
+    scores_[0] = static_cast<int32_t>(input_sequence_.size());
+    completion_scores_[0] = scores_[0];
+    intermediate_scores_[0] = 0;
+  }
+
+  int32_t Put(uint32_t codepoint, size_t position) {
+    const size_t row = position + 1;
+    TRACE("Calculating row: %ld", row);
+
+    EnsureCapacity(row + 1);
+    compare_sequence_[position] = codepoint;
+    classes_[row] = GetClass(codepoint);
+    last_put_row_ = row;
+
+    const uint64_t* match = masks_.data() + classes_[row] * words_;
+    const uint64_t* previous_match = masks_.data() + classes_[row - 1] * words_;
+    const uint64_t* vp = vp_.data() + (row - 1) * words_;
+    const uint64_t* vn = vn_.data() + (row - 1) * words_;
+    const uint64_t* previous_d0 = d0_.data() + (row - 1) * words_;
+    uint64_t* next_vp = vp_.data() + row * words_;
+    uint64_t* next_vn = vn_.data() + row * words_;
+    uint64_t* next_d0 = d0_.data() + row * words_;
+
+    // carries between words, the horizontal difference in the first column is always +1
+    uint64_t add_carry = 0;
+    uint64_t hp_carry = 1;
+    uint64_t hn_carry = 0;
+    uint64_t transposition_carry = 0;
+    int32_t score_difference = 0;
+
+    for (size_t word = 0; word < words_; ++word) {
+      // transpositions of the current and the previous codepoint
+      const uint64_t transposition_candidates = ~previous_d0[word] & match[word];
+      const uint64_t transpositions = ((transposition_candidates << 1) | transposition_carry) & previous_match[word];
+      transposition_carry = transposition_candidates >> 63;
+
+      // (match & vp) + vp with carry over words
+      const uint64_t x = match[word] & vp[word];
+      const uint64_t sum_1 = x + add_carry;
+      const uint64_t sum = sum_1 + vp[word];
+      add_carry = (sum_1 < x) | (sum < sum_1);
+
+      const uint64_t d0 = (sum ^ vp[word]) | match[word] | vn[word] | transpositions;
+      const uint64_t hp = vn[word] | ~(d0 | vp[word]);
+      const uint64_t hn = d0 & vp[word];
+
+      const uint64_t hp_shifted = (hp << 1) | hp_carry;
+      const uint64_t hn_shifted = (hn << 1) | hn_carry;
+      hp_carry = hp >> 63;
+      hn_carry = hn >> 63;
+
+      next_vp[word] = hn_shifted | ~(d0 | hp_shifted);
+      next_vn[word] = d0 & hp_shifted;
+      next_d0[word] = d0;
+
+      if (word + 1 == words_) {
+        const size_t last_bit = (input_sequence_.size() - 1) % 64;
+        score_difference = static_cast<int32_t>((hp >> last_bit) & 1) - static_cast<int32_t>((hn >> last_bit) & 1);
+      }
+    }
+
+    scores_[row] = words_ > 0 ? scores_[row - 1] + score_difference : static_cast<int32_t>(row);
+    completion_scores_[row] = completion_ ? std::min(completion_scores_[row - 1], scores_[row]) : scores_[row];
+    intermediate_scores_[row] = CalculateIntermediateScore(row);
+
+    TRACE("score: %d intermediate score: %d", completion_scores_[row], intermediate_scores_[row]);
+    return intermediate_scores_[row];
+  }
+
+  int32_t GetScore() const { return completion_scores_[last_put_row_]; }
+
+  std::string GetCandidate(size_t pos = 0) {
+    std::string candidate;
+    GetCandidate(&candidate, pos);
+    return candidate;
+  }
+
+  /**
+   * Get the candidate without allocating a new string.
+   *
+   * @param candidate string to write the candidate to, the old content gets replaced
+   * @param pos the position to start from
+   */
+  void GetCandidate(std::string* candidate, size_t pos = 0) const {
+    candidate->clear();
+    if (pos < last_put_row_) {
+      utf8::utf32to8(compare_sequence_.begin() + pos, compare_sequence_.begin() + last_put_row_,
+                     back_inserter(*candidate));
+    }
+  }
+
+  const std::vector<uint32_t>& GetInputSequence() const { return input_sequence_; }
+
+ private:
+  bool completion_;
+  int32_t max_distance_ = 0;
+  size_t words_ = 0;
+  size_t last_put_row_ = 0;
+
+  std::vector<uint32_t> input_sequence_;
+  std::vector<uint32_t> compare_sequence_;
+
+  // codepoint classes and their match masks
+  std::vector<uint32_t> ascii_classes_;
+  std::vector<std::pair<uint32_t, uint32_t>> non_ascii_classes_;
+  std::vector<uint64_t> masks_;
+
+  // per row: vertical differences, diagonal zero differences, class of the codepoint and scores
+  std::vector<uint64_t> vp_;
+  std::vector<uint64_t> vn_;
+  std::vector<uint64_t> d0_;
+  std::vector<uint32_t> classes_;
+  std::vector<int32_t> scores_;
+  std::vector<int32_t> completion_scores_;
+  std::vector<int32_t> intermediate_scores_;
+
+  uint32_t GetClass(const uint32_t codepoint) const {
+    if (codepoint < ascii_classes_.size()) {
+      return ascii_classes_[codepoint];
+    }
+
+    for (const auto& codepoint_class : non_ascii_classes_) {
+      if (codepoint_class.first == codepoint) {
+        return codepoint_class.second;
+      }
+    }
+    return 0;
+  }
+
+  /**
+   * The best score of the row, only considering cells which can still lead to a score within max_distance, like the
+   * corridor of NeedlemanWunsch.
+   */
+  int32_t CalculateIntermediateScore(const size_t row) const {
+    const size_t columns = input_sequence_.size() + 1;
+    const size_t max_distance = static_cast<size_t>(max_distance_);
+    const size_t first_column = row > max_distance ? row - max_distance : 1;
+    const size_t last_column = std::min(columns - 1, row + max_distance);
+
+    // the candidate is longer than the input + max distance
+    if (first_column >= columns) {
+      return intermediate_scores_[row - 1] + (completion_ ? 0 : 1);
+    }
+
+    const uint64_t* vp = vp_.data() + row * words_;
+    const uint64_t* vn = vn_.data() + row * words_;
+
+    // the first cell of the row is the row itself, sum up the differences up to the first column
+    int32_t distance = static_cast<int32_t>(row);
+    const size_t full_words = (first_column - 1) / 64;
+    for (size_t word = 0; word < full_words; ++word) {
+      distance += __builtin_popcountll(vp[word]) - __builtin_popcountll(vn[word]);
+    }
+    const size_t remaining_bits = (first_column - 1) % 64;
+    if (remaining_bits > 0) {
+      const uint64_t mask = (uint64_t(1) << remaining_bits) - 1;
+      distance += __builtin_popcountll(vp[full_words] & mask) - __builtin_popcountll(vn[full_words] & mask);
+    }
+
+    int32_t intermediate_score = intermediate_scores_[row - 1] + 1;
+    for (size_t column = first_column; column <= last_column; ++column) {
+      const size_t bit = column - 1;
+      distance += static_cast<int32_t>((vp[bit / 64] >> (bit % 64)) & 1);
+      distance -= static_cast<int32_t>((vn[bit / 64] >> (bit % 64)) & 1);
+      intermediate_score = std::min(intermediate_score, distance);
+    }
+
+    return std::min(intermediate_score, completion_scores_[row]);
+  }
+
+  void EnsureCapacity(size_t rows) {
+    if (classes_.size() < rows) {
+      const size_t capacity = std::max(rows, classes_.size() * 2);
+      compare_sequence_.resize(capacity);
+      classes_.resize(capacity);
+      scores_.resize(capacity);
+      completion_scores_.resize(capacity);
+      intermediate_scores_.resize(capacity);
+    }
+
+    if (vp_.size() < classes_.size() * words_) {
+      vp_.resize(classes_.size() * words_);
+      vn_.resize(classes_.size() * words_);
+      d0_.resize(classes_.size() * words_);
+    }
+  }
+};
+
+} /* namespace stringdistance */
+} /* namespace keyvi */
+
+#endif  // KEYVI_STRINGDISTANCE_BIT_PARALLEL_LEVENSHTEIN_H_
@@ -27,6 +27,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <stdexcept>
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -44,6 +45,7 @@ struct DistanceMatrix final {
     distance_matrix_ = new int32_t[rows * columns];
     number_of_rows_ = rows;
     number_of_columns_ = columns;
+    capacity_ = rows * columns;
   }
 
   DistanceMatrix() = delete;
@@ -55,10 +57,12 @@ struct DistanceMatrix final {
   DistanceMatrix(DistanceMatrix&& other)
       : distance_matrix_(other.distance_matrix_),
         number_of_columns_(other.number_of_columns_),
-        number_of_rows_(other.number_of_rows_) {
+        number_of_rows_(other.number_of_rows_),
+        capacity_(other.capacity_) {
     other.distance_matrix_ = 0;
     other.number_of_columns_ = 0;
     other.number_of_rows_ = 0;
+    other.capacity_ = 0;
   }
 
   ~DistanceMatrix() {
@@ -92,9 +96,32 @@ struct DistanceMatrix final {
       // switch matrix
       distance_matrix_ = newDistanceMatrix;
       number_of_rows_ = new_rows;
+      capacity_ = new_rows * number_of_columns_;
     }
   }
 
+  /**
+   * Reinitialize the matrix with a different number of columns, the buffer is only reallocated if it is too small.
+   *
+   * Note: the content of the matrix is undefined after a reset.
+   *
+   * @param columns the new number of columns
+   */
+  void Reset(size_t columns) {
+    if (columns < 1) {
+      throw std::invalid_argument("Distance Matrix must have at least 1 row and 1 column.");
+    }
+
+    if (columns > capacity_) {
+      delete[] distance_matrix_;
+      distance_matrix_ = new int32_t[columns];
+      capacity_ = columns;
+    }
+
+    number_of_columns_ = columns;
+    number_of_rows_ = capacity_ / columns;
+  }
+
   size_t Rows() const { return number_of_rows_; }
 
   size_t Columns() const { return number_of_columns_; }
@@ -103,6 +130,7 @@ struct DistanceMatrix final {
   int32_t* distance_matrix_;  //< internal matrix
   size_t number_of_columns_;  //< number of columns in the table. This is fixed at initialization time.
   size_t number_of_rows_;
+  size_t capacity_;  //< number of cells the buffer can hold
 };
 
 } /* namespace stringdistance */
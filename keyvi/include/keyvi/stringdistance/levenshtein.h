@@ -27,6 +27,7 @@
 
 #include <memory>
 
+#include "keyvi/stringdistance/bit_parallel_levenshtein.h"
 #include "keyvi/stringdistance/costfunctions/damerau_levenshtein.h"
 #include "keyvi/stringdistance/costfunctions/damerau_levenshtein_completion.h"
 #include "keyvi/stringdistance/needleman_wunsch.h"
@@ -34,9 +35,10 @@
 namespace keyvi {
 namespace stringdistance {
 
-// Levenshtein is NeedlemanWunsch with constant cost of 1 for all operations
-typedef NeedlemanWunsch<costfunctions::Damerau_Levenshtein> Levenshtein;
-typedef NeedlemanWunsch<costfunctions::Damerau_LevenshteinCompletion> LevenshteinCompletion;
+// Levenshtein has a constant cost of 1 for all operations, which allows a bit-parallel implementation of
+// NeedlemanWunsch
+typedef BitParallelLevenshtein<costfunctions::Damerau_Levenshtein> Levenshtein;
+typedef BitParallelLevenshtein<costfunctions::Damerau_LevenshteinCompletion> LevenshteinCompletion;
 
 typedef std::shared_ptr<Levenshtein> levenshtein_t;
 
@@ -0,0 +1,268 @@
+/* * keyvi - A key value store.
+ *
+ * Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * levenshtein_automaton.h
+ *
+ * Deterministic automaton accepting all strings within a maximum Damerau-Levenshtein distance of a query.
+ */
+
+#ifndef KEYVI_STRINGDISTANCE_LEVENSHTEIN_AUTOMATON_H_
+#define KEYVI_STRINGDISTANCE_LEVENSHTEIN_AUTOMATON_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace stringdistance {
+
+/**
+ * Levenshtein automaton for a query, including transpositions of adjacent characters.
+ *
+ * The automaton computes the same distances as Levenshtein (NeedlemanWunsch with Damerau_Levenshtein costs). A state
+ * stands for the distance matrix row of the characters read so far, capped at max_distance + 1, together with the cells
+ * of the previous row a transposition can still use. Characters are mapped to classes, one for every distinct character
+ * of the query and one for all others.
+ *
+ * States are determinized lazily: the first time a transition is taken the target row is computed and cached in the
+ * transition table, afterwards the transition is a table lookup. Traversing a dictionary visits the same transitions
+ * over and over, e.g. in sibling subtrees.
+ */
+class LevenshteinAutomaton final {
+ public:
+  using state_t = uint32_t;
+
+  // state from which no string within the maximum distance can be reached
+  static constexpr state_t DEAD_STATE = 0;
+
+  LevenshteinAutomaton(const std::vector<uint32_t>& query, const int32_t max_distance) { Reset(query, max_distance); }
+
+  LevenshteinAutomaton() = delete;
+
+  /**
+   * Reinitialize for a new query, the memory allocated so far is reused.
+   *
+   * @param query the query as codepoints
+   * @param max_distance the maximum distance, distances greater than 254 are not supported
+   */
+  void Reset(const std::vector<uint32_t>& query, const int32_t max_distance) {
+    max_distance_ = max_distance;
+    cap_ = static_cast<uint8_t>(std::clamp(max_distance + 1, 0, 255));
+    columns_ = query.size() + 1;
+    state_size_ = 2 * columns_ + sizeof(uint32_t);
+
+    ascii_classes_.fill(0);
+    non_ascii_classes_.clear();
+    query_classes_.clear();
+    number_of_classes_ = 1;
+
+    for (const uint32_t codepoint : query) {
+      uint32_t character_class = GetClass(codepoint);
+      if (character_class == 0) {
+        character_class = number_of_classes_++;
+        if (codepoint < ascii_classes_.size()) {
+          ascii_classes_[codepoint] = character_class;
+        } else {
+          non_ascii_classes_.emplace_back(codepoint, character_class);
+        }
+      }
+      query_classes_.push_back(character_class);
+    }
+
+    states_.clear();
+    transitions_.clear();
+    state_ids_.clear();
+
+    // the dead state loops to itself
+    scratch_.assign(state_size_, 0);
+    states_.insert(states_.end(), scratch_.begin(), scratch_.end());
+    transitions_.resize(number_of_classes_, DEAD_STATE);
+
+    start_state_ = DEAD_STATE;
+    if (max_distance_ < 0) {
+      return;
+    }
+
+    // first row: distance to the query prefixes, no previous row
+    uint8_t* row = reinterpret_cast<uint8_t*>(&scratch_[0]);
+    for (size_t column = 0; column < columns_; ++column) {
+      row[column] = static_cast<uint8_t>(std::min<size_t>(column, cap_));
+      row[columns_ + column] = cap_;
+    }
+    start_state_ = AddState();
+  }
+
+  state_t GetStartState() const { return start_state_; }
+
+  /**
+   * Take the transition for the given character.
+   *
+   * @param state the current state
+   * @param codepoint the character
+   * @return the next state, DEAD_STATE if no match is possible anymore
+   */
+  state_t Step(const state_t state, const uint32_t codepoint) {
+    const uint32_t character_class = GetClass(codepoint);
+    const size_t transition = static_cast<size_t>(state) * number_of_classes_ + character_class;
+
+    if (transitions_[transition] == UNKNOWN_STATE) {
+      // computing the transition might grow the table, so assign afterwards
+      const state_t next_state = ComputeTransition(state, character_class);
+      transitions_[transition] = next_state;
+    }
+
+    return transitions_[transition];
+  }
+
+  /**
+   * @return true if the string read so far is within the maximum distance
+   */
+  bool IsFinal(const state_t state) const {
+    return state != DEAD_STATE && states_[state * state_size_ + columns_ - 1] < cap_;
+  }
+
+  /**
+   * @return the distance of the string read so far, only exact for final states
+   */
+  int32_t GetScore(const state_t state) const { return states_[state * state_size_ + columns_ - 1]; }
+
+  /**
+   * @return a lower bound for the distance of every string starting with the string read so far
+   */
+  int32_t GetMinimumDistance(const state_t state) const {
+    const uint8_t* row = &states_[state * state_size_];
+    return *std::min_element(row, row + columns_);
+  }
+
+  /**
+   * @return the number of states determinized so far, including the dead state
+   */
+  size_t GetNumberOfStates() const { return states_.size() / state_size_; }
+
+ private:
+  static constexpr state_t UNKNOWN_STATE = std::numeric_limits<state_t>::max();
+
+  int32_t max_distance_ = 0;
+  uint8_t cap_ = 0;
+  size_t columns_ = 0;
+  size_t state_size_ = 0;
+  state_t start_state_ = DEAD_STATE;
+
+  // character classes, 0 for all characters not in the query
+  std::array<uint32_t, 128> ascii_classes_;
+  std::vector<std::pair<uint32_t, uint32_t>> non_ascii_classes_;
+  std::vector<uint32_t> query_classes_;
+  uint32_t number_of_classes_ = 1;
+
+  // state layout: current row, usable cells of the previous row, class of the previous character
+  std::vector<uint8_t> states_;
+  std::vector<state_t> transitions_;
+  std::unordered_map<std::string, state_t> state_ids_;
+  std::string scratch_;
+
+  uint32_t GetClass(const uint32_t codepoint) const {
+    if (codepoint < ascii_classes_.size()) {
+      return ascii_classes_[codepoint];
+    }
+
+    for (const auto& codepoint_class : non_ascii_classes_) {
+      if (codepoint_class.first == codepoint) {
+        return codepoint_class.second;
+      }
+    }
+    return 0;
+  }
+
+  state_t ComputeTransition(const state_t state, const uint32_t character_class) {
+    scratch_.resize(state_size_);
+    const uint8_t* current = &states_[state * state_size_];
+    const uint8_t* previous = current + columns_;
+    uint32_t previous_class;
+    std::memcpy(&previous_class, current + 2 * columns_, sizeof(uint32_t));
+
+    uint8_t* next = reinterpret_cast<uint8_t*>(&scratch_[0]);
+    next[0] = static_cast<uint8_t>(std::min<int32_t>(current[0] + 1, cap_));
+    bool alive = next[0] < cap_;
+
+    for (size_t column = 1; column < columns_; ++column) {
+      const uint32_t query_class = query_classes_[column - 1];
+      int32_t distance = current[column - 1] + (character_class != 0 && query_class == character_class ? 0 : 1);
+      distance = std::min<int32_t>(distance, next[column - 1] + 1);
+      distance = std::min<int32_t>(distance, current[column] + 1);
+
+      // transposition of the previous and the current character
+      if (column > 1 && character_class != 0 && query_class == previous_class &&
+          query_classes_[column - 2] == character_class) {
+        distance = std::min<int32_t>(distance, previous[column - 2] + 1);
+      }
+
+      next[column] = static_cast<uint8_t>(std::min<int32_t>(distance, cap_));
+      alive |= next[column] < cap_;
+    }
+
+    if (!alive) {
+      return DEAD_STATE;
+    }
+
+    // keep only the cells of the current row a transposition in the next step can use, so equivalent states are merged
+    uint8_t* next_previous = next + columns_;
+    bool has_previous = false;
+    for (size_t column = 0; column < columns_; ++column) {
+      next_previous[column] = cap_;
+      if (character_class != 0 && column + 2 < columns_ && query_classes_[column + 1] == character_class &&
+          current[column] + 1 < cap_) {
+        next_previous[column] = current[column];
+        has_previous = true;
+      }
+    }
+
+    const uint32_t next_previous_class = has_previous ? character_class : 0;
+    std::memcpy(next + 2 * columns_, &next_previous_class, sizeof(uint32_t));
+
+    auto it = state_ids_.find(scratch_);
+    if (it != state_ids_.end()) {
+      return it->second;
+    }
+
+    return AddState();
+  }
+
+  state_t AddState() {
+    const state_t state = static_cast<state_t>(states_.size() / state_size_);
+    TRACE("add state %u", state);
+
+    states_.insert(states_.end(), scratch_.begin(), scratch_.end());
+    transitions_.resize(transitions_.size() + number_of_classes_, UNKNOWN_STATE);
+    state_ids_.emplace(scratch_, state);
+    return state;
+  }
+};
+
+} /* namespace stringdistance */
+} /* namespace keyvi */
+
+#endif  // KEYVI_STRINGDISTANCE_LEVENSHTEIN_AUTOMATON_H_
@@ -73,6 +73,24 @@ class NeedlemanWunsch final {
 
   ~NeedlemanWunsch() {}
 
+  /**
+   * Reinitialize for a new input sequence, the memory allocated so far is reused.
+   *
+   * @param input_sequence the new input sequence
+   * @param max_distance the maximum distance
+   */
+  void Reset(const std::vector<uint32_t>& input_sequence, int32_t max_distance) {
+    max_distance_ = max_distance;
+    input_sequence_.assign(input_sequence.begin(), input_sequence.end());
+    distance_matrix_.Reset(input_sequence.size() + 1);
+    compare_sequence_.clear();
+    intermediate_scores_.clear();
+    last_put_position_ = 0;
+
+    // the buffers keep their capacity, they grow on demand in Put
+    init(0);
+  }
+
   int32_t Put(uint32_t codepoint, size_t position) {
     size_t row = position + 1;
     TRACE("Calculating row: %ld", row);
@@ -193,7 +211,19 @@ class NeedlemanWunsch final {
     return std::string(utf8result.begin(), utf8result.end());
   }
 
-  const std::vector<uint32_t> GetInputSequence() const { return input_sequence_; }
+  /**
+   * Get the candidate without allocating a new string.
+   *
+   * @param candidate string to write the candidate to, the old content gets replaced
+   * @param pos the position to start from
+   */
+  void GetCandidate(std::string* candidate, size_t pos = 0) const {
+    candidate->clear();
+    utf8::utf32to8(compare_sequence_.begin() + pos, compare_sequence_.begin() + last_put_position_ + 1,
+                   back_inserter(*candidate));
+  }
+
+  const std::vector<uint32_t>& GetInputSequence() const { return input_sequence_; }
 
  private:
   int32_t max_distance_ = 0;
@@ -35,9 +35,9 @@
 
 #include <boost/filesystem.hpp>
 
-#include <msgpack.hpp>
-
 #include "keyvi/dictionary/fsa/automata.h"
+#include "keyvi/index/constants.h"
+#include "keyvi/index/internal/deleted_key_set.h"
 #include "keyvi/testing/compilation_utils.h"
 
 namespace keyvi {
@@ -80,10 +80,7 @@ class IndexMock final {
 
     boost::filesystem::path tmp_filename(filename);
     tmp_filename += "-swap";
-    {
-      std::ofstream out_stream(tmp_filename.string(), std::ios::binary);
-      msgpack::pack(out_stream, deleted_keys);
-    }
+    index::internal::DeletedKeySet::Write(tmp_filename.string(), deleted_keys, MIN_JOB_MEMORY_LIMIT);
     std::rename(tmp_filename.string().c_str(), filename.string().c_str());
   }
 
@@ -25,11 +25,15 @@
 #ifndef KEYVI_TRANSFORM_FSA_TRANSFORM_H_
 #define KEYVI_TRANSFORM_FSA_TRANSFORM_H_
 
-#include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "keyvi/dictionary/dictionary.h"
 #include "keyvi/dictionary/fsa/automata.h"
+#include "keyvi/dictionary/match_view.h"
+#include "keyvi/dictionary/text_annotator.h"
 
 // #define ENABLE_TRACING
 #include "keyvi/dictionary/util/trace.h"
@@ -37,6 +41,12 @@
 namespace keyvi {
 namespace transform {
 
+/**
+ * Replaces all occurrences of the keys of a dictionary with their values.
+ *
+ * Keys are matched leftmost-longest and without overlap, text between the matches is copied. The input is scanned
+ * once, see dictionary::TextAnnotator.
+ */
 class FsaTransform final {
  public:
   explicit FsaTransform(dictionary::fsa::automata_t fsa) : fsa_(fsa) {}
@@ -44,69 +54,93 @@ class FsaTransform final {
   explicit FsaTransform(dictionary::dictionary_t d) { fsa_ = d->GetFsa(); }
 
   std::string Normalize(const std::string& input) const {
-    std::ostringstream output_buffer;
-
-    uint64_t state = fsa_->GetStartState();
-    size_t input_length = input.size();
-    uint64_t last_final_state = 0;
-    size_t last_final_state_position = 0;
-    size_t current_matching_depth = 0;
-    size_t offset = 0;
+    std::string output;
+    Normalize(input, &output);
+    return output;
+  }
 
-    TRACE("Normalizing %s", input.c_str());
-    while (offset < input_length) {
-      state = fsa_->TryWalkTransition(state, input[offset]);
+  /**
+   * Normalize the input into the given output buffer, the buffer is cleared first.
+   *
+   * Reusing the output buffer for many inputs avoids allocations.
+   *
+   * @param input the input
+   * @param output the output buffer
+   */
+  void Normalize(const std::string_view input, std::string* output) const {
+    NormalizationContext context;
+    Normalize(input, output, &context);
+  }
 
-      if (state) {
-        // got a match
-        TRACE("Matched at %d", offset);
+  /**
+   * Normalize a batch of inputs, buffers and decoded replacements are shared between the inputs.
+   *
+   * @param inputs the inputs
+   * @return the normalized inputs, in the same order
+   */
+  std::vector<std::string> Normalize(const std::vector<std::string>& inputs) const {
+    std::vector<std::string> outputs;
+    Normalize(inputs, &outputs);
+    return outputs;
+  }
 
-        ++current_matching_depth;
+  /**
+   * Normalize a batch of inputs into the given output buffers, the memory of existing outputs is reused.
+   *
+   * @param inputs the inputs
+   * @param outputs the output buffers, resized to the number of inputs
+   */
+  void Normalize(const std::vector<std::string>& inputs, std::vector<std::string>* outputs) const {
+    NormalizationContext context;
+    outputs->resize(inputs.size());
+
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      Normalize(inputs[i], &(*outputs)[i], &context);
+    }
+  }
 
-        if (fsa_->IsFinalState(state)) {
-          last_final_state = state;
-          last_final_state_position = current_matching_depth;
-        }
+ private:
+  /**
+   * Scratch space for normalizing, keeps the decoded replacements of values that are not stored as plain strings.
+   */
+  struct NormalizationContext {
+    dictionary::TextAnnotator annotator{dictionary::annotation_mode_t::LEFTMOST_LONGEST, ""};
+    std::unordered_map<uint64_t, std::string> replacements;
+  };
 
-      } else {
-        // no match
+  dictionary::fsa::automata_t fsa_;
 
-        if (last_final_state) {
-          TRACE("Write normalization");
+  void Normalize(const std::string_view input, std::string* output, NormalizationContext* context) const {
+    TRACE("Normalizing %s", std::string(input).c_str());
+    output->clear();
+    output->reserve(input.size());
+    size_t copied = 0;
 
-          output_buffer << fsa_->GetValueAsString(fsa_->GetStateValue(last_final_state));
-          last_final_state = 0;
+    context->annotator.Annotate(fsa_, input, [&](const dictionary::MatchView& m) {
+      output->append(input.data() + copied, m.GetStart() - copied);
+      output->append(GetReplacement(m.GetStateValue(), context));
+      copied = m.GetEnd();
+    });
 
-          // calculate the offset in the input buffer, that's the offset
-          // before traversal plus the offset till the last final match
-          offset -= (current_matching_depth - last_final_state_position + 1);
-        } else {
-          // just write the plain input
-          output_buffer.put(input[offset]);
-          offset -= current_matching_depth;
-        }
+    output->append(input.data() + copied, input.size() - copied);
+    TRACE("Normalization result: %s", output->c_str());
+  }
 
-        current_matching_depth = 0;
-        state = fsa_->GetStartState();
-      }
+  std::string_view GetReplacement(const uint64_t state_value, NormalizationContext* context) const {
+    std::string_view replacement;
 
-      ++offset;
+    // string values can be used without decoding them
+    if (fsa_->GetValueAsStringView(state_value, &replacement)) {
+      return replacement;
     }
 
-    if (last_final_state) {
-      output_buffer << fsa_->GetValueAsString(fsa_->GetStateValue(last_final_state));
-      // if we had a partial match and a partial traversal, add the original strings at the end
-      while (current_matching_depth > last_final_state_position) {
-        output_buffer.put(input[offset + last_final_state_position - current_matching_depth]);
-        ++last_final_state_position;
-      }
+    auto it = context->replacements.find(state_value);
+    if (it == context->replacements.end()) {
+      it = context->replacements.emplace(state_value, fsa_->GetValueAsString(state_value)).first;
     }
-    TRACE("Normalization result: %s", output_buffer.str().c_str());
-    return output_buffer.str();
-  }
 
- private:
-  dictionary::fsa::automata_t fsa_;
+    return it->second;
+  }
 };
 
 } /* namespace transform */
@@ -29,6 +29,7 @@
 #include <chrono>  // NOLINT
 #include <functional>
 #include <thread>  // NOLINT
+#include <utility>
 
 #include "blockingconcurrentqueue.h"
 
@@ -76,8 +77,9 @@ class ActiveObject final {
   }
 
   template <typename F>
-  void operator()(F f) {
-    queue_.enqueue([=] { f(*resource_); });
+  void operator()(F&& f) {
+    // move the callable into the queue, it might own large buffers
+    queue_.enqueue([this, f = std::forward<F>(f)]() mutable { f(*resource_); });
   }
 
   size_t Size() const { return queue_.size_approx(); }
@@ -30,6 +30,12 @@
 #include <sys/resource.h>
 #endif
 
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
 #include <cstddef>
 #include <fstream>
 #include <stdexcept>
@@ -70,6 +76,34 @@ class OsUtils {
 #endif
   }
 
+  /**
+   * Lower the CPU and I/O priority of the calling thread, used for background work like merges.
+   *
+   * Only supported on Linux, where priorities are per thread, a no-op on other platforms.
+   *
+   * @param nice the nice value to add, 1-19, I/O gets the best effort class with a priority derived from it
+   * @return true if the priority has been lowered
+   */
+  static bool LowerThreadPriority(const int nice) {
+#if defined(__linux__)
+    if (nice <= 0) {
+      return false;
+    }
+
+    const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    const int cpu_priority = std::min(19, getpriority(PRIO_PROCESS, tid) + nice);
+    bool lowered = setpriority(PRIO_PROCESS, tid, cpu_priority) == 0;
+
+    // best effort class (2) with priority 0 (highest) to 7 (lowest), see ioprio_set(2)
+    const int ioprio_who_process = 1;
+    const int io_priority = (2 << 13) | std::min(7, 4 + (nice + 4) / 5);
+    lowered = syscall(SYS_ioprio_set, ioprio_who_process, tid, io_priority) == 0 && lowered;
+    return lowered;
+#else
+    return false;
+#endif
+  }
+
   static inline std::ofstream OpenOutFileStream(const std::string& filename) {
     std::ofstream stream(filename, std::ios::binary);
 
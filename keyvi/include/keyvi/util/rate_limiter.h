@@ -0,0 +1,150 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * rate_limiter.h
+ *
+ * Limits the throughput of background work, e.g. bytes processed by merges, shared by all threads using it.
+ */
+
+#ifndef KEYVI_UTIL_RATE_LIMITER_H_
+#define KEYVI_UTIL_RATE_LIMITER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <mutex>   // NOLINT
+#include <streambuf>
+#include <thread>  // NOLINT
+
+namespace keyvi {
+namespace util {
+
+/**
+ * Rate limiter which lets callers pay for work done, pausing them if they are ahead of the rate.
+ *
+ * All callers share the rate. Unused capacity is not saved up for more than 1 second, so an idle period does not
+ * allow a long burst afterwards.
+ */
+class RateLimiter final {
+  using clock_t = std::chrono::steady_clock;
+
+ public:
+  /**
+   * @param bytes_per_second the rate, 0 for no limit
+   */
+  explicit RateLimiter(const size_t bytes_per_second = 0) : bytes_per_second_(bytes_per_second) {}
+
+  RateLimiter& operator=(RateLimiter const&) = delete;
+  RateLimiter(const RateLimiter& that) = delete;
+
+  size_t GetRate() const { return bytes_per_second_; }
+
+  /**
+   * Change the rate, takes effect with the next call to Acquire.
+   *
+   * @param bytes_per_second the rate, 0 for no limit
+   */
+  void SetRate(const size_t bytes_per_second) { bytes_per_second_ = bytes_per_second; }
+
+  /**
+   * Pay for the given number of bytes, blocks if the callers are ahead of the rate.
+   */
+  void Acquire(const size_t bytes) {
+    const size_t bytes_per_second = bytes_per_second_;
+    if (bytes_per_second == 0 || bytes == 0) {
+      return;
+    }
+
+    const auto cost = std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<double>(
+        static_cast<double>(bytes) / static_cast<double>(bytes_per_second)));
+    clock_t::time_point pause_until;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      const clock_t::time_point now = clock_t::now();
+      next_free_ = std::max(next_free_, now - std::chrono::seconds(1)) + cost;
+      pause_until = next_free_;
+    }
+
+    // short pauses are not worth a sleep, they are paid with the next call
+    if (pause_until - clock_t::now() > std::chrono::milliseconds(1)) {
+      std::this_thread::sleep_until(pause_until);
+    }
+  }
+
+ private:
+  std::atomic_size_t bytes_per_second_;
+  std::mutex mutex_;
+  clock_t::time_point next_free_;
+};
+
+/**
+ * Stream buffer which pays a rate limiter for the bytes written through it.
+ *
+ * Writes are passed on in chunks, so a big write gets paused in between instead of bursting at full speed.
+ */
+class RateLimitedStreamBuffer final : public std::streambuf {
+ public:
+  static constexpr std::streamsize CHUNK_SIZE = 64 * 1024;
+
+  /**
+   * @param target the buffer to write to, must outlive this buffer
+   * @param rate_limiter the rate limiter, must outlive this buffer
+   */
+  RateLimitedStreamBuffer(std::streambuf* target, RateLimiter* rate_limiter)
+      : target_(target), rate_limiter_(rate_limiter) {}
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+      return traits_type::not_eof(c);
+    }
+
+    rate_limiter_->Acquire(1);
+    return target_->sputc(traits_type::to_char_type(c));
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    std::streamsize written = 0;
+
+    while (written < n) {
+      const std::streamsize chunk = std::min(n - written, CHUNK_SIZE);
+      rate_limiter_->Acquire(static_cast<size_t>(chunk));
+      const std::streamsize chunk_written = target_->sputn(s + written, chunk);
+      written += chunk_written;
+
+      if (chunk_written < chunk) {
+        break;
+      }
+    }
+
+    return written;
+  }
+
+  int sync() override { return target_->pubsync(); }
+
+ private:
+  std::streambuf* target_;
+  RateLimiter* rate_limiter_;
+};
+
+} /* namespace util */
+} /* namespace keyvi */
+
+#endif  // KEYVI_UTIL_RATE_LIMITER_H_
@@ -0,0 +1,158 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * thread_pool.h
+ *
+ * Thread pool for fanning out work of a single query, e.g. one task per index segment.
+ */
+
+#ifndef KEYVI_UTIL_THREAD_POOL_H_
+#define KEYVI_UTIL_THREAD_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "blockingconcurrentqueue.h"
+
+// #define ENABLE_TRACING
+#include "keyvi/dictionary/util/trace.h"
+
+namespace keyvi {
+namespace util {
+
+class ThreadPool final {
+ public:
+  explicit ThreadPool(const size_t number_of_threads) : queue_(), workers_() {
+    for (size_t i = 0; i < number_of_threads; ++i) {
+      workers_.emplace_back([this] {
+        std::function<void()> task;
+        for (;;) {
+          queue_.wait_dequeue(task);
+          if (!task) {
+            return;
+          }
+          task();
+        }
+      });
+    }
+  }
+
+  ThreadPool& operator=(ThreadPool const&) = delete;
+  ThreadPool(const ThreadPool& that) = delete;
+
+  ~ThreadPool() {
+    // an empty task stops a worker
+    for (size_t i = 0; i < workers_.size(); ++i) {
+      queue_.enqueue(std::function<void()>());
+    }
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /**
+   * The pool shared by all callers, created on first use with one thread per core.
+   */
+  static ThreadPool& Shared() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+  }
+
+  size_t Size() const { return workers_.size(); }
+
+  /**
+   * Call func(i) for every i in [0, n) and wait for all calls to finish.
+   *
+   * The calling thread takes part: items are claimed one by one from a shared counter by the caller and by the pool
+   * workers, so a busy pool never stalls the caller and a call from within a pool thread can not deadlock. If calls
+   * throw, the first exception is rethrown after all claimed items finished.
+   *
+   * @param n the number of items
+   * @param func callable taking the item index
+   */
+  template <typename FuncT>
+  void ParallelFor(const size_t n, FuncT func) {
+    if (n == 0) {
+      return;
+    }
+
+    auto state = std::make_shared<ParallelForState>(n);
+    std::function<void(size_t)> call = std::move(func);
+
+    // helpers that start after all items are claimed return immediately, the caller does not wait for them
+    const size_t helpers = std::min(n - 1, workers_.size());
+    for (size_t i = 0; i < helpers; ++i) {
+      queue_.enqueue([state, call] { state->Run(call); });
+    }
+
+    state->Run(call);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished_condition.wait(lock, [&state] { return state->finished == state->size; });
+    if (state->exception) {
+      std::rethrow_exception(state->exception);
+    }
+  }
+
+ private:
+  struct ParallelForState {
+    explicit ParallelForState(const size_t n) : size(n) {}
+
+    void Run(const std::function<void(size_t)>& call) {
+      for (size_t i = next++; i < size; i = next++) {
+        std::exception_ptr e;
+        try {
+          call(i);
+        } catch (...) {
+          e = std::current_exception();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (e && !exception) {
+          exception = e;
+        }
+        if (++finished == size) {
+          finished_condition.notify_all();
+        }
+      }
+    }
+
+    const size_t size;
+    std::atomic_size_t next{0};
+    size_t finished = 0;
+    std::exception_ptr exception;
+    std::mutex mutex;
+    std::condition_variable finished_condition;
+  };
+
+  moodycamel::BlockingConcurrentQueue<std::function<void()>> queue_;
+  std::vector<std::thread> workers_;
+};
+
+} /* namespace util */
+} /* namespace keyvi */
+
+#endif  // KEYVI_UTIL_THREAD_POOL_H_
@@ -30,6 +30,7 @@
 #define KEYVI_UTIL_VINT_H_
 
 #include <string>
+#include <string_view>
 
 namespace keyvi {
 namespace util {
@@ -235,6 +236,18 @@ inline const char* decodeVarIntString(const char* input, size_t* length_ptr) {
   return input + i + 1;
 }
 
+/**
+ * Decode a length-prefixed string without copying it.
+ *
+ * @param input pointer to the length-prefixed string
+ * @return a view on the string, only valid as long as the input is
+ */
+inline std::string_view decodeVarIntStringView(const char* input) {
+  size_t length;
+  const char* value = decodeVarIntString(input, &length);
+  return std::string_view(value, length);
+}
+
 } /* namespace util */
 } /* namespace keyvi */
 #endif  // KEYVI_UTIL_VINT_H_
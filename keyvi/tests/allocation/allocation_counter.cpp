@@ -0,0 +1,118 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+/*
+ * allocation_counter.cpp
+ *
+ * Replaces the global operator new and delete. This file has its own translation unit, so the replacements are never
+ * inlined into code that allocates.
+ */
+
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local bool count_allocations = false;
+thread_local size_t allocations = 0;
+
+// every allocation is prefixed with its size, so the memory in use is known on delete
+const size_t header_size = alignof(std::max_align_t);
+
+std::atomic_size_t memory_in_use{0};
+std::atomic_size_t peak_memory{0};
+size_t memory_in_use_at_start = 0;
+std::atomic_bool track_peak_memory{false};
+
+void* Allocate(size_t size) {
+  if (count_allocations) {
+    ++allocations;
+  }
+
+  unsigned char* p = static_cast<unsigned char*>(std::malloc(size + header_size));
+  if (p == nullptr) {
+    return nullptr;
+  }
+  *reinterpret_cast<size_t*>(p) = size;
+
+  const size_t in_use = memory_in_use.fetch_add(size) + size;
+  if (track_peak_memory) {
+    size_t peak = peak_memory;
+    while (in_use > peak && !peak_memory.compare_exchange_weak(peak, in_use)) {
+    }
+  }
+  return p + header_size;
+}
+
+void Free(void* p) {
+  if (p == nullptr) {
+    return;
+  }
+
+  unsigned char* header = static_cast<unsigned char*>(p) - header_size;
+  memory_in_use -= *reinterpret_cast<size_t*>(header);
+  std::free(header);
+}
+}  // namespace
+
+void* operator new(size_t size) {
+  void* p = Allocate(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+
+void operator delete(void* p) noexcept { Free(p); }
+
+void operator delete(void* p, const std::nothrow_t&) noexcept { Free(p); }
+
+void operator delete(void* p, size_t) noexcept { Free(p); }
+
+namespace keyvi {
+namespace testing {
+
+void StartCountingAllocations() {
+  allocations = 0;
+  count_allocations = true;
+}
+
+size_t StopCountingAllocations() {
+  count_allocations = false;
+  return allocations;
+}
+
+void StartTrackingPeakMemory() {
+  memory_in_use_at_start = memory_in_use;
+  peak_memory = memory_in_use_at_start;
+  track_peak_memory = true;
+}
+
+size_t StopTrackingPeakMemory() {
+  track_peak_memory = false;
+  return peak_memory - memory_in_use_at_start;
+}
+
+} /* namespace testing */
+} /* namespace keyvi */
@@ -0,0 +1,62 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+/*
+ * allocation_counter.h
+ *
+ * Counts heap allocations of the current thread and tracks the peak of heap memory in use, only for test executables
+ * that do not share the global allocator with other tests.
+ */
+
+#ifndef KEYVI_TESTS_ALLOCATION_ALLOCATION_COUNTER_H_
+#define KEYVI_TESTS_ALLOCATION_ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+
+namespace keyvi {
+namespace testing {
+
+/**
+ * Start counting allocations of the current thread.
+ */
+void StartCountingAllocations();
+
+/**
+ * Stop counting allocations of the current thread.
+ *
+ * @return the number of allocations since StartCountingAllocations
+ */
+size_t StopCountingAllocations();
+
+/**
+ * Start tracking the peak of heap memory in use by all threads.
+ */
+void StartTrackingPeakMemory();
+
+/**
+ * Stop tracking the peak of heap memory in use.
+ *
+ * @return the peak since StartTrackingPeakMemory, not counting the memory that was in use already
+ */
+size_t StopTrackingPeakMemory();
+
+} /* namespace testing */
+} /* namespace keyvi */
+
+#endif  // KEYVI_TESTS_ALLOCATION_ALLOCATION_COUNTER_H_
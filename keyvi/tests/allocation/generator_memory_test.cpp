@@ -0,0 +1,83 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * generator_memory_test.cpp
+ *
+ * Part of the allocation test executable, as it tracks the heap memory in use.
+ */
+
+#include <cstdio>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/dictionary/dictionary.h"
+#include "keyvi/dictionary/fsa/generator.h"
+#include "keyvi/dictionary/fsa/internal/sparse_array_persistence.h"
+#include "keyvi/util/configuration.h"
+
+#include "allocation_counter.h"
+
+namespace keyvi {
+namespace dictionary {
+namespace fsa {
+
+BOOST_AUTO_TEST_SUITE(GeneratorMemoryTests)
+
+BOOST_AUTO_TEST_CASE(KeyFilterWithinMemoryLimit) {
+  const size_t number_of_keys = 2000000;
+  const size_t memory_limit = 10 * 1024 * 1024;
+  const std::string filename =
+      (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%-%%%%.kv")).string();
+
+  testing::StartTrackingPeakMemory();
+  {
+    Generator<internal::SparseArrayPersistence<>> generator(
+        keyvi::util::parameters_t{{MEMORY_LIMIT_KEY, std::to_string(memory_limit)},
+                                  {KEY_FILTER_KEY, "true"},
+                                  {KEY_FILTER_KEYS_KEY, std::to_string(number_of_keys)}});
+
+    char key[16];
+    for (size_t i = 0; i < number_of_keys; ++i) {
+      std::snprintf(key, sizeof(key), "%010zu", i);
+      generator.Add(key);
+    }
+
+    generator.CloseFeeding();
+    generator.WriteToFile(filename);
+  }
+  const size_t peak_memory = testing::StopTrackingPeakMemory();
+
+  // without the number of keys up front, the hashes of the keys alone take 16 MB
+  BOOST_CHECK_LE(peak_memory, memory_limit);
+
+  Dictionary d(filename);
+  BOOST_CHECK_EQUAL(number_of_keys, d.GetSize());
+  BOOST_CHECK(d.Contains("0000000042"));
+  BOOST_CHECK(d.GetStatistics().find("key_filter") != std::string::npos);
+
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace fsa */
+} /* namespace dictionary */
+} /* namespace keyvi */
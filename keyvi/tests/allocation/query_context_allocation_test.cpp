@@ -0,0 +1,85 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+/*
+ * query_context_allocation_test.cpp
+ *
+ * Own executable, as it replaces the global allocator to count allocations.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE Keyvi Allocation Test Suite
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/dictionary/dictionary.h"
+#include "keyvi/dictionary/query_context.h"
+#include "keyvi/testing/temp_dictionary.h"
+
+#include "allocation_counter.h"
+
+namespace keyvi {
+namespace dictionary {
+
+BOOST_AUTO_TEST_SUITE(QueryContextAllocationTests)
+
+BOOST_AUTO_TEST_CASE(NoAllocationsInSteadyState) {
+  std::vector<std::pair<std::string, uint32_t>> test_data = {
+      {"abc", 22}, {"abbc", 24}, {"abbcd", 444}, {"abcde", 200},
+      {"abdd", 1}, {"abcdef", 30}, {"abd", 5}, {"bbcd", 7},
+      {"bbc", 12}, {"zzz", 1}, {"a", 3}, {"ab", 100},
+      {"abcx", 60}, {"pizza", 11}, {"pizzeria:u2", 9}, {"pizzeria:u28", 3},
+      {"pizzeria:u281", 2}, {"pizzeria:u282", 4}, {"\xc3\xa4" "bc", 8}, {"\xc3\xa4" "bcd", 9}};
+  testing::TempDictionary dictionary(&test_data);
+  Dictionary d(dictionary.GetFsa());
+  QueryContext context;
+  const std::vector<std::string> queries = {"abc", "abd", "bbcd", "\xc3\xa4" "bc", "pizzeria:u281"};
+
+  size_t number_of_matches = 0;
+  auto visitor = [&number_of_matches](const Match& m) { number_of_matches += m.GetMatchedString().size() > 0; };
+
+  auto run_queries = [&]() {
+    for (const auto& query : queries) {
+      d.GetFuzzy(&context, query, 2, 1, visitor);
+      d.GetPrefixCompletion(&context, query, visitor);
+      d.GetNear(&context, query, 2, true, visitor);
+    }
+  };
+
+  // warm up, buffers grow to their final size
+  run_queries();
+  const size_t warm_up_matches = number_of_matches;
+  BOOST_CHECK(warm_up_matches > 0);
+
+  testing::StartCountingAllocations();
+  run_queries();
+  const size_t allocations = testing::StopCountingAllocations();
+
+  BOOST_CHECK_EQUAL(0, allocations);
+  BOOST_CHECK_EQUAL(2 * warm_up_matches, number_of_matches);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace dictionary
+}  // namespace keyvi
@@ -23,6 +23,7 @@
  *      Author: hendrik
  */
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -307,6 +308,269 @@ BOOST_AUTO_TEST_CASE(float_dictionary) {
   BOOST_CHECK(std::remove(file_name.c_str()) == 0);
 }
 
+std::string compile_to_temp_file(const std::vector<std::string>& keys, const keyvi::util::parameters_t& params) {
+  keyvi::dictionary::DictionaryCompiler<dictionary_type_t::JSON> compiler(params);
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    compiler.Add(keys[i], "{\"id\":" + std::to_string(i) + "}");
+  }
+  compiler.Compile();
+
+  boost::filesystem::path temp_path = boost::filesystem::temp_directory_path();
+  temp_path /= boost::filesystem::unique_path("dictionary-unit-test-dictionarycompiler-%%%%-%%%%-%%%%-%%%%");
+  const std::string file_name = temp_path.string();
+
+  compiler.WriteToFile(file_name);
+  return file_name;
+}
+
+std::vector<std::string> collect_matches(MatchIterator::MatchIteratorPair matches) {
+  std::vector<std::string> result;
+  for (const auto& m : matches) {
+    result.push_back(m->GetMatchedString() + ":" + m->GetValueAsString());
+  }
+  return result;
+}
+
+BOOST_AUTO_TEST_CASE(root_jump_table) {
+  std::vector<std::string> keys = {"",   "a",  "ab",  "abc", "abcd", "abd",         "b",
+                                   "ba", "bab", "zz", "zzz", "\xc3\xa4", "\xc3\xa4" "b", "\xc3\xa4" "bc",
+                                   "\xe2\x82\xac", "\xe2\x82\xac" "uro"};
+  for (size_t i = 0; i < 1000; ++i) {
+    keys.push_back("key-" + std::to_string(i));
+  }
+
+  const std::string file_name_plain = compile_to_temp_file(keys, {{"memory_limit_mb", "10"}});
+  const std::string file_name_jump =
+      compile_to_temp_file(keys, {{"memory_limit_mb", "10"}, {ROOT_JUMP_TABLE_KEY, "true"}});
+
+  const Dictionary plain(file_name_plain);
+  const Dictionary jump(file_name_jump);
+
+  BOOST_CHECK(plain.GetStatistics().find("root_jump_table") == std::string::npos);
+  BOOST_CHECK(jump.GetStatistics().find("root_jump_table") != std::string::npos);
+  BOOST_CHECK_EQUAL(plain.GetSize(), jump.GetSize());
+
+  std::vector<std::string> queries = keys;
+  queries.insert(queries.end(), {"ac", "abce", "c", "zy", "\xc3", "\xc3\xa5", "\xe2\x82", "key-", "key-10000"});
+
+  for (const auto& query : queries) {
+    BOOST_CHECK_EQUAL(plain.Contains(query), jump.Contains(query));
+    const match_t expected_match = plain[query];
+    const match_t actual_match = jump[query];
+    BOOST_CHECK_EQUAL(expected_match == nullptr, actual_match == nullptr);
+    if (expected_match && actual_match) {
+      BOOST_CHECK_EQUAL(expected_match->GetValueAsString(), actual_match->GetValueAsString());
+    }
+
+    const auto expected_completions = collect_matches(plain.GetPrefixCompletion(query));
+    const auto actual_completions = collect_matches(jump.GetPrefixCompletion(query));
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected_completions.begin(), expected_completions.end(),
+                                  actual_completions.begin(), actual_completions.end());
+  }
+
+  // fuzzy matching requires valid utf-8 and a minimum_exact_prefix between 1 and the number of code points
+  for (const auto& query : keys) {
+    const size_t code_points =
+        std::count_if(query.begin(), query.end(), [](const char c) { return (c & 0xC0) != 0x80; });
+
+    for (size_t exact_prefix = 1; exact_prefix <= std::min<size_t>(code_points, 3); ++exact_prefix) {
+      const auto expected_fuzzy = collect_matches(plain.GetFuzzy(query, 1, exact_prefix));
+      const auto actual_fuzzy = collect_matches(jump.GetFuzzy(query, 1, exact_prefix));
+      BOOST_CHECK_EQUAL_COLLECTIONS(expected_fuzzy.begin(), expected_fuzzy.end(), actual_fuzzy.begin(),
+                                    actual_fuzzy.end());
+    }
+  }
+
+  const auto expected_many = plain.ContainsMany(queries);
+  const auto actual_many = jump.ContainsMany(queries);
+  BOOST_CHECK(expected_many == actual_many);
+
+  BOOST_CHECK(std::remove(file_name_plain.c_str()) == 0);
+  BOOST_CHECK(std::remove(file_name_jump.c_str()) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(key_filter) {
+  std::vector<std::string> keys = {"", "a", "ab", "abc", "\xc3\xa4", "\xe2\x82\xac" "uro"};
+  for (size_t i = 0; i < 5000; ++i) {
+    keys.push_back("key-" + std::to_string(i));
+  }
+
+  const std::string file_name_plain = compile_to_temp_file(keys, {{"memory_limit_mb", "10"}});
+  const std::string file_name_filter = compile_to_temp_file(
+      keys, {{"memory_limit_mb", "10"}, {KEY_FILTER_KEY, "true"}, {ROOT_JUMP_TABLE_KEY, "true"}});
+
+  const Dictionary plain(file_name_plain);
+  const Dictionary filter(file_name_filter);
+
+  BOOST_CHECK(plain.GetStatistics().find("key_filter") == std::string::npos);
+  BOOST_CHECK(filter.GetStatistics().find("key_filter") != std::string::npos);
+  BOOST_CHECK_EQUAL(plain.GetSize(), filter.GetSize());
+
+  std::vector<std::string> queries = keys;
+  for (size_t i = 5000; i < 10000; ++i) {
+    queries.push_back("key-" + std::to_string(i));
+  }
+  queries.insert(queries.end(), {"ac", "abce", "\xc3", "key-"});
+
+  for (const auto& query : queries) {
+    BOOST_CHECK_EQUAL(plain.Contains(query), filter.Contains(query));
+    const match_t expected_match = plain[query];
+    const match_t actual_match = filter[query];
+    BOOST_CHECK_EQUAL(expected_match == nullptr, actual_match == nullptr);
+    if (expected_match && actual_match) {
+      BOOST_CHECK_EQUAL(expected_match->GetValueAsString(), actual_match->GetValueAsString());
+    }
+    BOOST_CHECK_EQUAL(collect_matches(plain.Get(query)).size(), collect_matches(filter.Get(query)).size());
+  }
+
+  const auto expected_many = plain.ContainsMany(queries);
+  const auto actual_many = filter.ContainsMany(queries);
+  BOOST_CHECK(expected_many == actual_many);
+
+  // no false negatives, few false positives
+  fsa::automata_t fsa(new fsa::Automata(file_name_filter));
+  size_t false_positives = 0;
+  for (const auto& key : keys) {
+    BOOST_CHECK(!plain.Contains(key) || fsa->MayContain(fsa->GetStartState(), key));
+  }
+  for (size_t i = 0; i < 10000; ++i) {
+    if (fsa->MayContain(fsa->GetStartState(), "missing-" + std::to_string(i))) {
+      ++false_positives;
+    }
+  }
+  BOOST_CHECK_LT(false_positives, 300);
+
+  BOOST_CHECK(std::remove(file_name_plain.c_str()) == 0);
+  BOOST_CHECK(std::remove(file_name_filter.c_str()) == 0);
+}
+
+std::vector<std::string> collect_entries(const std::string& file_name) {
+  fsa::automata_t fsa(new fsa::Automata(file_name));
+  std::vector<std::string> entries;
+  for (fsa::EntryIterator it(fsa), end_it; it != end_it; ++it) {
+    entries.push_back(it.GetKey() + ":" + it.GetValueAsString());
+  }
+  return entries;
+}
+
+void parallel_compile_test(const std::vector<std::string>& keys, const keyvi::util::parameters_t& params) {
+  keyvi::util::parameters_t parallel_params(params);
+  parallel_params[PARALLEL_COMPILE_KEY] = "4";
+
+  const std::string file_name_plain = compile_to_temp_file(keys, params);
+  const std::string file_name_parallel = compile_to_temp_file(keys, parallel_params);
+
+  const auto expected_entries = collect_entries(file_name_plain);
+  const auto actual_entries = collect_entries(file_name_parallel);
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected_entries.begin(), expected_entries.end(), actual_entries.begin(),
+                                actual_entries.end());
+
+  const Dictionary plain(file_name_plain);
+  const Dictionary parallel(file_name_parallel);
+  BOOST_CHECK_EQUAL(plain.GetSize(), parallel.GetSize());
+
+  for (const auto& query : {"", "a", "ab", "k", "key-1", "key-12", "\xc3", "zz", "missing"}) {
+    BOOST_CHECK_EQUAL(plain.Contains(query), parallel.Contains(query));
+    const auto expected_completions = collect_matches(plain.GetPrefixCompletion(query));
+    const auto actual_completions = collect_matches(parallel.GetPrefixCompletion(query));
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected_completions.begin(), expected_completions.end(),
+                                  actual_completions.begin(), actual_completions.end());
+  }
+
+  BOOST_CHECK(std::remove(file_name_plain.c_str()) == 0);
+  BOOST_CHECK(std::remove(file_name_parallel.c_str()) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_compile) {
+  std::vector<std::string> keys = {"",  "a",  "ab", "abc", "b", "ba", "key-1", "key-1", "zz", "zzz", "\xc3\xa4",
+                                   "\xc3\xa4" "b", "\xe2\x82\xac" "uro"};
+  for (size_t i = 0; i < 5000; ++i) {
+    keys.push_back("key-" + std::to_string(i));
+    keys.push_back(std::string(1, static_cast<char>('a' + i % 26)) + "-suffix-" + std::to_string(i % 100));
+  }
+
+  parallel_compile_test(keys, {{"memory_limit_mb", "10"}});
+  parallel_compile_test(keys, {{"memory_limit_mb", "10"}, {MINIMIZATION_KEY, "off"}});
+
+  // chunks on disk get merged per partition
+  for (size_t i = 0; i < 50000; ++i) {
+    keys.push_back("loooooooooooooooonnnnnnnngggggggg_key-" + std::to_string(i));
+  }
+  parallel_compile_test(keys, {{MEMORY_LIMIT_KEY, std::to_string(1024 * 1024)}});
+}
+
+BOOST_AUTO_TEST_CASE(parallel_compile_key_filter) {
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < 5000; ++i) {
+    keys.push_back(std::to_string(i) + "-key");
+  }
+
+  const std::string file_name = compile_to_temp_file(
+      keys, {{"memory_limit_mb", "10"}, {PARALLEL_COMPILE_KEY, "3"}, {KEY_FILTER_KEY, "true"},
+             {ROOT_JUMP_TABLE_KEY, "true"}});
+
+  const Dictionary d(file_name);
+  BOOST_CHECK(d.GetStatistics().find("key_filter") != std::string::npos);
+  BOOST_CHECK_EQUAL(keys.size(), d.GetSize());
+
+  fsa::automata_t fsa(new fsa::Automata(file_name));
+  for (const auto& key : keys) {
+    BOOST_CHECK(fsa->MayContain(fsa->GetStartState(), key));
+    BOOST_CHECK(d.Contains(key));
+  }
+  BOOST_CHECK(!d.Contains("5000-key"));
+
+  BOOST_CHECK(std::remove(file_name.c_str()) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_compile_inner_weights) {
+  std::vector<std::pair<std::string, uint32_t>> test_data;
+  for (size_t i = 0; i < 2000; ++i) {
+    // long keys, weights are only stored up to a depth of 30
+    test_data.emplace_back(std::to_string(i % 10) + "-a-long-common-part-of-the-key-" + std::to_string(i), i % 77);
+    test_data.emplace_back(std::to_string(i % 7) + "-" + std::to_string(i), i % 13);
+  }
+
+  std::vector<std::string> file_names;
+  for (const auto& parallel_compile : {"0", "4"}) {
+    DictionaryCompiler<dictionary_type_t::INT_WITH_WEIGHTS> compiler(
+        keyvi::util::parameters_t({{"memory_limit_mb", "10"}, {PARALLEL_COMPILE_KEY, parallel_compile}}));
+
+    for (const auto& p : test_data) {
+      compiler.Add(p.first, p.second);
+    }
+    compiler.Compile();
+
+    boost::filesystem::path temp_path = boost::filesystem::temp_directory_path();
+    temp_path /= boost::filesystem::unique_path("dictionary-unit-test-dictionarycompiler-%%%%-%%%%-%%%%-%%%%");
+    file_names.push_back(temp_path.string());
+    compiler.WriteToFile(file_names.back());
+  }
+
+  const auto expected_entries = collect_entries(file_names[0]);
+  const auto actual_entries = collect_entries(file_names[1]);
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected_entries.begin(), expected_entries.end(), actual_entries.begin(),
+                                actual_entries.end());
+
+  const fsa::automata_t plain(new fsa::Automata(file_names[0]));
+  const fsa::automata_t parallel(new fsa::Automata(file_names[1]));
+  BOOST_CHECK_EQUAL(plain->GetInnerWeight(plain->GetStartState()),
+                    parallel->GetInnerWeight(parallel->GetStartState()));
+
+  for (const auto& p : test_data) {
+    for (size_t length = 1; length <= p.first.size(); ++length) {
+      const std::string prefix = p.first.substr(0, length);
+      BOOST_CHECK_EQUAL(plain->GetInnerWeight(DCTTestHelper::GetStateIdForPrefix(plain, prefix)),
+                        parallel->GetInnerWeight(DCTTestHelper::GetStateIdForPrefix(parallel, prefix)));
+    }
+  }
+
+  for (const auto& file_name : file_names) {
+    BOOST_CHECK(std::remove(file_name.c_str()) == 0);
+  }
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(MultipleCompile, DictT, json_types) {
   DictT compiler(keyvi::util::parameters_t({{"memory_limit_mb", "10"}}));
 
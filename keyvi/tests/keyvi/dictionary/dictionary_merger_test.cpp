@@ -46,8 +46,11 @@ BOOST_AUTO_TEST_CASE(MergeKeyOnlyDicts) {
   std::vector<std::string> test_data2 = {"aaaaz", "aabbe", "cdddefgh"};
   testing::TempDictionary dictionary2(&test_data2);
 
-  keyvi::util::parameters_t merge_configurations[] = {{{"memory_limit_mb", "10"}},
-                                                      {{"memory_limit_mb", "10"}, {"merge_mode", "append"}}};
+  keyvi::util::parameters_t merge_configurations[] = {
+      {{"memory_limit_mb", "10"}},
+      {{"memory_limit_mb", "10"}, {"merge_mode", "append"}},
+      {{"memory_limit_mb", "10"}, {"merge_rate_limit_mb", "100"}},
+      {{"memory_limit_mb", "10"}, {"merge_mode", "append"}, {"merge_rate_limit_mb", "100"}}};
 
   for (const auto& params : merge_configurations) {
     DictionaryMerger<> merger(params);
@@ -0,0 +1,250 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * dictionary_relayout_test.cpp
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/dictionary/dictionary.h"
+#include "keyvi/dictionary/dictionary_compiler.h"
+#include "keyvi/dictionary/dictionary_relayout.h"
+#include "keyvi/dictionary/dictionary_types.h"
+#include "keyvi/dictionary/fsa/automata.h"
+#include "keyvi/dictionary/fsa/entry_iterator.h"
+#include "keyvi/util/configuration.h"
+
+namespace keyvi {
+namespace dictionary {
+
+BOOST_AUTO_TEST_SUITE(DictionaryRelayoutTests)
+
+std::string temp_file_name() {
+  boost::filesystem::path temp_path = boost::filesystem::temp_directory_path();
+  temp_path /= boost::filesystem::unique_path("dictionary-unit-test-relayout-%%%%-%%%%-%%%%-%%%%");
+  return temp_path.string();
+}
+
+void check_equal_entries(const std::string& expected_file_name, const std::string& actual_file_name) {
+  fsa::automata_t expected_fsa(new fsa::Automata(expected_file_name));
+  fsa::automata_t actual_fsa(new fsa::Automata(actual_file_name));
+
+  BOOST_CHECK_EQUAL(expected_fsa->GetNumberOfKeys(), actual_fsa->GetNumberOfKeys());
+
+  fsa::EntryIterator expected_it(expected_fsa);
+  fsa::EntryIterator actual_it(actual_fsa);
+  const fsa::EntryIterator end_it;
+
+  while (expected_it != end_it && actual_it != end_it) {
+    BOOST_CHECK_EQUAL(expected_it.GetKey(), actual_it.GetKey());
+    BOOST_CHECK_EQUAL(expected_it.GetValueAsString(), actual_it.GetValueAsString());
+    ++expected_it;
+    ++actual_it;
+  }
+
+  BOOST_CHECK(expected_it == end_it);
+  BOOST_CHECK(actual_it == end_it);
+}
+
+BOOST_AUTO_TEST_CASE(RelayoutBreadthFirst) {
+  DictionaryCompiler<dictionary_type_t::JSON> compiler(keyvi::util::parameters_t({{"memory_limit_mb", "10"}}));
+
+  for (size_t i = 0; i < 5000; ++i) {
+    compiler.Add("key-" + std::to_string(i * 7), "{\"id\":" + std::to_string(i) + "}");
+  }
+  compiler.Add("", "\"empty\"");
+  compiler.Add(std::string("zero\0byte", 9), "\"zero\"");
+  compiler.Compile();
+
+  const std::string file_name = temp_file_name();
+  compiler.WriteToFile(file_name);
+
+  const std::string relayout_file_name = temp_file_name();
+  {
+    DictionaryRelayout relayout(file_name, {{"memory_limit_mb", "10"}});
+    relayout.Relayout();
+    relayout.WriteToFile(relayout_file_name);
+  }
+
+  check_equal_entries(file_name, relayout_file_name);
+
+  Dictionary d(relayout_file_name);
+  BOOST_CHECK(d.Contains("key-700"));
+  BOOST_CHECK(!d.Contains("key-701"));
+  BOOST_CHECK(d.Contains(std::string("zero\0byte", 9)));
+  BOOST_CHECK(!d.Contains("zero"));
+  BOOST_CHECK_EQUAL("{\"id\":100}", d["key-700"]->GetValueAsString());
+
+  std::remove(file_name.c_str());
+  std::remove(relayout_file_name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(RelayoutWithAccessProfile) {
+  CompletionDictionaryCompiler compiler(
+      keyvi::util::parameters_t({{"memory_limit_mb", "10"}, {ROOT_JUMP_TABLE_KEY, "true"}, {KEY_FILTER_KEY, "true"}}));
+
+  for (size_t i = 0; i < 5000; ++i) {
+    compiler.Add("cold key number " + std::to_string(i), i);
+  }
+  const std::string hot_key = "a very hot key, which is looked up all the time";
+  compiler.Add(hot_key, 42);
+  compiler.Compile();
+
+  const std::string file_name = temp_file_name();
+  compiler.WriteToFile(file_name);
+
+  const std::string profile_file_name = temp_file_name();
+  {
+    std::ofstream profile(profile_file_name);
+    profile << hot_key << "\t1000\n";
+    profile << "cold key number 42\n";
+  }
+
+  const std::string relayout_file_name = temp_file_name();
+  std::vector<uint64_t> hot_offsets;
+  {
+    DictionaryRelayout relayout(file_name, {{"memory_limit_mb", "10"}});
+    relayout.AddAccessProfile(profile_file_name);
+    relayout.Relayout();
+    relayout.WriteToFile(relayout_file_name);
+
+    fsa::automata_t fsa(new fsa::Automata(file_name));
+    uint64_t state = fsa->GetStartState();
+    for (const char c : hot_key) {
+      hot_offsets.push_back(relayout.GetNewOffset(state));
+      state = fsa->TryWalkTransition(state, c);
+    }
+  }
+
+  check_equal_entries(file_name, relayout_file_name);
+
+  // the hot path got written last, so it is packed together with the start state
+  const auto minmax = std::minmax_element(hot_offsets.begin(), hot_offsets.end());
+  BOOST_CHECK_LT(*minmax.second - *minmax.first, 4096);
+
+  Dictionary original(file_name);
+  Dictionary d(relayout_file_name);
+  BOOST_CHECK(d.GetStatistics().find("root_jump_table") != std::string::npos);
+  BOOST_CHECK(d.GetStatistics().find("key_filter") != std::string::npos);
+  BOOST_CHECK_EQUAL("42", d[hot_key]->GetValueAsString());
+  BOOST_CHECK(!d.Contains("cold key number 5000"));
+
+  // inner weights are kept
+  std::vector<std::string> expected_completions;
+  for (const auto& m : original.GetPrefixCompletion("cold key number 4", 10)) {
+    expected_completions.push_back(m->GetMatchedString());
+  }
+  std::vector<std::string> actual_completions;
+  for (const auto& m : d.GetPrefixCompletion("cold key number 4", 10)) {
+    actual_completions.push_back(m->GetMatchedString());
+  }
+  BOOST_CHECK(actual_completions.size() > 0);
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected_completions.begin(), expected_completions.end(), actual_completions.begin(),
+                                actual_completions.end());
+
+  std::remove(file_name.c_str());
+  std::remove(profile_file_name.c_str());
+  std::remove(relayout_file_name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(RelayoutEmpty) {
+  DictionaryCompiler<dictionary_type_t::JSON> compiler(keyvi::util::parameters_t({{"memory_limit_mb", "10"}}));
+  compiler.Compile();
+
+  const std::string file_name = temp_file_name();
+  compiler.WriteToFile(file_name);
+
+  const std::string relayout_file_name = temp_file_name();
+  {
+    DictionaryRelayout relayout(file_name, {{"memory_limit_mb", "10"}});
+    relayout.Relayout();
+    relayout.WriteToFile(relayout_file_name);
+  }
+
+  Dictionary d(relayout_file_name);
+  BOOST_CHECK_EQUAL(0, d.GetSize());
+  BOOST_CHECK(!d.Contains("a"));
+
+  std::remove(file_name.c_str());
+  std::remove(relayout_file_name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(RelayoutExceedsMemoryLimit) {
+  DictionaryCompiler<dictionary_type_t::JSON> compiler(keyvi::util::parameters_t({{"memory_limit_mb", "10"}}));
+
+  for (size_t i = 0; i < 5000; ++i) {
+    compiler.Add("key-" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+  }
+  compiler.Compile();
+
+  const std::string file_name = temp_file_name();
+  compiler.WriteToFile(file_name);
+
+  {
+    DictionaryRelayout relayout(file_name, {{"memory_limit_kb", "64"}});
+    BOOST_CHECK_THROW(relayout.Relayout(), relayout_exception);
+  }
+
+  std::remove(file_name.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(RelayoutProfileCountsTowardsMemoryLimit) {
+  DictionaryCompiler<dictionary_type_t::JSON> compiler(keyvi::util::parameters_t({{"memory_limit_mb", "10"}}));
+
+  for (size_t i = 0; i < 50000; ++i) {
+    compiler.Add("key-" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+  }
+  compiler.Compile();
+
+  const std::string file_name = temp_file_name();
+  compiler.WriteToFile(file_name);
+
+  // find the smallest memory limit that fits the state graph without a profile
+  size_t memory_limit_kb = 1024;
+  for (;; memory_limit_kb += 256) {
+    DictionaryRelayout relayout(file_name, {{"memory_limit_kb", std::to_string(memory_limit_kb)}});
+    try {
+      relayout.Relayout();
+      break;
+    } catch (const relayout_exception&) {
+    }
+  }
+
+  {
+    DictionaryRelayout relayout(file_name, {{"memory_limit_kb", std::to_string(memory_limit_kb)}});
+    for (size_t i = 0; i < 50000; ++i) {
+      relayout.AddAccess("key-" + std::to_string(i));
+    }
+    BOOST_CHECK_THROW(relayout.Relayout(), relayout_exception);
+  }
+
+  std::remove(file_name.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace dictionary */
+} /* namespace keyvi */
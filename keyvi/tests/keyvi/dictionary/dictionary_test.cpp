@@ -24,6 +24,7 @@
  */
 
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
@@ -304,6 +305,120 @@ BOOST_AUTO_TEST_CASE(DictContainsEmptyDict) {
   BOOST_CHECK_EQUAL(d->Contains("\x00"), false);  // NOLINT: testing NUL
 }
 
+BOOST_AUTO_TEST_CASE(DictGetMany) {
+  std::vector<std::pair<std::string, uint32_t>> test_data = {
+      {"test", 22}, {"otherkey", 24}, {"other", 444}, {"bar", 200}, {"barfoo", 201},
+  };
+
+  const testing::TempDictionary dictionary(&test_data);
+  const dictionary_t d(new Dictionary(dictionary.GetFsa()));
+
+  // more keys than lanes to exercise lane refill
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < 10; ++i) {
+    keys.push_back("other");
+    keys.push_back("othe");
+    keys.push_back("barfoo");
+    keys.push_back("");
+    keys.push_back("barfoo2");
+  }
+
+  auto matches = d->GetMany(keys);
+  auto contains = d->ContainsMany(keys);
+  BOOST_CHECK_EQUAL(keys.size(), matches.size());
+  BOOST_CHECK_EQUAL(keys.size(), contains.size());
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    BOOST_CHECK_EQUAL(d->Contains(keys[i]), contains[i]);
+    BOOST_CHECK_EQUAL(d->Contains(keys[i]), static_cast<bool>(matches[i]));
+    if (matches[i]) {
+      BOOST_CHECK_EQUAL(keys[i], matches[i]->GetMatchedString());
+      BOOST_CHECK_EQUAL((*d)[keys[i]]->GetValueAsString(), matches[i]->GetValueAsString());
+    }
+  }
+
+  BOOST_CHECK(d->GetMany({}).empty());
+
+  std::vector<std::pair<std::string, uint32_t>> empty_test_data;
+  const testing::TempDictionary empty_dictionary(&empty_test_data);
+  const dictionary_t empty_d(new Dictionary(empty_dictionary.GetFsa()));
+  contains = empty_d->ContainsMany({"", "a"});
+  BOOST_CHECK(!contains[0]);
+  BOOST_CHECK(!contains[1]);
+}
+
+BOOST_AUTO_TEST_CASE(DictGetValueAsStringView) {
+  std::vector<std::pair<std::string, std::string>> test_data = {
+      {"abc", "{\"a\":2}"}, {"abbc", "{\"b\":3}"}, {"empty", ""}};
+  testing::TempDictionary json_dictionary = testing::TempDictionary::makeTempDictionaryFromJson(&test_data);
+  const dictionary_t d(new Dictionary(json_dictionary.GetFsa()));
+
+  std::string_view view;
+  for (const auto& key : {"abc", "abbc", "empty"}) {
+    match_t m = (*d)[key];
+    BOOST_CHECK(m->GetRawValueAsStringView(&view));
+    BOOST_CHECK_EQUAL(m->GetRawValueAsString(), std::string(view));
+    BOOST_CHECK(m->GetMsgPackedValueAsStringView(&view));
+    BOOST_CHECK_EQUAL(m->GetMsgPackedValueAsString(), std::string(view));
+    BOOST_CHECK(!m->GetValueAsStringView(&view));
+  }
+
+  const testing::TempDictionary string_dictionary(&test_data);
+  const dictionary_t d2(new Dictionary(string_dictionary.GetFsa()));
+  match_t m = (*d2)["abbc"];
+  BOOST_CHECK(m->GetValueAsStringView(&view));
+  BOOST_CHECK_EQUAL("{\"b\":3}", view);
+
+  // a match without a dictionary holds the raw value itself
+  Match m2;
+  m2.SetRawValue(m->GetRawValueAsString());
+  BOOST_CHECK(m2.GetRawValueAsStringView(&view));
+  BOOST_CHECK_EQUAL(m->GetRawValueAsString(), std::string(view));
+  BOOST_CHECK(!m2.GetValueAsStringView(&view));
+}
+
+BOOST_AUTO_TEST_CASE(DictForEachMatch) {
+  std::vector<std::pair<std::string, std::string>> test_data = {
+      {"pizzeria:u281z7hfvzq9", "pizzeria in Munich"}, {"pizzeria:u0vu7uqfyqkg", "pizzeria in Mainz"},
+      {"pizzeria:u33db8mmzj1t", "pizzeria in Berlin"}, {"pizzeria:u0yjjd65eqy0", "pizzeria in Frankfurt"},
+      {"pizzeria:u28db8mmzj1t", "pizzeria in Munich"}, {"pizzeria:u2817uqfyqkg", "pizzeria in Munich"},
+      {"pizzeria:u281wu8bmmzq", "pizzeria in Munich"}};
+
+  const testing::TempDictionary dictionary(&test_data);
+  const dictionary_t d(new Dictionary(dictionary.GetFsa()));
+
+  std::vector<std::pair<std::string, std::string>> expected;
+  for (const auto& m : d->GetAllItems()) {
+    expected.emplace_back(m->GetMatchedString(), m->GetValueAsString());
+  }
+
+  std::vector<std::pair<std::string, std::string>> visited;
+  d->ForEachMatch([&visited](const MatchView& m) {
+    visited.emplace_back(m.GetMatchedString(), m.GetValueAsString());
+  });
+  BOOST_CHECK_EQUAL(test_data.size(), visited.size());
+  BOOST_CHECK(expected == visited);
+
+  size_t calls = 0;
+  d->ForEachMatch([&calls](const MatchView& m) { return ++calls < 3; });
+  BOOST_CHECK_EQUAL(3, calls);
+
+  // near matching
+  for (const auto& query : {"pizzeria:u281wu88kekq", "pizzeria:u2815u88kekq", "pizzeria:u281wu8bmmzq", "pizzeria"}) {
+    for (const bool greedy : {false, true}) {
+      std::vector<std::string> expected_near;
+      for (const auto& m : d->GetNear(query, 8, greedy)) {
+        expected_near.push_back(m->GetMatchedString());
+      }
+
+      std::vector<std::string> visited_near;
+      auto matcher = matching::NearMatching<>::FromSingleFsa(d->GetFsa(), query, 8, greedy);
+      matcher.ForEachMatch([&visited_near](const MatchView& m) { visited_near.emplace_back(m.GetMatchedString()); });
+      BOOST_CHECK(expected_near == visited_near);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } /* namespace dictionary */
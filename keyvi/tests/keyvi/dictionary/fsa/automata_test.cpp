@@ -94,6 +94,36 @@ BOOST_AUTO_TEST_CASE(EmptyTest) {
   BOOST_CHECK(dictionary.GetFsa()->Empty());
 }
 
+BOOST_AUTO_TEST_CASE(HugePagesLoadingStrategiesTest) {
+  std::vector<std::pair<std::string, uint32_t>> test_data = {
+      {"aaaa", 22}, {"aabb", 24}, {"aabc", 444}, {"bbcd", 2}, {"cdef", 3},
+  };
+  testing::TempDictionary dictionary(&test_data);
+  automata_t reference = dictionary.GetFsa();
+
+  for (const auto strategy :
+       {loading_strategy_types::huge_pages_key_part, loading_strategy_types::copy_key_part_huge_pages}) {
+    automata_t f = std::make_shared<Automata>(dictionary.GetFileName(), strategy);
+
+    BOOST_CHECK_EQUAL(reference->GetStartState(), f->GetStartState());
+    for (const auto& key_value : test_data) {
+      uint64_t state = f->GetStartState();
+      uint64_t reference_state = reference->GetStartState();
+
+      for (const char c : key_value.first) {
+        state = f->TryWalkTransition(state, c);
+        reference_state = reference->TryWalkTransition(reference_state, c);
+        BOOST_CHECK_EQUAL(reference_state, state);
+      }
+      BOOST_CHECK(f->IsFinalState(state));
+      BOOST_CHECK_EQUAL(reference->GetValueAsString(reference->GetStateValue(reference_state)),
+                        f->GetValueAsString(f->GetStateValue(state)));
+    }
+
+    BOOST_CHECK_EQUAL(0, f->TryWalkTransition(f->GetStartState(), 'z'));
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } /* namespace fsa */
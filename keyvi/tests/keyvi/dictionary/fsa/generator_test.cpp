@@ -23,9 +23,12 @@
  *      Author: hendrik
  */
 
+#include <string>
+
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include "keyvi/dictionary/dictionary.h"
 #include "keyvi/dictionary/fsa/automata.h"
 #include "keyvi/dictionary/fsa/entry_iterator.h"
 #include "keyvi/dictionary/fsa/generator.h"
@@ -267,6 +270,33 @@ BOOST_AUTO_TEST_CASE(state_exception_handling) {
   BOOST_CHECK_THROW(g.Add("ghij", handle), generator_exception);
 }
 
+BOOST_AUTO_TEST_CASE(key_filter_memory_limit) {
+  // the key filter is taken from the memory limit, 10M keys need about 12 MB
+  BOOST_CHECK_THROW(Generator<internal::SparseArrayPersistence<>>(keyvi::util::parameters_t(
+                        {{"memory_limit_mb", "10"}, {KEY_FILTER_KEY, "true"}, {KEY_FILTER_KEYS_KEY, "10000000"}})),
+                    std::invalid_argument);
+
+  Generator<internal::SparseArrayPersistence<>> g(keyvi::util::parameters_t(
+      {{"memory_limit_mb", "10"}, {KEY_FILTER_KEY, "true"}, {KEY_FILTER_KEYS_KEY, "2"}}));
+  g.Add("abcd");
+  g.Add("efgh");
+  // more keys than announced only raise the false positive rate
+  g.Add("ijkl");
+  g.CloseFeeding();
+
+  const std::string filename = (boost::filesystem::temp_directory_path() / "key_filter_memory_limit.kv").string();
+  g.WriteToFile(filename);
+
+  Dictionary d(filename);
+  BOOST_CHECK(d.GetStatistics().find("key_filter") != std::string::npos);
+  BOOST_CHECK(d.Contains("abcd"));
+  BOOST_CHECK(d.Contains("efgh"));
+  BOOST_CHECK(d.Contains("ijkl"));
+  BOOST_CHECK(!d.Contains("mnop"));
+
+  boost::filesystem::remove(filename);
+}
+
 BOOST_AUTO_TEST_CASE(value_handle) {
   ValueHandle handle = {0, 0, false, false};
   ValueHandle handle2 = {1, 0, false, false};
@@ -24,6 +24,8 @@
 
 #include "keyvi/dictionary/fsa/internal/json_value_store.h"
 
+#include <string_view>
+
 #include <boost/filesystem.hpp>
 #include <boost/interprocess/file_mapping.hpp>
 #include <boost/test/unit_test.hpp>
@@ -147,6 +149,51 @@ BOOST_AUTO_TEST_CASE(persistence) {
   std::remove(filename.c_str());
 }
 
+BOOST_AUTO_TEST_CASE(persistenceStringView) {
+  JsonValueStore json_value_store(keyvi::util::parameters_t{
+      {TEMPORARY_PATH_KEY, "/tmp"}, {"memory_limit_mb", "10"}, {COMPRESSION_KEY, "zlib"}});
+  bool no_minimization = false;
+  std::string value = "{\"";
+  value += std::string(60000, 'a');
+  value += "\":42}";
+
+  uint64_t v = json_value_store.AddValue(value, &no_minimization);
+  uint64_t w = json_value_store.AddValue("{\"mytestvalue2\":23}", &no_minimization);
+
+  boost::filesystem::path temp_path = boost::filesystem::temp_directory_path();
+
+  temp_path /= boost::filesystem::unique_path("dictionary-unit-test-temp-dictionary-%%%%-%%%%-%%%%-%%%%");
+
+  std::string filename = temp_path.string();
+
+  std::ofstream out_stream(filename, std::ios::binary);
+  json_value_store.Write(out_stream);
+  out_stream.close();
+
+  std::ifstream in_stream(filename, std::ios::binary);
+  auto file_mapping = new boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only);
+
+  fsa::internal::ValueStoreProperties properties = fsa::internal::ValueStoreProperties::FromJson(in_stream);
+
+  JsonValueStoreReader reader(file_mapping, properties, loading_strategy_types::lazy);
+
+  std::string_view view;
+
+  // small value, stored uncompressed
+  BOOST_CHECK(reader.GetRawValueAsStringView(w, &view));
+  BOOST_CHECK_EQUAL(reader.GetRawValueAsString(w), std::string(view));
+  BOOST_CHECK(reader.GetMsgPackedValueAsStringView(w, &view));
+  BOOST_CHECK_EQUAL(reader.GetMsgPackedValueAsString(w), std::string(view));
+
+  // large value, stored compressed, a msgpack view requires decompression
+  BOOST_CHECK(reader.GetRawValueAsStringView(v, &view));
+  BOOST_CHECK_EQUAL(reader.GetRawValueAsString(v), std::string(view));
+  BOOST_CHECK(!reader.GetMsgPackedValueAsStringView(v, &view));
+  BOOST_CHECK(!reader.GetValueAsStringView(v, &view));
+
+  std::remove(filename.c_str());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } /* namespace internal */
@@ -23,9 +23,13 @@
  *      Author: hendrik
  */
 
+#include <cstring>
+#include <vector>
+
 #include <boost/interprocess/mapped_region.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include "keyvi/dictionary/fsa/internal/huge_page_region.h"
 #include "keyvi/dictionary/fsa/internal/memory_map_flags.h"
 
 namespace keyvi {
@@ -155,6 +159,60 @@ BOOST_AUTO_TEST_CASE(MemoryMapFlagsTestpopulate_key_part_no_readahead_value_part
   BOOST_CHECK(value_advise_flags == boost::interprocess::mapped_region::advice_types::advice_random);
 }
 
+BOOST_AUTO_TEST_CASE(MemoryMapFlagsTesthuge_pages_key_part) {
+  loading_strategy_types strategy = loading_strategy_types::huge_pages_key_part;
+  auto key_advise_flags = MemoryMapFlags::FSAGetMemoryMapAdvices(strategy);
+  auto value_advise_flags = MemoryMapFlags::ValuesGetMemoryMapAdvices(strategy);
+
+#if not defined(OS_MACOSX)
+  int key_flags = MemoryMapFlags::FSAGetMemoryMapOptions(strategy);
+  int value_flags = MemoryMapFlags::ValuesGetMemoryMapOptions(strategy);
+  // no map populate
+  BOOST_CHECK((key_flags & MAP_POPULATE) == 0);
+  BOOST_CHECK((value_flags & MAP_POPULATE) == 0);
+#endif
+
+  BOOST_CHECK(key_advise_flags == boost::interprocess::mapped_region::advice_types::advice_normal);
+  BOOST_CHECK(value_advise_flags == boost::interprocess::mapped_region::advice_types::advice_normal);
+  BOOST_CHECK(MemoryMapFlags::FSAUseHugePages(strategy));
+  BOOST_CHECK(!MemoryMapFlags::FSACopyToHugePages(strategy));
+}
+
+BOOST_AUTO_TEST_CASE(MemoryMapFlagsTestcopy_key_part_huge_pages) {
+  loading_strategy_types strategy = loading_strategy_types::copy_key_part_huge_pages;
+  auto key_advise_flags = MemoryMapFlags::FSAGetMemoryMapAdvices(strategy);
+  auto value_advise_flags = MemoryMapFlags::ValuesGetMemoryMapAdvices(strategy);
+
+#if not defined(OS_MACOSX)
+  int key_flags = MemoryMapFlags::FSAGetMemoryMapOptions(strategy);
+  int value_flags = MemoryMapFlags::ValuesGetMemoryMapOptions(strategy);
+  // map populate for the key part, which gets copied
+  BOOST_CHECK((key_flags & MAP_POPULATE));
+  BOOST_CHECK((value_flags & MAP_POPULATE) == 0);
+#endif
+
+  BOOST_CHECK(key_advise_flags == boost::interprocess::mapped_region::advice_types::advice_sequential);
+  BOOST_CHECK(value_advise_flags == boost::interprocess::mapped_region::advice_types::advice_normal);
+  BOOST_CHECK(!MemoryMapFlags::FSAUseHugePages(strategy));
+  BOOST_CHECK(MemoryMapFlags::FSACopyToHugePages(strategy));
+}
+
+BOOST_AUTO_TEST_CASE(MemoryMapFlagsTestHugePageRegion) {
+  std::vector<unsigned char> data(3 * 1024 * 1024 + 17);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<unsigned char>(i * 7);
+  }
+
+  HugePageRegion region(data.data(), data.size());
+  BOOST_CHECK(region.get_address() != nullptr);
+  BOOST_CHECK(std::memcmp(data.data(), region.get_address(), data.size()) == 0);
+
+  HugePageRegion moved;
+  moved = std::move(region);
+  BOOST_CHECK(region.get_address() == nullptr);
+  BOOST_CHECK(std::memcmp(data.data(), moved.get_address(), data.size()) == 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } /* namespace internal */
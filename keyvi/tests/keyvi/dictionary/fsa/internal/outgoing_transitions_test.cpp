@@ -0,0 +1,98 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * outgoing_transitions_test.cpp
+ */
+
+#include <cstdlib>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/dictionary/fsa/internal/outgoing_transitions.h"
+
+namespace keyvi {
+namespace dictionary {
+namespace fsa {
+namespace internal {
+
+BOOST_AUTO_TEST_SUITE(OutgoingTransitionsTests)
+
+void CheckKernel(outgoing_transitions_kernel_t kernel) {
+  std::srand(42);
+  // unaligned on purpose
+  std::vector<unsigned char> labels(256 + 1);
+
+  for (size_t round = 0; round < 100; ++round) {
+    uint64_t expected[4] = {0, 0, 0, 0};
+
+    for (size_t i = 0; i < 256; ++i) {
+      // roughly every 4th label matches
+      labels[i + 1] = (std::rand() % 4 == 0) ? i : static_cast<unsigned char>(std::rand());
+      if (labels[i + 1] == i) {
+        expected[i >> 6] |= 1ULL << (i & 63);
+      }
+    }
+
+    uint64_t bitmap[4];
+    kernel(labels.data() + 1, bitmap);
+
+    for (size_t word = 0; word < 4; ++word) {
+      BOOST_CHECK_EQUAL(expected[word], bitmap[word]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(scalar) { CheckKernel(&GetOutgoingTransitionsScalar); }
+
+BOOST_AUTO_TEST_CASE(dispatched) {
+  CheckKernel(GetOutgoingTransitionsKernel());
+  BOOST_CHECK(GetOutgoingTransitionsKernel() == SelectOutgoingTransitionsKernel());
+}
+
+#if defined(KEYVI_SSE42)
+BOOST_AUTO_TEST_CASE(sse42) { CheckKernel(&GetOutgoingTransitionsSSE42); }
+#endif
+
+#if defined(KEYVI_RUNTIME_DISPATCH)
+BOOST_AUTO_TEST_CASE(avx2) {
+  if (__builtin_cpu_supports("avx2")) {
+    CheckKernel(&GetOutgoingTransitionsAVX2);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(avx512) {
+  if (__builtin_cpu_supports("avx512bw")) {
+    CheckKernel(&GetOutgoingTransitionsAVX512);
+  }
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(count_trailing_zeros) {
+  BOOST_CHECK_EQUAL(0, CountTrailingZeros(1));
+  BOOST_CHECK_EQUAL(5, CountTrailingZeros(0x60));
+  BOOST_CHECK_EQUAL(63, CountTrailingZeros(0x8000000000000000ULL));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace internal */
+} /* namespace fsa */
+} /* namespace dictionary */
+} /* namespace keyvi */
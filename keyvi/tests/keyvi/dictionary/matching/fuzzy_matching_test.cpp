@@ -23,10 +23,15 @@
  */
 
 #include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
 #include "keyvi/dictionary/dictionary.h"
+#include "keyvi/dictionary/match_view.h"
+#include "keyvi/dictionary/matching/fuzzy_automaton_matching.h"
 #include "keyvi/dictionary/matching/fuzzy_matching.h"
 #include "keyvi/testing/temp_dictionary.h"
 
@@ -70,6 +75,25 @@ void test_fuzzy_matching(std::vector<std::pair<std::string, uint32_t>>* test_dat
   }
   BOOST_CHECK(expected_it == expected_sorted.end());
 
+  // test the visitor api
+  std::vector<std::string> visited;
+  auto matcher_visitor = matching::FuzzyMatching<fsa::StateTraverser<>>::FromSingleFsa<fsa::StateTraverser<>>(
+      dictionary.GetFsa(), query, max_edit_distance);
+  matcher_visitor.ForEachMatch([&visited](const MatchView& m) { visited.emplace_back(m.GetMatchedString()); });
+  BOOST_CHECK(expected_sorted == visited);
+
+  // test the automaton based matcher
+  auto matcher_automaton = std::make_shared<matching::FuzzyAutomatonMatching<>>(
+      matching::FuzzyAutomatonMatching<>::FromSingleFsa(dictionary.GetFsa(), query, max_edit_distance));
+  MatchIterator::MatchIteratorPair matcher_automaton_it = MatchIterator::MakeIteratorPair(
+      [matcher_automaton]() { return matcher_automaton->NextMatch(); }, std::move(matcher_automaton->FirstMatch()));
+  expected_it = expected.begin();
+  for (auto m : matcher_automaton_it) {
+    BOOST_CHECK(expected_it != expected.end());
+    BOOST_CHECK_EQUAL(*expected_it++, m->GetMatchedString());
+  }
+  BOOST_CHECK(expected_it == expected.end());
+
   // test with multiple dictionaries
   // split test data into 3 groups with some duplication
   std::vector<std::pair<std::string, uint32_t>> test_data_1;
@@ -117,6 +141,18 @@ void test_fuzzy_matching(std::vector<std::pair<std::string, uint32_t>>* test_dat
     BOOST_CHECK_EQUAL(*expected_it++, m->GetMatchedString());
   }
   BOOST_CHECK(expected_it == expected_sorted.end());
+
+  visited.clear();
+  auto matcher_zipped_visitor = matching::FuzzyMatching<fsa::ZipStateTraverser<fsa::StateTraverser<>>>::FromMulipleFsas<
+      fsa::StateTraverser<>>(fsas, query, max_edit_distance);
+  matcher_zipped_visitor.ForEachMatch([&visited](const MatchView& m) { visited.emplace_back(m.GetMatchedString()); });
+  BOOST_CHECK(expected_sorted == visited);
+
+  visited.clear();
+  auto matcher_zipped_automaton =
+      matching::FuzzyAutomatonMatching<>::FromMulipleFsas<fsa::StateTraverser<>>(fsas, query, max_edit_distance);
+  matcher_zipped_automaton.ForEachMatch([&visited](const MatchView& m) { visited.emplace_back(m.GetMatchedString()); });
+  BOOST_CHECK(expected_sorted == visited);
 }
 
 BOOST_AUTO_TEST_CASE(fuzzy_0) {
@@ -363,6 +399,133 @@ BOOST_AUTO_TEST_CASE(fuzzy_cjk) {
                       std::vector<std::string>{"あsだs", "あsだsっd", "あsだsっdさ", "あsだsdさ"});
 }
 
+BOOST_AUTO_TEST_CASE(fuzzy_automaton_same_as_needleman_wunsch) {
+  std::vector<std::pair<std::string, uint32_t>> test_data = {
+      {"abc", 22},  {"abbc", 24},   {"abbcd", 444},      {"abcde", 200},       {"abdd", 1},
+      {"abcdef", 30}, {"abd", 5},   {"bbcd", 7},         {"bbc", 12},          {"bacd", 3},
+      {"acbd", 4},  {"ab", 100},    {"abcx", 60},        {"abdc", 13},         {"ba", 8},
+      {"a", 3},     {"cabd", 17},   {"abcdefg", 2},      {"\xc3\xa4" "bc", 8}, {"a\xc3\xa4" "bc", 9}};
+  testing::TempDictionary dictionary(&test_data);
+  Dictionary d(dictionary.GetFsa());
+
+  for (const std::string query : {"abcd", "abc", "bacd", "ab", "abdc", "\xc3\xa4" "b", "abcdefgh", "xyz", "cadb"}) {
+    for (size_t exact_prefix = 0; exact_prefix < 3; ++exact_prefix) {
+      for (int32_t max_edit_distance = 0; max_edit_distance < 4; ++max_edit_distance) {
+        std::vector<std::pair<std::string, double>> expected;
+        for (auto m : d.GetFuzzy(query, max_edit_distance, exact_prefix)) {
+          expected.emplace_back(m->GetMatchedString(), m->GetScore());
+        }
+
+        std::vector<std::pair<std::string, double>> actual;
+        for (auto m : d.GetFuzzyWithAutomaton(query, max_edit_distance, exact_prefix)) {
+          actual.emplace_back(m->GetMatchedString(), m->GetScore());
+        }
+        BOOST_CHECK(expected == actual);
+      }
+    }
+  }
+}
+
+// a close key with a low weight, far keys with high weights and ties in distance and weight
+std::vector<std::pair<std::string, uint32_t>> top_n_test_data() {
+  return {{"abcd", 5},    {"abc", 80},   {"abce", 50},   {"abcf", 50},           {"abcde", 50},
+          {"xbcd", 10},   {"bacd", 50},  {"bbcd", 50},   {"abdc", 50},           {"ab", 1000},
+          {"abef", 300},  {"xbce", 300}, {"abcdef", 700}, {"zzzz", 999},         {"a", 3},
+          {"abcdefg", 2}, {"\xc3\xa4" "bcd", 50}, {"a\xc3\xa4" "cd", 60}};
+}
+
+BOOST_AUTO_TEST_CASE(fuzzy_top_n_same_as_sorted) {
+  std::vector<std::pair<std::string, uint32_t>> test_data = top_n_test_data();
+  testing::TempDictionary dictionary(&test_data);
+  Dictionary d(dictionary.GetFsa());
+
+  std::vector<std::string> keys;
+  for (const auto& key_value : test_data) {
+    keys.push_back(key_value.first);
+  }
+  testing::TempDictionary key_only_dictionary(&keys);
+  Dictionary key_only(key_only_dictionary.GetFsa());
+
+  for (const std::string query : {"abcd", "abc", "bacd", "ab", "\xc3\xa4" "bcd", "abcdefgh", "xyz"}) {
+    for (size_t exact_prefix = 0; exact_prefix < 3; ++exact_prefix) {
+      for (int32_t max_edit_distance = 0; max_edit_distance < 4; ++max_edit_distance) {
+        // all matches ordered by score and weight
+        std::vector<std::tuple<double, int64_t, std::string>> all_matches;
+        for (auto m : d.GetFuzzy(query, max_edit_distance, exact_prefix)) {
+          all_matches.emplace_back(m->GetScore(), -static_cast<int64_t>(m->GetWeight()), m->GetMatchedString());
+        }
+        std::sort(all_matches.begin(), all_matches.end());
+
+        for (size_t top_n : {1, 3, 100}) {
+          std::vector<std::tuple<double, int64_t, std::string>> actual;
+          for (auto m : d.GetFuzzy(query, max_edit_distance, exact_prefix, top_n)) {
+            actual.emplace_back(m->GetScore(), -static_cast<int64_t>(m->GetWeight()), m->GetMatchedString());
+          }
+
+          // ties in distance and weight can be returned in any order, compare the ranking and check the keys exist
+          BOOST_REQUIRE_EQUAL(std::min(top_n, all_matches.size()), actual.size());
+          for (size_t i = 0; i < actual.size(); ++i) {
+            BOOST_CHECK_EQUAL(std::get<0>(all_matches[i]), std::get<0>(actual[i]));
+            BOOST_CHECK_EQUAL(std::get<1>(all_matches[i]), std::get<1>(actual[i]));
+            BOOST_CHECK(std::find(all_matches.begin(), all_matches.end(), actual[i]) != all_matches.end());
+          }
+
+          // without weights only the scores are ordered
+          std::vector<double> scores;
+          for (auto m : key_only.GetFuzzy(query, max_edit_distance, exact_prefix, top_n)) {
+            scores.push_back(m->GetScore());
+          }
+          BOOST_REQUIRE_EQUAL(actual.size(), scores.size());
+          for (size_t i = 0; i < scores.size(); ++i) {
+            BOOST_CHECK_EQUAL(std::get<0>(all_matches[i]), scores[i]);
+          }
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(fuzzy_top_n_ordering) {
+  std::vector<std::pair<std::string, uint32_t>> test_data = top_n_test_data();
+  testing::TempDictionary dictionary(&test_data);
+  Dictionary d(dictionary.GetFsa());
+
+  std::vector<std::tuple<std::string, double, uint32_t>> actual;
+  for (auto m : d.GetFuzzy("abcd", 2, 0, 12)) {
+    actual.emplace_back(m->GetMatchedString(), m->GetScore(), m->GetWeight());
+  }
+  BOOST_REQUIRE_EQUAL(12, actual.size());
+
+  // the exact match wins despite its low weight, a far key only comes after all close ones
+  BOOST_CHECK(std::make_tuple(std::string("abcd"), 0.0, 5u) == actual[0]);
+  BOOST_CHECK(std::make_tuple(std::string("abc"), 1.0, 80u) == actual[1]);
+  BOOST_CHECK(std::make_tuple(std::string("a\xc3\xa4" "cd"), 1.0, 60u) == actual[2]);
+  BOOST_CHECK(std::make_tuple(std::string("xbcd"), 1.0, 10u) == actual[10]);
+  BOOST_CHECK(std::make_tuple(std::string("ab"), 2.0, 1000u) == actual[11]);
+
+  // 7 keys tie at distance 1 with weight 50, each one is returned once
+  std::vector<std::string> ties;
+  for (size_t i = 3; i < 10; ++i) {
+    BOOST_CHECK_EQUAL(1.0, std::get<1>(actual[i]));
+    BOOST_CHECK_EQUAL(50, std::get<2>(actual[i]));
+    ties.push_back(std::get<0>(actual[i]));
+  }
+  std::sort(ties.begin(), ties.end());
+  const std::vector<std::string> expected_ties = {"abcde", "abce", "abcf", "abdc", "bacd", "bbcd",
+                                                  "\xc3\xa4" "bcd"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected_ties.begin(), expected_ties.end(), ties.begin(), ties.end());
+
+  // a cut within the ties still returns the best ones
+  std::vector<std::string> top_4;
+  for (auto m : d.GetFuzzy("abcd", 2, 0, 4)) {
+    top_4.push_back(m->GetMatchedString());
+  }
+  BOOST_REQUIRE_EQUAL(4, top_4.size());
+  BOOST_CHECK_EQUAL("abcd", top_4[0]);
+  BOOST_CHECK_EQUAL("abc", top_4[1]);
+  BOOST_CHECK(std::find(expected_ties.begin(), expected_ties.end(), top_4[3]) != expected_ties.end());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } /* namespace matching */
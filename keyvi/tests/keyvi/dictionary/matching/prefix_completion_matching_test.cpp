@@ -18,9 +18,13 @@
 #include "keyvi/dictionary/matching/prefix_completion_matching.h"
 
 #include <algorithm>
+#include <string>
+#include <vector>
+
 #include <boost/test/unit_test.hpp>
 
 #include "keyvi/dictionary/dictionary.h"
+#include "keyvi/dictionary/match_view.h"
 #include "keyvi/testing/matching_test_utils.h"
 #include "keyvi/testing/temp_dictionary.h"
 
@@ -57,6 +61,37 @@ BOOST_AUTO_TEST_CASE(prefix_completion_edge_cases) {
   testing::test_matching<matching::PrefixCompletionMatching>(&test_data, " ", {});
 }
 
+BOOST_AUTO_TEST_CASE(prefix_completion_for_each_match) {
+  std::vector<std::pair<std::string, uint32_t>> test_data = {{"aa", 100},    {"aaaa", 1000}, {"aabb", 1001},
+                                                             {"aabc", 1002}, {"aacd", 1030}, {"bbcd", 1040}};
+  testing::TempDictionary dictionary(&test_data);
+
+  std::vector<std::string> visited;
+  auto matcher = PrefixCompletionMatching<>::FromSingleFsa(dictionary.GetFsa(), "aa");
+  matcher.ForEachMatch([&visited](const MatchView& m) { visited.emplace_back(m.GetMatchedString()); });
+  BOOST_CHECK(std::vector<std::string>({"aa", "aacd", "aabc", "aabb", "aaaa"}) == visited);
+
+  // stop early, materialize the match
+  match_t last_match;
+  size_t calls = 0;
+  matcher = PrefixCompletionMatching<>::FromSingleFsa(dictionary.GetFsa(), "aa");
+  matcher.ForEachMatch([&last_match, &calls](const MatchView& m) {
+    ++calls;
+    last_match = m.ToMatch();
+    return calls < 2;
+  });
+  BOOST_CHECK_EQUAL(2, calls);
+  BOOST_CHECK_EQUAL("aacd", last_match->GetMatchedString());
+  BOOST_CHECK_EQUAL(1030, last_match->GetWeight());
+
+  // filter matches
+  visited.clear();
+  matcher = PrefixCompletionMatching<>::FromSingleFsa(dictionary.GetFsa(), "aa");
+  matcher.ForEachMatch([&visited](const MatchView& m) { visited.emplace_back(m.GetMatchedString()); },
+                       [](const MatchView& m) { return m.GetMatchedString().size() == 2; });
+  BOOST_CHECK(std::vector<std::string>({"aacd", "aabc", "aabb", "aaaa"}) == visited);
+}
+
 BOOST_AUTO_TEST_CASE(prefix_completion_cjk) {
   std::vector<std::pair<std::string, uint32_t>> test_data = {
       {"あsだ", 331},       {"あsだs", 23698},    {"あsaだsっdさ", 18838},
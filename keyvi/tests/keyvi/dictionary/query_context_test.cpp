@@ -0,0 +1,123 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * query_context_test.cpp
+ */
+
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/dictionary/dictionary.h"
+#include "keyvi/dictionary/query_context.h"
+#include "keyvi/testing/temp_dictionary.h"
+
+namespace keyvi {
+namespace dictionary {
+
+BOOST_AUTO_TEST_SUITE(QueryContextTests)
+
+using result_t = std::vector<std::tuple<std::string, double, std::string>>;
+
+result_t collect(MatchIterator::MatchIteratorPair matches) {
+  result_t result;
+  for (auto m : matches) {
+    result.emplace_back(m->GetMatchedString(), m->GetScore(), m->GetValueAsString());
+  }
+  return result;
+}
+
+std::vector<std::pair<std::string, uint32_t>> test_data = {
+    {"abc", 22}, {"abbc", 24}, {"abbcd", 444}, {"abcde", 200},
+    {"abdd", 1}, {"abcdef", 30}, {"abd", 5}, {"bbcd", 7},
+    {"bbc", 12}, {"zzz", 1}, {"a", 3}, {"ab", 100},
+    {"abcx", 60}, {"pizza", 11}, {"pizzeria:u2", 9}, {"pizzeria:u28", 3},
+    {"pizzeria:u281", 2}, {"pizzeria:u282", 4}, {"\xc3\xa4" "bc", 8}, {"\xc3\xa4" "bcd", 9}};
+
+BOOST_AUTO_TEST_CASE(SameResultsAsIterators) {
+  testing::TempDictionary dictionary(&test_data);
+  Dictionary d(dictionary.GetFsa());
+  QueryContext context;
+
+  const std::vector<std::string> queries = {"abc", "abd", "ab", "a", "b", "\xc3\xa4" "b", "xyz", "abcdefgh",
+                                            "bbcd", "pizzeria:u283", "pizzeria:u281", "abcdx", "z", "pi"};
+
+  // run all queries twice, interleaving the query types to check reset
+  for (size_t round = 0; round < 2; ++round) {
+    for (const auto& query : queries) {
+      for (size_t exact_prefix = 1; exact_prefix <= 2; ++exact_prefix) {
+        for (int32_t max_edit_distance = 0; max_edit_distance < 3; ++max_edit_distance) {
+          result_t actual;
+          d.GetFuzzy(&context, query, max_edit_distance, exact_prefix, [&actual](const Match& m) {
+            actual.emplace_back(m.GetMatchedString(), m.GetScore(), m.GetValueAsString());
+          });
+
+          // the iterator based version does not support queries shorter than the exact prefix
+          if (query.size() >= exact_prefix) {
+            BOOST_CHECK(collect(d.GetFuzzy(query, max_edit_distance, exact_prefix)) == actual);
+          } else {
+            BOOST_CHECK(actual.empty());
+          }
+        }
+      }
+
+      result_t actual;
+      d.GetPrefixCompletion(&context, query, [&actual](const Match& m) {
+        actual.emplace_back(m.GetMatchedString(), m.GetScore(), m.GetValueAsString());
+      });
+      BOOST_CHECK(collect(d.GetPrefixCompletion(query)) == actual);
+
+      for (size_t prefix = 0; prefix <= query.size(); ++prefix) {
+        for (const bool greedy : {false, true}) {
+          actual.clear();
+          d.GetNear(&context, query, prefix, greedy, [&actual](const Match& m) {
+            actual.emplace_back(m.GetMatchedString(), m.GetScore(), m.GetValueAsString());
+          });
+          BOOST_CHECK(collect(d.GetNear(query, prefix, greedy)) == actual);
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(StopEarly) {
+  testing::TempDictionary dictionary(&test_data);
+  Dictionary d(dictionary.GetFsa());
+  QueryContext context;
+
+  std::vector<std::string> matches;
+  d.GetPrefixCompletion(&context, "ab", [&matches](const Match& m) {
+    matches.push_back(m.GetMatchedString());
+    return matches.size() < 3;
+  });
+  BOOST_CHECK_EQUAL(3, matches.size());
+
+  // the context is reusable after stopping early
+  matches.clear();
+  d.GetPrefixCompletion(&context, "bb", [&matches](const Match& m) { matches.push_back(m.GetMatchedString()); });
+  BOOST_CHECK_EQUAL(2, matches.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace dictionary
+}  // namespace keyvi
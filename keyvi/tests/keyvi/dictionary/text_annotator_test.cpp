@@ -0,0 +1,160 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * text_annotator_test.cpp
+ */
+
+#include "keyvi/dictionary/text_annotator.h"
+
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/dictionary/dictionary.h"
+#include "keyvi/testing/temp_dictionary.h"
+
+namespace keyvi {
+namespace dictionary {
+
+BOOST_AUTO_TEST_SUITE(TextAnnotatorTests)
+
+using annotations_t = std::vector<std::tuple<size_t, size_t, std::string>>;
+
+annotations_t annotate(const Dictionary& d, TextAnnotator* annotator, const std::string& text) {
+  annotations_t annotations;
+  d.LookupText(annotator, text, [&annotations](const MatchView& m) {
+    annotations.emplace_back(m.GetStart(), m.GetEnd(), m.GetMatchedString());
+  });
+  return annotations;
+}
+
+std::vector<std::pair<std::string, uint32_t>> test_data = {
+    {"new", 1},  {"new york", 2}, {"york", 3}, {"new york city", 4}, {"city", 5}, {"york city hall", 6},
+    {"he", 7},   {"she", 8},      {"his", 9},  {"hers", 10},         {"hall", 11}};
+
+BOOST_AUTO_TEST_CASE(Modes) {
+  testing::TempDictionary dictionary(&test_data);
+  Dictionary d(dictionary.GetFsa());
+  const std::string text = "i love new york city hall and york city hall";
+
+  TextAnnotator all(annotation_mode_t::ALL);
+  annotations_t expected = {{7, 10, "new"},        {7, 15, "new york"},        {11, 15, "york"},
+                            {7, 20, "new york city"}, {16, 20, "city"},        {11, 25, "york city hall"},
+                            {21, 25, "hall"},      {30, 34, "york"},           {35, 39, "city"},
+                            {30, 44, "york city hall"}, {40, 44, "hall"}};
+  BOOST_CHECK(expected == annotate(d, &all, text));
+
+  TextAnnotator longest(annotation_mode_t::LONGEST);
+  expected = {{7, 20, "new york city"}, {11, 25, "york city hall"}, {16, 20, "city"}, {21, 25, "hall"},
+              {30, 44, "york city hall"}, {35, 39, "city"},        {40, 44, "hall"}};
+  BOOST_CHECK(expected == annotate(d, &longest, text));
+
+  TextAnnotator leftmost_longest;
+  expected = {{7, 20, "new york city"}, {21, 25, "hall"}, {30, 44, "york city hall"}};
+  BOOST_CHECK(expected == annotate(d, &leftmost_longest, text));
+
+  // reuse the annotator
+  expected = {{0, 3, "new"}};
+  BOOST_CHECK(expected == annotate(d, &leftmost_longest, "new yorker"));
+  BOOST_CHECK(annotate(d, &leftmost_longest, "").empty());
+  BOOST_CHECK(annotate(d, &leftmost_longest, "newyork").empty());
+
+  // text ending within a key
+  for (TextAnnotator* annotator : {&all, &longest, &leftmost_longest}) {
+    BOOST_CHECK(annotate(d, annotator, "yor").empty());
+    expected = {{0, 3, "new"}};
+    BOOST_CHECK(expected == annotate(d, annotator, "new yor"));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Boundaries) {
+  testing::TempDictionary dictionary(&test_data);
+  Dictionary d(dictionary.GetFsa());
+
+  TextAnnotator annotator(annotation_mode_t::LEFTMOST_LONGEST, ",; ");
+  annotations_t expected = {{0, 8, "new york"}, {9, 23, "york city hall"}, {24, 28, "city"}};
+  BOOST_CHECK(expected == annotate(d, &annotator, "new york,york city hall;city"));
+
+  // without boundaries keys are matched anywhere
+  TextAnnotator substrings(annotation_mode_t::ALL, "");
+  expected = {{1, 4, "she"}, {2, 4, "he"}, {2, 6, "hers"}};
+  BOOST_CHECK(expected == annotate(d, &substrings, "ushers"));
+
+  // more boundaries than the vectorized search supports
+  TextAnnotator many_boundaries(annotation_mode_t::LEFTMOST_LONGEST, " !\"#$%&'()*+,-./:;<=>?");
+  expected = {{37, 40, "new"}, {41, 45, "york"}};
+  BOOST_CHECK(expected == annotate(d, &many_boundaries, "somewhat long tokens without matches:new/york"));
+}
+
+BOOST_AUTO_TEST_CASE(SkipLongTokens) {
+  testing::TempDictionary dictionary(&test_data);
+  Dictionary d(dictionary.GetFsa());
+
+  std::string text = std::string(100, 'n') + " newyork " + std::string(37, 'y') + " new york";
+  TextAnnotator annotator;
+  annotations_t expected = {{147, 155, "new york"}};
+  BOOST_CHECK(expected == annotate(d, &annotator, text));
+}
+
+BOOST_AUTO_TEST_CASE(StopEarly) {
+  testing::TempDictionary dictionary(&test_data);
+  Dictionary d(dictionary.GetFsa());
+
+  for (const auto mode : {annotation_mode_t::ALL, annotation_mode_t::LONGEST, annotation_mode_t::LEFTMOST_LONGEST}) {
+    TextAnnotator annotator(mode);
+    size_t calls = 0;
+    d.LookupText(&annotator, "new york city hall and york city hall", [&calls](const MatchView& m) {
+      ++calls;
+      return false;
+    });
+    BOOST_CHECK_EQUAL(1, calls);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(LookupTextCompatibility) {
+  testing::TempDictionary dictionary(&test_data);
+  Dictionary d(dictionary.GetFsa());
+
+  for (const std::string text : {"i love new york city hall and york city hall", " new york", "new  york city ",
+                                 "hers he his she", "", " ", "new"}) {
+    // lookup from every token start
+    std::vector<std::string> expected;
+    for (size_t position = 0; position < text.size(); ++position) {
+      if (position == 0 || text[position - 1] == ' ') {
+        for (const auto& m : d.Lookup(text, position)) {
+          expected.push_back(m->GetMatchedString());
+        }
+      }
+    }
+
+    std::vector<std::string> actual;
+    for (const auto& m : d.LookupText(text)) {
+      actual.push_back(m->GetMatchedString());
+    }
+    BOOST_CHECK(expected == actual);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace dictionary
+}  // namespace keyvi
@@ -25,7 +25,10 @@
 
 #include <chrono>  //NOLINT
 #include <cstdlib>
+#include <future>  //NOLINT
+#include <stdexcept>
 #include <thread>  //NOLINT
+#include <utility>
 
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
@@ -53,6 +56,8 @@ class IndexFriend {
     return index->payload_.Segments();
   }
 
+  static std::shared_ptr<internal::MemTable> GetMemTable(Index* index) { return index->Payload().GetMemTable(); }
+
   static bool Contains(const std::shared_ptr<internal::segment_vec_t>& segments, const std::string& key) {
     for (auto it = segments->crbegin(); it != segments->crend(); it++) {
       if ((*it)->GetDictionary()->Contains(key)) {
@@ -106,6 +111,10 @@ BOOST_AUTO_TEST_CASE(basic_writer_simple_merge_policy) {
   basic_writer_test({{KEYVIMERGER_BIN, get_keyvimerger_bin()}, {MERGE_POLICY, "simple"}});
 }
 
+BOOST_AUTO_TEST_CASE(basic_writer_inline_compile) {
+  basic_writer_test({{KEYVIMERGER_BIN, get_keyvimerger_bin()}, {MAX_CONCURRENT_COMPILES, "0"}});
+}
+
 void basic_writer_bulk_test(const keyvi::util::parameters_t& params = keyvi::util::parameters_t()) {
   using boost::filesystem::temp_directory_path;
   using boost::filesystem::unique_path;
@@ -170,6 +179,374 @@ BOOST_AUTO_TEST_CASE(basic_writer_bulk_simple_merge_policy) {
   basic_writer_bulk_test({{KEYVIMERGER_BIN, get_keyvimerger_bin()}, {MERGE_POLICY, "simple"}});
 }
 
+BOOST_AUTO_TEST_CASE(basic_writer_move) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index writer(tmp_path.string(), {{KEYVIMERGER_BIN, get_keyvimerger_bin()}});
+
+    // more than fits into 1 write buffer
+    for (size_t i = 0; i < 2 * WRITE_BUFFER_SIZE + 10; ++i) {
+      writer.Set("a" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+    }
+
+    key_value_vector_t input_data;
+    for (int i = 0; i < 100; ++i) {
+      input_data.push_back({"b" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}"});
+    }
+    writer.MSet(std::move(input_data));
+
+    // buffered writes and deletes must keep their order
+    writer.Set("c", "{\"id\":1}");
+    writer.Delete("c");
+    writer.Set("d", "{\"id\":1}");
+    writer.Delete("d");
+    writer.Set("d", "{\"id\":2}");
+    writer.Flush();
+
+    BOOST_CHECK(writer.Contains("a0"));
+    BOOST_CHECK(writer.Contains("a" + std::to_string(2 * WRITE_BUFFER_SIZE + 9)));
+    BOOST_CHECK(writer.Contains("b99"));
+    BOOST_CHECK(!writer.Contains("c"));
+    BOOST_CHECK_EQUAL("{\"id\":2}", writer["d"]->GetValueAsString());
+  }
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(background_compile_with_deletes) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index writer(tmp_path.string(), {{KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                                     {SEGMENT_COMPILE_KEY_THRESHOLD, "100"},
+                                     {MAX_CONCURRENT_COMPILES, "2"}});
+
+    // deletes race with the compilation of the segment that holds the key
+    for (int i = 0; i < 2000; ++i) {
+      writer.Set("a" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+      if (i % 10 == 0) {
+        writer.Delete("a" + std::to_string(i - 5));
+      }
+    }
+    writer.Flush();
+
+    for (int i = 0; i < 2000; ++i) {
+      BOOST_CHECK_EQUAL(!(i % 10 == 5 && i < 1995), writer.Contains("a" + std::to_string(i)));
+    }
+  }
+  boost::filesystem::remove_all(tmp_path);
+}
+
+void compile_failure_test(const keyvi::util::parameters_t& params) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  auto moved_path = tmp_path;
+  moved_path += ".moved";
+  {
+    Index writer(tmp_path.string(), params);
+
+    writer.Set("a", "{\"id\":1}");
+    writer.Flush();
+
+    // segments can not be written while the index directory is gone, unlike permissions this works as root, too
+    boost::filesystem::rename(tmp_path, moved_path);
+    writer.Set("b", "{\"id\":2}");
+    BOOST_CHECK_THROW(writer.Flush(), std::invalid_argument);
+    boost::filesystem::rename(moved_path, tmp_path);
+
+    // the failed compilation neither blocks nor fails later flushes
+    writer.Set("c", "{\"id\":3}");
+    writer.Flush();
+
+    BOOST_CHECK(writer.Contains("a"));
+    BOOST_CHECK(writer.Contains("c"));
+    BOOST_CHECK_EQUAL(2, unit_test::IndexFriend::GetSegments(&writer)->size());
+  }
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(compile_failure_background) {
+  compile_failure_test({{KEYVIMERGER_BIN, get_keyvimerger_bin()}, {"refresh_interval", "60000"}});
+}
+
+BOOST_AUTO_TEST_CASE(compile_failure_inline) {
+  compile_failure_test(
+      {{KEYVIMERGER_BIN, get_keyvimerger_bin()}, {"refresh_interval", "60000"}, {MAX_CONCURRENT_COMPILES, "0"}});
+}
+
+BOOST_AUTO_TEST_CASE(compile_failure_futures) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  auto moved_path = tmp_path;
+  moved_path += ".moved";
+  {
+    Index writer(tmp_path.string(), {{KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                                     {"refresh_interval", "60000"},
+                                     {SEGMENT_COMPILE_KEY_THRESHOLD, "100"}});
+
+    writer.Set("a", "{\"id\":1}");
+    writer.Flush();
+
+    // the writes trigger compilations in the background, which fail
+    boost::filesystem::rename(tmp_path, moved_path);
+    for (int i = 0; i < 250; ++i) {
+      writer.Set("b" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+    }
+    BOOST_CHECK_THROW(writer.Flush().get(), std::invalid_argument);
+
+    writer.Set("c", "{\"id\":3}");
+    BOOST_CHECK_THROW(writer.ForceMerge(1, true).get(), std::invalid_argument);
+    boost::filesystem::rename(moved_path, tmp_path);
+
+    // errors get reported once, the writer stays usable
+    writer.Set("d", "{\"id\":4}");
+    writer.Flush().get();
+    writer.ForceMerge(1, true).get();
+
+    BOOST_CHECK_EQUAL(1, unit_test::IndexFriend::GetSegments(&writer)->size());
+    BOOST_CHECK(writer.Contains("a"));
+    BOOST_CHECK(writer.Contains("d"));
+  }
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(force_merge_async) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    // the scheduled task does not run during the test, merges must be driven by merge events
+    Index writer(tmp_path.string(), {{KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                                     {"refresh_interval", "60000"},
+                                     {SEGMENT_COMPILE_KEY_THRESHOLD, "100"}});
+
+    for (int i = 0; i < 1000; ++i) {
+      writer.Set("a" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+    }
+
+    std::shared_future<void> merged = writer.ForceMerge(1, true);
+    BOOST_CHECK(merged.wait_for(std::chrono::seconds(30)) == std::future_status::ready);
+    merged.get();
+
+    BOOST_CHECK_EQUAL(1, unit_test::IndexFriend::GetSegments(&writer)->size());
+    BOOST_CHECK(writer.Contains("a0"));
+    BOOST_CHECK(writer.Contains("a999"));
+
+    // a synchronous flush returns a ready future
+    writer.Set("b", "{\"id\":1}");
+    BOOST_CHECK(writer.Flush().wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    BOOST_CHECK(writer.Contains("b"));
+  }
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(memtable_read_your_writes) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    // the scheduled task does not run during the test, writes are only readable from the mem table
+    Index writer(tmp_path.string(),
+                 {{KEYVIMERGER_BIN, get_keyvimerger_bin()}, {"refresh_interval", "60000"}, {INDEX_MEMTABLE, "true"}});
+
+    writer.Set("abb", "{\"id\":0}");
+    writer.Set("abc", "{\"id\":1}");
+    writer.Set("abd", "{\"id\":2}");
+    writer.Flush();
+    writer.Set("abd", "{\"id\":3}");
+    writer.Set("abe", "{\"id\":4}");
+    writer.Delete("abc");
+
+    BOOST_CHECK(!writer.Contains("abc"));
+    BOOST_CHECK(!writer["abc"]);
+    BOOST_CHECK_EQUAL("{\"id\":3}", writer["abd"]->GetValueAsString());
+    BOOST_CHECK(writer.Contains("abe"));
+
+    std::vector<bool> contains = writer.ContainsMany({"abc", "abd", "abe", "abf"});
+    BOOST_CHECK(!contains[0] && contains[1] && contains[2] && !contains[3]);
+    std::vector<dictionary::match_t> matches = writer.GetMany({"abc", "abd", "abe"});
+    BOOST_CHECK(!matches[0]);
+    BOOST_CHECK_EQUAL("{\"id\":3}", matches[1]->GetValueAsString());
+    BOOST_CHECK_EQUAL("{\"id\":4}", matches[2]->GetValueAsString());
+
+    // matches from the segments and the mem table interleave
+    const std::vector<std::string> expected = {"abb", "abd", "abe"};
+    std::vector<std::string> keys;
+    for (auto m : writer.GetFuzzy("abx", 1, 2)) {
+      keys.push_back(m->GetMatchedString());
+    }
+    BOOST_CHECK_EQUAL_COLLECTIONS(keys.begin(), keys.end(), expected.begin(), expected.end());
+
+    keys.clear();
+    for (auto m : writer.GetNear("abe", 2)) {
+      keys.push_back(m->GetMatchedString());
+    }
+    BOOST_CHECK_EQUAL(1, keys.size());
+    BOOST_CHECK_EQUAL("abe", keys[0]);
+
+    keys.clear();
+    std::vector<std::string> values;
+    writer.ForEachMatch([&keys, &values](dictionary::MatchView& m) {
+      keys.emplace_back(m.GetMatchedString());
+      values.push_back(m.GetValueAsString());
+    });
+    BOOST_CHECK_EQUAL_COLLECTIONS(keys.begin(), keys.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL("{\"id\":3}", values[1]);
+
+    // once flushed, the segments have the same view
+    writer.Flush();
+    BOOST_CHECK(unit_test::IndexFriend::GetMemTable(&writer)->Empty());
+    BOOST_CHECK(!writer.Contains("abc"));
+    BOOST_CHECK_EQUAL("{\"id\":3}", writer["abd"]->GetValueAsString());
+    BOOST_CHECK(writer.Contains("abe"));
+  }
+  boost::filesystem::remove_all(tmp_path);
+
+  tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index writer(tmp_path.string(),
+                 {{KEYVIMERGER_BIN, get_keyvimerger_bin()}, {"refresh_interval", "60000"}, {INDEX_MEMTABLE, "false"}});
+
+    writer.Set("abc", "{\"id\":1}");
+    BOOST_CHECK(!writer.Contains("abc"));
+    writer.Flush();
+    BOOST_CHECK(writer.Contains("abc"));
+  }
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(memtable_delete_across_scheduled_task) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    // writes get compiled and published in between scheduled tasks, which persist the deletes
+    Index writer(tmp_path.string(), {{KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                                     {"refresh_interval", "100"},
+                                     {SEGMENT_COMPILE_KEY_THRESHOLD, "2"},
+                                     {MAX_CONCURRENT_COMPILES, "0"},
+                                     {INDEX_MEMTABLE, "true"}});
+
+    writer.Set("abc", "{\"id\":1}");
+    writer.Flush();
+    BOOST_CHECK(writer.Contains("abc"));
+
+    writer.Delete("abc");
+    for (int i = 0; i < 200; ++i) {
+      writer.Set("b" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+      BOOST_CHECK(!writer.Contains("abc"));
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    writer.Flush();
+    BOOST_CHECK(unit_test::IndexFriend::GetMemTable(&writer)->Empty());
+    BOOST_CHECK(!writer.Contains("abc"));
+    BOOST_CHECK(writer.Contains("b199"));
+  }
+  boost::filesystem::remove_all(tmp_path);
+}
+
+// a single write stays in the write buffer, the first scheduled task compiles and publishes it
+void scheduled_task_compile_test(const keyvi::util::parameters_t& params) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index writer(tmp_path.string(), params);
+
+    writer.Set("abc", "{\"id\":1}");
+
+    // no flush, wait for the scheduled task to compile and publish the write
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((unit_test::IndexFriend::GetSegments(&writer)->size() == 0 ||
+            !unit_test::IndexFriend::GetMemTable(&writer)->Empty()) &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    BOOST_CHECK_EQUAL(1, unit_test::IndexFriend::GetSegments(&writer)->size());
+    BOOST_CHECK(unit_test::IndexFriend::GetMemTable(&writer)->Empty());
+    BOOST_CHECK(writer.Contains("abc"));
+  }
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(scheduled_task_inline_compile) {
+  scheduled_task_compile_test({{KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                               {"refresh_interval", "200"},
+                               {MAX_CONCURRENT_COMPILES, "0"},
+                               {INDEX_MEMTABLE, "true"}});
+}
+
+BOOST_AUTO_TEST_CASE(scheduled_task_background_compile) {
+  // a finished compilation gets published right away, not with the next scheduled task
+  scheduled_task_compile_test(
+      {{KEYVIMERGER_BIN, get_keyvimerger_bin()}, {"refresh_interval", "200"}, {INDEX_MEMTABLE, "true"}});
+}
+
+// segments written by the compiler, an internal and an external merge carry a key filter
+void key_filter_test(const keyvi::util::parameters_t& params) {
+  using boost::filesystem::temp_directory_path;
+  using boost::filesystem::unique_path;
+
+  auto tmp_path = temp_directory_path();
+  tmp_path /= unique_path();
+  {
+    Index writer(tmp_path.string(), params);
+
+    for (int i = 0; i < 3; ++i) {
+      writer.Set("a" + std::to_string(i), "{\"id\":" + std::to_string(i) + "}");
+      writer.Flush();
+    }
+
+    internal::const_segments_t segments = unit_test::IndexFriend::GetSegments(&writer);
+    BOOST_CHECK(segments->size() > 1);
+    for (const auto& segment : *segments) {
+      BOOST_CHECK(segment->GetDictionary()->GetStatistics().find("key_filter") != std::string::npos);
+    }
+
+    writer.ForceMerge(1);
+    internal::const_segments_t merged_segments = unit_test::IndexFriend::GetSegments(&writer);
+    BOOST_CHECK_EQUAL(1, merged_segments->size());
+    BOOST_CHECK((*merged_segments)[0]->GetDictionary()->GetStatistics().find("key_filter") != std::string::npos);
+    BOOST_CHECK(writer.Contains("a0"));
+    BOOST_CHECK(writer.Contains("a2"));
+    BOOST_CHECK(!writer.Contains("a3"));
+  }
+  boost::filesystem::remove_all(tmp_path);
+}
+
+BOOST_AUTO_TEST_CASE(key_filter_internal_merge) {
+  key_filter_test({{KEYVIMERGER_BIN, get_keyvimerger_bin()}, {"refresh_interval", "60000"}});
+}
+
+BOOST_AUTO_TEST_CASE(key_filter_external_merge) {
+  key_filter_test({{KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                   {"refresh_interval", "60000"},
+                   {SEGMENT_EXTERNAL_MERGE_KEY_THRESHOLD, "0"}});
+}
+
 void bigger_feed_test(const keyvi::util::parameters_t& params = keyvi::util::parameters_t()) {
   using boost::filesystem::temp_directory_path;
   using boost::filesystem::unique_path;
@@ -200,6 +577,14 @@ BOOST_AUTO_TEST_CASE(bigger_feed) {
       {{"refresh_interval", "100"}, {KEYVIMERGER_BIN, get_keyvimerger_bin()}, {"max_concurrent_merges", "2"}});
 }
 
+BOOST_AUTO_TEST_CASE(bigger_feed_small_memory_budget) {
+  // merges must make progress even if the budget is smaller than the minimum for a single merge
+  bigger_feed_test({{"refresh_interval", "100"},
+                    {KEYVIMERGER_BIN, get_keyvimerger_bin()},
+                    {"max_concurrent_merges", "2"},
+                    {"memory_budget_mb", "1"}});
+}
+
 BOOST_AUTO_TEST_CASE(bigger_feed_external_merge) {
   bigger_feed_test({{"refresh_interval", "100"},
                     {KEYVIMERGER_BIN, get_keyvimerger_bin()},
@@ -39,6 +39,16 @@ BOOST_AUTO_TEST_CASE(defaultkeyvimergerbin) {
   BOOST_CHECK_EQUAL(std::string("keyvimerger"), settings.GetKeyviMergerBin());
 }
 
+BOOST_AUTO_TEST_CASE(memorybudget) {
+  BOOST_CHECK_EQUAL(DEFAULT_INDEX_MEMORY_BUDGET, IndexSettings({}).GetMemoryBudget());
+
+  IndexSettings settings(keyvi::util::parameters_t{{"memory_budget", "1048576"}});
+  BOOST_CHECK_EQUAL(1048576, settings.GetMemoryBudget());
+
+  IndexSettings settings_mb(keyvi::util::parameters_t{{"memory_budget_mb", "2"}});
+  BOOST_CHECK_EQUAL(2 * 1048576, settings_mb.GetMemoryBudget());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } /* namespace internal */
@@ -0,0 +1,171 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * mem_table_test.cpp
+ */
+
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/index/internal/mem_table.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+BOOST_AUTO_TEST_SUITE(MemTableTests)
+
+BOOST_AUTO_TEST_CASE(put_get_delete) {
+  MemTable mem_table;
+  bool deleted = false;
+  std::string value;
+
+  BOOST_CHECK(mem_table.Empty());
+  BOOST_CHECK(!mem_table.Get("abc", &deleted));
+
+  mem_table.Put("abc", "{\"a\":1}", 1);
+  mem_table.Put("abd", "{\"a\":2}", 2);
+  BOOST_CHECK_EQUAL(2, mem_table.Size());
+  BOOST_CHECK(mem_table.Get("abc", &deleted, &value));
+  BOOST_CHECK(!deleted);
+  BOOST_CHECK_EQUAL("{\"a\":1}", value);
+
+  // overwrite
+  mem_table.Put("abc", "{\"a\":3}", 3);
+  BOOST_CHECK_EQUAL(2, mem_table.Size());
+  BOOST_CHECK(mem_table.Get("abc", &deleted, &value));
+  BOOST_CHECK_EQUAL("{\"a\":3}", value);
+
+  // a delete is kept as tombstone
+  mem_table.Delete("abd", 4);
+  BOOST_CHECK(mem_table.Get("abd", &deleted));
+  BOOST_CHECK(deleted);
+
+  dictionary::match_t m = MemTable::CreateMatch("abc", "{\"a\":3}", 2);
+  BOOST_CHECK_EQUAL("abc", m->GetMatchedString());
+  BOOST_CHECK_EQUAL(2, m->GetScore());
+  BOOST_CHECK_EQUAL("{\"a\":3}", m->GetValueAsString());
+}
+
+BOOST_AUTO_TEST_CASE(purge) {
+  MemTable mem_table;
+  bool deleted = false;
+
+  mem_table.Put("abc", "1", 1);
+  mem_table.Put("abd", "2", 2);
+  mem_table.Delete("abe", 3);
+  mem_table.Put("abc", "4", 4);
+
+  // the key written again after the purged sequence number must survive
+  mem_table.Purge(3);
+  BOOST_CHECK_EQUAL(1, mem_table.Size());
+  BOOST_CHECK(mem_table.Get("abc", &deleted));
+  BOOST_CHECK(!mem_table.Get("abd", &deleted));
+  BOOST_CHECK(!mem_table.Get("abe", &deleted));
+
+  mem_table.Purge(4);
+  BOOST_CHECK(mem_table.Empty());
+}
+
+BOOST_AUTO_TEST_CASE(purge_batch) {
+  MemTable mem_table;
+  bool deleted = false;
+  std::string value;
+
+  // a key written twice within a batch shares the sequence number
+  std::vector<std::pair<std::string, std::string>> batch = {{"abc", "1"}, {"abd", "2"}, {"abc", "3"}};
+  mem_table.PutMany(batch, 1);
+  mem_table.Put("abe", "4", 2);
+  BOOST_CHECK_EQUAL(3, mem_table.Size());
+  BOOST_CHECK(mem_table.Get("abc", &deleted, &value));
+  BOOST_CHECK_EQUAL("3", value);
+
+  mem_table.Delete("abd", 3);
+  mem_table.Purge(1);
+  BOOST_CHECK_EQUAL(2, mem_table.Size());
+  BOOST_CHECK(!mem_table.Get("abc", &deleted));
+  BOOST_CHECK(mem_table.Get("abd", &deleted));
+  BOOST_CHECK(deleted);
+
+  mem_table.Put("abc", "5", 4);
+  mem_table.Purge(3);
+  BOOST_CHECK_EQUAL(1, mem_table.Size());
+  BOOST_CHECK(mem_table.Get("abc", &deleted, &value));
+  BOOST_CHECK_EQUAL("5", value);
+
+  mem_table.Purge(4);
+  BOOST_CHECK(mem_table.Empty());
+}
+
+BOOST_AUTO_TEST_CASE(range) {
+  MemTable mem_table;
+
+  mem_table.Put("b", "1", 1);
+  mem_table.Put("abc", "2", 2);
+  mem_table.Put("ab", "3", 3);
+  mem_table.Delete("abd", 4);
+  mem_table.Put("ac", "5", 5);
+
+  std::vector<MemTable::entry_t> entries = mem_table.GetRange("ab");
+  BOOST_CHECK_EQUAL(3, entries.size());
+  BOOST_CHECK_EQUAL("ab", entries[0].first);
+  BOOST_CHECK_EQUAL("abc", entries[1].first);
+  BOOST_CHECK_EQUAL("abd", entries[2].first);
+  BOOST_CHECK(entries[2].second.deleted);
+
+  entries = mem_table.GetRange();
+  BOOST_CHECK_EQUAL(5, entries.size());
+  BOOST_CHECK_EQUAL("ab", entries[0].first);
+  BOOST_CHECK_EQUAL("b", entries[4].first);
+
+  BOOST_CHECK_EQUAL(0, mem_table.GetRange("x").size());
+}
+
+BOOST_AUTO_TEST_CASE(snapshot) {
+  MemTable mem_table;
+  BOOST_CHECK(!mem_table.GetSnapshot());
+
+  mem_table.Put("b", "1", 1);
+  mem_table.Delete("a", 2);
+
+  MemTable::snapshot_t snapshot = mem_table.GetSnapshot();
+  BOOST_CHECK_EQUAL(2, snapshot->size());
+  BOOST_CHECK_EQUAL("a", (*snapshot)[0].first);
+  BOOST_CHECK((*snapshot)[0].second.deleted);
+
+  // shared until the next write
+  BOOST_CHECK(snapshot == mem_table.GetSnapshot());
+
+  mem_table.Put("c", "3", 3);
+  MemTable::snapshot_t new_snapshot = mem_table.GetSnapshot();
+  BOOST_CHECK(snapshot != new_snapshot);
+  BOOST_CHECK_EQUAL(2, snapshot->size());
+  BOOST_CHECK_EQUAL(3, new_snapshot->size());
+
+  mem_table.Purge(1);
+  BOOST_CHECK_EQUAL(2, mem_table.GetSnapshot()->size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
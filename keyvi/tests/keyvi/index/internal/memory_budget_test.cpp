@@ -0,0 +1,92 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * memory_budget_test.cpp
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/index/internal/memory_budget.h"
+
+namespace keyvi {
+namespace index {
+namespace internal {
+
+using dictionary::fsa::internal::KeyFilter;
+
+BOOST_AUTO_TEST_SUITE(MemoryBudgetTests)
+
+BOOST_AUTO_TEST_CASE(acquire) {
+  MemoryBudget budget(64 * 1024 * 1024);
+
+  // small jobs get the minimum
+  size_t small = budget.Acquire(10);
+  BOOST_CHECK_EQUAL(MIN_JOB_MEMORY_LIMIT + KeyFilter::GetSize(10), small);
+
+  // a job gets memory by keys, but not more than half of the budget, the key filter comes on top
+  const size_t medium_keys = 10 * 1024 * 1024 / JOB_MEMORY_PER_KEY;
+  size_t medium = budget.Acquire(medium_keys);
+  BOOST_CHECK_EQUAL(10 * 1024 * 1024 + KeyFilter::GetSize(medium_keys), medium);
+  size_t big = budget.Acquire(1024 * 1024);
+  BOOST_CHECK_EQUAL(32 * 1024 * 1024 + KeyFilter::GetSize(1024 * 1024), big);
+  BOOST_CHECK(budget.CanAcquire());
+
+  // the rest of the budget
+  const size_t available = budget.Available();
+  size_t rest = budget.Acquire(1024 * 1024);
+  BOOST_CHECK_EQUAL(available, rest);
+  BOOST_CHECK(!budget.CanAcquire());
+
+  // exhausted, but the minimum is always granted
+  BOOST_CHECK_EQUAL(MIN_JOB_MEMORY_LIMIT + KeyFilter::GetSize(10), budget.Acquire(10));
+  BOOST_CHECK_EQUAL(0, budget.Available());
+
+  budget.Release(MIN_JOB_MEMORY_LIMIT + KeyFilter::GetSize(10));
+  budget.Release(rest);
+  budget.Release(big);
+  BOOST_CHECK_EQUAL(64 * 1024 * 1024 - small - medium, budget.Available());
+  budget.Release(medium);
+  budget.Release(small);
+  BOOST_CHECK_EQUAL(0, budget.Used());
+}
+
+BOOST_AUTO_TEST_CASE(key_filter) {
+  MemoryBudget budget(64 * 1024 * 1024);
+
+  // a compile next to a merge of 50M keys, the key filter of the merge alone takes more than the rest of the budget
+  size_t compile = budget.Acquire(100000);
+  BOOST_CHECK(!budget.CanAcquire(50 * 1000 * 1000));
+
+  // a smaller merge fits including its key filter
+  const size_t merge_keys = 10 * 1000 * 1000;
+  BOOST_CHECK(budget.CanAcquire(merge_keys));
+  size_t merge = budget.Acquire(merge_keys);
+  BOOST_CHECK(merge > KeyFilter::GetSize(merge_keys) + MIN_JOB_MEMORY_LIMIT);
+  BOOST_CHECK_LE(budget.Used(), budget.GetBudget());
+
+  budget.Release(merge);
+  budget.Release(compile);
+  BOOST_CHECK_EQUAL(0, budget.Used());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace internal */
+} /* namespace index */
+} /* namespace keyvi */
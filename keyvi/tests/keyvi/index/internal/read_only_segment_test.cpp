@@ -17,11 +17,15 @@
 //
 
 #include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
 #include <msgpack.hpp>
 
+#include "keyvi/index/constants.h"
 #include "keyvi/index/internal/read_only_segment.h"
 #include "keyvi/testing/temp_dictionary.h"
 
@@ -117,6 +121,79 @@ BOOST_AUTO_TEST_CASE(deletedkeys_reload) {
   std::remove(filename.c_str());
 }
 
+BOOST_AUTO_TEST_CASE(deletedkeys_compact) {
+  std::vector<std::pair<std::string, std::string>> test_data{
+      {"abc", "{a:1}"}, {"abbc", "{b:2}"}, {"cde", "{c:2}"}, {"fgh", "{g:6}"}, {"tyc", "{o:2}"}};
+  testing::TempDictionary dictionary = testing::TempDictionary::makeTempDictionaryFromJson(&test_data);
+
+  std::string filename{dictionary.GetFileName() + ".dk"};
+  std::string filename_dkm{dictionary.GetFileName() + ".dkm"};
+
+  // compact format and the old format can be mixed, keys in both files are counted once
+  DeletedKeySet::Write(filename, std::vector<std::string>{"tyc", "abc", "abc"}, MIN_JOB_MEMORY_LIMIT);
+  {
+    std::vector<std::string> deleted_keys_dkm{"abc", "cde"};
+    std::ofstream out_stream(filename_dkm, std::ios::binary);
+    msgpack::pack(out_stream, deleted_keys_dkm);
+  }
+
+  read_only_segment_t segment(new ReadOnlySegment(dictionary.GetFileName()));
+
+  BOOST_CHECK(segment->HasDeletedKeys());
+  BOOST_CHECK(!segment->DeletedKeys()->empty());
+  BOOST_CHECK_EQUAL(3, segment->DeletedKeysSize());
+  BOOST_CHECK(segment->IsDeleted("abc"));
+  BOOST_CHECK(segment->IsDeleted("tyc"));
+  BOOST_CHECK(segment->IsDeleted("cde"));
+  BOOST_CHECK(!segment->IsDeleted("abbc"));
+  BOOST_CHECK(!segment->IsDeleted("ab"));
+
+  std::remove(filename_dkm.c_str());
+  DeletedKeySet::Write(filename_dkm, std::vector<std::string>{"abc", "fgh"}, MIN_JOB_MEMORY_LIMIT);
+
+  segment->ReloadDeletedKeys();
+  BOOST_CHECK_EQUAL(3, segment->DeletedKeysSize());
+  BOOST_CHECK(segment->IsDeleted("fgh"));
+  BOOST_CHECK(!segment->IsDeleted("cde"));
+
+  std::remove(filename_dkm.c_str());
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(deletedkeys_log_layers) {
+  std::vector<std::pair<std::string, std::string>> test_data{{"abc", "{a:1}"}, {"abbc", "{b:2}"}};
+  testing::TempDictionary dictionary = testing::TempDictionary::makeTempDictionaryFromJson(&test_data);
+
+  std::string filename{dictionary.GetFileName() + ".dk"};
+  std::string log_filename{dictionary.GetFileName() + ".dk-log"};
+  DeletedKeySet::Write(filename, std::vector<std::string>{"abc"}, MIN_JOB_MEMORY_LIMIT);
+
+  // every load of the log tail creates a new set, earlier ones must stay unchanged
+  std::vector<std::shared_ptr<DeletedKeySet>> deleted_keys;
+  deleted_keys.push_back(std::make_shared<DeletedKeySet>());
+  deleted_keys.back()->Load(filename);
+
+  size_t offset = 0;
+  for (size_t i = 0; i < 100; ++i) {
+    DeletedKeySet::AppendToLog(log_filename, {"key-" + std::to_string(i), "abc"});
+    deleted_keys.push_back(std::make_shared<DeletedKeySet>(*deleted_keys.back()));
+    offset = deleted_keys.back()->LoadLog(log_filename, offset);
+  }
+
+  for (size_t i = 0; i < deleted_keys.size(); ++i) {
+    BOOST_CHECK(deleted_keys[i]->count("abc"));
+    BOOST_CHECK_EQUAL(i + 1, deleted_keys[i]->size());
+    BOOST_CHECK(!deleted_keys[i]->count("key-" + std::to_string(i)));
+    if (i > 0) {
+      BOOST_CHECK(deleted_keys[i]->count("key-0"));
+      BOOST_CHECK(deleted_keys[i]->count("key-" + std::to_string(i - 1)));
+    }
+  }
+
+  std::remove(log_filename.c_str());
+  std::remove(filename.c_str());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace internal
@@ -17,12 +17,11 @@
 //
 
 #include <algorithm>
+#include <fstream>
 
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
-#include <msgpack.hpp>
-
 #include "keyvi/index/internal/segment.h"
 #include "keyvi/testing/temp_dictionary.h"
 
@@ -33,17 +32,14 @@ namespace internal {
 BOOST_AUTO_TEST_SUITE(SegmentTests)
 
 void LoadDeletedKeys(const std::string& filename, std::vector<std::string>* deleted_keys) {
-  std::ifstream deleted_keys_stream(filename, std::ios::binary);
-
-  BOOST_CHECK(deleted_keys_stream.good());
+  BOOST_CHECK(boost::filesystem::exists(filename) || boost::filesystem::exists(filename + "-log"));
 
-  std::stringstream buffer;
-  buffer << deleted_keys_stream.rdbuf();
+  DeletedKeySet deleted_keys_file;
+  deleted_keys_file.LoadLog(filename + "-log", 0);
+  deleted_keys_file.Load(filename);
 
-  msgpack::object_handle unpacked_object;
-  msgpack::unpack(unpacked_object, buffer.str().data(), buffer.str().size());
-
-  unpacked_object.get().convert(*deleted_keys);
+  deleted_keys->clear();
+  deleted_keys_file.ForEach([deleted_keys](const std::string& key) { deleted_keys->push_back(key); });
   std::sort(deleted_keys->begin(), deleted_keys->end());
 }
 
@@ -317,6 +313,144 @@ BOOST_AUTO_TEST_CASE(deletekeyendtoend) {
   BOOST_CHECK(!boost::filesystem::exists(dictionary.GetFileName()));
 }
 
+BOOST_AUTO_TEST_CASE(deletedkeyslog) {
+  std::vector<std::pair<std::string, std::string>> test_data;
+  for (size_t i = 0; i < 3000; ++i) {
+    test_data.emplace_back("key-" + std::to_string(i), "{a:1}");
+  }
+  testing::TempDictionary dictionary = testing::TempDictionary::makeTempDictionaryFromJson(&test_data);
+  const std::string dk_file = dictionary.GetFileName() + ".dk";
+  const std::string dk_log_file = dictionary.GetFileName() + ".dk-log";
+
+  segment_t segment(new Segment(dictionary.GetFileName()));
+  read_only_segment_t reader(new ReadOnlySegment(dictionary.GetFileName()));
+
+  // small deletes only get appended to the log
+  for (size_t i = 0; i < 10; ++i) {
+    segment->DeleteKey("key-" + std::to_string(i));
+  }
+  BOOST_CHECK(segment->Persist());
+  BOOST_CHECK(!segment->Persist());
+  BOOST_CHECK(boost::filesystem::exists(dk_log_file));
+  BOOST_CHECK(!boost::filesystem::exists(dk_file));
+
+  reader->ReloadDeletedKeys();
+  BOOST_CHECK_EQUAL(10, reader->DeletedKeysSize());
+  BOOST_CHECK(reader->IsDeleted("key-9"));
+
+  // the log gets compacted once it is big enough
+  for (size_t i = 10; i < 1500; ++i) {
+    segment->DeleteKey("key-" + std::to_string(i));
+    if (i % 100 == 0) {
+      segment->Persist();
+      reader->ReloadDeletedKeys();
+      BOOST_CHECK_EQUAL(i + 1, reader->DeletedKeysSize());
+    }
+  }
+  segment->Persist();
+  BOOST_CHECK(boost::filesystem::exists(dk_file));
+
+  reader->ReloadDeletedKeys();
+  BOOST_CHECK_EQUAL(1500, reader->DeletedKeysSize());
+  BOOST_CHECK(reader->IsDeleted("key-0"));
+  BOOST_CHECK(reader->IsDeleted("key-1499"));
+  BOOST_CHECK(!reader->IsDeleted("key-1500"));
+
+  // a fresh reader sees the same
+  read_only_segment_t reader2(new ReadOnlySegment(dictionary.GetFileName()));
+  BOOST_CHECK_EQUAL(1500, reader2->DeletedKeysSize());
+  BOOST_CHECK(reader2->IsDeleted("key-1499"));
+
+  // merges only read the compacted file
+  segment->DeleteKey("key-1500");
+  segment->ElectedForMerge();
+  BOOST_CHECK(!boost::filesystem::exists(dk_log_file));
+
+  std::vector<std::string> deleted_keys;
+  LoadDeletedKeys(dk_file, &deleted_keys);
+  BOOST_CHECK_EQUAL(1501, deleted_keys.size());
+
+  segment->RemoveFiles();
+  BOOST_CHECK(!boost::filesystem::exists(dk_file));
+  BOOST_CHECK(!boost::filesystem::exists(dk_log_file));
+}
+
+BOOST_AUTO_TEST_CASE(deletedkeyslog_partial_record) {
+  std::vector<std::pair<std::string, std::string>> test_data;
+  for (size_t i = 0; i < 10; ++i) {
+    test_data.emplace_back("key-" + std::to_string(i), "{a:1}");
+  }
+  testing::TempDictionary dictionary = testing::TempDictionary::makeTempDictionaryFromJson(&test_data);
+  const std::string dk_log_file = dictionary.GetFileName() + ".dk-log";
+
+  {
+    segment_t segment(new Segment(dictionary.GetFileName()));
+    segment->DeleteKey("key-1");
+    BOOST_CHECK(segment->Persist());
+  }
+
+  // a crash while appending leaves a partial record: a length of 10, but only 3 bytes of the key
+  {
+    const char partial_record[] = {10, 0, 0, 0, 'k', 'e', 'y'};
+    std::ofstream log_stream(dk_log_file, std::ios::binary | std::ios::app);
+    log_stream.write(partial_record, sizeof(partial_record));
+  }
+
+  size_t number_of_records = 0;
+  BOOST_CHECK(!DeletedKeySet::ScanLog(dk_log_file, &number_of_records));
+  BOOST_CHECK_EQUAL(1, number_of_records);
+
+  // the writer compacts on load, so deletes appended later are not hidden behind the partial record
+  segment_t segment(new Segment(dictionary.GetFileName()));
+  BOOST_CHECK(segment->IsDeleted("key-1"));
+  BOOST_CHECK(!boost::filesystem::exists(dk_log_file));
+
+  segment->DeleteKey("key-2");
+  BOOST_CHECK(segment->Persist());
+  BOOST_CHECK(DeletedKeySet::ScanLog(dk_log_file, &number_of_records));
+  BOOST_CHECK_EQUAL(1, number_of_records);
+
+  read_only_segment_t reader(new ReadOnlySegment(dictionary.GetFileName()));
+  BOOST_CHECK_EQUAL(2, reader->DeletedKeysSize());
+  BOOST_CHECK(reader->IsDeleted("key-1"));
+  BOOST_CHECK(reader->IsDeleted("key-2"));
+
+  segment->RemoveFiles();
+}
+
+BOOST_AUTO_TEST_CASE(deletedkeyslog_reopen) {
+  std::vector<std::pair<std::string, std::string>> test_data;
+  for (size_t i = 0; i < 1100; ++i) {
+    test_data.emplace_back("key-" + std::to_string(i), "{a:1}");
+  }
+  testing::TempDictionary dictionary = testing::TempDictionary::makeTempDictionaryFromJson(&test_data);
+  const std::string dk_file = dictionary.GetFileName() + ".dk";
+  const std::string dk_log_file = dictionary.GetFileName() + ".dk-log";
+
+  {
+    segment_t segment(new Segment(dictionary.GetFileName()));
+    for (size_t i = 0; i < DELETED_KEYS_LOG_MIN_COMPACTION - 10; ++i) {
+      segment->DeleteKey("key-" + std::to_string(i));
+    }
+    BOOST_CHECK(segment->Persist());
+    BOOST_CHECK(!boost::filesystem::exists(dk_file));
+  }
+
+  // after reopening, the keys already in the log count towards the compaction
+  segment_t segment(new Segment(dictionary.GetFileName()));
+  for (size_t i = DELETED_KEYS_LOG_MIN_COMPACTION - 10; i < DELETED_KEYS_LOG_MIN_COMPACTION + 10; ++i) {
+    segment->DeleteKey("key-" + std::to_string(i));
+  }
+  BOOST_CHECK(segment->Persist());
+  BOOST_CHECK(boost::filesystem::exists(dk_file));
+  BOOST_CHECK(!boost::filesystem::exists(dk_log_file));
+
+  read_only_segment_t reader(new ReadOnlySegment(dictionary.GetFileName()));
+  BOOST_CHECK_EQUAL(DELETED_KEYS_LOG_MIN_COMPACTION + 10, reader->DeletedKeysSize());
+
+  segment->RemoveFiles();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace internal
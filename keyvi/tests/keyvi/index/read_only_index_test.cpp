@@ -22,8 +22,14 @@
  *  Created on: Jan 13, 2017
  *      Author: hendrik
  */
+#include <algorithm>
 #include <chrono>  //NOLINT
+#include <functional>
+#include <string>
 #include <thread>  //NOLINT
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
@@ -75,8 +81,6 @@ BOOST_AUTO_TEST_CASE(basicindex) {
   index.AddSegment(&test_data_3);
   BOOST_CHECK(reader.Contains("abc"));
 
-  BOOST_CHECK_EQUAL(reader["abbcd"]->GetValueAsString(), "\"{c:6}\"");
-
   // force reload
   reader.Reload();
   BOOST_CHECK(reader.Contains("abc"));
@@ -147,6 +151,113 @@ BOOST_AUTO_TEST_CASE(indexwithdeletedkeys) {
   BOOST_CHECK(!reader.Contains("störe"));
 }
 
+#if defined(__linux__)
+void change_notification_test(const keyvi::util::parameters_t& params) {
+  testing::IndexMock index;
+
+  std::vector<std::pair<std::string, std::string>> test_data = {{"abc", "{a:1}"}, {"abbc", "{b:2}"}};
+  index.AddSegment(&test_data);
+
+  ReadOnlyIndex reader(index.GetIndexFolder(), params);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  auto wait_for = [](std::function<bool()> condition) {
+    for (size_t i = 0; i < 100 && !condition(); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+  };
+
+  std::vector<std::pair<std::string, std::string>> test_data_2 = {{"abbc", "{b:3}"}, {"babc", "{a:1}"}};
+  index.AddSegment(&test_data_2);
+  BOOST_CHECK(wait_for([&reader] { return reader.Contains("babc"); }));
+  BOOST_CHECK_EQUAL(reader["abbc"]->GetValueAsString(), "\"{b:3}\"");
+
+  index.AddDeletedKeys({"abc"}, 0);
+  BOOST_CHECK(wait_for([&reader] { return !reader.Contains("abc"); }));
+
+  index.AddDeletedKeys({"abbc"}, 1);
+  BOOST_CHECK(wait_for([&reader] { return !reader.Contains("abbc"); }));
+}
+
+BOOST_AUTO_TEST_CASE(changenotification) {
+  // with change notifications the reader must not wait for the refresh interval
+  change_notification_test({{"refresh_interval", "3000"}});
+
+  // without polling, changes are only picked up from notifications
+  change_notification_test({{"refresh_interval", "10"}, {"watcher_poll_interval", "0"}});
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(getMany) {
+  testing::IndexMock index;
+
+  std::vector<std::pair<std::string, std::string>> test_data = {
+      {"abc", "{a:1}"}, {"abbc", "{b:2}"}, {"abbcd", "{c:3}"}, {"abdd", "{b:2}"}};
+  index.AddSegment(&test_data);
+
+  std::vector<std::pair<std::string, std::string>> test_data_2 = {{"abbcd", "{c:6}"}, {"babc", "{a:1}"}};
+  index.AddSegment(&test_data_2);
+  index.AddDeletedKeys({"abdd"}, 0);
+
+  ReadOnlyIndex reader(index.GetIndexFolder(), {{"refresh_interval", "400"}});
+
+  const std::vector<std::string> keys = {"abc", "abbcd", "abdd", "babc", "ab", ""};
+  auto matches = reader.GetMany(keys);
+  auto contains = reader.ContainsMany(keys);
+
+  BOOST_CHECK_EQUAL(keys.size(), matches.size());
+  BOOST_CHECK_EQUAL(keys.size(), contains.size());
+  BOOST_CHECK_EQUAL(matches[0]->GetValueAsString(), "\"{a:1}\"");
+  BOOST_CHECK_EQUAL(matches[1]->GetValueAsString(), "\"{c:6}\"");
+  BOOST_CHECK(!matches[2]);
+  BOOST_CHECK_EQUAL(matches[3]->GetValueAsString(), "\"{a:1}\"");
+  BOOST_CHECK(!matches[4]);
+  BOOST_CHECK(!matches[5]);
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    BOOST_CHECK_EQUAL(reader.Contains(keys[i]), contains[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(forEachMatch) {
+  testing::IndexMock index;
+
+  std::vector<std::pair<std::string, std::string>> test_data = {
+      {"abc", "{a:1}"}, {"abbc", "{b:2}"}, {"abbcd", "{c:3}"}, {"abdd", "{b:2}"}};
+  index.AddSegment(&test_data);
+
+  std::vector<std::pair<std::string, std::string>> test_data_2 = {
+      {"abbcd", "{c:6}"}, {"babc", "{a:1}"}, {"bbc", "{d:1}"}};
+  index.AddSegment(&test_data_2);
+
+  std::vector<std::pair<std::string, std::string>> visited;
+  auto visitor = [&visited](const dictionary::MatchView& m) {
+    visited.emplace_back(m.GetMatchedString(), m.GetValueAsString());
+  };
+
+  ReadOnlyIndex reader_1(index.GetIndexFolder(), {{"refresh_interval", "400"}});
+  reader_1.ForEachMatch(visitor);
+  std::vector<std::pair<std::string, std::string>> expected = {{"abbc", "\"{b:2}\""}, {"abbcd", "\"{c:6}\""},
+                                                               {"abc", "\"{a:1}\""},  {"abdd", "\"{b:2}\""},
+                                                               {"babc", "\"{a:1}\""}, {"bbc", "\"{d:1}\""}};
+  BOOST_CHECK(expected == visited);
+
+  index.AddDeletedKeys({"abdd", "abbcd"}, 0);
+  index.AddDeletedKeys({"babc"}, 1);
+
+  visited.clear();
+  ReadOnlyIndex reader_2(index.GetIndexFolder(), {{"refresh_interval", "400"}});
+  reader_2.ForEachMatch(visitor);
+  expected = {{"abbc", "\"{b:2}\""}, {"abbcd", "\"{c:6}\""}, {"abc", "\"{a:1}\""}, {"bbc", "\"{d:1}\""}};
+  BOOST_CHECK(expected == visited);
+
+  // stop early
+  size_t calls = 0;
+  reader_2.ForEachMatch([&calls](const dictionary::MatchView& m) { return ++calls < 2; });
+  BOOST_CHECK_EQUAL(2, calls);
+}
+
 void testFuzzyMatching(ReadOnlyIndex* reader, const std::string& query, const size_t max_edit_distance,
                        const size_t minimum_exact_prefix, const std::vector<std::string>& expected_matches,
                        const std::vector<std::string>& expected_values) {
@@ -226,7 +337,115 @@ BOOST_AUTO_TEST_CASE(fuzzyMatchingExactPrefix) {
   testFuzzyMatching(&reader_1, "app", 0, 1, {}, {});
   testFuzzyMatching(&reader_1, "ap", 1, 1, {"a"}, {"\"{a:1}\""});
   index.AddDeletedKeys({"a"}, 0);
-  testFuzzyMatching(&reader_1, "ap", 1, 1, {"a"}, {"\"{a:1}\""});
+  reader_1.Reload();
+  testFuzzyMatching(&reader_1, "ap", 1, 1, {}, {});
+}
+
+BOOST_AUTO_TEST_CASE(fuzzyMatchingParallel) {
+  testing::IndexMock index;
+
+  std::vector<std::pair<std::string, std::string>> test_data = {{"abc", "{a:1}"},   {"abbc", "{b:2}"},
+                                                                {"abbcd", "{c:3}"}, {"abcde", "{a:1}"},
+                                                                {"abdd", "{b:3}"},  {"bbdd", "{f:2}"}};
+  index.AddSegment(&test_data);
+  std::vector<std::pair<std::string, std::string>> test_data_2 = {
+      {"abbcd", "{c:6}"}, {"abcde", "{x:1}"},  {"babc", "{a:1}"},
+      {"babbc", "{b:2}"}, {"babcde", "{a:1}"}, {"babdd", "{g:2}"},
+  };
+  index.AddSegment(&test_data_2);
+  std::vector<std::pair<std::string, std::string>> test_data_3 = {
+      {"abb", "{d:1}"}, {"abbc", "{d:2}"}, {"abdd", "{d:3}"}, {"bbdd", "{d:4}"}, {"zzz", "{d:5}"}};
+  index.AddSegment(&test_data_3);
+
+  ReadOnlyIndex reader_1(index.GetIndexFolder(), {{"refresh_interval", "400"}, {"parallel_query_min_segments", "2"}});
+
+  testFuzzyMatching(&reader_1, "abbc", 1, 2, {"abb", "abbc", "abbcd", "abc"},
+                    {"\"{d:1}\"", "\"{d:2}\"", "\"{c:6}\"", "\"{a:1}\""});
+  testFuzzyMatching(&reader_1, "babbc", 0, 3, {"babbc"}, {"\"{b:2}\""});
+  testFuzzyMatching(&reader_1, "babbc", 3, 10, {}, {});
+
+  index.AddDeletedKeys({"abbcd", "abcde", "babbc"}, 1);
+  index.AddDeletedKeys({"abbcd", "bbdd"}, 0);
+  index.AddDeletedKeys({"abdd"}, 2);
+
+  ReadOnlyIndex reader_2(index.GetIndexFolder(), {{"refresh_interval", "400"}, {"parallel_query_min_segments", "2"}});
+  ReadOnlyIndex reader_3(index.GetIndexFolder(), {{"refresh_interval", "400"}});
+
+  testFuzzyMatching(&reader_2, "abbc", 2, 2, {"abb", "abbc", "abc"}, {"\"{d:1}\"", "\"{d:2}\"", "\"{a:1}\""});
+  testFuzzyMatching(&reader_2, "bbdd", 2, 1, {"babdd", "bbdd"}, {"\"{g:2}\"", "\"{d:4}\""});
+
+  // same matches in the same order as without parallel queries
+  for (const std::string query : {"abbc", "abc", "bbdd", "babbc", "zz", "ab"}) {
+    for (int32_t max_edit_distance = 0; max_edit_distance < 4; ++max_edit_distance) {
+      for (size_t minimum_exact_prefix = 0; minimum_exact_prefix < 3; ++minimum_exact_prefix) {
+        std::vector<std::string> expected;
+        for (auto m : reader_3.GetFuzzy(query, max_edit_distance, minimum_exact_prefix)) {
+          expected.push_back(m->GetMatchedString() + m->GetValueAsString());
+        }
+        std::vector<std::string> actual;
+        for (auto m : reader_2.GetFuzzy(query, max_edit_distance, minimum_exact_prefix)) {
+          actual.push_back(m->GetMatchedString() + m->GetValueAsString());
+        }
+        BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), actual.begin(), actual.end());
+      }
+    }
+  }
+}
+
+void testFuzzyMatchingTopN(ReadOnlyIndex* reader, const std::string& query, const size_t max_edit_distance,
+                           const size_t minimum_exact_prefix, const size_t top_n,
+                           const std::vector<std::tuple<double, std::string, std::string>>& expected) {
+  std::vector<std::tuple<double, std::string, std::string>> actual;
+
+  auto matcher = reader->GetFuzzy(query, max_edit_distance, minimum_exact_prefix, top_n);
+  for (auto m : matcher) {
+    BOOST_CHECK(actual.empty() || std::get<0>(actual.back()) <= m->GetScore());
+    actual.emplace_back(m->GetScore(), m->GetMatchedString(), m->GetValueAsString());
+  }
+
+  // without weights the order of matches with the same score is not defined
+  std::sort(actual.begin(), actual.end());
+  BOOST_CHECK(expected == actual);
+}
+
+BOOST_AUTO_TEST_CASE(fuzzyMatchingTopN) {
+  testing::IndexMock index;
+
+  std::vector<std::pair<std::string, std::string>> test_data = {{"abc", "{a:1}"},   {"abbc", "{b:2}"},
+                                                                {"abbcd", "{c:3}"}, {"abcde", "{a:1}"},
+                                                                {"abdd", "{b:3}"},  {"bbdd", "{f:2}"}};
+  index.AddSegment(&test_data);
+  std::vector<std::pair<std::string, std::string>> test_data_2 = {
+      {"abbcd", "{c:6}"}, {"abcde", "{x:1}"},  {"babc", "{a:1}"},
+      {"babbc", "{b:2}"}, {"babcde", "{a:1}"}, {"babdd", "{g:2}"},
+  };
+
+  index.AddSegment(&test_data_2);
+  ReadOnlyIndex reader_1(index.GetIndexFolder(), {{"refresh_interval", "400"}});
+
+  testFuzzyMatchingTopN(&reader_1, "abbc", 1, 2, 1, {{0, "abbc", "\"{b:2}\""}});
+  testFuzzyMatchingTopN(&reader_1, "abbc", 1, 2, 10,
+                        {{0, "abbc", "\"{b:2}\""}, {1, "abbcd", "\"{c:6}\""}, {1, "abc", "\"{a:1}\""}});
+  testFuzzyMatchingTopN(&reader_1, "abbc", 4, 1, 5,
+                        {{0, "abbc", "\"{b:2}\""},
+                         {1, "abbcd", "\"{c:6}\""},
+                         {1, "abc", "\"{a:1}\""},
+                         {2, "abdd", "\"{b:3}\""},
+                         {3, "abcde", "\"{x:1}\""}});
+  testFuzzyMatchingTopN(&reader_1, "babbc", 3, 10, 5, {});
+  testFuzzyMatchingTopN(&reader_1, "abbc", 1, 2, 0, {});
+
+  index.AddDeletedKeys({"abbcd", "abcde", "babbc"}, 1);
+  index.AddDeletedKeys({"abbcd", "bbdd"}, 0);
+
+  ReadOnlyIndex reader_2(index.GetIndexFolder(), {{"refresh_interval", "400"}});
+
+  // deleted keys do not count
+  testFuzzyMatchingTopN(&reader_2, "abbc", 1, 2, 2, {{0, "abbc", "\"{b:2}\""}, {1, "abc", "\"{a:1}\""}});
+  testFuzzyMatchingTopN(&reader_2, "abbc", 2, 2, 3,
+                        {{0, "abbc", "\"{b:2}\""}, {1, "abc", "\"{a:1}\""}, {2, "abdd", "\"{b:3}\""}});
+  testFuzzyMatchingTopN(&reader_2, "babbc", 2, 3, 1, {{1, "babc", "\"{a:1}\""}});
+  testFuzzyMatchingTopN(&reader_2, "bbdd", 2, 1, 3, {{1, "babdd", "\"{g:2}\""}});
 }
 
 void testNearMatching(ReadOnlyIndex* reader, const std::string& query, const size_t minimum_exact_prefix,
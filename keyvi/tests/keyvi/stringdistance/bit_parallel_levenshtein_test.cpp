@@ -0,0 +1,128 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * bit_parallel_levenshtein_test.cpp
+ */
+
+#include "keyvi/stringdistance/bit_parallel_levenshtein.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "utf8.h"
+
+#include "keyvi/stringdistance/costfunctions/damerau_levenshtein.h"
+#include "keyvi/stringdistance/costfunctions/damerau_levenshtein_completion.h"
+#include "keyvi/stringdistance/needleman_wunsch.h"
+
+namespace keyvi {
+namespace stringdistance {
+
+BOOST_AUTO_TEST_SUITE(BitParallelLevenshteinTests)
+
+/**
+ * Put random candidates, going back to earlier positions like a traversal, and compare with NeedlemanWunsch.
+ */
+template <class CostFunctionT>
+void compare_with_needleman_wunsch(const size_t max_query_length) {
+  const std::vector<uint32_t> alphabet = {'a', 'b', 'c', 0xe4};
+  std::mt19937 generator(7);
+  std::uniform_int_distribution<size_t> alphabet_distribution(0, alphabet.size() - 1);
+  std::uniform_int_distribution<size_t> length_distribution(1, max_query_length);
+
+  for (size_t i = 0; i < 100; ++i) {
+    std::vector<uint32_t> query(length_distribution(generator));
+    for (auto& codepoint : query) {
+      codepoint = alphabet[alphabet_distribution(generator)];
+    }
+    const int32_t max_distance = i % 4;
+
+    BitParallelLevenshtein<CostFunctionT> bit_parallel(query, 20, max_distance);
+    NeedlemanWunsch<CostFunctionT> needleman_wunsch(query, 20, max_distance);
+    // without cutoff for comparing scores above the max distance
+    NeedlemanWunsch<CostFunctionT> needleman_wunsch_exact(query, 20, 1000);
+
+    size_t position = 0;
+    for (size_t step = 0; step < 300; ++step) {
+      const uint32_t codepoint = alphabet[alphabet_distribution(generator)];
+
+      const int32_t expected_intermediate = needleman_wunsch.Put(codepoint, position);
+      needleman_wunsch_exact.Put(codepoint, position);
+      const int32_t intermediate = bit_parallel.Put(codepoint, position);
+
+      if (expected_intermediate <= max_distance || intermediate <= max_distance) {
+        BOOST_CHECK_EQUAL(expected_intermediate, intermediate);
+      }
+      BOOST_CHECK_EQUAL(needleman_wunsch_exact.GetScore(), bit_parallel.GetScore());
+      // NeedlemanWunsch does not update the score for candidates longer than the query + max distance
+      if (position < query.size() + max_distance && needleman_wunsch.GetScore() <= max_distance) {
+        BOOST_CHECK_EQUAL(needleman_wunsch.GetScore(), bit_parallel.GetScore());
+      }
+      BOOST_CHECK_EQUAL(needleman_wunsch.GetCandidate(), bit_parallel.GetCandidate());
+
+      // go deeper or back to an earlier position
+      if (generator() % 4 != 0 && position < query.size() + max_distance + 2) {
+        ++position;
+      } else {
+        position = generator() % (position + 1);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(sameAsNeedlemanWunsch) {
+  compare_with_needleman_wunsch<costfunctions::Damerau_Levenshtein>(10);
+  compare_with_needleman_wunsch<costfunctions::Damerau_LevenshteinCompletion>(10);
+}
+
+BOOST_AUTO_TEST_CASE(longInput) {
+  // inputs longer than a word
+  compare_with_needleman_wunsch<costfunctions::Damerau_Levenshtein>(150);
+  compare_with_needleman_wunsch<costfunctions::Damerau_LevenshteinCompletion>(150);
+}
+
+BOOST_AUTO_TEST_CASE(reset) {
+  std::vector<uint32_t> codepoints;
+  std::string input = "text";
+  utf8::unchecked::utf8to32(input.begin(), input.end(), back_inserter(codepoints));
+
+  BitParallelLevenshtein<costfunctions::Damerau_Levenshtein> metric(codepoints, 20, 2);
+  metric.Put('t', 0);
+  metric.Put('x', 1);
+  BOOST_CHECK_EQUAL(2, metric.GetScore());
+
+  codepoints.clear();
+  input = "tx";
+  utf8::unchecked::utf8to32(input.begin(), input.end(), back_inserter(codepoints));
+  metric.Reset(codepoints, 2);
+  metric.Put('t', 0);
+  BOOST_CHECK_EQUAL(1, metric.GetScore());
+  metric.Put('x', 1);
+  BOOST_CHECK_EQUAL(0, metric.GetScore());
+  BOOST_CHECK_EQUAL("tx", metric.GetCandidate());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace stringdistance */
+} /* namespace keyvi */
@@ -0,0 +1,135 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * levenshtein_automaton_test.cpp
+ */
+
+#include "keyvi/stringdistance/levenshtein_automaton.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "utf8.h"
+
+#include "keyvi/stringdistance/levenshtein.h"
+
+namespace keyvi {
+namespace stringdistance {
+
+BOOST_AUTO_TEST_SUITE(LevenshteinAutomatonTests)
+
+std::vector<uint32_t> to_codepoints(const std::string& input) {
+  std::vector<uint32_t> codepoints;
+  utf8::unchecked::utf8to32(input.begin(), input.end(), back_inserter(codepoints));
+  return codepoints;
+}
+
+// returns the automaton score if the candidate is accepted, -1 otherwise
+int32_t automaton_score(LevenshteinAutomaton* automaton, const std::vector<uint32_t>& candidate) {
+  LevenshteinAutomaton::state_t state = automaton->GetStartState();
+  for (const uint32_t codepoint : candidate) {
+    state = automaton->Step(state, codepoint);
+  }
+  return automaton->IsFinal(state) ? automaton->GetScore(state) : -1;
+}
+
+BOOST_AUTO_TEST_CASE(distances) {
+  LevenshteinAutomaton automaton(to_codepoints("text"), 2);
+
+  BOOST_CHECK_EQUAL(0, automaton_score(&automaton, to_codepoints("text")));
+  BOOST_CHECK_EQUAL(1, automaton_score(&automaton, to_codepoints("tet")));
+  BOOST_CHECK_EQUAL(1, automaton_score(&automaton, to_codepoints("texts")));
+  BOOST_CHECK_EQUAL(1, automaton_score(&automaton, to_codepoints("txet")));
+  BOOST_CHECK_EQUAL(2, automaton_score(&automaton, to_codepoints("xtet")));
+  BOOST_CHECK_EQUAL(2, automaton_score(&automaton, to_codepoints("t\xc3\xa4xt\xc3\xa4")));
+  BOOST_CHECK_EQUAL(-1, automaton_score(&automaton, to_codepoints("teller")));
+  BOOST_CHECK_EQUAL(-1, automaton_score(&automaton, to_codepoints("")));
+
+  // once dead, always dead
+  LevenshteinAutomaton::state_t state = automaton.GetStartState();
+  for (const uint32_t codepoint : to_codepoints("xyz")) {
+    state = automaton.Step(state, codepoint);
+  }
+  BOOST_CHECK_EQUAL(LevenshteinAutomaton::DEAD_STATE, state);
+  BOOST_CHECK_EQUAL(LevenshteinAutomaton::DEAD_STATE, automaton.Step(state, 't'));
+
+  // reuse for a different query
+  automaton.Reset(to_codepoints("\xc3\xa4" "b"), 0);
+  BOOST_CHECK_EQUAL(0, automaton_score(&automaton, to_codepoints("\xc3\xa4" "b")));
+  BOOST_CHECK_EQUAL(-1, automaton_score(&automaton, to_codepoints("b\xc3\xa4")));
+  BOOST_CHECK_EQUAL(-1, automaton_score(&automaton, to_codepoints("ab")));
+
+  automaton.Reset(to_codepoints("ab"), -1);
+  BOOST_CHECK_EQUAL(LevenshteinAutomaton::DEAD_STATE, automaton.GetStartState());
+}
+
+BOOST_AUTO_TEST_CASE(sameAsLevenshtein) {
+  // small alphabet with a non ascii character to get many near matches
+  const std::vector<uint32_t> alphabet = {'a', 'b', 'c', 0xe4};
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<size_t> length_distribution(0, 7);
+  std::uniform_int_distribution<size_t> alphabet_distribution(0, alphabet.size() - 1);
+
+  auto random_sequence = [&]() {
+    std::vector<uint32_t> sequence(length_distribution(generator));
+    for (auto& codepoint : sequence) {
+      codepoint = alphabet[alphabet_distribution(generator)];
+    }
+    return sequence;
+  };
+
+  for (size_t i = 0; i < 200; ++i) {
+    const std::vector<uint32_t> query = random_sequence();
+    if (query.empty()) {
+      continue;
+    }
+
+    for (int32_t max_distance = 0; max_distance < 4; ++max_distance) {
+      LevenshteinAutomaton automaton(query, max_distance);
+
+      for (size_t j = 0; j < 50; ++j) {
+        const std::vector<uint32_t> candidate = random_sequence();
+
+        int32_t expected = -1;
+        if (candidate.size() <= query.size() + max_distance && candidate.size() > 0) {
+          Levenshtein metric(query, 20, max_distance);
+          for (size_t position = 0; position < candidate.size(); ++position) {
+            metric.Put(candidate[position], position);
+          }
+          if (metric.GetScore() <= max_distance) {
+            expected = metric.GetScore();
+          }
+        } else if (candidate.size() == 0 && static_cast<int32_t>(query.size()) <= max_distance) {
+          expected = query.size();
+        }
+
+        BOOST_CHECK_EQUAL(expected, automaton_score(&automaton, candidate));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace stringdistance */
+} /* namespace keyvi */
@@ -24,6 +24,9 @@
  */
 
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -75,6 +78,54 @@ BOOST_AUTO_TEST_CASE(NormalizePartialAtEnd) {
   BOOST_CHECK_EQUAL("xb", transformer.Normalize(input));
 }
 
+BOOST_AUTO_TEST_CASE(NormalizePartialMatches) {
+  std::vector<std::pair<std::string, std::string>> test_data = {
+      {"aa", "b"}, {"c", "d"}, {"caa", "ef"}, {"a", "g"}, {"xyz", "1"},
+  };
+
+  testing::TempDictionary dictionary(&test_data);
+  auto transformer = FsaTransform(dictionary.GetFsa());
+
+  // the rest after a partial match gets normalized, too
+  BOOST_CHECK_EQUAL("dg", transformer.Normalize("ca"));
+  BOOST_CHECK_EQUAL("dgdgb", transformer.Normalize("cacab"));
+  BOOST_CHECK_EQUAL("xyx1", transformer.Normalize("xyxxyz"));
+  BOOST_CHECK_EQUAL("xy", transformer.Normalize("xy"));
+  BOOST_CHECK_EQUAL("", transformer.Normalize(""));
+}
+
+BOOST_AUTO_TEST_CASE(NormalizeIntoBuffer) {
+  std::vector<std::pair<std::string, std::string>> test_data = {{"aa", "x"}, {"aabc", "y"}};
+
+  testing::TempDictionary dictionary(&test_data);
+  auto transformer = FsaTransform(dictionary.GetFsa());
+
+  std::string output;
+  transformer.Normalize("aabc aab", &output);
+  BOOST_CHECK_EQUAL("y xb", output);
+
+  // the buffer gets cleared
+  transformer.Normalize("b", &output);
+  BOOST_CHECK_EQUAL("b", output);
+}
+
+BOOST_AUTO_TEST_CASE(NormalizeBatch) {
+  std::vector<std::pair<std::string, uint32_t>> test_data = {{"one", 1}, {"two", 2}, {"three", 3}};
+
+  testing::TempDictionary dictionary(&test_data);
+  auto transformer = FsaTransform(dictionary.GetFsa());
+
+  // values which need decoding
+  const std::vector<std::string> inputs = {"one two three", "", "three times two", "none"};
+  std::vector<std::string> expected = {"1 2 3", "", "3 times 2", "n1"};
+  BOOST_CHECK(expected == transformer.Normalize(inputs));
+
+  // existing outputs get overwritten
+  std::vector<std::string> outputs = {"a", "b", "c", "d", "e", "f"};
+  transformer.Normalize(inputs, &outputs);
+  BOOST_CHECK(expected == outputs);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace transform
@@ -0,0 +1,93 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * rate_limiter_test.cpp
+ */
+
+#include <chrono>  // NOLINT
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/util/rate_limiter.h"
+
+namespace keyvi {
+namespace util {
+
+BOOST_AUTO_TEST_SUITE(RateLimiterTests)
+
+BOOST_AUTO_TEST_CASE(unlimited) {
+  RateLimiter limiter;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < 100; ++i) {
+    limiter.Acquire(1024 * 1024 * 1024);
+  }
+  BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100));
+}
+
+BOOST_AUTO_TEST_CASE(limited) {
+  RateLimiter limiter(10 * 1024 * 1024);
+
+  // 1s worth of bytes can be used without pause
+  auto start = std::chrono::steady_clock::now();
+  limiter.Acquire(10 * 1024 * 1024);
+  BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(200));
+
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < 5; ++i) {
+    limiter.Acquire(1024 * 1024);
+  }
+  BOOST_CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(400));
+
+  // lifting the limit takes effect immediately
+  limiter.SetRate(0);
+  start = std::chrono::steady_clock::now();
+  limiter.Acquire(100 * 1024 * 1024);
+  BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100));
+}
+
+BOOST_AUTO_TEST_CASE(stream_buffer) {
+  RateLimiter limiter(1024 * 1024);
+
+  // use up the burst
+  limiter.Acquire(1024 * 1024);
+
+  std::ostringstream target;
+  RateLimitedStreamBuffer buffer(target.rdbuf(), &limiter);
+  std::ostream stream(&buffer);
+
+  const std::string data(512 * 1024, 'x');
+  auto start = std::chrono::steady_clock::now();
+  stream << 'a';
+  stream.write(data.data(), data.size());
+  stream.flush();
+  BOOST_CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(400));
+
+  BOOST_CHECK(stream.good());
+  BOOST_CHECK_EQUAL(data.size() + 1, target.str().size());
+  BOOST_CHECK_EQUAL('a', target.str()[0]);
+  BOOST_CHECK_EQUAL('x', target.str().back());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace util */
+} /* namespace keyvi */
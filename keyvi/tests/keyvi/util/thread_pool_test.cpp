@@ -0,0 +1,75 @@
+//
+// keyvi - A key value store.
+//
+// Copyright 2026 Hendrik Muhs<hendrik.muhs@gmail.com>
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*
+ * thread_pool_test.cpp
+ */
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "keyvi/util/thread_pool.h"
+
+namespace keyvi {
+namespace util {
+
+BOOST_AUTO_TEST_SUITE(ThreadPoolTests)
+
+BOOST_AUTO_TEST_CASE(parallelfor) {
+  ThreadPool pool(4);
+
+  for (size_t n : {0, 1, 3, 4, 100}) {
+    std::vector<size_t> calls(n, 0);
+    pool.ParallelFor(n, [&calls](const size_t i) { ++calls[i]; });
+    for (size_t i = 0; i < n; ++i) {
+      BOOST_CHECK_EQUAL(1, calls[i]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(parallelfornested) {
+  ThreadPool pool(2);
+  std::atomic_size_t calls{0};
+
+  // inner calls run on pool threads, the pool must not deadlock
+  pool.ParallelFor(8, [&pool, &calls](const size_t) { pool.ParallelFor(8, [&calls](const size_t) { ++calls; }); });
+  BOOST_CHECK_EQUAL(64, calls);
+}
+
+BOOST_AUTO_TEST_CASE(parallelforexception) {
+  ThreadPool pool(2);
+  std::atomic_size_t calls{0};
+
+  BOOST_CHECK_THROW(pool.ParallelFor(10,
+                                     [&calls](const size_t i) {
+                                       ++calls;
+                                       if (i == 5) {
+                                         throw std::invalid_argument("5");
+                                       }
+                                     }),
+                    std::invalid_argument);
+  BOOST_CHECK_EQUAL(10, calls);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace util */
+} /* namespace keyvi */
@@ -7,4 +7,4 @@ n=FsaTransform(d)
 
 
 for line in sys.stdin:
-    print(n.Normalize(line))
+    print(n.normalize(line))
@@ -0,0 +1,28 @@
+
+
+    def normalize(self, input):
+        """Replace all keys of the dictionary found in input with their values, releases the GIL."""
+        if isinstance(input, unicode):
+            input = input.encode('utf-8')
+        assert isinstance(input, bytes), 'arg input wrong type'
+
+        cdef libcpp_string input_string = <libcpp_string> input
+        cdef libcpp_string result
+        with nogil:
+            result = self.inst.get().Normalize(input_string)
+        return result
+
+    def normalize_batch(self, inputs):
+        """Normalize a list of inputs at once, releases the GIL for the whole batch."""
+        cdef libcpp_vector[libcpp_string] input_strings
+        input_strings.reserve(len(inputs))
+        for input in inputs:
+            if isinstance(input, unicode):
+                input = input.encode('utf-8')
+            assert isinstance(input, bytes), 'arg inputs wrong type'
+            input_strings.push_back(<libcpp_string> input)
+
+        cdef libcpp_vector[libcpp_string] results
+        with nogil:
+            results = self.inst.get().Normalize(input_strings)
+        return [result for result in results]
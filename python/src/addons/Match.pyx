@@ -41,13 +41,28 @@
 
     @property
     def value(self):
-        cdef libcpp_string packed_value = self.inst.get().GetMsgPackedValueAsString()
-        if packed_value.empty():
+        packed_value = self.msgpacked_value_as_memoryview()
+        if len(packed_value) == 0:
             return None
 
         return msgpack.loads(packed_value)
 
 
+    def msgpacked_value_as_memoryview(self):
+        """msgpack value as read-only memoryview, uncompressed values are not copied but read from the dictionary"""
+        cdef string_view packed_view
+        cdef _ValueView view
+
+        if not self.inst.get().GetMsgPackedValueAsStringView(&packed_view):
+            return memoryview(<bytes> self.inst.get().GetMsgPackedValueAsString())
+
+        view = _ValueView.__new__(_ValueView)
+        view.owner = self
+        view.data = packed_view.data()
+        view.size = packed_view.size()
+        return memoryview(view)
+
+
     def GetValue(self, *args):
         """deprecated, use value property"""        
         return call_deprecated_method_getter("GetValue", "value", self.value, *args)
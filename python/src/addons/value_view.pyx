@@ -0,0 +1,15 @@
+from cpython.buffer cimport PyBuffer_FillInfo
+from libcpp.string_view cimport string_view
+
+
+cdef class _ValueView:
+    """Read-only buffer on a value inside a dictionary, keeps the owning match alive."""
+    cdef object owner
+    cdef const char* data
+    cdef Py_ssize_t size
+
+    def __getbuffer__(self, Py_buffer* buffer, int flags):
+        PyBuffer_FillInfo(buffer, self, <void*> self.data, self.size, 1, flags)
+
+    def __releasebuffer__(self, Py_buffer* buffer):
+        pass
@@ -19,7 +19,9 @@ cdef extern from "keyvi/dictionary/dictionary.h" namespace "keyvi::dictionary":
         populate_lazy, # load data lazy but ask the OS to read ahead if possible (does not block)
         lazy_no_readahead, # disable any read-ahead (for cases when index > x * main memory)
         lazy_no_readahead_value_part, # disable read-ahead only for the value part
-        populate_key_part_no_readahead_value_part # populate the key part, but disable read ahead value part
+        populate_key_part_no_readahead_value_part, # populate the key part, but disable read ahead value part
+        huge_pages_key_part, # ask the OS to back the key part with transparent huge pages, load value part lazy
+        copy_key_part_huge_pages # copy the key part into anonymous huge pages (MAP_HUGETLB), never faults after loading
         
     cdef cppclass Dictionary:
         # wrap-doc:
@@ -38,6 +40,12 @@ cdef extern from "keyvi/dictionary/dictionary.h" namespace "keyvi::dictionary":
         _MatchIteratorPair GetNear (libcpp_utf8_string key, size_t minimum_prefix_length, bool greedy) except + # wrap-as:match_near
         _MatchIteratorPair GetFuzzy (libcpp_utf8_string key, int32_t max_edit_distance) except + # wrap-as:match_fuzzy
         _MatchIteratorPair GetFuzzy (libcpp_utf8_string key, int32_t max_edit_distance, size_t minimum_exact_prefix) except + # wrap-as:match_fuzzy
+        _MatchIteratorPair GetFuzzy (libcpp_utf8_string key, int32_t max_edit_distance, size_t minimum_exact_prefix, size_t top_n) except + # wrap-as:match_fuzzy
+        _MatchIteratorPair GetFuzzyWithAutomaton (libcpp_utf8_string key, int32_t max_edit_distance) except + # wrap-as:match_fuzzy_with_automaton
+        _MatchIteratorPair GetFuzzyWithAutomaton (libcpp_utf8_string key, int32_t max_edit_distance, size_t minimum_exact_prefix) except + # wrap-as:match_fuzzy_with_automaton
+        # wrap-doc:
+        #  Same matches as match_fuzzy, using a Levenshtein automaton
+        #  which is faster for large dictionaries.
         _MatchIteratorPair GetPrefixCompletion (libcpp_utf8_string key) except + # wrap-as:complete_prefix
         # wrap-doc:
         #  Complete the given key to full matches(prefix matching)
@@ -17,6 +17,7 @@ cdef extern from "keyvi/index/index.h" namespace "keyvi::index":
         _MatchIteratorPair GetNear (libcpp_utf8_string, size_t minimum_prefix_length) except + # wrap-as:get_near
         _MatchIteratorPair GetNear (libcpp_utf8_string, size_t minimum_prefix_length, bool greedy) except + # wrap-as:get_near
         _MatchIteratorPair GetFuzzy(libcpp_utf8_string, int32_t max_edit_distance, size_t minimum_exact_prefix) except + # wrap-as:get_fuzzy
+        _MatchIteratorPair GetFuzzy(libcpp_utf8_string, int32_t max_edit_distance, size_t minimum_exact_prefix, size_t top_n) except + # wrap-as:get_fuzzy
         void Delete(libcpp_utf8_string) except+ # wrap-as:delete
         void Flush() except+ # wrap-as:flush
         void Flush(bool) except+ # wrap-as:flush
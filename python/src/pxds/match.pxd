@@ -2,6 +2,7 @@ from libc.stdint cimport uint32_t
 from libcpp.string cimport string as libcpp_string
 from libcpp.string cimport string as libcpp_utf8_string
 from libcpp.string cimport string as libcpp_utf8_output_string
+from libcpp.string_view cimport string_view
 from libcpp cimport bool
 from cpython.ref cimport PyObject
 from compression cimport CompressionAlgorithm
@@ -23,6 +24,7 @@ cdef extern from "keyvi/dictionary/match.h" namespace "keyvi::dictionary":
         libcpp_string GetRawValueAsString() except + # wrap-as:raw_value_as_string
         libcpp_string GetMsgPackedValueAsString() except + # wrap-as:msgpacked_value_as_string
         libcpp_string GetMsgPackedValueAsString(CompressionAlgorithm) except + # wrap-as:msgpacked_value_as_string
+        bool GetMsgPackedValueAsStringView(string_view*) # wrap-ignore
         void SetRawValue(libcpp_utf8_string) except + # wrap-ignore
         void SetAttribute(libcpp_utf8_string, libcpp_utf8_string) except + # wrap-ignore
         void SetAttribute(libcpp_utf8_string, float) except + # wrap-ignore
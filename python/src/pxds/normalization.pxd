@@ -1,9 +1,11 @@
 from libcpp.string cimport string as libcpp_string
 from libcpp.string cimport string as libcpp_utf8_string
+from libcpp.vector cimport vector as libcpp_vector
 from dictionary cimport Dictionary
 from libcpp.memory cimport shared_ptr
 
 cdef extern from "keyvi/transform/fsa_transform.h" namespace "keyvi::transform":
     cdef cppclass FsaTransform:
         FsaTransform(shared_ptr[Dictionary]) except +
-        libcpp_string Normalize(libcpp_utf8_string) nogil # wrap-as:normalize
+        libcpp_string Normalize(libcpp_utf8_string) nogil # wrap-ignore
+        libcpp_vector[libcpp_string] Normalize(libcpp_vector[libcpp_string]) nogil # wrap-ignore
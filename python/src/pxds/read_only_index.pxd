@@ -13,5 +13,6 @@ cdef extern from "keyvi/index/read_only_index.h" namespace "keyvi::index":
         bool Contains(libcpp_utf8_string) # wrap-ignore
         shared_ptr[Match] operator[](libcpp_utf8_string) # wrap-ignore
         _MatchIteratorPair GetFuzzy(libcpp_utf8_string, int32_t max_edit_distance, size_t minimum_exact_prefix) except+ # wrap-as:get_fuzzy
+        _MatchIteratorPair GetFuzzy(libcpp_utf8_string, int32_t max_edit_distance, size_t minimum_exact_prefix, size_t top_n) except+ # wrap-as:get_fuzzy
         _MatchIteratorPair GetNear (libcpp_utf8_string, size_t minimum_prefix_length) except + # wrap-as:get_near
         _MatchIteratorPair GetNear (libcpp_utf8_string, size_t minimum_prefix_length, bool greedy) except + # wrap-as:get_near
@@ -55,3 +55,44 @@ def test_match_fuzzy_minimum_prefix():
         assert matches[0].matched_string == "a"
         assert matches[0].score == 1
 
+
+
+def test_match_fuzzy_with_automaton():
+    c = CompletionDictionaryCompiler({"memory_limit_mb": "10"})
+    c.add("türkei news", 23698)
+    c.add("türkei side", 18838)
+    c.add("türkisch für", 21655)
+    c.add("tüv i", 331)
+    c.add("tüv in", 10188)
+    c.add("tüv ib", 10189)
+    c.add("tüv kosten", 11387)
+    c.add("tüv nord", 46052)
+    c.add("tüv sood", 46057)
+    c.add("tüs rhein", 462)
+
+    with tmp_dictionary(c, 'match_fuzzy_with_automaton.kv') as d:
+        for query in ['tüv koid', 'tüv i', 'türkei', 'tüs rhien', 'xyz']:
+            for max_edit_distance in range(0, 3):
+                expected = [(m.matched_string, m.value, m.score) for m in d.match_fuzzy(query, max_edit_distance)]
+                actual = [(m.matched_string, m.value, m.score)
+                          for m in d.match_fuzzy_with_automaton(query, max_edit_distance)]
+                assert expected == actual
+
+        matches = list(d.match_fuzzy_with_automaton('tüv koid', 2))
+        assert len(matches) == 2
+        assert matches[0].matched_string == 'tüv sood'
+        assert matches[1].matched_string == 'tüv nord'
+
+
+def test_match_fuzzy_with_automaton_minimum_prefix():
+    c = IntDictionaryCompiler({"memory_limit_mb": "10"})
+    c.add("a", 0)
+    c.add("apple", 1)
+    with tmp_dictionary(c, 'match_fuzzy_with_automaton_mp.kv') as d:
+        matches = list(d.match_fuzzy_with_automaton("app", 0, 1))
+        assert len(matches) == 0
+        matches = list(d.match_fuzzy_with_automaton("ap", 1, 1))
+        assert len(matches) == 1
+        assert matches[0].value == 0
+        assert matches[0].matched_string == "a"
+        assert matches[0].score == 1
@@ -164,6 +164,31 @@ def test_get_value():
         ) == {"a": 3}
 
 
+def test_get_value_as_memoryview():
+    c = JsonDictionaryCompiler({"memory_limit_mb": "10"})
+    c.add("abc", '{"a" : 2}')
+    c.add("abd", '{"a" : 3}')
+    with tmp_dictionary(c, "match_object_json_memoryview.kv") as d:
+        m = d["abc"]
+        view = m.msgpacked_value_as_memoryview()
+        assert view.readonly
+        assert view.tobytes() == m.msgpacked_value_as_string()
+        assert msgpack.loads(view) == {"a": 2}
+        # the view keeps the match alive
+        del m
+        assert msgpack.loads(view) == {"a": 2}
+        del view
+
+    c = StringDictionaryCompiler({"memory_limit_mb": "10"})
+    c.add("abc", "aaaaa")
+    with tmp_dictionary(c, "match_object_string_memoryview.kv") as d:
+        m = d["abc"]
+        assert msgpack.loads(m.msgpacked_value_as_memoryview()) == "aaaaa"
+
+    m = keyvi.Match()
+    assert len(m.msgpacked_value_as_memoryview()) == 0
+
+
 def test_get_value_int():
     c = CompletionDictionaryCompiler({"memory_limit_mb": "10"})
     c.add("abc", 42)
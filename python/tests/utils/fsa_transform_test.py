@@ -0,0 +1,26 @@
+# -*- coding: utf-8 -*-
+# Usage: py.test tests
+
+import sys
+import os
+
+from keyvi.compiler import StringDictionaryCompiler
+from keyvi.util import FsaTransform
+
+root = os.path.dirname(os.path.abspath(__file__))
+sys.path.append(os.path.join(root, "../"))
+
+from test_tools import tmp_dictionary
+
+
+def test_normalize():
+    c = StringDictionaryCompiler({"memory_limit_mb": "10"})
+    c.add("aa", "b")
+    c.add("c", "d")
+    c.add("caa", "ef")
+    c.add("a", "g")
+    with tmp_dictionary(c, 'fsa_transform_normalize.kv') as d:
+        n = FsaTransform(d)
+        assert n.normalize("caaa") == b"efg"
+        assert n.normalize(b"dcac") == b"ddgd"
+        assert n.normalize_batch(["aa ", "", u"cac"]) == [b"b ", b"", b"dgd"]
@@ -70,6 +70,7 @@ fn main() {
         .allowlist_function("keyvi_match_get_matched_string")
         .allowlist_function("keyvi_match_get_msgpacked_value")
         .allowlist_function("keyvi_match_get_msgpacked_value_compressed")
+        .allowlist_function("keyvi_match_get_msgpacked_value_view")
         .allowlist_function("keyvi_match_get_score")
         .allowlist_function("keyvi_match_get_value_as_string")
         .allowlist_function("keyvi_match_is_empty")
@@ -60,6 +60,14 @@ impl KeyviMatch {
     }
 
     pub fn get_msgpacked_value(&self) -> Vec<u8> {
+        // avoid the intermediate copy if the value can be read directly from the dictionary
+        let kv_view = unsafe { root::keyvi_match_get_msgpacked_value_view(self.match_ptr_) };
+        if kv_view.data_size != 0 {
+            return unsafe {
+                slice::from_raw_parts(kv_view.data_ptr, kv_view.data_size as usize).to_vec()
+            };
+        }
+
         let kv_bytes = unsafe { root::keyvi_match_get_msgpacked_value(self.match_ptr_) };
         let msgpacked_value = if kv_bytes.data_size == 0 {
             Vec::new()